@@ -0,0 +1,158 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "pi_atecc.h"
+
+enum {
+    CACHE_VERSION   = 1U,
+    CACHE_FILE_SIZE = 4U + 1U + ATECC_SERIAL_NUMBER_SIZE + ATECC_CONFIG_SIZE
+};
+
+static const char cache_magic[4] = { 'A', 'T', 'C', 'C' };
+
+/**
+ * @brief Cache directory, $XDG_CACHE_HOME/pi_atecc (or ~/.cache/pi_atecc), created on demand
+ *
+ * @param dir Output path buffer
+ * @param size Size of the path buffer
+ * @return true if the directory exists, false otherwise
+ */
+bool atecc_cache_dir(char *dir, size_t size) {
+    const char *base = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+
+    if (base && base[0] != '\0') {
+        snprintf(dir, size, "%s/pi_atecc", base);
+    } else if (home && home[0] != '\0') {
+        snprintf(dir, size, "%s/.cache", home);
+        mkdir(dir, 0700);
+        snprintf(dir, size, "%s/.cache/pi_atecc", home);
+    } else {
+        return false;
+    }
+    return mkdir(dir, 0700) == 0 || errno == EEXIST;
+}
+
+/**
+ * @brief Build the cache file path for a device, creating the cache directory
+ *
+ * Files live in atecc_cache_dir() and are keyed by bus, mux hop and
+ * device address, e.g. "i2c-1-70.3-60.bin".
+ *
+ * @param dev Device handle
+ * @param path Output path buffer
+ * @param size Size of the path buffer
+ * @return true if a path was produced, false otherwise
+ */
+static bool cache_path(const atecc_dev_t *dev, char *path, size_t size) {
+    char dir[256];
+    if (!atecc_cache_dir(dir, sizeof(dir))) {
+        return false;
+    }
+
+    const char *bus = strrchr(dev->bus, '/');
+    bus = bus ? bus + 1 : dev->bus;
+
+    int written;
+    if (dev->mux) {
+        written = snprintf(path, size, "%s/%s-%02X.%u-%02X.bin", dir, bus,
+                           dev->mux->port.address, dev->mux_channel, dev->address);
+    } else {
+        written = snprintf(path, size, "%s/%s-%02X.bin", dir, bus, dev->address);
+    }
+    return written > 0 && (size_t)written < size;
+}
+
+/**
+ * @brief Load the cached serial number and config zone for a device
+ *
+ * The identity is marked valid but not verified: the first command that wakes
+ * the device re-reads the serial number and drops the cached config if it
+ * does not match. Until then config reads are served from the cache.
+ *
+ * @param dev Device handle
+ * @return true if a cache entry was loaded, false otherwise
+ */
+bool atecc_cache_load(atecc_dev_t *dev) {
+    char path[512];
+    if (!dev || !cache_path(dev, path, sizeof(path))) {
+        return false;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+
+    uint8_t entry[CACHE_FILE_SIZE];
+    size_t length = fread(entry, 1, sizeof(entry), file);
+    fclose(file);
+    if (length != sizeof(entry) || memcmp(entry, cache_magic, sizeof(cache_magic)) != 0 || entry[4] != CACHE_VERSION) {
+        return false;
+    }
+
+    memcpy(dev->serial, &entry[5], ATECC_SERIAL_NUMBER_SIZE);
+    memcpy(dev->config, &entry[5 + ATECC_SERIAL_NUMBER_SIZE], ATECC_CONFIG_SIZE);
+    dev->identity_valid = true;
+    dev->config_valid = true;
+    atecc_snapshot_publish(dev);
+    return true;
+}
+
+/**
+ * @brief Persist the serial number and config zone of a fully locked device
+ *
+ * Only devices with both the config and data zones locked are cached, since
+ * their config zone can no longer be rewritten.
+ *
+ * @param dev Device handle
+ * @return true if the cache entry was written, false otherwise
+ */
+bool atecc_cache_store(const atecc_dev_t *dev) {
+    if (!dev || !dev->identity_valid || !dev->config_valid ||
+        dev->config[ATECC_CONFIG_LOCK_VALUE] != 0x00 || dev->config[ATECC_CONFIG_LOCK_CONFIG] != 0x00) {
+        return false;
+    }
+
+    char path[512];
+    char tmp_path[520];
+    if (!cache_path(dev, path, sizeof(path))) {
+        return false;
+    }
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    uint8_t entry[CACHE_FILE_SIZE];
+    memcpy(entry, cache_magic, sizeof(cache_magic));
+    entry[4] = CACHE_VERSION;
+    memcpy(&entry[5], dev->serial, ATECC_SERIAL_NUMBER_SIZE);
+    memcpy(&entry[5 + ATECC_SERIAL_NUMBER_SIZE], dev->config, ATECC_CONFIG_SIZE);
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(entry, 1, sizeof(entry), file) == sizeof(entry);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmp_path, path) < 0) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Remove a device's cache entry after its config zone has been rewritten
+ *
+ * @param dev Device handle
+ */
+void atecc_cache_invalidate(const atecc_dev_t *dev) {
+    char path[512];
+    if (dev && cache_path(dev, path, sizeof(path))) {
+        remove(path);
+    }
+}
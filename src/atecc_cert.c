@@ -0,0 +1,771 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "pi_atecc.h"
+
+enum {
+    DER_SEQUENCE        = 0x30U,
+    DER_INTEGER         = 0x02U,
+    DER_BIT_STRING      = 0x03U,
+    DER_UTC_TIME        = 0x17U,
+    DER_GENERALIZED     = 0x18U,
+    DER_VERSION         = 0xA0U,    // [0] EXPLICIT version
+    P256_SIZE           = 32U,
+    PUBKEY_SIZE         = 64U,
+    SHA1_SIZE           = 20U,
+    COMP_DATES          = 64U,      // Compressed layout: signature (64), dates (3),
+    COMP_SIGNER_ID      = 67U,      // signer id (2), template/chain id, serial source/format,
+    COMP_IDS            = 69U,      // reserved
+    COMP_SN_SOURCE      = 70U,
+    COMP_RESERVED       = 71U,
+    COMP_YEAR_BASE      = 2000,
+    BENCH_DEFAULT_REPEAT = 100U
+};
+
+/**
+ * @brief DER element header
+ */
+typedef struct {
+    uint8_t tag;
+    size_t header;          // Tag and length bytes
+    size_t length;          // Content length
+} der_item_t;
+
+/**
+ * @brief Read the element header at 'at', checking it fits before 'end'
+ */
+static bool der_read(const uint8_t *der, size_t end, size_t at, der_item_t *item) {
+    if (at + 2U > end) {
+        return false;
+    }
+    item->tag = der[at];
+    item->header = 2U;
+    item->length = der[at + 1U];
+    if (item->length & 0x80U) {
+        size_t bytes = item->length & 0x7FU;
+        if (bytes == 0 || bytes > 2U || at + 2U + bytes > end) {
+            return false;
+        }
+        item->length = 0;
+        for (size_t i = 0; i < bytes; i++) {
+            item->length = (item->length << 8) | der[at + 2U + i];
+        }
+        item->header += bytes;
+    }
+    return at + item->header + item->length <= end;
+}
+
+/**
+ * @brief Read an element with an expected tag
+ */
+static bool der_expect(const uint8_t *der, size_t end, size_t at, uint8_t tag, der_item_t *item) {
+    return der_read(der, end, at, item) && item->tag == tag;
+}
+
+/**
+ * @brief Write a tag and definite length, returning the header size
+ */
+static size_t der_put_header(uint8_t *out, uint8_t tag, size_t length) {
+    out[0] = tag;
+    if (length < 0x80U) {
+        out[1] = (uint8_t)length;
+        return 2U;
+    }
+    if (length < 0x100U) {
+        out[1] = 0x81U;
+        out[2] = (uint8_t)length;
+        return 3U;
+    }
+    out[1] = 0x82U;
+    out[2] = (uint8_t)(length >> 8);
+    out[3] = (uint8_t)length;
+    return 4U;
+}
+
+/**
+ * @brief Locate the device-specific fields of an X.509 certificate with a P-256 key
+ *
+ * @param der Certificate
+ * @param length Certificate length
+ * @param layout Receives field offsets
+ * @return true if the certificate has the expected structure, false otherwise
+ */
+bool atecc_cert_parse(const uint8_t *der, size_t length, atecc_cert_layout_t *layout) {
+    der_item_t cert, tbs, item, spki;
+    if (!der || !layout || !der_expect(der, length, 0, DER_SEQUENCE, &cert) ||
+        cert.header + cert.length != length) {
+        errno = EINVAL;
+        return false;
+    }
+    memset(layout, 0, sizeof(*layout));
+
+    size_t at = cert.header;
+    if (!der_expect(der, length, at, DER_SEQUENCE, &tbs)) {
+        errno = EINVAL;
+        return false;
+    }
+    layout->tbs_offset = at;
+    layout->tbs_length = tbs.header + tbs.length;
+    size_t tbs_end = at + layout->tbs_length;
+
+    at += tbs.header;
+    if (der_expect(der, tbs_end, at, DER_VERSION, &item)) {
+        at += item.header + item.length;
+    }
+    if (!der_expect(der, tbs_end, at, DER_INTEGER, &item)) {
+        errno = EINVAL;
+        return false;
+    }
+    layout->serial_offset = at + item.header;
+    layout->serial_length = item.length;
+    at += item.header + item.length;
+
+    // signature AlgorithmIdentifier, issuer
+    for (unsigned int i = 0; i < 2U; i++) {
+        if (!der_expect(der, tbs_end, at, DER_SEQUENCE, &item)) {
+            errno = EINVAL;
+            return false;
+        }
+        at += item.header + item.length;
+    }
+
+    // validity
+    if (!der_expect(der, tbs_end, at, DER_SEQUENCE, &item)) {
+        errno = EINVAL;
+        return false;
+    }
+    size_t time_at = at + item.header;
+    at += item.header + item.length;
+    size_t *offsets[2] = { &layout->issue_offset, &layout->expire_offset };
+    size_t *lengths[2] = { &layout->issue_length, &layout->expire_length };
+    for (unsigned int i = 0; i < 2U; i++) {
+        if (!der_read(der, at, time_at, &item) || (item.tag != DER_UTC_TIME && item.tag != DER_GENERALIZED)) {
+            errno = EINVAL;
+            return false;
+        }
+        *offsets[i] = time_at + item.header;
+        *lengths[i] = item.length;
+        time_at += item.header + item.length;
+    }
+    if (layout->issue_length != 13U || (layout->expire_length != 13U && layout->expire_length != 15U)) {
+        errno = EINVAL;
+        return false;
+    }
+
+    // subject, then subjectPublicKeyInfo { algorithm, BIT STRING 00 04 X Y }
+    if (!der_expect(der, tbs_end, at, DER_SEQUENCE, &item)) {
+        errno = EINVAL;
+        return false;
+    }
+    at += item.header + item.length;
+    if (!der_expect(der, tbs_end, at, DER_SEQUENCE, &spki) ||
+        !der_expect(der, tbs_end, at + spki.header, DER_SEQUENCE, &item)) {
+        errno = EINVAL;
+        return false;
+    }
+    size_t key_at = at + spki.header + item.header + item.length;
+    if (!der_expect(der, tbs_end, key_at, DER_BIT_STRING, &item) || item.length != 2U + PUBKEY_SIZE ||
+        der[key_at + item.header] != 0x00 || der[key_at + item.header + 1U] != 0x04) {
+        errno = EINVAL;
+        return false;
+    }
+    layout->pubkey_offset = key_at + item.header + 2U;
+
+    // subjectKeyIdentifier extension: OID 2.5.29.14, OCTET STRING { OCTET STRING (20) }
+    static const uint8_t ski_pattern[] = { 0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14 };
+    for (size_t i = layout->pubkey_offset + PUBKEY_SIZE; i + sizeof(ski_pattern) + SHA1_SIZE <= tbs_end; i++) {
+        if (memcmp(&der[i], ski_pattern, sizeof(ski_pattern)) == 0) {
+            layout->ski_offset = i + sizeof(ski_pattern);
+            break;
+        }
+    }
+
+    at = tbs_end;
+    if (!der_expect(der, length, at, DER_SEQUENCE, &item)) {
+        errno = EINVAL;
+        return false;
+    }
+    layout->sig_alg_offset = at;
+    layout->sig_alg_length = item.header + item.length;
+    at += layout->sig_alg_length;
+    if (!der_expect(der, length, at, DER_BIT_STRING, &item) || item.length < 1U || der[at + item.header] != 0x00) {
+        errno = EINVAL;
+        return false;
+    }
+    layout->sig_offset = at + item.header + 1U;
+    layout->sig_length = item.length - 1U;
+    return true;
+}
+
+/**
+ * @brief Load a certificate to serve as the template for compressed certificates
+ *
+ * The serial number source defaults to the chip serial when the template's
+ * serial number is 9 bytes long, and to the template's own value otherwise.
+ *
+ * @param def Definition to fill
+ * @param path DER certificate file
+ * @return true on success, false otherwise
+ */
+bool atecc_cert_def_load(atecc_cert_def_t *def, const char *path) {
+    if (!def || !path) {
+        errno = EINVAL;
+        return false;
+    }
+    memset(def, 0, sizeof(*def));
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror("atecc_cert_def_load: cannot open template");
+        return false;
+    }
+    def->length = fread(def->der, 1, sizeof(def->der), file);
+    bool truncated = !feof(file) && fgetc(file) != EOF;
+    fclose(file);
+
+    if (truncated || !atecc_cert_parse(def->der, def->length, &def->layout)) {
+        fprintf(stderr, "atecc_cert_def_load: %s is not a P-256 DER certificate of at most %u bytes\n", path,
+                ATECC_CERT_MAX);
+        errno = EINVAL;
+        return false;
+    }
+    def->sn_source = (def->layout.serial_length == ATECC_SERIAL_NUMBER_SIZE) ? ATECC_CERT_SN_DEVICE
+                                                                              : ATECC_CERT_SN_STORED;
+    sha256(def->der, def->length, def->digest);
+    return true;
+}
+
+/**
+ * @brief Date fields kept in a compressed certificate
+ */
+typedef struct {
+    int year;
+    int month;
+    int day;
+    int hour;
+    int expire_years;       // 0 keeps the template's notAfter
+} comp_dates_t;
+
+static int two_digits(const uint8_t *p) {
+    return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+/**
+ * @brief Parse YYMMDDHH (UTCTime) or YYYYMMDDHH (GeneralizedTime) from a time element
+ */
+static void parse_time(const uint8_t *p, size_t length, comp_dates_t *date) {
+    if (length == 13U) {
+        int yy = two_digits(p);
+        date->year = (yy < 50) ? 2000 + yy : 1900 + yy;
+        p += 2;
+    } else {
+        date->year = two_digits(p) * 100 + two_digits(p + 2);
+        p += 4;
+    }
+    date->month = two_digits(p);
+    date->day = two_digits(p + 2);
+    date->hour = two_digits(p + 4);
+}
+
+/**
+ * @brief Write a time element for a date at the top of the hour
+ */
+static void format_time(uint8_t *p, size_t length, int year, int month, int day, int hour) {
+    char text[16];
+    if (length == 13U) {
+        snprintf(text, sizeof(text), "%02d%02d%02d%02d0000Z", year % 100, month, day, hour);
+    } else {
+        snprintf(text, sizeof(text), "%04d%02d%02d%02d0000Z", year, month, day, hour);
+    }
+    memcpy(p, text, length);
+}
+
+static void encode_dates(const comp_dates_t *date, uint8_t *out) {
+    unsigned int year = (unsigned int)(date->year - COMP_YEAR_BASE);
+    unsigned int month = (unsigned int)date->month;
+    unsigned int day = (unsigned int)date->day;
+    unsigned int hour = (unsigned int)date->hour;
+    unsigned int expire = (unsigned int)date->expire_years;
+    out[0] = (uint8_t)(((year & 0x1FU) << 3) | ((month >> 1) & 0x07U));
+    out[1] = (uint8_t)(((month & 0x01U) << 7) | ((day & 0x1FU) << 2) | ((hour >> 3) & 0x03U));
+    out[2] = (uint8_t)(((hour & 0x07U) << 5) | (expire & 0x1FU));
+}
+
+static void decode_dates(const uint8_t *in, comp_dates_t *date) {
+    date->year = COMP_YEAR_BASE + (in[0] >> 3);
+    date->month = ((in[0] & 0x07) << 1) | (in[1] >> 7);
+    date->day = (in[1] >> 2) & 0x1F;
+    date->hour = ((in[1] & 0x03) << 3) | (in[2] >> 5);
+    date->expire_years = in[2] & 0x1F;
+}
+
+/**
+ * @brief DER-encode a 32-byte big-endian value as a minimal positive INTEGER
+ */
+static size_t put_integer(uint8_t *out, const uint8_t *value) {
+    size_t skip = 0;
+    while (skip < P256_SIZE - 1U && value[skip] == 0x00) {
+        skip++;
+    }
+    size_t pad = (value[skip] & 0x80U) ? 1U : 0U;
+    size_t header = der_put_header(out, DER_INTEGER, pad + P256_SIZE - skip);
+    out[header] = 0x00;
+    memcpy(&out[header + pad], &value[skip], P256_SIZE - skip);
+    return header + pad + P256_SIZE - skip;
+}
+
+/**
+ * @brief Extract a DER INTEGER as a 32-byte big-endian value
+ */
+static bool get_integer(const uint8_t *der, size_t end, size_t *at, uint8_t *value) {
+    der_item_t item;
+    if (!der_expect(der, end, *at, DER_INTEGER, &item)) {
+        return false;
+    }
+    const uint8_t *p = &der[*at + item.header];
+    size_t length = item.length;
+    while (length > P256_SIZE && *p == 0x00) {
+        p++;
+        length--;
+    }
+    if (length > P256_SIZE) {
+        return false;
+    }
+    memset(value, 0, P256_SIZE);
+    memcpy(&value[P256_SIZE - length], p, length);
+    *at += item.header + item.length;
+    return true;
+}
+
+/**
+ * @brief Rebuild a full DER certificate from its compressed form
+ *
+ * @param def Template
+ * @param compressed 72-byte compressed certificate
+ * @param serial Chip serial number (used when the serial source is the device)
+ * @param public_key 64-byte public key (X || Y)
+ * @param der Output buffer of ATECC_CERT_MAX bytes
+ * @param length Receives the certificate length
+ * @return true on success, false otherwise
+ */
+bool atecc_cert_rebuild(const atecc_cert_def_t *def, const uint8_t *compressed, const uint8_t *serial,
+                        const uint8_t *public_key, uint8_t *der, size_t *length) {
+    if (!def || !compressed || !public_key || !der || !length) {
+        errno = EINVAL;
+        return false;
+    }
+    const atecc_cert_layout_t *layout = &def->layout;
+    size_t base = layout->tbs_offset;
+
+    uint8_t tbs[ATECC_CERT_MAX];
+    memcpy(tbs, &def->der[base], layout->tbs_length);
+
+    uint8_t sn_source = compressed[COMP_SN_SOURCE] >> 4;
+    if (sn_source == ATECC_CERT_SN_DEVICE) {
+        if (!serial || layout->serial_length != ATECC_SERIAL_NUMBER_SIZE) {
+            errno = EINVAL;
+            return false;
+        }
+        memcpy(&tbs[layout->serial_offset - base], serial, ATECC_SERIAL_NUMBER_SIZE);
+    }
+
+    comp_dates_t date;
+    decode_dates(&compressed[COMP_DATES], &date);
+    format_time(&tbs[layout->issue_offset - base], layout->issue_length, date.year, date.month, date.day, date.hour);
+    if (date.expire_years != 0) {
+        format_time(&tbs[layout->expire_offset - base], layout->expire_length, date.year + date.expire_years,
+                    date.month, date.day, date.hour);
+    }
+    memcpy(&tbs[layout->pubkey_offset - base], public_key, PUBKEY_SIZE);
+    if (layout->ski_offset != 0) {
+        uint8_t point[1U + PUBKEY_SIZE] = { 0x04 };
+        memcpy(&point[1], public_key, PUBKEY_SIZE);
+        sha1(point, sizeof(point), &tbs[layout->ski_offset - base]);
+    }
+
+    // ECDSA-Sig-Value ::= SEQUENCE { r INTEGER, s INTEGER }
+    uint8_t integers[2U * (4U + P256_SIZE)];
+    size_t integers_length = put_integer(integers, compressed);
+    integers_length += put_integer(&integers[integers_length], &compressed[P256_SIZE]);
+    uint8_t sig_value[8U + sizeof(integers)];
+    size_t sig_length = der_put_header(sig_value, DER_SEQUENCE, integers_length);
+    if (integers_length > sizeof(sig_value) - sig_length) {
+        errno = EOVERFLOW;
+        return false;
+    }
+    memcpy(&sig_value[sig_length], integers, integers_length);
+    sig_length += integers_length;
+
+    uint8_t bit_header[4];
+    size_t bit_header_length = der_put_header(bit_header, DER_BIT_STRING, 1U + sig_length);
+    size_t body = layout->tbs_length + layout->sig_alg_length + bit_header_length + 1U + sig_length;
+    if (body + 4U > ATECC_CERT_MAX) {
+        errno = EOVERFLOW;
+        return false;
+    }
+
+    size_t at = der_put_header(der, DER_SEQUENCE, body);
+    memcpy(&der[at], tbs, layout->tbs_length);
+    at += layout->tbs_length;
+    memcpy(&der[at], &def->der[layout->sig_alg_offset], layout->sig_alg_length);
+    at += layout->sig_alg_length;
+    memcpy(&der[at], bit_header, bit_header_length);
+    at += bit_header_length;
+    der[at++] = 0x00;
+    memcpy(&der[at], sig_value, sig_length);
+    *length = at + sig_length;
+    return true;
+}
+
+/**
+ * @brief Compress a certificate issued from a template into 72 bytes
+ *
+ * The result is rebuilt and compared with the input, so a certificate that
+ * differs from the template anywhere other than the compressed fields (or
+ * whose dates are not at the top of the hour) is rejected.
+ *
+ * @param def Template
+ * @param der Certificate to compress
+ * @param length Certificate length
+ * @param compressed Receives 72 bytes
+ * @return true if the certificate round-trips exactly, false otherwise
+ */
+bool atecc_cert_compress(const atecc_cert_def_t *def, const uint8_t *der, size_t length, uint8_t *compressed) {
+    atecc_cert_layout_t layout;
+    if (!def || !compressed || !atecc_cert_parse(der, length, &layout)) {
+        errno = EINVAL;
+        return false;
+    }
+    if (layout.tbs_length != def->layout.tbs_length ||
+        layout.serial_offset - layout.tbs_offset != def->layout.serial_offset - def->layout.tbs_offset ||
+        layout.pubkey_offset - layout.tbs_offset != def->layout.pubkey_offset - def->layout.tbs_offset ||
+        layout.issue_offset - layout.tbs_offset != def->layout.issue_offset - def->layout.tbs_offset) {
+        fprintf(stderr, "atecc_cert_compress: certificate layout differs from the template\n");
+        errno = EINVAL;
+        return false;
+    }
+
+    memset(compressed, 0, ATECC_CERT_COMPRESSED_SIZE);
+    der_item_t sig;
+    size_t at = layout.sig_offset;
+    size_t end = layout.sig_offset + layout.sig_length;
+    if (!der_expect(der, end, at, DER_SEQUENCE, &sig)) {
+        errno = EINVAL;
+        return false;
+    }
+    at += sig.header;
+    if (!get_integer(der, end, &at, compressed) || !get_integer(der, end, &at, &compressed[P256_SIZE])) {
+        errno = EINVAL;
+        return false;
+    }
+
+    comp_dates_t issue;
+    comp_dates_t expire;
+    parse_time(&der[layout.issue_offset], layout.issue_length, &issue);
+    parse_time(&der[layout.expire_offset], layout.expire_length, &expire);
+    issue.expire_years = expire.year - issue.year;
+    if (issue.expire_years < 0 || issue.expire_years > 31) {
+        issue.expire_years = 0;
+    }
+    if (issue.year < COMP_YEAR_BASE || issue.year > COMP_YEAR_BASE + 31) {
+        fprintf(stderr, "atecc_cert_compress: issue year %d outside %d-%d\n", issue.year, COMP_YEAR_BASE,
+                COMP_YEAR_BASE + 31);
+        errno = ERANGE;
+        return false;
+    }
+    encode_dates(&issue, &compressed[COMP_DATES]);
+    compressed[COMP_SIGNER_ID] = 0x00;
+    compressed[COMP_SIGNER_ID + 1U] = 0x00;
+    compressed[COMP_IDS] = (uint8_t)(((def->template_id & 0x0FU) << 4) | (def->chain_id & 0x0FU));
+    compressed[COMP_SN_SOURCE] = (uint8_t)((def->sn_source & 0x0FU) << 4);    // Format version 0
+    compressed[COMP_RESERVED] = 0x00;
+
+    uint8_t rebuilt[ATECC_CERT_MAX];
+    size_t rebuilt_length = 0;
+    if (!atecc_cert_rebuild(def, compressed, &der[layout.serial_offset], &der[layout.pubkey_offset], rebuilt,
+                            &rebuilt_length) ||
+        rebuilt_length != length || memcmp(rebuilt, der, length) != 0) {
+        fprintf(stderr, "atecc_cert_compress: certificate does not round-trip through the template\n");
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Fetch a device certificate, rebuilding it only on the first request per serial
+ *
+ * A miss reads the 72-byte compressed certificate and the slot's public key
+ * (GenKey) and rebuilds the DER on the host. Later requests for the same
+ * chip and slot are answered from memory without any I2C traffic.
+ *
+ * @param cache Certificate cache
+ * @param dev Device handle
+ * @param def Template the certificate was compressed against
+ * @param cert_slot Slot holding the compressed certificate
+ * @param key_slot Slot holding the certificate's private key
+ * @param der Set to the cached certificate
+ * @param length Receives the certificate length
+ * @return true on success, false otherwise
+ */
+bool atecc_cert_get(atecc_cert_cache_t *cache, atecc_dev_t *dev, const atecc_cert_def_t *def, uint8_t cert_slot,
+                    uint8_t key_slot, const uint8_t **der, size_t *length) {
+    if (!cache || !dev || !def || !der || !length) {
+        errno = EINVAL;
+        return false;
+    }
+    // Waking verifies identity, so the serial is this chip's from here on
+    if (!dev->identity_verified && !atecc_ensure_awake(dev)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < ATECC_CERT_CACHE_MAX; i++) {
+        atecc_cert_entry_t *entry = &cache->entries[i];
+        if (entry->length > 0 && entry->cert_slot == cert_slot && entry->key_slot == key_slot &&
+            memcmp(entry->serial, dev->serial, sizeof(entry->serial)) == 0 &&
+            memcmp(entry->template_digest, def->digest, sizeof(entry->template_digest)) == 0) {
+            cache->hits++;
+            *der = entry->der;
+            *length = entry->length;
+            return true;
+        }
+    }
+
+    uint8_t compressed[ATECC_CERT_COMPRESSED_SIZE];
+    uint8_t public_key[PUBKEY_SIZE];
+    if (!atecc_read_slot(dev, cert_slot, 0, compressed, sizeof(compressed)) ||
+        !atecc_get_pubkey(dev, key_slot, public_key)) {
+        fprintf(stderr, "atecc_cert_get: cannot read certificate slot %u / key slot %u\n", cert_slot, key_slot);
+        return false;
+    }
+
+    atecc_cert_entry_t *entry = &cache->entries[cache->next];
+    if (!atecc_cert_rebuild(def, compressed, dev->serial, public_key, entry->der, &entry->length)) {
+        entry->length = 0;
+        return false;
+    }
+    memcpy(entry->serial, dev->serial, sizeof(entry->serial));
+    memcpy(entry->template_digest, def->digest, sizeof(entry->template_digest));
+    entry->cert_slot = cert_slot;
+    entry->key_slot = key_slot;
+    cache->next = (cache->next + 1U) % ATECC_CERT_CACHE_MAX;
+    cache->misses++;
+
+    *der = entry->der;
+    *length = entry->length;
+    return true;
+}
+
+/**
+ * @brief Read a whole file into a buffer of ATECC_CERT_MAX bytes
+ */
+static bool read_cert_file(const char *path, uint8_t *der, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror("cert: cannot open certificate");
+        return false;
+    }
+    *length = fread(der, 1, ATECC_CERT_MAX, file);
+    fclose(file);
+    return *length > 0;
+}
+
+/**
+ * @brief Open the device named by an optional topology argument
+ *
+ * @param spec Topology address, NULL for the default device
+ * @param mux Receives the mux the device sits behind, if any
+ * @param dev Receives the device handle
+ * @param muxed Set to whether mux was opened and must be closed with the device (see close_cli_device())
+ * @return true on success, false otherwise (nothing left open)
+ */
+static bool open_cli_device(const char *spec, atecc_mux_t *mux, atecc_dev_t *dev, bool *muxed) {
+    atecc_topo_t topo = { .bus = I2C_DEVICE, .address = ATECC_I2C_ADDRESS };
+    *muxed = false;
+    if (spec && !atecc_parse_topo(spec, &topo)) {
+        fprintf(stderr, "❌ ERROR: Invalid device address '%s'\n", spec);
+        return false;
+    }
+    if (topo.mux_address != 0 && !atecc_mux_open(mux, topo.bus, topo.mux_address)) {
+        return false;
+    }
+    if (!atecc_open_topo(dev, &topo, mux)) {
+        if (topo.mux_address != 0) {
+            atecc_mux_close(mux);
+        }
+        return false;
+    }
+    *muxed = topo.mux_address != 0;
+    return true;
+}
+
+/**
+ * @brief Close a device opened with open_cli_device() and the mux in front of it
+ */
+static void close_cli_device(atecc_mux_t *mux, atecc_dev_t *dev, bool muxed) {
+    atecc_close(dev);
+    if (muxed) {
+        atecc_mux_close(mux);
+    }
+}
+
+/**
+ * @brief Compress a certificate and write it to a slot
+ */
+static int cert_store(const atecc_cert_def_t *def, const char *cert_path, uint8_t cert_slot, const char *spec) {
+    uint8_t der[ATECC_CERT_MAX];
+    size_t length = 0;
+    uint8_t compressed[ATECC_CERT_COMPRESSED_SIZE];
+    atecc_cert_layout_t layout;
+    if (!read_cert_file(cert_path, der, &length) || !atecc_cert_compress(def, der, length, compressed) ||
+        !atecc_cert_parse(der, length, &layout)) {
+        return 1;
+    }
+
+    atecc_mux_t mux;
+    atecc_dev_t dev;
+    bool muxed = false;
+    if (!open_cli_device(spec, &mux, &dev, &muxed)) {
+        return 1;
+    }
+    if (!atecc_ensure_awake(&dev)) {
+        close_cli_device(&mux, &dev, muxed);
+        return 1;
+    }
+    // The template rebuilds the serial from the chip, so any other serial would void the signature
+    if (def->sn_source == ATECC_CERT_SN_DEVICE &&
+        memcmp(&der[layout.serial_offset], dev.serial, ATECC_SERIAL_NUMBER_SIZE) != 0) {
+        fprintf(stderr, "❌ ERROR: Certificate serial number does not match this chip's serial\n");
+        close_cli_device(&mux, &dev, muxed);
+        return 1;
+    }
+
+    bool ok = atecc_write_slot(&dev, cert_slot, 0, compressed, sizeof(compressed));
+    if (ok) {
+        printf("✅ %zu-byte certificate stored in slot %u as %u bytes\n", length, cert_slot,
+               ATECC_CERT_COMPRESSED_SIZE);
+    }
+    close_cli_device(&mux, &dev, muxed);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Rebuild a certificate repeatedly and report cold and warm fetch cost
+ */
+static int cert_fetch(const atecc_cert_def_t *def, uint8_t cert_slot, uint8_t key_slot, size_t repeat,
+                      const char *out_path, const char *spec) {
+    atecc_mux_t mux;
+    atecc_dev_t dev;
+    bool muxed = false;
+    if (!open_cli_device(spec, &mux, &dev, &muxed)) {
+        return 1;
+    }
+    atecc_cert_cache_t *cache = calloc(1, sizeof(*cache));
+    if (!cache) {
+        close_cli_device(&mux, &dev, muxed);
+        return 1;
+    }
+
+    const uint8_t *der = NULL;
+    size_t length = 0;
+    unsigned long commands = dev.commands;
+    uint64_t start = atecc_now_us();
+    bool ok = atecc_cert_get(cache, &dev, def, cert_slot, key_slot, &der, &length);
+    uint64_t cold_us = atecc_now_us() - start;
+    unsigned long cold_commands = dev.commands - commands;
+
+    commands = dev.commands;
+    start = atecc_now_us();
+    for (size_t i = 1; ok && i < repeat; i++) {
+        ok = atecc_cert_get(cache, &dev, def, cert_slot, key_slot, &der, &length);
+    }
+    uint64_t warm_us = atecc_now_us() - start;
+    unsigned long warm_commands = dev.commands - commands;
+
+    if (ok) {
+        char serial_hex[2U * ATECC_SERIAL_NUMBER_SIZE + 1U];
+        atecc_hex(dev.serial, ATECC_SERIAL_NUMBER_SIZE, serial_hex, ATECC_HEX_UPPER);
+        printf("📜 Rebuilt %zu-byte certificate for %s from %u bytes\n", length, serial_hex,
+               ATECC_CERT_COMPRESSED_SIZE);
+        printf("⏱️ Cold fetch: %.1f ms, %lu commands\n", (double)cold_us / 1000.0, cold_commands);
+        if (repeat > 1) {
+            printf("⏱️ Warm fetch: %.2f us, %lu commands over %zu fetches (%lu hits)\n",
+                   (double)warm_us / (double)(repeat - 1U), warm_commands, repeat - 1U, cache->hits);
+        }
+        if (out_path) {
+            FILE *file = fopen(out_path, "wb");
+            ok = file && fwrite(der, 1, length, file) == length;
+            if (file) {
+                fclose(file);
+            }
+            if (!ok) {
+                perror("cert: cannot write certificate");
+            }
+        }
+    }
+
+    free(cache);
+    close_cli_device(&mux, &dev, muxed);
+    return ok ? 0 : 1;
+}
+
+static void cert_usage(void) {
+    fprintf(stderr, "usage: pi_atecc cert store <template.der> <cert.der> <slot> [device]\n"
+                    "       pi_atecc cert fetch <template.der> <slot> <key-slot> [--repeat N] [--out FILE] "
+                    "[device]\n");
+}
+
+/**
+ * @brief Store or rebuild compressed device certificates
+ *
+ * Usage: cert store <template.der> <cert.der> <slot> [device], or
+ * cert fetch <template.der> <slot> <key-slot> [--repeat N] [--out FILE] [device]
+ *
+ * @return Process exit status
+ */
+int atecc_cert_main(int argc, char **argv) {
+    bool store = argc >= 4 && strcmp(argv[0], "store") == 0;
+    bool fetch = argc >= 4 && strcmp(argv[0], "fetch") == 0;
+    if (!store && !fetch) {
+        cert_usage();
+        return 2;
+    }
+
+    size_t repeat = BENCH_DEFAULT_REPEAT;
+    const char *out_path = NULL;
+    const char *spec = NULL;
+    for (int i = 4; i < argc; i++) {
+        if (fetch && strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = strtoul(argv[++i], NULL, 10);
+        } else if (fetch && strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (argv[i][0] != '-' && !spec) {
+            spec = argv[i];
+        } else {
+            cert_usage();
+            return 2;
+        }
+    }
+
+    atecc_cert_def_t *def = malloc(sizeof(*def));
+    if (!def || !atecc_cert_def_load(def, argv[1])) {
+        free(def);
+        return 1;
+    }
+
+    int status;
+    if (store) {
+        status = cert_store(def, argv[2], (uint8_t)strtoul(argv[3], NULL, 0), spec);
+    } else {
+        uint8_t cert_slot = (uint8_t)strtoul(argv[2], NULL, 0);
+        uint8_t key_slot = (uint8_t)strtoul(argv[3], NULL, 0);
+        status = cert_fetch(def, cert_slot, key_slot, repeat ? repeat : 1U, out_path, spec);
+    }
+
+    free(def);
+    return status;
+}
@@ -0,0 +1,713 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "pi_atecc.h"
+
+enum {
+    BENCH_DEFAULT_BYTES = 4096U,          // 128 Random commands per path on one chip
+    BENCH_CHUNK         = 65536U,
+    BATCH_BENCH_MAX_THREADS = 32U,        // Daemon client limit
+    BATCH_BENCH_BAR     = 40U,            // Width of the p99 bar
+    BATCH_BENCH_BAR_MS  = 100U,           // p99 shown as a full bar
+    BURST_BENCH_LEARN   = 3U,             // Bursts the daemon needs before it can predict the next
+    SHA_DIGEST_BYTES    = 32U
+};
+
+/**
+ * @brief Connect to the daemon and map the ring it hands over
+ *
+ * @param client Connection to initialize
+ * @param path Control socket path, NULL for atecc_socket_path()
+ * @return true on success, false otherwise
+ */
+bool atecc_client_open(atecc_client_t *client, const char *path) {
+    if (!client) {
+        errno = EINVAL;
+        return false;
+    }
+    memset(client, 0, sizeof(*client));
+    client->fd = -1;
+
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    path = path ? path : atecc_socket_path();
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    strcpy(addr.sun_path, path);
+
+    client->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (client->fd < 0 || connect(client->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("atecc_client_open: connect failed");
+        atecc_client_close(client);
+        return false;
+    }
+
+    atecc_hello_t hello;
+    struct iovec iov = { .iov_base = &hello, .iov_len = sizeof(hello) };
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.space,
+        .msg_controllen = sizeof(control.space)
+    };
+    ssize_t received = recvmsg(client->fd, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (received != (ssize_t)sizeof(hello) || hello.magic != ATECC_DAEMON_MAGIC || !cmsg ||
+        cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        fprintf(stderr, "atecc_client_open: invalid daemon greeting\n");
+        atecc_client_close(client);
+        errno = EPROTO;
+        return false;
+    }
+
+    int ring_fd;
+    memcpy(&ring_fd, CMSG_DATA(cmsg), sizeof(ring_fd));
+    client->ring_size = (size_t)hello.ring_size;
+    client->ring = mmap(NULL, client->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0);
+    close(ring_fd);
+    if (client->ring == MAP_FAILED) {
+        perror("atecc_client_open: ring mmap failed");
+        client->ring = NULL;
+        atecc_client_close(client);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Disconnect and unmap the ring
+ */
+void atecc_client_close(atecc_client_t *client) {
+    if (!client) {
+        return;
+    }
+    if (client->ring) {
+        munmap(client->ring, client->ring_size);
+        client->ring = NULL;
+    }
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+}
+
+/**
+ * @brief Claim a contiguous ring region for the next request
+ *
+ * Regions are handed out in order and wrap at the end of the ring, so a
+ * result stays valid until another ring_size bytes have been claimed.
+ *
+ * @param client Connection
+ * @param length Region size
+ * @return Pointer into the ring, NULL if length exceeds the ring
+ */
+uint8_t *atecc_client_reserve(atecc_client_t *client, size_t length) {
+    if (!client || !client->ring || length > client->ring_size) {
+        errno = ERANGE;
+        return NULL;
+    }
+    if (length > client->ring_size - client->ring_next) {
+        client->ring_next = 0;
+    }
+    uint8_t *region = &client->ring[client->ring_next];
+    client->ring_next += length;
+    return region;
+}
+
+/**
+ * @brief Send a request and wait for its reply
+ */
+static bool client_call(atecc_client_t *client, atecc_request_t *req, atecc_reply_t *reply) {
+    req->id = client->next_id++;
+    if (!atecc_write_full(client->fd, req, sizeof(*req)) || !atecc_read_full(client->fd, reply, sizeof(*reply))) {
+        perror("atecc_client: daemon connection lost");
+        return false;
+    }
+    if (reply->id != req->id) {
+        errno = EPROTO;
+        return false;
+    }
+    if (reply->status != 0) {
+        errno = reply->status;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Fetch random bytes delivered through the shared ring
+ *
+ * @param client Connection
+ * @param length Number of bytes
+ * @param data Set to the result inside the ring
+ * @return true on success, false otherwise
+ */
+bool atecc_client_random(atecc_client_t *client, size_t length, uint8_t **data) {
+    uint8_t *region = atecc_client_reserve(client, length);
+    if (!region || !data) {
+        return false;
+    }
+
+    atecc_request_t req = { .op = ATECC_OP_RANDOM, .offset = (uint64_t)(region - client->ring), .length = length };
+    atecc_reply_t reply;
+    if (!client_call(client, &req, &reply)) {
+        return false;
+    }
+    *data = region;
+    return true;
+}
+
+/**
+ * @brief Fetch random bytes copied through the control socket
+ *
+ * @param client Connection
+ * @param buf Output buffer
+ * @param length Number of bytes
+ * @return true on success, false otherwise
+ */
+bool atecc_client_random_copy(atecc_client_t *client, uint8_t *buf, size_t length) {
+    atecc_request_t req = { .op = ATECC_OP_RANDOM_INLINE, .length = length };
+    atecc_reply_t reply;
+    return client_call(client, &req, &reply) && atecc_read_full(client->fd, buf, length);
+}
+
+/**
+ * @brief AES-CTR in place over a ring region on the daemon's device pool
+ *
+ * @param client Connection
+ * @param key_slot Slot holding the AES key
+ * @param counter Initial 16-byte counter block
+ * @param data Region from atecc_client_reserve() holding the input
+ * @param length Number of bytes
+ * @return true on success, false otherwise
+ */
+bool atecc_client_aes_ctr(atecc_client_t *client, uint8_t key_slot, const uint8_t *counter, uint8_t *data,
+                          size_t length) {
+    if (!client || !counter || !data || data < client->ring || data >= client->ring + client->ring_size ||
+        length > (size_t)(client->ring + client->ring_size - data)) {
+        errno = EINVAL;
+        return false;
+    }
+
+    atecc_request_t req = {
+        .op = ATECC_OP_AES_CTR,
+        .offset = (uint64_t)(data - client->ring),
+        .length = length,
+        .key_slot = key_slot
+    };
+    memcpy(req.counter, counter, sizeof(req.counter));
+    atecc_reply_t reply;
+    return client_call(client, &req, &reply);
+}
+
+/**
+ * @brief Device SHA-256 of a ring region, digest written over its start
+ *
+ * Messages longer than ATECC_SHA_MAX_LENGTH are refused with EMSGSIZE;
+ * hash them on the host instead.
+ *
+ * @param client Connection
+ * @param data Region from atecc_client_reserve() holding the message, at least 32 bytes
+ * @param length Message length
+ * @param digest Receives the 32-byte digest, may be NULL to leave it in the ring only
+ * @return true on success, false otherwise
+ */
+bool atecc_client_sha256(atecc_client_t *client, uint8_t *data, size_t length, uint8_t *digest) {
+    // The region must also hold the digest written over its start
+    if (!client || !data || data < client->ring || data >= client->ring + client->ring_size ||
+        (length > SHA_DIGEST_BYTES ? length : SHA_DIGEST_BYTES) > (size_t)(client->ring + client->ring_size - data)) {
+        errno = EINVAL;
+        return false;
+    }
+    if (length > ATECC_SHA_MAX_LENGTH) {
+        errno = EMSGSIZE;
+        return false;
+    }
+
+    atecc_request_t req = { .op = ATECC_OP_SHA256, .offset = (uint64_t)(data - client->ring), .length = length };
+    atecc_reply_t reply;
+    if (!client_call(client, &req, &reply)) {
+        return false;
+    }
+    if (digest) {
+        memcpy(digest, data, SHA_DIGEST_BYTES);
+    }
+    return true;
+}
+
+/**
+ * @brief Change how long the daemon may hold this connection's requests to batch them
+ *
+ * Other connections keep their own policy. The daemon caps max_delay_us at
+ * its --max-delay-us.
+ *
+ * @param client Connection
+ * @param mode Batching mode
+ * @param max_delay_us Longest a request is held back
+ * @return true on success, false otherwise
+ */
+bool atecc_client_set_batch(atecc_client_t *client, atecc_batch_mode_t mode, uint64_t max_delay_us) {
+    atecc_request_t req = { .op = ATECC_OP_SET_BATCH, .length = max_delay_us, .key_slot = (uint8_t)mode };
+    atecc_reply_t reply;
+    return client_call(client, &req, &reply);
+}
+
+/**
+ * @brief Report client-side throughput for one delivery path
+ */
+static void client_bench_report(const char *label, size_t bytes, uint64_t start_us, uint8_t checksum) {
+    double elapsed_s = (double)(atecc_now_us() - start_us) / 1e6;
+    printf("📊 %-20s %8zu bytes  %8.3f s  %10.1f B/s  (checksum %02X)\n", label, bytes, elapsed_s,
+           (double)bytes / elapsed_s, checksum);
+}
+
+/**
+ * @brief Compare shared-ring and socket delivery of daemon results
+ *
+ * Usage: client-bench [--socket PATH] [--bytes N] [--slot S]
+ *
+ * Every result is read once on the client, as a consumer would.
+ *
+ * @return Process exit status
+ */
+int atecc_client_bench_main(int argc, char **argv) {
+    const char *path = NULL;
+    size_t bytes = BENCH_DEFAULT_BYTES;
+    int key_slot = -1;
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--socket") == 0 && has_value) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "--bytes") == 0 && has_value) {
+            bytes = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--slot") == 0 && has_value) {
+            key_slot = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: pi_atecc client-bench [--socket PATH] [--bytes N] [--slot S]\n");
+            return 2;
+        }
+    }
+
+    atecc_client_t client;
+    if (!atecc_client_open(&client, path)) {
+        return 1;
+    }
+
+    uint8_t *copy = malloc(BENCH_CHUNK);
+    if (!copy) {
+        atecc_client_close(&client);
+        return 1;
+    }
+
+    bool ok = true;
+    uint8_t checksum = 0;
+    uint64_t start = atecc_now_us();
+    for (size_t done = 0; ok && done < bytes; done += BENCH_CHUNK) {
+        size_t chunk = (bytes - done < BENCH_CHUNK) ? bytes - done : BENCH_CHUNK;
+        uint8_t *data = NULL;
+        ok = atecc_client_random(&client, chunk, &data);
+        for (size_t i = 0; ok && i < chunk; i++) {
+            checksum ^= data[i];
+        }
+    }
+    if (ok) {
+        client_bench_report("random (ring)", bytes, start, checksum);
+    }
+
+    checksum = 0;
+    start = atecc_now_us();
+    for (size_t done = 0; ok && done < bytes; done += BENCH_CHUNK) {
+        size_t chunk = (bytes - done < BENCH_CHUNK) ? bytes - done : BENCH_CHUNK;
+        ok = atecc_client_random_copy(&client, copy, chunk);
+        for (size_t i = 0; ok && i < chunk; i++) {
+            checksum ^= copy[i];
+        }
+    }
+    if (ok) {
+        client_bench_report("random (socket)", bytes, start, checksum);
+    }
+
+    if (ok && key_slot >= 0) {
+        uint8_t counter[16] = {0};
+        checksum = 0;
+        start = atecc_now_us();
+        for (size_t done = 0; ok && done < bytes; done += BENCH_CHUNK) {
+            size_t chunk = (bytes - done < BENCH_CHUNK) ? bytes - done : BENCH_CHUNK;
+            uint64_t first_block = done / 16U;
+            for (unsigned int k = 0; k < 8U; k++) {
+                counter[15U - k] = (uint8_t)(first_block >> (8U * k));
+            }
+            uint8_t *data = atecc_client_reserve(&client, chunk);
+            ok = data != NULL;
+            if (ok) {
+                memset(data, 0, chunk);
+                ok = atecc_client_aes_ctr(&client, (uint8_t)key_slot, counter, data, chunk);
+            }
+            for (size_t i = 0; ok && i < chunk; i++) {
+                checksum ^= data[i];
+            }
+        }
+        if (ok) {
+            client_bench_report("aes-ctr (ring)", bytes, start, checksum);
+        }
+    }
+
+    if (!ok) {
+        perror("client-bench: request failed");
+    }
+    free(copy);
+    atecc_client_close(&client);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief One load generator thread of batch-bench
+ */
+typedef struct {
+    atecc_client_t client;
+    pthread_t thread;
+    uint64_t start_us;      // Common start time
+    uint64_t end_us;        // Stop issuing requests after this
+    uint64_t interval_us;   // Time between this thread's requests
+    size_t bytes;           // Random bytes per request
+    uint32_t *latency_us;   // Completed request latencies
+    size_t capacity;
+    size_t done;
+    bool failed;
+} batch_load_t;
+
+/**
+ * @brief Issue paced Random requests until the run ends
+ *
+ * Send times follow a fixed schedule rather than the previous completion,
+ * so latency includes time spent queued behind a slow daemon.
+ */
+static void *batch_load_thread(void *arg) {
+    batch_load_t *load = arg;
+    uint64_t next_us = load->start_us;
+    while (next_us < load->end_us && load->done < load->capacity) {
+        uint64_t now = atecc_now_us();
+        if (now < next_us) {
+            usleep((useconds_t)(next_us - now));
+        }
+        uint8_t *data = NULL;
+        if (!atecc_client_random(&load->client, load->bytes, &data)) {
+            load->failed = true;
+            break;
+        }
+        load->latency_us[load->done++] = (uint32_t)(atecc_now_us() - next_us);
+        next_us += load->interval_us;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Issue back-to-back large Random requests, as a runaway consumer would
+ */
+static void *batch_abuse_thread(void *arg) {
+    batch_load_t *load = arg;
+    while (atecc_now_us() < load->end_us) {
+        uint8_t *data = NULL;
+        if (!atecc_client_random(&load->client, load->bytes, &data)) {
+            load->failed = true;
+            break;
+        }
+        load->done++;
+    }
+    return NULL;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sweep offered load and chart p99 latency against throughput
+ *
+ * Usage: batch-bench [--socket PATH] [--threads N] [--rates R1,R2,...] [--seconds S] [--bytes B]
+ *                    [--max-delay-us D] [--abuser BYTES]
+ *
+ * Runs each rate (requests per second over all threads) once with a fixed
+ * window and once with the adaptive window, set on every connection with
+ * the given maximum delay (capped by the daemon). --abuser adds one more
+ * connection issuing unpaced BYTES-sized Random requests; the latencies
+ * shown remain those of the paced clients.
+ *
+ * @return Process exit status
+ */
+int atecc_batch_bench_main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *rates_arg = "50,100,200,400,800";
+    size_t thread_count = 8;
+    double seconds = 3.0;
+    size_t bytes = 8;
+    uint64_t max_delay_us = 2000;
+    size_t abuser_bytes = 0;
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--socket") == 0 && has_value) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+            thread_count = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rates") == 0 && has_value) {
+            rates_arg = argv[++i];
+        } else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--bytes") == 0 && has_value) {
+            bytes = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-delay-us") == 0 && has_value) {
+            max_delay_us = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--abuser") == 0 && has_value) {
+            abuser_bytes = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: pi_atecc batch-bench [--socket PATH] [--threads N] [--rates R1,R2,...] "
+                            "[--seconds S] [--bytes B] [--max-delay-us D] [--abuser BYTES]\n");
+            return 2;
+        }
+    }
+    size_t abusers = abuser_bytes ? 1U : 0U;
+    if (thread_count == 0 || thread_count + abusers > BATCH_BENCH_MAX_THREADS || seconds <= 0.0 || bytes == 0) {
+        fprintf(stderr, "batch-bench: invalid arguments\n");
+        return 2;
+    }
+
+    batch_load_t *loads = calloc(thread_count + abusers, sizeof(*loads));
+    if (!loads) {
+        return 1;
+    }
+    size_t opened = 0;
+    while (opened < thread_count + abusers && atecc_client_open(&loads[opened].client, path)) {
+        opened++;
+    }
+    bool ok = (opened == thread_count + abusers);
+    batch_load_t *abuser = abusers ? &loads[thread_count] : NULL;
+
+    static const struct {
+        atecc_batch_mode_t mode;
+        const char *label;
+    } modes[] = { { ATECC_BATCH_FIXED, "fixed" }, { ATECC_BATCH_ADAPTIVE, "adaptive" } };
+
+    printf("%-9s %9s %11s %9s %9s  p99\n", "window", "offered/s", "achieved/s", "p50 ms", "p99 ms");
+    for (size_t m = 0; ok && m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for (size_t t = 0; ok && t < opened; t++) {
+            ok = atecc_client_set_batch(&loads[t].client, modes[m].mode, max_delay_us);
+        }
+        for (const char *rate_at = rates_arg; ok && *rate_at;) {
+            char *rate_end;
+            double rate = strtod(rate_at, &rate_end);
+            rate_at = (*rate_end == ',') ? rate_end + 1 : rate_end;
+            if (rate <= 0.0) {
+                continue;
+            }
+
+            uint64_t interval_us = (uint64_t)((double)thread_count * 1e6 / rate);
+            size_t capacity = (size_t)(seconds * 1e6 / (double)(interval_us ? interval_us : 1U)) + 1U;
+            uint64_t start = atecc_now_us() + 10000U;
+            size_t started = 0;
+            for (size_t t = 0; t < thread_count; t++) {
+                batch_load_t *load = &loads[t];
+                load->latency_us = malloc(capacity * sizeof(uint32_t));
+                if (!load->latency_us) {
+                    break;
+                }
+                // Stagger threads across the interval so the offered load is smooth
+                load->start_us = start + interval_us * t / thread_count;
+                load->end_us = start + (uint64_t)(seconds * 1e6);
+                load->interval_us = interval_us ? interval_us : 1U;
+                load->bytes = bytes;
+                load->capacity = capacity;
+                load->done = 0;
+                load->failed = false;
+                if (pthread_create(&load->thread, NULL, batch_load_thread, load) != 0) {
+                    free(load->latency_us);
+                    break;
+                }
+                started++;
+            }
+            bool abusing = false;
+            if (abuser && started == thread_count) {
+                abuser->end_us = start + (uint64_t)(seconds * 1e6);
+                abuser->bytes = abuser_bytes;
+                abuser->done = 0;
+                abuser->failed = false;
+                abusing = pthread_create(&abuser->thread, NULL, batch_abuse_thread, abuser) == 0;
+            }
+
+            size_t total = 0;
+            for (size_t t = 0; t < started; t++) {
+                pthread_join(loads[t].thread, NULL);
+                ok = ok && !loads[t].failed;
+                total += loads[t].done;
+            }
+            uint64_t elapsed_us = atecc_now_us() - start;
+            ok = ok && started == thread_count;
+            if (abusing) {
+                pthread_join(abuser->thread, NULL);
+                ok = ok && !abuser->failed;
+            } else if (abuser) {
+                ok = false;
+            }
+
+            uint32_t *all = ok && total ? malloc(total * sizeof(uint32_t)) : NULL;
+            if (all) {
+                size_t at = 0;
+                for (size_t t = 0; t < started; t++) {
+                    memcpy(&all[at], loads[t].latency_us, loads[t].done * sizeof(uint32_t));
+                    at += loads[t].done;
+                }
+                qsort(all, total, sizeof(uint32_t), compare_u32);
+                double p50_ms = all[total / 2U] / 1000.0;
+                double p99_ms = all[(total * 99U) / 100U] / 1000.0;
+                char bar[BATCH_BENCH_BAR + 1];
+                size_t bar_len = (size_t)(p99_ms * BATCH_BENCH_BAR / BATCH_BENCH_BAR_MS);
+                bar_len = bar_len > BATCH_BENCH_BAR ? BATCH_BENCH_BAR : bar_len;
+                memset(bar, '#', bar_len);
+                bar[bar_len] = '\0';
+                printf("%-9s %9.0f %11.1f %9.2f %9.2f  %s\n", modes[m].label, rate,
+                       (double)total * 1e6 / (double)elapsed_us, p50_ms, p99_ms, bar);
+                if (abuser) {
+                    printf("          abuser: %.1f B/s\n",
+                           (double)abuser->done * (double)abuser_bytes * 1e6 / (double)elapsed_us);
+                }
+            }
+            free(all);
+            for (size_t t = 0; t < started; t++) {
+                free(loads[t].latency_us);
+                loads[t].latency_us = NULL;
+            }
+        }
+    }
+
+    if (ok) {
+        printf("📊 p99 bar: one '#' per %.1f ms\n", (double)BATCH_BENCH_BAR_MS / BATCH_BENCH_BAR);
+    } else {
+        perror("batch-bench: request failed");
+    }
+    for (size_t t = 0; t < opened; t++) {
+        atecc_client_close(&loads[t].client);
+    }
+    free(loads);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Send periodic bursts and time the first request of each
+ *
+ * Usage: burst-bench [--socket PATH] [--period-ms P] [--bursts N] [--size K] [--jitter-ms J] [--bytes B]
+ *
+ * Every P ms, give or take up to J ms, K Random requests of B bytes go out
+ * back to back after the connection has sat idle. The first request of a
+ * burst pays for waking the devices unless the daemon woke them ahead of
+ * time (serve --prewake). Bursts before the daemon has seen the pattern
+ * (BURST_BENCH_LEARN) are reported apart from the rest.
+ *
+ * @return Process exit status
+ */
+int atecc_burst_bench_main(int argc, char **argv) {
+    const char *path = NULL;
+    uint64_t period_us = 5000000U;
+    size_t bursts = 10;
+    size_t size = 4;
+    uint64_t jitter_us = 0;
+    size_t bytes = 32;
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--socket") == 0 && has_value) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "--period-ms") == 0 && has_value) {
+            period_us = strtoull(argv[++i], NULL, 10) * 1000U;
+        } else if (strcmp(argv[i], "--bursts") == 0 && has_value) {
+            bursts = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && has_value) {
+            size = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--jitter-ms") == 0 && has_value) {
+            jitter_us = strtoull(argv[++i], NULL, 10) * 1000U;
+        } else if (strcmp(argv[i], "--bytes") == 0 && has_value) {
+            bytes = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: pi_atecc burst-bench [--socket PATH] [--period-ms P] [--bursts N] [--size K] "
+                            "[--jitter-ms J] [--bytes B]\n");
+            return 2;
+        }
+    }
+    if (bursts == 0 || size == 0 || bytes == 0 || jitter_us * 2U >= period_us) {
+        fprintf(stderr, "burst-bench: invalid arguments\n");
+        return 2;
+    }
+
+    atecc_client_t client;
+    if (!atecc_client_open(&client, path)) {
+        return 1;
+    }
+
+    bool ok = true;
+    unsigned int seed = (unsigned int)atecc_now_us();
+    uint64_t first_total_us[2] = {0};
+    uint64_t first_max_us[2] = {0};
+    size_t counted[2] = {0};
+    uint64_t start = atecc_now_us() + jitter_us;
+    printf("%-6s %12s %12s\n", "burst", "first ms", "burst ms");
+    for (size_t b = 0; ok && b < bursts; b++) {
+        uint64_t at = start + b * period_us;
+        if (jitter_us > 0) {
+            at = at - jitter_us + (uint64_t)rand_r(&seed) % (2U * jitter_us + 1U);
+        }
+        uint64_t now = atecc_now_us();
+        if (now < at) {
+            usleep((useconds_t)(at - now));
+        }
+
+        uint64_t sent = atecc_now_us();
+        uint64_t first_us = 0;
+        for (size_t k = 0; ok && k < size; k++) {
+            uint8_t *data = NULL;
+            ok = atecc_client_random(&client, bytes, &data);
+            if (k == 0) {
+                first_us = atecc_now_us() - sent;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+        uint64_t burst_us = atecc_now_us() - sent;
+        size_t phase = (b < BURST_BENCH_LEARN) ? 0U : 1U;
+        first_total_us[phase] += first_us;
+        first_max_us[phase] = (first_us > first_max_us[phase]) ? first_us : first_max_us[phase];
+        counted[phase]++;
+        printf("%-6zu %12.2f %12.2f\n", b + 1U, (double)first_us / 1000.0, (double)burst_us / 1000.0);
+        fflush(stdout);
+    }
+
+    if (ok) {
+        static const char *const phases[] = { "learning", "predictable" };
+        for (size_t p = 0; p < 2U; p++) {
+            if (counted[p] > 0) {
+                printf("📊 First request, %zu %s burst(s): avg %.2f ms, max %.2f ms\n", counted[p], phases[p],
+                       (double)first_total_us[p] / (double)counted[p] / 1000.0, (double)first_max_us[p] / 1000.0);
+            }
+        }
+    } else {
+        perror("burst-bench: request failed");
+    }
+    atecc_client_close(&client);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,354 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "pi_atecc.h"
+
+enum {
+    CTR_BLOCK_SIZE     = 16U,
+    CTR_CHUNK_BLOCKS   = 4U,        // Blocks claimed per worker grab
+    CTR_MAX_DEVICES    = ATECC_POOL_MAX,
+    CTR_SEGMENT_SIZE   = 65536U,    // Stream mode: bytes per pass over the pool
+    CTR_DEFAULT_BENCH  = 4096U
+};
+
+/**
+ * @brief Add a block offset to a 128-bit big-endian counter block
+ *
+ * @param counter 16-byte counter block, updated in place
+ * @param blocks Number of blocks to advance
+ */
+void atecc_ctr_add(uint8_t *counter, uint64_t blocks) {
+    for (int i = CTR_BLOCK_SIZE - 1; i >= 0 && blocks != 0; i--) {
+        uint64_t sum = (uint64_t)counter[i] + (blocks & 0xFFU);
+        counter[i] = (uint8_t)sum;
+        blocks = (blocks >> 8) + (sum >> 8);
+    }
+}
+
+/**
+ * @brief Work shared by the per-device workers of one atecc_aes_ctr() call
+ */
+typedef struct {
+    const uint8_t *counter;
+    const uint8_t *input;
+    uint8_t *output;
+    size_t length;
+    size_t block_count;
+    uint8_t key_slot;
+    atomic_size_t next_block;
+    atomic_bool failed;
+} ctr_job_t;
+
+typedef struct {
+    ctr_job_t *job;
+    atecc_dev_t *dev;
+} ctr_worker_t;
+
+/**
+ * @brief Claim chunks of counter blocks until none are left
+ *
+ * Each block's keystream is XORed straight into its own position of the
+ * output, so blocks complete in any order across devices and the result is
+ * already in stream order.
+ */
+static void *ctr_worker(void *arg) {
+    ctr_worker_t *worker = arg;
+    ctr_job_t *job = worker->job;
+
+    while (!atomic_load(&job->failed)) {
+        size_t first = atomic_fetch_add(&job->next_block, CTR_CHUNK_BLOCKS);
+        if (first >= job->block_count) {
+            break;
+        }
+        size_t last = first + CTR_CHUNK_BLOCKS;
+        if (last > job->block_count) {
+            last = job->block_count;
+        }
+
+        for (size_t block = first; block < last; block++) {
+            uint8_t counter[CTR_BLOCK_SIZE];
+            uint8_t keystream[CTR_BLOCK_SIZE];
+            memcpy(counter, job->counter, CTR_BLOCK_SIZE);
+            atecc_ctr_add(counter, block);
+
+            if (!aes_encrypt(worker->dev, counter, keystream, job->key_slot)) {
+                atomic_store(&job->failed, true);
+                break;
+            }
+
+            size_t offset = block * CTR_BLOCK_SIZE;
+            size_t bytes = job->length - offset;
+            if (bytes > CTR_BLOCK_SIZE) {
+                bytes = CTR_BLOCK_SIZE;
+            }
+            for (size_t i = 0; i < bytes; i++) {
+                job->output[offset + i] = job->input[offset + i] ^ keystream[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Thread entry for a spawned worker: take the device's real-time settings, then claim blocks
+ *
+ * mlockall() is process-wide and was already applied by whoever set
+ * dev->rt, so only the per-thread settings are repeated here.
+ */
+static void *ctr_thread(void *arg) {
+    ctr_worker_t *worker = arg;
+    if (worker->dev->rt) {
+        atecc_rt_opts_t opts = *worker->dev->rt;
+        opts.lock_memory = false;
+        atecc_rt_apply(&opts);
+    }
+    return ctr_worker(worker);
+}
+
+/**
+ * @brief AES-128-CTR over a pool of devices holding the same key in key_slot
+ *
+ * Counter blocks are handed out in small chunks to one worker thread per
+ * device; output is identical to running the whole range on a single device.
+ * The counter is the full 128-bit block, incremented big-endian.
+ *
+ * @param devs Devices with the key provisioned identically
+ * @param dev_count Number of devices
+ * @param key_slot Slot holding the AES key on every device
+ * @param counter Initial 16-byte counter block
+ * @param input Data to encrypt or decrypt
+ * @param output Result (may alias input)
+ * @param length Number of bytes
+ * @return true on success, false if any block failed
+ */
+bool atecc_aes_ctr(atecc_dev_t **devs, size_t dev_count, uint8_t key_slot, const uint8_t *counter,
+                   const uint8_t *input, uint8_t *output, size_t length) {
+    if (!devs || dev_count == 0 || dev_count > CTR_MAX_DEVICES || !counter || (length > 0 && (!input || !output))) {
+        errno = EINVAL;
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    ctr_job_t job = {
+        .counter = counter,
+        .input = input,
+        .output = output,
+        .length = length,
+        .block_count = (length + CTR_BLOCK_SIZE - 1U) / CTR_BLOCK_SIZE,
+        .key_slot = key_slot
+    };
+    atomic_init(&job.next_block, 0);
+    atomic_init(&job.failed, false);
+
+    ctr_worker_t workers[CTR_MAX_DEVICES];
+    pthread_t threads[CTR_MAX_DEVICES];
+    bool started[CTR_MAX_DEVICES] = {false};
+
+    for (size_t i = 0; i < dev_count; i++) {
+        workers[i].job = &job;
+        workers[i].dev = devs[i];
+        if (dev_count > 1U) {
+            started[i] = pthread_create(&threads[i], NULL, ctr_thread, &workers[i]) == 0;
+        }
+    }
+    if (dev_count == 1U || !started[0]) {
+        ctr_worker(&workers[0]);
+    }
+    for (size_t i = 0; i < dev_count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    // Workers that failed to start leave their share to the others; only
+    // an empty pool can leave blocks unclaimed.
+    if (!atomic_load(&job.failed) && atomic_load(&job.next_block) < job.block_count) {
+        ctr_worker(&workers[0]);
+    }
+    return !atomic_load(&job.failed);
+}
+
+/**
+ * @brief Encrypt zeros with 1..N devices, report throughput and check output equality
+ */
+static bool ctr_bench(atecc_pool_t *pool, uint8_t key_slot, const uint8_t *counter, size_t bytes) {
+    uint8_t *input = calloc(bytes, 1);
+    uint8_t *reference = malloc(bytes);
+    uint8_t *output = malloc(bytes);
+    if (!input || !reference || !output) {
+        free(input);
+        free(reference);
+        free(output);
+        return false;
+    }
+
+    bool ok = true;
+    double single_rate = 0.0;
+    for (size_t devices = 1; devices <= pool->count && ok; devices++) {
+        uint8_t *target = (devices == 1U) ? reference : output;
+        uint64_t start = atecc_now_us();
+        ok = atecc_aes_ctr(pool->members, devices, key_slot, counter, input, target, bytes);
+        double elapsed_s = (double)(atecc_now_us() - start) / 1e6;
+        double rate = (double)bytes / elapsed_s;
+        if (devices == 1U) {
+            single_rate = rate;
+        }
+
+        bool identical = (devices == 1U) || memcmp(reference, output, bytes) == 0;
+        printf("📊 %2zu device(s): %8.1f B/s  %5.2fx  %s\n", devices, rate,
+               single_rate > 0.0 ? rate / single_rate : 0.0,
+               ok ? (identical ? "output matches single-device" : "❌ OUTPUT MISMATCH") : "❌ failed");
+        ok = ok && identical;
+    }
+
+    free(input);
+    free(reference);
+    free(output);
+    return ok;
+}
+
+/**
+ * @brief Encrypt or decrypt a file or stdin through the stream pipeline
+ *
+ * Later segments are read while the pool works on the current one, and
+ * finished segments are written in the background.
+ */
+static bool ctr_stream(atecc_pool_t *pool, uint8_t key_slot, const uint8_t *counter, const char *in_path,
+                       const char *out_path, size_t depth, bool use_uring) {
+    int in_fd = in_path ? open(in_path, O_RDONLY | O_CLOEXEC) : STDIN_FILENO;
+    int out_fd = out_path ? open(out_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600) : STDOUT_FILENO;
+    atecc_stream_t stream;
+    if (in_fd < 0 || out_fd < 0 || !atecc_stream_open(&stream, in_fd, out_fd, CTR_SEGMENT_SIZE, depth, use_uring)) {
+        perror("aes-ctr");
+        if (in_fd > STDIN_FILENO) {
+            close(in_fd);
+        }
+        if (out_fd > STDOUT_FILENO) {
+            close(out_fd);
+        }
+        return false;
+    }
+
+    bool ok = true;
+    uint64_t start = atecc_now_us();
+    uint64_t blocks_done = 0;
+    uint8_t *segment;
+    size_t length = 0;
+    while (ok && (segment = atecc_stream_read(&stream, &length)) != NULL) {
+        // Segments are whole blocks except the last, so each segment's counter is exact
+        uint8_t segment_counter[CTR_BLOCK_SIZE];
+        memcpy(segment_counter, counter, CTR_BLOCK_SIZE);
+        atecc_ctr_add(segment_counter, blocks_done);
+        ok = atecc_aes_ctr(pool->members, pool->count, key_slot, segment_counter, segment, segment, length);
+        ok = atecc_stream_write(&stream, segment, ok ? length : 0U) && ok;
+        blocks_done += length / CTR_BLOCK_SIZE;
+    }
+    const char *backend = atecc_stream_backend(&stream);
+    ok = atecc_stream_close(&stream) && ok;
+    double elapsed_s = (double)(atecc_now_us() - start) / 1e6;
+    fprintf(stderr, "📊 aes-ctr: %llu bytes in %.3f s, %.1f B/s via %s, %.1f ms waiting on I/O\n",
+            (unsigned long long)stream.bytes_in, elapsed_s, elapsed_s > 0.0 ? (double)stream.bytes_in / elapsed_s : 0.0,
+            backend, (double)stream.wait_us / 1000.0);
+    if (!ok) {
+        perror("aes-ctr: stream failed");
+    }
+    if (in_fd > STDIN_FILENO) {
+        close(in_fd);
+    }
+    if (out_fd > STDOUT_FILENO) {
+        close(out_fd);
+    }
+    return ok;
+}
+
+static void aes_ctr_usage(void) {
+    fprintf(stderr, "usage: pi_atecc aes-ctr <slot> <32-hex-digit counter> [--bench BYTES] [--in FILE] "
+                    "[--out FILE] [--depth N] [--no-uring] [--cpu C] [--fifo PRIO | --deadline] [--mlock] "
+                    "[device...]\n");
+}
+
+/**
+ * @brief AES-CTR over stdin/stdout or files using every device in the pool
+ *
+ * Usage: aes-ctr <slot> <counter-hex> [--bench BYTES] [--in FILE] [--out FILE] [--depth N] [--no-uring]
+ *                [--cpu C] [--fifo PRIO | --deadline] [--mlock] [device...]
+ *
+ * Without device arguments every discovered device is used. The real-time
+ * options (see atecc_rt_apply()) apply to the main thread and every worker.
+ *
+ * @return Process exit status
+ */
+int atecc_aes_ctr_main(int argc, char **argv) {
+    if (argc < 2 || strlen(argv[1]) != 2U * CTR_BLOCK_SIZE) {
+        aes_ctr_usage();
+        return 2;
+    }
+
+    uint8_t key_slot = (uint8_t)strtoul(argv[0], NULL, 0);
+    uint8_t counter[CTR_BLOCK_SIZE];
+    if (!atecc_hex_decode(argv[1], CTR_BLOCK_SIZE, counter)) {
+        fprintf(stderr, "aes-ctr: counter must be 32 hex digits\n");
+        return 2;
+    }
+
+    size_t bench_bytes = 0;
+    const char *in_path = NULL;
+    const char *out_path = NULL;
+    size_t depth = 0;
+    bool use_uring = true;
+    atecc_rt_opts_t rt = { .cpu = -1, .policy = ATECC_RT_NONE };
+    const char *specs[CTR_MAX_DEVICES];
+    size_t spec_count = 0;
+    for (int i = 2; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--bench") == 0) {
+            bench_bytes = has_value ? strtoul(argv[++i], NULL, 10) : CTR_DEFAULT_BENCH;
+        } else if (strcmp(argv[i], "--in") == 0 && has_value) {
+            in_path = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && has_value) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--depth") == 0 && has_value) {
+            depth = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--no-uring") == 0) {
+            use_uring = false;
+        } else if (atecc_rt_parse_arg(argc, argv, &i, &rt)) {
+            // --cpu, --fifo, --deadline and --mlock, consumed into rt
+        } else if (argv[i][0] != '-' && spec_count < CTR_MAX_DEVICES) {
+            specs[spec_count++] = argv[i];
+        } else {
+            aes_ctr_usage();
+            return 2;
+        }
+    }
+
+    atecc_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool || !atecc_pool_open(pool, specs, spec_count)) {
+        fprintf(stderr, "aes-ctr: no devices available\n");
+        free(pool);
+        return 1;
+    }
+    if (atecc_rt_requested(&rt)) {
+        atecc_rt_apply_pool(&rt, pool);
+    }
+
+    bool ok = true;
+    if (bench_bytes > 0) {
+        ok = ctr_bench(pool, key_slot, counter, bench_bytes);
+    } else {
+        ok = ctr_stream(pool, key_slot, counter, in_path, out_path, depth, use_uring);
+    }
+
+    atecc_pool_close(pool);
+    free(pool);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,1597 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <time.h>
+#include "pi_atecc.h"
+
+enum {
+    DAEMON_VERSION     = 1U,
+    DAEMON_MAX_CLIENTS = ATECC_STATUS_CLIENT_MAX,
+    DAEMON_BACKLOG     = 8,
+    RANDOM_BLOCK_SIZE  = 32U,
+    SHA_BLOCK_SIZE     = 64U,
+    SHA_COMMAND_US     = 6000U,     // One SHA Start/Update/End command including its delay
+    SHA_DIGEST_SIZE    = 32U,
+    RANDOM_COMMAND_US  = 50000U,    // One Random command including its delay (atecc_random())
+    AES_BLOCK_SIZE     = 16U,
+    AES_BLOCK_US       = 5000U,     // One AES block (aes_encrypt())
+    BATCH_DEFAULT_US   = 2000U,     // Default maximum batching delay
+    BATCH_MAX_US       = 1000000U,  // Largest --max-delay-us
+    DRR_QUANTUM_US     = RANDOM_COMMAND_US, // Default device time credited per client and round
+    QUOTA_BURST_US     = 1000000U,  // Default token bucket depth
+    EWMA_SHIFT         = 3U,        // EWMA weight 1/8
+    SELFTEST_COUNT     = 5U,        // Algorithms SelfTest covers, one slice each
+    IDLE_GAPS          = 64U,       // Recent idle gaps kept to predict the next one
+    IDLE_MIN_GAPS      = 8U,        // Comparable gaps needed before trusting the history
+    IDLE_CONFIDENCE    = 90U,       // Percent of comparable gaps that must outlast a slice
+    IDLE_MARGIN        = 2U,        // Idle time needed without history, in slice durations
+    BURST_HISTORY      = 16U,       // Recent burst starts kept for the periodic detector
+    BURST_TOLERANCE_US = 50000U,    // Least jitter allowed between periodic bursts
+    PREWAKE_LEAD_US    = 5000U,     // Default time a pre-wake leads the predicted burst by
+    PREWAKE_MAX_MISSES = 3U,        // Consecutive spurious pre-wakes before predictions stop
+    PREWAKE_SPURIOUS   = 6U,        // Default spurious pre-wakes allowed per hour
+    PREWAKE_HOUR_S     = 3600U,     // Window of the spurious pre-wake cap
+    STANDBY_REWAKE_US  = 50000U,    // A standby is woken again this long before its awake window ends
+    CONFIG_SLOT_CONFIG = 20U,       // SlotConfig[16], 2 bytes each
+    CONFIG_KEY_CONFIG  = 96U,       // KeyConfig[16], 2 bytes each
+    CONFIG_AES_ENABLE  = 13U,       // Bit 0: AES command enabled
+    KEY_TYPE_P256      = 4U,
+    KEY_TYPE_AES       = 6U,
+    PUBLIC_KEY_SIZE    = 64U
+};
+
+// Shortest first, so tests due at the same time start with the cheap slices
+static const uint8_t selftest_order[SELFTEST_COUNT] = {
+    ATECC_SELFTEST_RNG, ATECC_SELFTEST_SHA, ATECC_SELFTEST_AES, ATECC_SELFTEST_ECDH, ATECC_SELFTEST_ECDSA
+};
+
+/**
+ * @brief One connected client and its shared result ring
+ */
+typedef struct {
+    int fd;                 // Control socket
+    int ring_fd;            // memfd backing the ring
+    uint8_t *ring;          // Daemon-side mapping of the ring
+    size_t ring_size;       // Ring size
+    bool queued;            // Has a request waiting in the batch queue
+    bool dead;              // Reply failed; drop after the current batch
+    pid_t pid;              // Peer process, for the status page
+    atecc_batch_mode_t batch_mode;  // How long this client's requests may be held (see batch_window())
+    uint64_t max_delay_us;  // At most the daemon's --max-delay-us
+
+    // Accounting, in device microseconds from the execution model (see request_share())
+    int64_t tokens_us;      // Token bucket level, negative while in debt
+    uint64_t refilled_us;   // Last bucket refill
+    uint64_t deficit_us;    // Deficit round robin credit
+    uint64_t device_us;     // Device time charged
+    uint64_t served;        // Requests completed
+    uint64_t throttled;     // Rounds sat out for lack of tokens
+} serve_client_t;
+
+/**
+ * @brief Random bytes drawn from one device in whole 32-byte calls
+ *
+ * Bytes left over from one request's last block serve the next request,
+ * also across batches, so small requests cost ceil(total / 32) calls.
+ */
+typedef struct {
+    atecc_dev_t *dev;
+    uint8_t block[RANDOM_BLOCK_SIZE];
+    size_t left;            // Unused bytes at the end of block
+    unsigned long calls;    // Random commands issued
+} random_stream_t;
+
+/**
+ * @brief Request waiting for the next batch
+ */
+typedef struct {
+    size_t client;          // Index into serve_state_t.clients
+    atecc_request_t req;
+    uint64_t done;          // Bytes served in earlier rounds
+    uint8_t *payload;       // Inline Random result being assembled
+    bool held;              // Sitting out this round for lack of tokens
+    bool finished;          // Answered this round
+    bool burst_first;       // First request of a burst, timed for the pre-wake report
+    bool prewoken;          // Its burst found the devices pre-woken
+    uint64_t arrived_us;    // Arrival, for burst_first requests
+} serve_pending_t;
+
+/**
+ * @brief Count, total and maximum of a latency: burst first requests, failover detection and recovery
+ */
+typedef struct {
+    unsigned long count;
+    uint64_t total_us;
+    uint64_t max_us;
+} burst_latency_t;
+
+/**
+ * @brief Daemon state
+ */
+typedef struct {
+    atecc_pool_t *pool;
+    int listen_fd;
+    serve_client_t clients[DAEMON_MAX_CLIENTS];
+    size_t client_count;
+    size_t next_device;     // Round-robin position for single-device operations
+    atecc_status_page_t *status;    // Published identity and health page
+    uint64_t requests;      // Requests served
+
+    // Batching: clients have at most one request outstanding, so the queue never exceeds the client table
+    serve_pending_t queue[DAEMON_MAX_CLIENTS];
+    size_t queued;
+    atecc_batch_mode_t batch_mode;  // Policy new clients start with
+    uint64_t max_delay_us;  // Upper bound on how long a request is held back, for every client
+    uint64_t deadline_us;   // When the current batch is dispatched at the latest
+    uint64_t last_arrival_us;
+    uint64_t gap_us;        // EWMA of the time between arrivals
+    uint64_t service_us;    // EWMA of device time per request
+    bool batch_open;        // Runnable requests are waiting for deadline_us
+    unsigned long batches;  // Rounds dispatched
+    random_stream_t random; // Shared by all Random requests
+
+    // Fairness: a deficit round robin over clients, each behind its own token bucket
+    uint64_t quota_us;      // Device microseconds per second each client may use, 0 for no quota
+    uint64_t burst_us;      // Token bucket depth
+    uint64_t quantum_us;    // Credit per client and round
+    size_t round;           // Rotates the service order between rounds
+    uint64_t wake_us;       // When a client held by its quota can run again, 0 if none is held
+
+    // Idle-time SelfTest: one algorithm on one device per slice (see selftest_plan())
+    uint64_t selftest_interval_us;  // Every test runs on every device once per interval, 0 to disable
+    uint64_t selftest_last_us[ATECC_POOL_MAX][SELFTEST_COUNT];   // Last run of each test, 0 if never
+    uint64_t selftest_start_us;     // Tests never run are due from here
+    uint64_t idle_since_us;         // End of the last round
+    uint64_t idle_gaps[IDLE_GAPS];  // Recent idle gaps: empty queue to the next arrival
+    size_t idle_gap_count;
+    size_t idle_gap_next;
+    bool selftest_due;              // The plan below names a due test
+    bool selftest_waiting;          // It is waiting for an idle gap
+    bool selftest_forced;           // It is overdue and runs at the next empty queue
+    size_t selftest_device;         // Planned device
+    size_t selftest_test;           // Planned test, index into selftest_order
+    atecc_status_selftest_t selftest;
+
+    // Predictive pre-wake: bursts that follow a periodic pattern find the devices awake (see prewake_plan())
+    bool prewake;                   // Predictions enabled
+    uint64_t prewake_lead_us;       // Wake this long before the earliest expected start
+    unsigned int prewake_spurious_max;  // Spurious pre-wakes allowed per hour
+    uint64_t bursts[BURST_HISTORY]; // Recent burst starts, oldest first
+    size_t burst_count;
+    uint64_t prewake_at_us;         // Next planned pre-wake, 0 if none
+    uint64_t prewake_target_us;     // Burst start it anticipates
+    uint64_t prewoke_us;            // Last pre-wake not yet matched by a burst, 0 if none
+    unsigned int prewake_misses;    // Consecutive pre-wakes no burst followed
+    uint64_t spurious_hour_us;      // Start of the current spurious-wake accounting hour
+    unsigned int spurious_in_hour;
+    unsigned long prewakes;         // Pre-wakes issued
+    unsigned long spurious;         // Pre-wakes no burst followed
+    burst_latency_t warm;           // Bursts that found the devices pre-woken
+    burst_latency_t cold;           // Bursts that paid the wake themselves
+
+    // Hot standby: spare devices kept awake and warm to replace a failed active device (see serve_failover())
+    atecc_dev_t *active[ATECC_POOL_MAX];    // Devices requests run on
+    size_t active_count;
+    atecc_dev_t *standby[ATECC_POOL_MAX];   // Spares, promoted in order
+    size_t standby_count;
+    unsigned long failovers;        // Standbys promoted
+    unsigned long lost;             // Device requests answered with an error
+    burst_latency_t detect;         // Piece start to the failure being reported
+    burst_latency_t recover;        // Failure to the retried piece completing on the standby
+} serve_state_t;
+
+static volatile sig_atomic_t serve_stop;
+
+static void serve_signal(int signo) {
+    (void)signo;
+    serve_stop = 1;
+}
+
+/**
+ * @brief Default control socket path: $XDG_RUNTIME_DIR/pi_atecc.sock, else /tmp/pi_atecc.sock
+ *
+ * @return Socket path (static storage)
+ */
+const char *atecc_socket_path(void) {
+    static char path[sizeof(((struct sockaddr_un *)NULL)->sun_path)];
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+
+    if (runtime && runtime[0] != '\0' &&
+        (size_t)snprintf(path, sizeof(path), "%s/pi_atecc.sock", runtime) < sizeof(path)) {
+        return path;
+    }
+    return "/tmp/pi_atecc.sock";
+}
+
+/**
+ * @brief Read exactly len bytes from a descriptor
+ *
+ * @return true on success, false on error or end of file (errno ECONNRESET)
+ */
+bool atecc_read_full(int fd, void *buf, size_t len) {
+    uint8_t *bytes = buf;
+    while (len > 0) {
+        ssize_t received = read(fd, bytes, len);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            if (received == 0) {
+                errno = ECONNRESET;
+            }
+            return false;
+        }
+        bytes += received;
+        len -= (size_t)received;
+    }
+    return true;
+}
+
+/**
+ * @brief Write exactly len bytes to a socket, without raising SIGPIPE
+ *
+ * @return true on success, false otherwise
+ */
+bool atecc_write_full(int fd, const void *buf, size_t len) {
+    const uint8_t *bytes = buf;
+    while (len > 0) {
+        ssize_t sent = send(fd, bytes, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        len -= (size_t)sent;
+    }
+    return true;
+}
+
+/**
+ * @brief Create a client's memfd ring and send it with the greeting
+ *
+ * The ring is sealed against resizing so a client cannot truncate it under
+ * the daemon's mapping.
+ */
+static bool client_attach(serve_client_t *client, int fd) {
+    memset(client, 0, sizeof(*client));
+    client->fd = fd;
+    client->ring_size = ATECC_RING_SIZE;
+    client->ring_fd = memfd_create("pi_atecc-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (client->ring_fd < 0) {
+        perror("serve: memfd_create failed");
+        return false;
+    }
+    if (ftruncate(client->ring_fd, (off_t)client->ring_size) < 0 ||
+        fcntl(client->ring_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+        perror("serve: ring setup failed");
+        close(client->ring_fd);
+        return false;
+    }
+    client->ring = mmap(NULL, client->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, client->ring_fd, 0);
+    if (client->ring == MAP_FAILED) {
+        perror("serve: ring mmap failed");
+        close(client->ring_fd);
+        return false;
+    }
+
+    atecc_hello_t hello = { .magic = ATECC_DAEMON_MAGIC, .version = DAEMON_VERSION, .ring_size = client->ring_size };
+    struct iovec iov = { .iov_base = &hello, .iov_len = sizeof(hello) };
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.space,
+        .msg_controllen = sizeof(control.space)
+    };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &client->ring_fd, sizeof(int));
+
+    if (sendmsg(fd, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(hello)) {
+        perror("serve: greeting failed");
+        munmap(client->ring, client->ring_size);
+        close(client->ring_fd);
+        return false;
+    }
+    return true;
+}
+
+static void client_detach(serve_client_t *client) {
+    munmap(client->ring, client->ring_size);
+    close(client->ring_fd);
+    close(client->fd);
+}
+
+/**
+ * @brief Fill dst from the stream
+ *
+ * Whole blocks are received straight into dst when no leftover bytes are
+ * pending, so the only copy is the one out of the response frame.
+ */
+static bool random_fill(random_stream_t *stream, uint8_t *dst, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        if (stream->left > 0) {
+            size_t take = (length - done < stream->left) ? length - done : stream->left;
+            uint8_t *from = &stream->block[RANDOM_BLOCK_SIZE - stream->left];
+            memcpy(&dst[done], from, take);
+            memset(from, 0, take);
+            stream->left -= take;
+            done += take;
+        } else if (length - done >= RANDOM_BLOCK_SIZE) {
+            if (!atecc_random(stream->dev, &dst[done])) {
+                return false;
+            }
+            stream->calls++;
+            done += RANDOM_BLOCK_SIZE;
+        } else {
+            if (!atecc_random(stream->dev, stream->block)) {
+                return false;
+            }
+            stream->calls++;
+            stream->left = RANDOM_BLOCK_SIZE;
+        }
+    }
+    return true;
+}
+
+// The longest accepted SHA job must finish inside one awake window (see request_valid())
+_Static_assert((ATECC_SHA_MAX_LENGTH / SHA_BLOCK_SIZE + 2U) * SHA_COMMAND_US <= ATECC_AWAKE_WINDOW_US,
+               "ATECC_SHA_MAX_LENGTH does not fit one awake window");
+
+/**
+ * @brief Device SHA-256 of a ring region, keeping jobs of a batch in one awake period
+ */
+static bool serve_sha256(atecc_dev_t *dev, uint8_t *data, size_t length) {
+    uint64_t needed_us = (uint64_t)(length / SHA_BLOCK_SIZE + 2U) * SHA_COMMAND_US;
+    uint8_t digest[SHA_DIGEST_SIZE];
+    if (!atecc_keep_awake(dev, needed_us) || !atecc_sha256(dev, data, length, digest)) {
+        return false;
+    }
+    memcpy(data, digest, sizeof(digest));
+    return true;
+}
+
+/**
+ * @brief Check a request's ring region before queueing it
+ *
+ * SHA jobs are limited to ATECC_SHA_MAX_LENGTH: the device loses its SHA
+ * state when the watchdog expires, and atecc_keep_awake() cannot stretch
+ * one job over more than a single awake window.
+ */
+static bool request_valid(const serve_client_t *client, const atecc_request_t *req) {
+    if (req->op == ATECC_OP_SHA256 && req->length > ATECC_SHA_MAX_LENGTH) {
+        fprintf(stderr, "serve: refusing %llu-byte SHA-256 job, the device hashes at most %u bytes per wake\n",
+                (unsigned long long)req->length, ATECC_SHA_MAX_LENGTH);
+        errno = EMSGSIZE;
+        return false;
+    }
+    bool in_ring = (req->op == ATECC_OP_RANDOM || req->op == ATECC_OP_AES_CTR || req->op == ATECC_OP_SHA256);
+    uint64_t extent = (req->op == ATECC_OP_SHA256 && req->length < SHA_DIGEST_SIZE) ? SHA_DIGEST_SIZE : req->length;
+
+    if ((in_ring && (req->offset > client->ring_size || extent > client->ring_size - req->offset)) ||
+        (req->op == ATECC_OP_RANDOM_INLINE && req->length > client->ring_size)) {
+        errno = ERANGE;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Part of a request that a client's credit pays for
+ *
+ * This is the execution model all accounting uses: Random is charged per
+ * byte at the cost of a 32-byte call, AES-CTR per 16-byte block and
+ * SHA-256 per command. Random and AES-CTR are served in pieces; SHA-256
+ * only as a whole, once enough credit has built up.
+ *
+ * @param pending Request
+ * @param budget_us Device time the client may spend now
+ * @param bytes Receives the bytes to serve
+ * @param cost_us Receives their device time
+ * @return true if the request can make progress
+ */
+static bool request_share(const serve_pending_t *pending, uint64_t budget_us, uint64_t *bytes, uint64_t *cost_us) {
+    uint64_t remaining = pending->req.length - pending->done;
+    uint64_t share;
+
+    switch (pending->req.op) {
+    case ATECC_OP_RANDOM:
+    case ATECC_OP_RANDOM_INLINE:
+        share = budget_us * RANDOM_BLOCK_SIZE / RANDOM_COMMAND_US;
+        *bytes = (share < remaining) ? share : remaining;
+        *cost_us = (*bytes * RANDOM_COMMAND_US + RANDOM_BLOCK_SIZE - 1U) / RANDOM_BLOCK_SIZE;
+        return *bytes > 0 || remaining == 0;
+    case ATECC_OP_AES_CTR:
+        share = budget_us / AES_BLOCK_US * AES_BLOCK_SIZE;
+        *bytes = (share < remaining) ? share : remaining;
+        *cost_us = (*bytes + AES_BLOCK_SIZE - 1U) / AES_BLOCK_SIZE * AES_BLOCK_US;
+        return *bytes > 0 || remaining == 0;
+    case ATECC_OP_SHA256:
+        *bytes = remaining;
+        *cost_us = (remaining / SHA_BLOCK_SIZE + 2U) * SHA_COMMAND_US;
+        return *cost_us <= budget_us;
+    default:
+        *bytes = remaining;
+        *cost_us = 0;
+        return true;
+    }
+}
+
+/**
+ * @brief Run the next bytes of a request
+ */
+static bool serve_piece(serve_state_t *state, serve_client_t *client, serve_pending_t *pending, uint64_t bytes) {
+    const atecc_request_t *req = &pending->req;
+    uint64_t at = req->offset + pending->done;
+
+    switch (req->op) {
+    case ATECC_OP_RANDOM:
+        return random_fill(&state->random, &client->ring[at], bytes);
+    case ATECC_OP_RANDOM_INLINE:
+        if (!pending->payload) {
+            pending->payload = malloc(req->length ? req->length : 1U);
+            if (!pending->payload) {
+                return false;
+            }
+        }
+        return random_fill(&state->random, &pending->payload[pending->done], bytes);
+    case ATECC_OP_AES_CTR: {
+        uint8_t counter[sizeof(req->counter)];
+        memcpy(counter, req->counter, sizeof(counter));
+        atecc_ctr_add(counter, pending->done / AES_BLOCK_SIZE);
+        return atecc_aes_ctr(state->active, state->active_count, req->key_slot, counter, &client->ring[at],
+                             &client->ring[at], bytes);
+    }
+    case ATECC_OP_SHA256:
+        return serve_sha256(state->random.dev, &client->ring[req->offset], req->length);
+    case ATECC_OP_SET_BATCH:
+        // Only the caller's own requests follow it, and never longer than the operator allows
+        if (req->key_slot > ATECC_BATCH_ADAPTIVE) {
+            errno = EINVAL;
+            return false;
+        }
+        client->batch_mode = (atecc_batch_mode_t)req->key_slot;
+        client->max_delay_us = (req->length < state->max_delay_us) ? req->length : state->max_delay_us;
+        return true;
+    default:
+        errno = EINVAL;
+        return false;
+    }
+}
+
+static void burst_latency_add(burst_latency_t *latency, uint64_t us) {
+    latency->count++;
+    latency->total_us += us;
+    if (us > latency->max_us) {
+        latency->max_us = us;
+    }
+}
+
+/**
+ * @brief Whether a request runs on the devices, as opposed to changing daemon settings
+ */
+static bool device_op(uint32_t op) {
+    return op == ATECC_OP_RANDOM || op == ATECC_OP_RANDOM_INLINE || op == ATECC_OP_AES_CTR || op == ATECC_OP_SHA256;
+}
+
+/**
+ * @brief Replace every active device whose failure count rose since the snapshot with the next standby
+ *
+ * @param state Daemon state
+ * @param failures Failure counts of the active devices before the piece ran
+ * @return true if at least one device was replaced
+ */
+static bool standby_promote(serve_state_t *state, const unsigned long *failures) {
+    bool promoted = false;
+    for (size_t i = 0; i < state->active_count && state->standby_count > 0; i++) {
+        atecc_dev_t *failed = state->active[i];
+        if (failed->failures == failures[i]) {
+            continue;
+        }
+        atecc_dev_t *spare = state->standby[0];
+        state->standby_count--;
+        memmove(state->standby, &state->standby[1], state->standby_count * sizeof(state->standby[0]));
+        state->active[i] = spare;
+        if (state->random.dev == failed) {
+            state->random.dev = spare;
+        }
+        state->failovers++;
+        promoted = true;
+        fprintf(stderr, "⚠️ serve: %s:0x%02X failed, promoted standby %s:0x%02X (%zu left)\n", failed->bus,
+                failed->address, spare->bus, spare->address, state->standby_count);
+    }
+    return promoted;
+}
+
+/**
+ * @brief Run a piece, re-running it on a standby when an active device fails under it
+ *
+ * The standby is already awake with its config and timing profile loaded,
+ * so the retry costs the piece itself and no wake. AES-CTR works in place,
+ * so its input is kept until the piece has succeeded.
+ */
+static bool serve_failover(serve_state_t *state, serve_client_t *client, serve_pending_t *pending, uint64_t bytes) {
+    uint32_t op = pending->req.op;
+    if (state->standby_count == 0 || !device_op(op)) {
+        return serve_piece(state, client, pending, bytes);
+    }
+
+    uint8_t *data = NULL;
+    uint8_t *saved = NULL;
+    if (op == ATECC_OP_AES_CTR) {
+        data = &client->ring[pending->req.offset + pending->done];
+        if (!(saved = malloc(bytes ? bytes : 1U))) {
+            return serve_piece(state, client, pending, bytes);
+        }
+        memcpy(saved, data, bytes);
+    }
+
+    unsigned long failures[ATECC_POOL_MAX];
+    uint64_t start = atecc_now_us();
+    uint64_t failed_us = 0;
+    bool ok;
+    for (;;) {
+        for (size_t i = 0; i < state->active_count; i++) {
+            failures[i] = state->active[i]->failures;
+        }
+        ok = serve_piece(state, client, pending, bytes);
+        uint64_t now = atecc_now_us();
+        if (ok || !standby_promote(state, failures)) {
+            if (ok && failed_us != 0) {
+                burst_latency_add(&state->recover, now - failed_us);
+            }
+            break;
+        }
+        burst_latency_add(&state->detect, now - start);
+        start = now;
+        if (failed_us == 0) {
+            failed_us = now;
+        }
+        if (saved) {
+            memcpy(data, saved, bytes);
+        }
+    }
+    free(saved);
+    return ok;
+}
+
+/**
+ * @brief Answer a request, with errno as the status when it failed
+ *
+ * @return false if the client connection should be dropped
+ */
+static bool serve_reply(serve_client_t *client, const serve_pending_t *pending, bool ok) {
+    const atecc_request_t *req = &pending->req;
+    atecc_reply_t reply = { .id = req->id, .offset = req->offset, .length = req->length };
+    reply.status = ok ? 0 : (errno ? errno : EIO);
+    if (!ok) {
+        reply.length = 0;
+    } else if (req->op == ATECC_OP_SHA256) {
+        reply.length = SHA_DIGEST_SIZE;
+    }
+
+    bool sent = atecc_write_full(client->fd, &reply, sizeof(reply));
+    if (sent && ok && req->op == ATECC_OP_RANDOM_INLINE) {
+        sent = atecc_write_full(client->fd, pending->payload, req->length);
+    }
+    return sent;
+}
+
+/**
+ * @brief Order in which a batch runs its requests
+ *
+ * Random requests go first and share one stream; SHA jobs follow back to
+ * back on the same device; everything else runs last.
+ */
+static unsigned int batch_pass(uint32_t op) {
+    switch (op) {
+    case ATECC_OP_RANDOM:
+    case ATECC_OP_RANDOM_INLINE:
+        return 0;
+    case ATECC_OP_SHA256:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+/**
+ * @brief Drop a client, keeping queue entries pointed at the right table slots
+ */
+static void remove_client(serve_state_t *state, size_t index) {
+    client_detach(&state->clients[index]);
+    size_t last = --state->client_count;
+    state->clients[index] = state->clients[last];
+    for (size_t i = 0; i < state->queued; i++) {
+        if (state->queue[i].client == last) {
+            state->queue[i].client = index;
+        }
+    }
+}
+
+/**
+ * @brief How long a client's request may be held for the batch
+ *
+ * Adaptive mode scales the client's maximum delay by the device's
+ * utilization (per-request service time over inter-arrival time): below
+ * one eighth there is no wait at all, and at saturation the full delay
+ * applies. The delay is at most BATCH_MAX_US, so deadlines cannot overflow.
+ */
+static uint64_t batch_window(const serve_state_t *state, const serve_client_t *client) {
+    switch (client->batch_mode) {
+    case ATECC_BATCH_FIXED:
+        return client->max_delay_us;
+    case ATECC_BATCH_ADAPTIVE:
+        if (state->gap_us == 0 || state->service_us * 8U < state->gap_us) {
+            return 0;
+        }
+        if (state->service_us >= state->gap_us) {
+            return client->max_delay_us;
+        }
+        return client->max_delay_us * state->service_us / state->gap_us;
+    default:
+        return 0;
+    }
+}
+
+static void ewma_update(uint64_t *average, uint64_t sample) {
+    *average = (*average == 0) ? sample : *average - (*average >> EWMA_SHIFT) + (sample >> EWMA_SHIFT);
+}
+
+/**
+ * @brief Predict the next periodic burst and plan the pre-wake for it
+ *
+ * A burst start t_j extends a periodic pattern when an earlier start t_i
+ * and one before that, t_k, are spaced by the same period P within a
+ * tolerance (the larger of BURST_TOLERANCE_US and 2% of P). Such a
+ * pattern predicts the next start at t_j + P. Several interleaved
+ * patterns (an hourly job and a per-minute one) are tracked at once, and
+ * the earliest prediction still ahead wins. The pre-wake leads it by the
+ * tolerance plus prewake_lead_us.
+ *
+ * No pre-wake is planned after PREWAKE_MAX_MISSES spurious pre-wakes in
+ * a row, until a burst arrives, or once the hourly spurious cap is spent.
+ */
+static void prewake_plan(serve_state_t *state, uint64_t now) {
+    state->prewake_at_us = 0;
+    bool capped = now - state->spurious_hour_us < PREWAKE_HOUR_S * 1000000ULL &&
+                  state->spurious_in_hour >= state->prewake_spurious_max;
+    if (!state->prewake || state->prewake_misses >= PREWAKE_MAX_MISSES || capped) {
+        return;
+    }
+
+    const uint64_t *t = state->bursts;
+    size_t n = state->burst_count;
+    uint64_t best_target = 0;
+    uint64_t best_tolerance = 0;
+    for (size_t j = 2; j < n; j++) {
+        for (size_t i = 1; i < j; i++) {
+            uint64_t period = t[j] - t[i];
+            uint64_t tolerance = (period / 50U > BURST_TOLERANCE_US) ? period / 50U : BURST_TOLERANCE_US;
+            if (period < ATECC_AWAKE_WINDOW_US) {
+                continue;
+            }
+            bool confirmed = false;
+            for (size_t k = 0; k < i && !confirmed; k++) {
+                uint64_t earlier = t[i] - t[k];
+                confirmed = (earlier > period ? earlier - period : period - earlier) <= tolerance;
+            }
+            // Skip to the latest start of the pattern; a miss moves the target on by a period
+            uint64_t target = t[j] + period;
+            while (confirmed && target + tolerance <= now) {
+                target += period;
+            }
+            if (confirmed && target > state->prewake_target_us + tolerance &&
+                (best_target == 0 || target < best_target)) {
+                best_target = target;
+                best_tolerance = tolerance;
+            }
+        }
+    }
+    if (best_target != 0) {
+        uint64_t lead = best_tolerance + state->prewake_lead_us;
+        state->prewake_target_us = best_target;
+        state->prewake_at_us = (best_target > now + lead) ? best_target - lead : now;
+    }
+}
+
+/**
+ * @brief Close out a pre-wake that no burst followed within the awake window
+ */
+static void prewake_expire(serve_state_t *state, uint64_t now) {
+    if (state->prewoke_us == 0 || now - state->prewoke_us < ATECC_AWAKE_WINDOW_US) {
+        return;
+    }
+    state->prewoke_us = 0;
+    state->spurious++;
+    state->prewake_misses++;
+    if (now - state->spurious_hour_us >= PREWAKE_HOUR_S * 1000000ULL) {
+        state->spurious_hour_us = now;
+        state->spurious_in_hour = 0;
+    }
+    state->spurious_in_hour++;
+    prewake_plan(state, now);
+}
+
+/**
+ * @brief Wake every active device ahead of the predicted burst (standbys are awake anyway)
+ */
+static void prewake_run(serve_state_t *state, uint64_t now) {
+    for (size_t i = 0; i < state->active_count; i++) {
+        atecc_ensure_awake(state->active[i]);
+    }
+    state->prewakes++;
+    state->prewoke_us = now;
+    state->prewake_at_us = 0;
+}
+
+/**
+ * @brief Record a burst start: an arrival after the devices have had time to fall asleep
+ *
+ * @return Whether the burst found the devices pre-woken
+ */
+static bool prewake_burst(serve_state_t *state, uint64_t now) {
+    bool prewoken = state->prewoke_us != 0 && now - state->prewoke_us < ATECC_AWAKE_WINDOW_US;
+    state->prewoke_us = 0;
+    state->prewake_misses = 0;
+
+    if (state->burst_count == BURST_HISTORY) {
+        memmove(state->bursts, &state->bursts[1], (BURST_HISTORY - 1U) * sizeof(state->bursts[0]));
+        state->burst_count--;
+    }
+    state->bursts[state->burst_count++] = now;
+    prewake_plan(state, now);
+    return prewoken;
+}
+
+/**
+ * @brief Queue a request, opening the batch window or shortening it to the client's
+ *
+ * @return false if the request was refused and the client could not be told
+ */
+static bool enqueue_request(serve_state_t *state, size_t client, const atecc_request_t *req) {
+    serve_pending_t *pending = &state->queue[state->queued];
+    memset(pending, 0, sizeof(*pending));
+    pending->client = client;
+    pending->req = *req;
+    if (!request_valid(&state->clients[client], req)) {
+        return serve_reply(&state->clients[client], pending, false);
+    }
+
+    uint64_t now = atecc_now_us();
+    if (state->last_arrival_us != 0) {
+        ewma_update(&state->gap_us, now - state->last_arrival_us);
+    }
+    if (state->queued == 0 && state->idle_since_us != 0) {
+        uint64_t active = (state->last_arrival_us > state->idle_since_us) ? state->last_arrival_us
+                                                                          : state->idle_since_us;
+        state->idle_gaps[state->idle_gap_next] = now - active;
+        state->idle_gap_next = (state->idle_gap_next + 1U) % IDLE_GAPS;
+        if (state->idle_gap_count < IDLE_GAPS) {
+            state->idle_gap_count++;
+        }
+    }
+    // A burst starts once the devices have been idle long enough to fall asleep
+    if (state->queued == 0 && (state->last_arrival_us == 0 || now - state->last_arrival_us >= ATECC_AWAKE_WINDOW_US) &&
+        (state->idle_since_us == 0 || now - state->idle_since_us >= ATECC_AWAKE_WINDOW_US)) {
+        pending->burst_first = true;
+        pending->prewoken = prewake_burst(state, now);
+        pending->arrived_us = now;
+    }
+    state->last_arrival_us = now;
+
+    // The batch goes by the shortest window among its clients
+    uint64_t deadline = now + batch_window(state, &state->clients[client]);
+    if (!state->batch_open || deadline < state->deadline_us) {
+        state->deadline_us = deadline;
+    }
+    state->batch_open = true;
+    state->queued++;
+    state->clients[client].queued = true;
+    return true;
+}
+
+/**
+ * @brief Whether the queued batch should go now
+ *
+ * Besides the deadline, a batch goes early when every client is waiting
+ * (nothing else can arrive), or when it is all Random from clients in
+ * adaptive mode and uses up whole 32-byte calls.
+ */
+static bool batch_ready(const serve_state_t *state, uint64_t now) {
+    if (state->queued == 0) {
+        return false;
+    }
+    if (state->wake_us != 0 && now >= state->wake_us) {
+        return true;
+    }
+    if (!state->batch_open) {
+        return false;
+    }
+    if (now >= state->deadline_us || state->queued == state->client_count) {
+        return true;
+    }
+    uint64_t random_bytes = 0;
+    for (size_t i = 0; i < state->queued; i++) {
+        if (batch_pass(state->queue[i].req.op) != 0 ||
+            state->clients[state->queue[i].client].batch_mode != ATECC_BATCH_ADAPTIVE) {
+            return false;
+        }
+        random_bytes += state->queue[i].req.length - state->queue[i].done;
+    }
+    // Served from buffered bytes, or ends exactly on a block boundary
+    size_t left = state->random.left;
+    return random_bytes <= left || (random_bytes - left) % RANDOM_BLOCK_SIZE == 0;
+}
+
+/**
+ * @brief Top up a client's token bucket for the time since its last refill
+ */
+static void bucket_refill(const serve_state_t *state, serve_client_t *client, uint64_t now) {
+    int64_t tokens = client->tokens_us + (int64_t)((now - client->refilled_us) * state->quota_us / 1000000U);
+    client->tokens_us = (tokens < (int64_t)state->burst_us) ? tokens : (int64_t)state->burst_us;
+    client->refilled_us = now;
+}
+
+/**
+ * @brief Publish device health and per-client usage
+ */
+static void publish_status(serve_state_t *state) {
+    atecc_status_client_t usage[DAEMON_MAX_CLIENTS];
+    for (size_t i = 0; i < state->client_count; i++) {
+        const serve_client_t *client = &state->clients[i];
+        usage[i] = (atecc_status_client_t){
+            .pid = (int32_t)client->pid,
+            .queued = client->queued,
+            .requests = client->served,
+            .device_us = client->device_us,
+            .tokens_us = client->tokens_us,
+            .throttled = client->throttled
+        };
+    }
+    atecc_status_publish(state->status, state->pool, state->requests, usage, state->client_count,
+                         &state->selftest);
+}
+
+/**
+ * @brief Decide when the next round runs
+ *
+ * Requests that can run keep the batch open with an immediate deadline,
+ * so arrivals are still polled between rounds. If every queued client is
+ * held by its quota, the next round waits until the first bucket refills.
+ */
+static void schedule_round(serve_state_t *state, uint64_t now) {
+    state->batch_open = false;
+    state->wake_us = 0;
+    for (size_t i = 0; i < state->queued; i++) {
+        serve_client_t *client = &state->clients[state->queue[i].client];
+        if (state->quota_us > 0) {
+            bucket_refill(state, client, now);
+        }
+        if (state->quota_us == 0 || client->tokens_us > 0) {
+            state->batch_open = true;
+            continue;
+        }
+        uint64_t ready_us = now + ((uint64_t)-client->tokens_us + 1U) * 1000000U / state->quota_us + 1U;
+        if (state->wake_us == 0 || ready_us < state->wake_us) {
+            state->wake_us = ready_us;
+        }
+    }
+    if (state->batch_open) {
+        state->deadline_us = now;
+    }
+}
+
+/**
+ * @brief One deficit round robin round over the queue
+ *
+ * Every queued client with tokens is credited one quantum of device time
+ * and served as much of its request as its credit pays for, so a client
+ * asking for megabytes of Random holds the devices for about one quantum
+ * per round instead of until its request completes. A small request thus
+ * waits at most about one quantum per other busy client. Clients whose
+ * bucket is empty sit the round out. Finished requests are answered; the
+ * rest stay queued for the next round.
+ */
+static void dispatch_round(serve_state_t *state) {
+    uint64_t start = atecc_now_us();
+    random_stream_t *stream = &state->random;
+    if (stream->left == 0) {
+        stream->dev = state->active[state->next_device++ % state->active_count];
+    }
+
+    for (size_t i = 0; i < state->queued; i++) {
+        serve_pending_t *pending = &state->queue[i];
+        serve_client_t *client = &state->clients[pending->client];
+        if (state->quota_us > 0) {
+            bucket_refill(state, client, start);
+        }
+        pending->held = state->quota_us > 0 && client->tokens_us <= 0;
+        if (pending->held) {
+            client->throttled++;
+        } else {
+            client->deficit_us += state->quantum_us;
+        }
+    }
+
+    size_t first = state->round++;
+    size_t pieces = 0;
+    for (unsigned int pass = 0; pass < 3U; pass++) {
+        for (size_t k = 0; k < state->queued; k++) {
+            serve_pending_t *pending = &state->queue[(first + k) % state->queued];
+            if (pending->held || pending->finished || batch_pass(pending->req.op) != pass) {
+                continue;
+            }
+            serve_client_t *client = &state->clients[pending->client];
+            uint64_t bytes;
+            uint64_t cost_us;
+            if (!request_share(pending, client->deficit_us, &bytes, &cost_us)) {
+                continue;
+            }
+
+            bool ok = serve_failover(state, client, pending, bytes);
+            pieces++;
+            client->deficit_us -= (cost_us < client->deficit_us) ? cost_us : client->deficit_us;
+            client->tokens_us -= (int64_t)cost_us;
+            client->device_us += cost_us;
+            pending->done += bytes;
+            if (!ok || pending->done == pending->req.length) {
+                if (!ok && device_op(pending->req.op)) {
+                    state->lost++;
+                }
+                if (!serve_reply(client, pending, ok)) {
+                    client->dead = true;
+                }
+                client->served++;
+                pending->finished = true;
+                if (pending->burst_first) {
+                    burst_latency_add(pending->prewoken ? &state->warm : &state->cold,
+                                      atecc_now_us() - pending->arrived_us);
+                }
+            }
+        }
+    }
+
+    // Drop answered requests; a client with nothing queued loses its credit
+    size_t kept = 0;
+    for (size_t i = 0; i < state->queued; i++) {
+        serve_pending_t *pending = &state->queue[i];
+        if (pending->finished) {
+            state->clients[pending->client].queued = false;
+            state->clients[pending->client].deficit_us = 0;
+            free(pending->payload);
+            state->requests++;
+        } else {
+            state->queue[kept++] = *pending;
+        }
+    }
+    state->queued = kept;
+
+    uint64_t now = atecc_now_us();
+    if (pieces > 0) {
+        ewma_update(&state->service_us, (now - start) / pieces);
+    }
+    state->batches++;
+    state->idle_since_us = now;
+
+    for (size_t i = state->client_count; i-- > 0;) {
+        if (state->clients[i].dead) {
+            remove_client(state, i);
+        }
+    }
+    schedule_round(state, now);
+    publish_status(state);
+}
+
+/**
+ * @brief Idle time after which a slice of cost_us is predicted to fit before the next arrival
+ *
+ * Among the recent idle gaps that lasted at least as long as the current
+ * one, IDLE_CONFIDENCE percent must have lasted cost_us longer still. For
+ * periodic clients this holds right after a request. For bursty ones it
+ * holds once a burst is over. For random arrivals it holds only when gaps
+ * are long compared to the slice. Without enough history the slice waits
+ * IDLE_MARGIN times its duration.
+ *
+ * @param state Daemon state
+ * @param idle_for Current idle time
+ * @param cost_us Slice duration
+ * @return Idle time (>= idle_for) at which the slice fits, UINT64_MAX if never
+ */
+static uint64_t idle_fit(const serve_state_t *state, uint64_t idle_for, uint64_t cost_us) {
+    if (state->client_count == 0) {
+        return idle_for;
+    }
+    if (state->idle_gap_count < IDLE_MIN_GAPS) {
+        uint64_t needed = IDLE_MARGIN * cost_us;
+        return (idle_for > needed) ? idle_for : needed;
+    }
+
+    // The survival ratio only improves just past a recorded gap, so those are the candidates
+    uint64_t best = UINT64_MAX;
+    for (size_t c = 0; c <= state->idle_gap_count; c++) {
+        uint64_t t = (c == state->idle_gap_count) ? idle_for : state->idle_gaps[c] + 1U;
+        if (t < idle_for || t >= best) {
+            continue;
+        }
+        size_t lasted = 0;
+        size_t outlasted = 0;
+        for (size_t i = 0; i < state->idle_gap_count; i++) {
+            lasted += state->idle_gaps[i] >= t;
+            outlasted += state->idle_gaps[i] >= t + cost_us;
+        }
+        if (lasted >= IDLE_MIN_GAPS && outlasted * 100U >= lasted * IDLE_CONFIDENCE) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Pick the most overdue SelfTest and when it may start
+ *
+ * Only called with an empty queue. A slice starts once idle_fit() predicts
+ * the idle gap will outlast it. A test that is overdue by a whole second
+ * interval runs at the next empty queue regardless, so a pool that is
+ * never idle long enough still gets every test, at the cost of one slice
+ * of delay for requests that arrive during it.
+ *
+ * @param state Daemon state, receives the plan
+ * @param now Current time
+ * @return When to start the slice or, with nothing due, to plan again; 0 when SelfTest is off
+ */
+static uint64_t selftest_plan(serve_state_t *state, uint64_t now) {
+    uint64_t interval = state->selftest_interval_us;
+    uint64_t next_due = 0;
+    uint64_t oldest = 0;
+
+    state->selftest_due = false;
+    if (interval == 0) {
+        return 0;
+    }
+    for (size_t d = 0; d < state->pool->count; d++) {
+        for (size_t t = 0; t < SELFTEST_COUNT; t++) {
+            uint64_t last = state->selftest_last_us[d][t];
+            uint64_t age = last ? now - last : now - state->selftest_start_us + interval;
+            if (age < interval) {
+                if (next_due == 0 || last + interval < next_due) {
+                    next_due = last + interval;
+                }
+            } else if (!state->selftest_due || age > oldest) {
+                state->selftest_due = true;
+                state->selftest_device = d;
+                state->selftest_test = t;
+                state->selftest_forced = age >= 2U * interval;
+                oldest = age;
+            }
+        }
+    }
+    if (!state->selftest_due) {
+        return next_due;
+    }
+    if (state->selftest_forced) {
+        return now;
+    }
+
+    uint64_t last = state->selftest_last_us[state->selftest_device][state->selftest_test];
+    uint64_t forced_at = last ? last + 2U * interval : state->selftest_start_us + interval;
+    uint64_t cost_us = atecc_selftest_us(state->pool->members[state->selftest_device],
+                                         selftest_order[state->selftest_test]);
+    uint64_t active = (state->last_arrival_us > state->idle_since_us) ? state->last_arrival_us : state->idle_since_us;
+    uint64_t fit = idle_fit(state, now - active, cost_us);
+    return (fit == UINT64_MAX || active + fit > forced_at) ? forced_at : active + fit;
+}
+
+/**
+ * @brief Run the planned SelfTest slice, if it is due now, and account for its effect on requests
+ *
+ * Called only after a poll found no pending input. A started SelfTest
+ * cannot be cancelled, so requests that arrive during a slice wait for it.
+ * The same descriptors are polled again without blocking afterwards. If
+ * any became readable, the slice's duration is recorded as the bound on
+ * their delay, and the caller serves them from the returned events.
+ */
+static void selftest_run(serve_state_t *state, struct pollfd *fds, size_t nfds) {
+    uint64_t start = atecc_now_us();
+    if (selftest_plan(state, start) > start || !state->selftest_due) {
+        return;
+    }
+    size_t device = state->selftest_device;
+    uint8_t test = selftest_order[state->selftest_test];
+    atecc_dev_t *dev = state->pool->members[device];
+
+    uint8_t failed = 0;
+    bool ok = atecc_selftest(dev, test, &failed);
+    uint64_t end = atecc_now_us();
+    state->selftest_last_us[device][state->selftest_test] = end;
+    state->selftest_waiting = false;
+    state->selftest.slices++;
+    if (state->selftest_forced) {
+        state->selftest.forced++;
+    }
+    if (!ok || failed != 0) {
+        state->selftest.failures++;
+        fprintf(stderr, "⚠️ serve: %s:0x%02X SelfTest 0x%02X %s\n", dev->bus, dev->address, test,
+                ok ? "failed" : "did not answer");
+    }
+    if (poll(fds, nfds, 0) > 0) {
+        state->selftest.delayed++;
+        if (end - start > state->selftest.delay_max_us) {
+            state->selftest.delay_max_us = end - start;
+        }
+    }
+    publish_status(state);
+}
+
+/**
+ * @brief Warm the standbys and drop those that cannot stand in for the first active device
+ *
+ * Waking a standby verifies its identity and loads its timing profile; its
+ * config zone was read at startup. Its SlotConfig and KeyConfig must match
+ * the first active device's, and so must the public key of every P-256
+ * private key and the key check value (atecc_aes_kcv()) of every AES key.
+ */
+static void standby_prepare(serve_state_t *state) {
+    atecc_dev_t *primary = state->active[0];
+    if (!primary->config_valid) {
+        fprintf(stderr, "⚠️ serve: no config zone from %s:0x%02X, standbys disabled\n", primary->bus,
+                primary->address);
+        state->standby_count = 0;
+        return;
+    }
+
+    uint8_t keys[ATECC_SLOT_COUNT][PUBLIC_KEY_SIZE];
+    bool has_key[ATECC_SLOT_COUNT] = {false};
+    uint8_t kcvs[ATECC_SLOT_COUNT][ATECC_KCV_SIZE];
+    bool has_kcv[ATECC_SLOT_COUNT] = {false};
+    bool aes_enabled = (primary->config[CONFIG_AES_ENABLE] & 0x01U) != 0;
+    for (uint8_t slot = 0; slot < ATECC_SLOT_COUNT; slot++) {
+        unsigned int key_config = primary->config[CONFIG_KEY_CONFIG + 2U * slot] |
+                                  (primary->config[CONFIG_KEY_CONFIG + 2U * slot + 1U] << 8);
+        unsigned int key_type = (key_config >> 2) & 0x07U;
+        if (key_type == KEY_TYPE_P256 && (key_config & 0x01U) != 0) {
+            has_key[slot] = atecc_get_pubkey(primary, slot, keys[slot]);
+        } else if (key_type == KEY_TYPE_AES && aes_enabled) {
+            has_kcv[slot] = atecc_aes_kcv(primary, slot, kcvs[slot]);
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < state->standby_count; i++) {
+        atecc_dev_t *dev = state->standby[i];
+        const char *reason = NULL;
+        if (!atecc_ensure_awake(dev) || !dev->config_valid) {
+            reason = "did not answer";
+        } else if (memcmp(&dev->config[CONFIG_SLOT_CONFIG], &primary->config[CONFIG_SLOT_CONFIG],
+                          2U * ATECC_SLOT_COUNT) != 0 ||
+                   memcmp(&dev->config[CONFIG_KEY_CONFIG], &primary->config[CONFIG_KEY_CONFIG],
+                          2U * ATECC_SLOT_COUNT) != 0) {
+            reason = "has a different slot configuration";
+        }
+        for (uint8_t slot = 0; slot < ATECC_SLOT_COUNT && !reason; slot++) {
+            uint8_t key[PUBLIC_KEY_SIZE];
+            uint8_t kcv[ATECC_KCV_SIZE];
+            if ((has_key[slot] && (!atecc_get_pubkey(dev, slot, key) || memcmp(key, keys[slot], sizeof(key)) != 0)) ||
+                (has_kcv[slot] && (!atecc_aes_kcv(dev, slot, kcv) || memcmp(kcv, kcvs[slot], sizeof(kcv)) != 0))) {
+                reason = "holds different keys";
+            }
+        }
+        if (reason) {
+            fprintf(stderr, "⚠️ serve: %s:0x%02X %s, not used as a standby\n", dev->bus, dev->address, reason);
+        } else {
+            state->standby[kept++] = dev;
+        }
+    }
+    state->standby_count = kept;
+}
+
+/**
+ * @brief Wake standbys again shortly before their awake window ends, so a failover never waits for a wake
+ *
+ * @param state Daemon state
+ * @return When the next standby is due, 0 without standbys
+ */
+static uint64_t standby_keepalive(serve_state_t *state) {
+    uint64_t next_us = 0;
+    for (size_t i = 0; i < state->standby_count;) {
+        atecc_dev_t *dev = state->standby[i];
+        if (!atecc_keep_awake(dev, STANDBY_REWAKE_US)) {
+            fprintf(stderr, "⚠️ serve: standby %s:0x%02X did not answer, dropped\n", dev->bus, dev->address);
+            state->standby_count--;
+            memmove(&state->standby[i], &state->standby[i + 1U],
+                    (state->standby_count - i) * sizeof(state->standby[0]));
+            continue;
+        }
+        uint64_t due = dev->woke_at_us + ATECC_AWAKE_WINDOW_US - STANDBY_REWAKE_US;
+        if (next_us == 0 || due < next_us) {
+            next_us = due;
+        }
+        i++;
+    }
+    return next_us;
+}
+
+/**
+ * @brief Bind the control socket, replacing a stale socket file
+ */
+static int serve_listen(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "serve: socket path too long\n");
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("serve: socket failed");
+        return -1;
+    }
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, DAEMON_BACKLOG) < 0) {
+        perror("serve: bind failed");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Serve device operations to local clients over a Unix socket
+ *
+ * Usage: serve [--socket PATH] [--shm NAME] [--batch off|fixed|adaptive] [--max-delay-us N]
+ *              [--quota PCT] [--burst-ms MS] [--quantum-us US] [--selftest-interval S]
+ *              [--prewake] [--standby N] [--inject-fault DEV:N] [--cpu C] [--fifo PRIO | --deadline]
+ *              [--mlock] [device...]
+ *
+ * Each client gets its own memfd ring; results are written into it and
+ * only fixed-size descriptors cross the socket. Without device arguments
+ * every discovered device is served. Requests are collected into batches
+ * (see batch_window()) and served in deficit round robin rounds (see
+ * dispatch_round()); --quota caps each client's average share of the
+ * pool's device time. --selftest-interval runs SelfTest on every device
+ * in idle gaps, one algorithm per slice (see selftest_plan()). --prewake
+ * wakes the devices just before bursts that recur periodically (see
+ * prewake_plan()). --standby keeps the last N devices awake as spares
+ * that take over from a failing device (see serve_failover());
+ * --inject-fault makes emulated device DEV stop answering after N more
+ * commands to exercise it (see atecc_emu_fail_after()). --cpu, --fifo,
+ * --deadline and --mlock put the event loop and the AES-CTR workers under
+ * real-time settings (see atecc_rt_apply_pool()). Identity, lock state,
+ * health and per-client usage are published on a read-only status page
+ * after every round.
+ *
+ * @return Process exit status
+ */
+int atecc_serve_main(int argc, char **argv) {
+    const char *path = atecc_socket_path();
+    const char *shm_name = ATECC_STATUS_SHM;
+    const char *specs[ATECC_POOL_MAX];
+    size_t spec_count = 0;
+    atecc_batch_mode_t batch_mode = ATECC_BATCH_ADAPTIVE;
+    uint64_t max_delay_us = BATCH_DEFAULT_US;
+    unsigned long quota_pct = 0;
+    uint64_t burst_us = QUOTA_BURST_US;
+    uint64_t quantum_us = DRR_QUANTUM_US;
+    uint64_t selftest_interval_us = 0;
+    bool prewake = false;
+    uint64_t prewake_lead_us = PREWAKE_LEAD_US;
+    unsigned int prewake_spurious_max = PREWAKE_SPURIOUS;
+    size_t standby_count = 0;
+    size_t fault_device = 0;
+    unsigned long fault_after = 0;
+    atecc_rt_opts_t rt = { .cpu = -1, .policy = ATECC_RT_NONE };
+    static const char *const batch_modes[] = { "off", "fixed", "adaptive" };
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--socket") == 0 && has_value) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "--shm") == 0 && has_value) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--max-delay-us") == 0 && has_value) {
+            max_delay_us = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--quota") == 0 && has_value) {
+            quota_pct = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--burst-ms") == 0 && has_value) {
+            burst_us = strtoull(argv[++i], NULL, 10) * 1000U;
+        } else if (strcmp(argv[i], "--quantum-us") == 0 && has_value) {
+            quantum_us = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--selftest-interval") == 0 && has_value) {
+            selftest_interval_us = strtoull(argv[++i], NULL, 10) * 1000000U;
+        } else if (strcmp(argv[i], "--prewake") == 0) {
+            prewake = true;
+        } else if (strcmp(argv[i], "--prewake-lead-ms") == 0 && has_value) {
+            prewake_lead_us = strtoull(argv[++i], NULL, 10) * 1000U;
+        } else if (strcmp(argv[i], "--prewake-max-spurious") == 0 && has_value) {
+            prewake_spurious_max = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--standby") == 0 && has_value) {
+            standby_count = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--inject-fault") == 0 && has_value &&
+                   sscanf(argv[i + 1], "%zu:%lu", &fault_device, &fault_after) == 2) {
+            i++;
+        } else if (atecc_rt_parse_arg(argc, argv, &i, &rt)) {
+            // --cpu, --fifo, --deadline and --mlock, consumed into rt
+        } else if (strcmp(argv[i], "--batch") == 0 && has_value) {
+            const char *mode = argv[++i];
+            batch_mode = (atecc_batch_mode_t)-1;
+            for (unsigned int m = 0; m < 3U; m++) {
+                if (strcmp(mode, batch_modes[m]) == 0) {
+                    batch_mode = (atecc_batch_mode_t)m;
+                }
+            }
+            if (batch_mode == (atecc_batch_mode_t)-1) {
+                fprintf(stderr, "serve: unknown batch mode '%s'\n", mode);
+                return 2;
+            }
+        } else if (argv[i][0] != '-' && spec_count < ATECC_POOL_MAX) {
+            specs[spec_count++] = argv[i];
+        } else {
+            fprintf(stderr, "usage: pi_atecc serve [--socket PATH] [--shm NAME] [--batch off|fixed|adaptive] "
+                            "[--max-delay-us N] [--quota PCT] [--burst-ms MS] [--quantum-us US] "
+                            "[--selftest-interval S] [--prewake] [--prewake-lead-ms MS] "
+                            "[--prewake-max-spurious N] [--standby N] [--inject-fault DEV:N] [--cpu C] "
+                            "[--fifo PRIO | --deadline] [--mlock] [device...]\n");
+            return 2;
+        }
+    }
+    if (quota_pct > 100U || quantum_us == 0 || max_delay_us > BATCH_MAX_US) {
+        fprintf(stderr, "serve: --quota must be 0-100, --quantum-us positive and --max-delay-us at most %u\n",
+                (unsigned int)BATCH_MAX_US);
+        return 2;
+    }
+
+    serve_state_t *state = calloc(1, sizeof(*state));
+    if (!state || !(state->pool = calloc(1, sizeof(*state->pool)))) {
+        perror("serve");
+        free(state);
+        return 1;
+    }
+    state->batch_mode = batch_mode;
+    state->max_delay_us = max_delay_us;
+    state->burst_us = burst_us;
+    state->quantum_us = quantum_us;
+    state->selftest_interval_us = selftest_interval_us;
+    state->selftest_start_us = atecc_now_us();
+    state->prewake = prewake;
+    state->prewake_lead_us = prewake_lead_us;
+    state->prewake_spurious_max = prewake_spurious_max;
+    if (!atecc_pool_open(state->pool, specs, spec_count)) {
+        fprintf(stderr, "serve: no devices available\n");
+        free(state->pool);
+        free(state);
+        return 1;
+    }
+    if (standby_count >= state->pool->count || (fault_after != 0 && fault_device >= state->pool->count)) {
+        fprintf(stderr, "serve: --standby must leave an active device and --inject-fault name one of %zu\n",
+                state->pool->count);
+        atecc_pool_close(state->pool);
+        free(state->pool);
+        free(state);
+        return 2;
+    }
+    if (fault_after != 0 && !state->pool->members[fault_device]->emu) {
+        fprintf(stderr, "serve: --inject-fault needs an emulated device (emu0:0x60 ...), device %zu is %s\n",
+                fault_device, state->pool->members[fault_device]->bus);
+        atecc_pool_close(state->pool);
+        free(state->pool);
+        free(state);
+        return 2;
+    }
+    if (atecc_rt_requested(&rt)) {
+        atecc_rt_apply_pool(&rt, state->pool);
+    }
+    state->active_count = state->pool->count - standby_count;
+    state->standby_count = standby_count;
+    memcpy(state->active, state->pool->members, state->active_count * sizeof(state->active[0]));
+    memcpy(state->standby, &state->pool->members[state->active_count], standby_count * sizeof(state->standby[0]));
+
+    // A percentage of the time of every active device, in device microseconds per second
+    state->quota_us = quota_pct * state->active_count * 10000U;
+
+    // Identity and config are read once up front so the status page is complete
+    for (size_t i = 0; i < state->pool->count; i++) {
+        atecc_cache_load(state->pool->members[i]);
+        if (!atecc_read_config(state->pool->members[i])) {
+            fprintf(stderr, "⚠️ serve: %s:0x%02X did not answer\n", state->pool->devs[i].bus,
+                    state->pool->devs[i].address);
+        }
+    }
+    if (state->standby_count > 0) {
+        standby_prepare(state);
+    }
+    if (fault_after != 0) {
+        atecc_emu_fail_after(state->pool->members[fault_device], fault_after);
+    }
+    state->status = atecc_status_create(shm_name);
+    publish_status(state);
+
+    state->listen_fd = serve_listen(path);
+    if (state->listen_fd < 0) {
+        atecc_status_destroy(state->status, shm_name);
+        atecc_pool_close(state->pool);
+        free(state->pool);
+        free(state);
+        return 1;
+    }
+
+    struct sigaction action = { .sa_handler = serve_signal };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    printf("🛰️ Serving %zu device(s) on %s\n", state->active_count, path);
+    if (state->standby_count > 0) {
+        printf("🛟 %zu standby device(s) awake\n", state->standby_count);
+    }
+    fflush(stdout);
+
+    struct pollfd fds[1 + DAEMON_MAX_CLIENTS];
+    size_t polled[DAEMON_MAX_CLIENTS];
+    while (!serve_stop) {
+        // Clients with a queued request are not read again until it is answered
+        size_t nfds = 1;
+        fds[0].fd = state->listen_fd;
+        fds[0].events = POLLIN;
+        for (size_t i = 0; i < state->client_count; i++) {
+            if (!state->clients[i].queued) {
+                polled[nfds - 1U] = i;
+                fds[nfds].fd = state->clients[i].fd;
+                fds[nfds].events = POLLIN;
+                nfds++;
+            }
+        }
+
+        struct timespec wait = {0};
+        struct timespec *timeout = NULL;
+        uint64_t next_us = 0;
+        if (state->queued > 0) {
+            next_us = state->batch_open ? state->deadline_us : 0;
+            if (state->wake_us != 0 && (next_us == 0 || state->wake_us < next_us)) {
+                next_us = state->wake_us;
+            }
+        } else {
+            uint64_t now = atecc_now_us();
+            next_us = selftest_plan(state, now);
+            state->selftest_waiting = state->selftest_due;
+            prewake_expire(state, now);
+            uint64_t prewake_us = state->prewoke_us ? state->prewoke_us + ATECC_AWAKE_WINDOW_US : state->prewake_at_us;
+            if (prewake_us != 0 && (next_us == 0 || prewake_us < next_us)) {
+                next_us = prewake_us;
+            }
+        }
+        uint64_t standby_us = standby_keepalive(state);
+        if (standby_us != 0 && (next_us == 0 || standby_us < next_us)) {
+            next_us = standby_us;
+        }
+        if (next_us != 0) {
+            uint64_t now = atecc_now_us();
+            uint64_t left_us = (next_us > now) ? next_us - now : 0;
+            wait.tv_sec = (time_t)(left_us / 1000000U);
+            wait.tv_nsec = (long)(left_us % 1000000U) * 1000L;
+            timeout = &wait;
+        }
+        int ready = ppoll(fds, nfds, timeout, NULL);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("serve: poll failed");
+            break;
+        }
+
+        // SelfTest only runs when nothing is waiting; a request arriving first puts it off
+        uint64_t idle_now = atecc_now_us();
+        if (ready == 0 && state->queued == 0 && state->prewake_at_us != 0 && idle_now >= state->prewake_at_us) {
+            prewake_run(state, idle_now);
+        }
+        if (ready == 0 && state->queued == 0 && state->selftest_interval_us != 0) {
+            selftest_run(state, fds, nfds);
+        } else if (ready > 0 && state->selftest_waiting) {
+            state->selftest.deferred++;
+            state->selftest_waiting = false;
+        }
+
+        // Read existing clients first; removing one may reorder the client table
+        for (size_t k = nfds - 1U; k-- > 0;) {
+            if (!fds[1 + k].revents) {
+                continue;
+            }
+            size_t i = polled[k];
+            atecc_request_t req;
+            if (!atecc_read_full(state->clients[i].fd, &req, sizeof(req)) || !enqueue_request(state, i, &req)) {
+                remove_client(state, i);
+                publish_status(state);
+            }
+        }
+
+        if (batch_ready(state, atecc_now_us())) {
+            dispatch_round(state);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept4(state->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+            if (fd < 0) {
+                continue;
+            }
+            if (state->client_count == DAEMON_MAX_CLIENTS ||
+                !client_attach(&state->clients[state->client_count], fd)) {
+                close(fd);
+                continue;
+            }
+            serve_client_t *client = &state->clients[state->client_count++];
+            struct ucred peer;
+            socklen_t peer_length = sizeof(peer);
+            if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &peer_length) == 0) {
+                client->pid = peer.pid;
+            }
+            client->tokens_us = (int64_t)state->burst_us;
+            client->refilled_us = atecc_now_us();
+            client->batch_mode = state->batch_mode;
+            client->max_delay_us = state->max_delay_us;
+            publish_status(state);
+        }
+    }
+
+    // Requests still queued are dropped; their clients see the connection close
+    for (size_t i = 0; i < state->queued; i++) {
+        free(state->queue[i].payload);
+    }
+    printf("📊 %llu request(s) in %lu round(s), %lu Random call(s)\n", (unsigned long long)state->requests,
+           state->batches, state->random.calls);
+    if (state->selftest.slices > 0) {
+        printf("🧪 %llu SelfTest slice(s), %llu failed, %llu deferred, %llu forced; %llu met a request, "
+               "adding at most %.1f ms\n", (unsigned long long)state->selftest.slices,
+               (unsigned long long)state->selftest.failures, (unsigned long long)state->selftest.deferred,
+               (unsigned long long)state->selftest.forced, (unsigned long long)state->selftest.delayed,
+               (double)state->selftest.delay_max_us / 1000.0);
+    }
+    if (state->prewake) {
+        printf("⏰ %lu pre-wake(s), %lu spurious\n", state->prewakes, state->spurious);
+    }
+    if (state->warm.count > 0 || state->cold.count > 0) {
+        printf("📊 First request of a burst: pre-woken %lu, avg %.1f ms, max %.1f ms; cold %lu, avg %.1f ms, "
+               "max %.1f ms\n", state->warm.count,
+               state->warm.count ? (double)state->warm.total_us / (double)state->warm.count / 1000.0 : 0.0,
+               (double)state->warm.max_us / 1000.0, state->cold.count,
+               state->cold.count ? (double)state->cold.total_us / (double)state->cold.count / 1000.0 : 0.0,
+               (double)state->cold.max_us / 1000.0);
+    }
+    if (standby_count > 0 || fault_after != 0) {
+        printf("🔁 %lu failover(s), %lu request(s) lost; detection avg %.1f ms, max %.1f ms; recovery avg %.1f ms, "
+               "max %.1f ms\n", state->failovers, state->lost,
+               state->detect.count ? (double)state->detect.total_us / (double)state->detect.count / 1000.0 : 0.0,
+               (double)state->detect.max_us / 1000.0,
+               state->recover.count ? (double)state->recover.total_us / (double)state->recover.count / 1000.0 : 0.0,
+               (double)state->recover.max_us / 1000.0);
+    }
+    for (size_t i = 0; i < state->client_count; i++) {
+        client_detach(&state->clients[i]);
+    }
+    close(state->listen_fd);
+    unlink(path);
+    atecc_status_destroy(state->status, shm_name);
+    atecc_pool_close(state->pool);
+    free(state->pool);
+    free(state);
+    printf("🌙 Daemon stopped\n");
+    return 0;
+}
@@ -0,0 +1,242 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "pi_atecc.h"
+
+enum {
+    DISCOVER_MAX_BUSES     = 32U,
+    DISCOVER_MAX_ADDRESSES = 16U
+};
+
+/**
+ * @brief Default candidate addresses: factory ATECC608A (0x60) and the
+ *        Trust&GO/TrustFLEX default (0x35)
+ */
+static const uint16_t default_addresses[] = { ATECC_I2C_ADDRESS, 0x35 };
+
+/**
+ * @brief Work item for one bus probe thread
+ */
+typedef struct {
+    char bus[32];
+    const uint16_t *addresses;
+    size_t address_count;
+    atecc_found_t found[DISCOVER_MAX_ADDRESSES];
+    size_t found_count;
+} bus_probe_t;
+
+/**
+ * @brief Whether a 4-byte response is the wake signature checked by atecc_wake()
+ */
+static bool is_wake_response(const uint8_t *response) {
+    return response[0] == 0x04 && response[1] == ATECC_STATUS_WAKE;
+}
+
+/**
+ * @brief Send the sleep word address, ignoring NACKs from absent devices
+ */
+static void probe_sleep(atecc_dev_t *dev) {
+    uint8_t sleep_cmd = ATECC_WORDADDR_SLEEP;
+    (void)atecc_i2c_write(dev, &sleep_cmd, 1);
+}
+
+/**
+ * @brief Drive the wake token on the bus and wait tWHI
+ *
+ * The token holds SDA low long enough to wake every ATECC on the bus, so a
+ * single wake covers all candidate addresses.
+ */
+static void probe_wake(atecc_dev_t *dev) {
+    uint8_t wake_token = ATECC_WAKE_TOKEN;
+    (void)atecc_i2c_write(dev, &wake_token, 1);
+    usleep(ATECC_WAKE_DELAY_US);
+}
+
+/**
+ * @brief Probe all candidate addresses on one bus
+ *
+ * One wake token is shared by every address. A device that ACKs without the
+ * wake signature was already awake with a stale output buffer; it is put to
+ * sleep and woken again before giving up on it.
+ */
+static void *probe_bus(void *arg) {
+    bus_probe_t *probe = arg;
+    atecc_dev_t devs[DISCOVER_MAX_ADDRESSES];
+    bool opened[DISCOVER_MAX_ADDRESSES] = {false};
+    size_t count = probe->address_count;
+
+    for (size_t i = 0; i < count; i++) {
+        opened[i] = atecc_open(&devs[i], probe->bus, probe->addresses[i]);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (opened[i]) {
+            probe_wake(&devs[i]);
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!opened[i]) {
+            continue;
+        }
+
+        uint8_t response[4] = {0};
+        if (!atecc_i2c_read(&devs[i], response, sizeof(response))) {
+            continue;
+        }
+        if (!is_wake_response(response)) {
+            probe_sleep(&devs[i]);
+            probe_wake(&devs[i]);
+            memset(response, 0, sizeof(response));
+            if (!atecc_i2c_read(&devs[i], response, sizeof(response)) || !is_wake_response(response)) {
+                continue;
+            }
+        }
+
+        atecc_found_t *found = &probe->found[probe->found_count];
+        if (!atecc_read_serial(&devs[i], found->serial)) {
+            continue;
+        }
+        memcpy(found->bus, probe->bus, sizeof(found->bus));
+        found->address = devs[i].address;
+        found->xfer = devs[i].xfer;
+        probe->found_count++;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (opened[i]) {
+            probe_sleep(&devs[i]);
+            atecc_close(&devs[i]);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Order buses numerically so the inventory is stable across runs
+ */
+static int compare_bus_number(const void *a, const void *b) {
+    const bus_probe_t *lhs = a;
+    const bus_probe_t *rhs = b;
+    long left = strtol(lhs->bus + strlen("/dev/i2c-"), NULL, 10);
+    long right = strtol(rhs->bus + strlen("/dev/i2c-"), NULL, 10);
+    return (left > right) - (left < right);
+}
+
+/**
+ * @brief Discover ATECC devices on every /dev/i2c-* bus
+ *
+ * Buses are probed in parallel, one thread per bus, each waking its bus once
+ * and checking every candidate address for the wake response before reading
+ * the serial number. Found devices are left asleep.
+ *
+ * @param addresses Candidate addresses, or NULL for the defaults (0x60, 0x35)
+ * @param address_count Number of candidate addresses
+ * @param found Output inventory
+ * @param max_found Capacity of the inventory
+ * @return Number of devices found
+ */
+size_t atecc_discover(const uint16_t *addresses, size_t address_count, atecc_found_t *found, size_t max_found) {
+    if (!addresses || address_count == 0) {
+        addresses = default_addresses;
+        address_count = sizeof(default_addresses) / sizeof(default_addresses[0]);
+    }
+    if (address_count > DISCOVER_MAX_ADDRESSES) {
+        address_count = DISCOVER_MAX_ADDRESSES;
+    }
+
+    DIR *dir = opendir("/dev");
+    if (!dir) {
+        perror("atecc_discover: opendir /dev");
+        return 0;
+    }
+
+    bus_probe_t *probes = calloc(DISCOVER_MAX_BUSES, sizeof(*probes));
+    if (!probes) {
+        closedir(dir);
+        return 0;
+    }
+
+    size_t bus_count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && bus_count < DISCOVER_MAX_BUSES) {
+        const char *name = entry->d_name;
+        if (strncmp(name, "i2c-", 4) != 0 || name[4] == '\0' || strspn(&name[4], "0123456789") != strlen(&name[4])) {
+            continue;
+        }
+        bus_probe_t *probe = &probes[bus_count++];
+        snprintf(probe->bus, sizeof(probe->bus), "/dev/%.26s", name);
+        probe->addresses = addresses;
+        probe->address_count = address_count;
+    }
+    closedir(dir);
+
+    qsort(probes, bus_count, sizeof(*probes), compare_bus_number);
+
+    pthread_t threads[DISCOVER_MAX_BUSES];
+    bool started[DISCOVER_MAX_BUSES] = {false};
+    for (size_t i = 0; i < bus_count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, probe_bus, &probes[i]) == 0;
+        if (!started[i]) {
+            probe_bus(&probes[i]);
+        }
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < bus_count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        for (size_t j = 0; j < probes[i].found_count && total < max_found; j++) {
+            found[total++] = probes[i].found[j];
+        }
+    }
+
+    free(probes);
+    return total;
+}
+
+/**
+ * @brief List every ATECC device reachable on the local I2C buses
+ *
+ * Usage: discover [address...]
+ *
+ * @return Process exit status (1 if nothing was found)
+ */
+int atecc_discover_main(int argc, char **argv) {
+    uint16_t addresses[DISCOVER_MAX_ADDRESSES];
+    size_t address_count = 0;
+
+    for (int i = 0; i < argc && address_count < DISCOVER_MAX_ADDRESSES; i++) {
+        char *end = NULL;
+        unsigned long value = strtoul(argv[i], &end, 0);
+        if (end == argv[i] || *end != '\0' || value > 0x7FU) {
+            fprintf(stderr, "discover: invalid address '%s'\n", argv[i]);
+            return 2;
+        }
+        addresses[address_count++] = (uint16_t)value;
+    }
+
+    atecc_found_t found[ATECC_DISCOVER_MAX];
+    uint64_t start = atecc_now_us();
+    size_t count = atecc_discover(address_count ? addresses : NULL, address_count, found, ATECC_DISCOVER_MAX);
+    double elapsed_ms = (double)(atecc_now_us() - start) / 1000.0;
+
+    char serial_hex[2U * ATECC_SERIAL_NUMBER_SIZE + 1U];
+    for (size_t i = 0; i < count; i++) {
+        atecc_hex(found[i].serial, ATECC_SERIAL_NUMBER_SIZE, serial_hex, ATECC_HEX_UPPER);
+        printf("🆔 %s:0x%02X  %s  (%s)\n", found[i].bus, found[i].address, serial_hex,
+               atecc_xfer_name(found[i].xfer));
+    }
+    printf("🔎 Found %zu device(s) in %.1f ms\n", count, elapsed_ms);
+
+    return count > 0 ? 0 : 1;
+}
@@ -0,0 +1,961 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "pi_atecc.h"
+
+enum {
+    EMU_DEFAULT_HZ      = 400000U,  // Bus clock unless $ATECC_EMU_HZ says otherwise
+    EMU_BITS_PER_BYTE   = 9U,       // Eight data bits and the ACK
+    EMU_FRAME_BITS      = 2U,       // START and STOP
+    EMU_WATCHDOG_US     = 1300000U, // An awake chip falls asleep this long after its wake
+    EMU_MUX_FIRST       = 0x70U,    // Emulated addresses 0x70-0x77 are TCA9548A muxes
+    EMU_MUX_LAST        = 0x77U,
+    EMU_WORDADDR_IDLE   = 0x02U,
+    EMU_STATUS_VERIFY   = 0x01U,    // Verify: signature does not match
+    EMU_STATUS_PARSE    = 0x03U,    // Unknown opcode or bad parameters
+    EMU_STATUS_EXEC     = 0x0FU,    // Command not allowed in the chip's current state
+    EMU_STATUS_CRC      = 0xFFU,    // Command CRC mismatch
+    EMU_CMD_AES         = 0x51U,
+    EMU_CMD_INFO        = 0x30U,
+    EMU_NONCE_PASSTHRU  = 0x03U,
+    EMU_ZONE_CONFIG     = 0x00U,    // Read/Write/Lock param1 zone bits
+    EMU_ZONE_OTP        = 0x01U,
+    EMU_ZONE_DATA       = 0x02U,
+    EMU_LOCK_NO_CRC     = 0x80U,    // Lock param1: skip the summary CRC check
+    EMU_VERIFY_STORED   = 0x00U,    // Verify param1: public key of the slot in param2
+    EMU_VERIFY_EXTERNAL = 0x02U,    // Verify param1: public key supplied after the signature
+    EMU_CONFIG_HEAD     = 16U,      // Config bytes 0-15 are read-only
+    EMU_CONFIG_EXTRA    = 84U,      // Config bytes 84-87 (UserExtra, locks) are not written by Write
+    EMU_DATA_SIZE       = 1208U,    // Slots 0-7 of 36 bytes, slot 8 of 416, slots 9-15 of 72
+    EMU_OTP_SIZE        = 64U,
+    EMU_DEFAULT_EXEC_US = 100U,
+    EMU_KEY_SIZE        = 32U,
+    EMU_BLOCK_SIZE      = 16U,
+    RIG_DEFAULT_MAX     = 64U,
+    RIG_DEFAULT_BYTES   = 8192U,    // 512 AES blocks per rig
+    RIG_KEY_SLOT        = 9U,       // AES slot of the emulated config
+    RIG_DIRECT_FIRST    = 0x20U,    // First address of directly attached rig devices
+    RIG_MUXED_ADDRESS   = 0x60U,    // Address of every rig device behind a mux
+    RIG_BAR             = 40U,      // Width of the efficiency bar at 100 %
+    RIG_MAX_ROWS        = 8U        // 1, 2, 4, ... 64 and one odd maximum
+};
+
+/**
+ * @brief Typical execution times the emulated chips take, as atecc_trace.c assumes them
+ */
+static const struct {
+    uint8_t opcode;
+    uint32_t exec_us;
+} emu_exec[] = {
+    { ATECC_CMD_READ,     100U },
+    { ATECC_CMD_WRITE,    7000U },
+    { ATECC_CMD_NONCE,    100U },
+    { ATECC_CMD_LOCK,     8000U },
+    { ATECC_CMD_RANDOM,   1000U },
+    { EMU_CMD_INFO,       100U },
+    { ATECC_CMD_GENKEY,   60000U },
+    { ATECC_CMD_SIGN,     40000U },
+    { ATECC_CMD_ECDH,     38000U },
+    { ATECC_CMD_VERIFY,   40000U },
+    { ATECC_CMD_SHA,      100U },
+    { EMU_CMD_AES,        1000U }
+};
+
+/**
+ * @brief Typical SelfTest time per algorithm, a SelfTest taking the sum over the bits of its mode
+ */
+static const struct {
+    uint8_t test;
+    uint32_t exec_us;
+} emu_selftest_exec[] = {
+    { ATECC_SELFTEST_RNG,   15000U },
+    { ATECC_SELFTEST_ECDSA, 150000U },
+    { ATECC_SELFTEST_ECDH,  60000U },
+    { ATECC_SELFTEST_AES,   7000U },
+    { ATECC_SELFTEST_SHA,   7000U }
+};
+
+/**
+ * @brief One virtual I2C bus: a wire that carries one transfer at a time
+ *
+ * The lock also guards the state of every chip and mux on the bus, so a
+ * transfer sees and changes them atomically.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t free_at_us;    // End of the last transfer scheduled on the wire
+    uint64_t busy_us;       // Wire time used
+    unsigned long transfers;
+} emu_bus_t;
+
+/**
+ * @brief Emulated ATECC608 or TCA9548A behind one device handle
+ */
+struct atecc_emu_chip {
+    emu_bus_t *bus;
+    bool mux;                   // TCA9548A rather than an ATECC608
+    uint8_t control;            // Mux: enabled channels
+    uint64_t wake_at_us;        // Chip answers from here after a wake token, 0 while asleep
+    uint64_t ready_us;          // The command in progress completes
+    uint8_t response[ATECC_RESPONSE_SIZE];
+    size_t response_length;
+    uint8_t config[ATECC_CONFIG_SIZE];
+    uint8_t data[EMU_DATA_SIZE];    // Data zone, slot after slot
+    uint8_t temp_key[EMU_KEY_SIZE];
+    sha256_ctx_t sha;
+    uint64_t random_state;
+    unsigned long commands;     // Command packets received
+    unsigned long fail_at;      // Fault injection: stop answering once commands reaches it, 0 = off
+};
+
+static emu_bus_t emu_buses[ATECC_EMU_BUSES];
+static uint32_t emu_hz = EMU_DEFAULT_HZ;
+static bool emu_unlocked;
+static atomic_uint emu_chips;
+static pthread_once_t emu_once = PTHREAD_ONCE_INIT;
+
+static void emu_init(void) {
+    for (size_t i = 0; i < ATECC_EMU_BUSES; i++) {
+        pthread_mutex_init(&emu_buses[i].lock, NULL);
+    }
+    const char *hz = getenv("ATECC_EMU_HZ");
+    if (hz && strtoul(hz, NULL, 10) > 0) {
+        emu_hz = (uint32_t)strtoul(hz, NULL, 10);
+    }
+    const char *unlocked = getenv("ATECC_EMU_UNLOCKED");
+    emu_unlocked = unlocked && strcmp(unlocked, "0") != 0;
+}
+
+/**
+ * @brief Whether a bus name refers to an emulated bus ("emu0" to "emu15")
+ */
+bool atecc_emu_bus(const char *bus) {
+    size_t prefix = strlen(ATECC_EMU_BUS_PREFIX);
+    if (!bus || strncmp(bus, ATECC_EMU_BUS_PREFIX, prefix) != 0 || bus[prefix] < '0' || bus[prefix] > '9') {
+        return false;
+    }
+    char *end = NULL;
+    unsigned long index = strtoul(&bus[prefix], &end, 10);
+    return *end == '\0' && index < ATECC_EMU_BUSES;
+}
+
+/**
+ * @brief Fill the config zone of a freshly provisioned, locked chip
+ *
+ * Slots 0-4 hold P-256 private keys usable for external signing and ECDH,
+ * slot 9 an AES key, the rest data. The serial number is unique per chip;
+ * the keys are the same on every chip, as in a uniformly provisioned pool.
+ * With $ATECC_EMU_UNLOCKED set the config and data zones start unlocked, as
+ * on a chip fresh from the factory, so provisioning can run against it.
+ */
+static void emu_config(struct atecc_emu_chip *chip, uint32_t id, uint8_t bus, uint16_t address) {
+    static const uint8_t revision[] = { 0x00, 0x00, 0x60, 0x02 };
+    uint8_t *config = chip->config;
+
+    memset(config, 0, ATECC_CONFIG_SIZE);
+    config[0] = 0x01;
+    config[1] = 0x23;
+    config[2] = bus;
+    config[3] = (uint8_t)address;
+    memcpy(&config[4], revision, sizeof(revision));
+    config[8] = (uint8_t)id;
+    config[9] = (uint8_t)(id >> 8);
+    config[10] = (uint8_t)(id >> 16);
+    config[11] = (uint8_t)(id >> 24);
+    config[12] = 0xEE;
+    config[13] = 0x01;                          // AES enabled
+    config[16] = (uint8_t)(address << 1);
+    for (size_t slot = 0; slot < ATECC_SLOT_COUNT; slot++) {
+        uint8_t *slot_config = &config[20U + 2U * slot];
+        uint8_t *key_config = &config[96U + 2U * slot];
+        if (slot <= 4U) {
+            slot_config[0] = 0x85;              // IsSecret, ReadKey: external sign and ECDH
+            slot_config[1] = 0x20;
+            key_config[0] = 0x33;               // Private P-256 key, public key derivable
+        } else if (slot == RIG_KEY_SLOT) {
+            slot_config[0] = 0x80;
+            key_config[0] = 0x18;               // AES key
+        } else {
+            key_config[0] = 0x1C;               // Data
+        }
+    }
+    config[ATECC_CONFIG_LOCK_VALUE] = emu_unlocked ? 0x55 : 0x00;
+    config[ATECC_CONFIG_LOCK_CONFIG] = emu_unlocked ? 0x55 : 0x00;
+    chip->random_state = 0x9E3779B97F4A7C15ULL * (id + 1U);
+}
+
+/**
+ * @brief Attach a handle to a new emulated chip on an emulated bus
+ *
+ * Addresses 0x70-0x77 are TCA9548A muxes, everything else an ATECC608.
+ * Every handle is its own chip, so two handles never share state.
+ *
+ * @param dev Handle to initialize, already cleared
+ * @param bus Emulated bus name
+ * @param address 7-bit address
+ * @return true on success, false otherwise
+ */
+bool atecc_emu_attach(atecc_dev_t *dev, const char *bus, uint16_t address) {
+    if (!dev || !atecc_emu_bus(bus)) {
+        errno = EINVAL;
+        return false;
+    }
+    pthread_once(&emu_once, emu_init);
+
+    struct atecc_emu_chip *chip = calloc(1, sizeof(*chip));
+    if (!chip) {
+        return false;
+    }
+    // A real descriptor keeps the fd checks and atecc_close() working unchanged
+    dev->fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+    if (dev->fd < 0) {
+        perror("atecc_emu_attach: open /dev/null");
+        free(chip);
+        return false;
+    }
+
+    unsigned long index = strtoul(&bus[strlen(ATECC_EMU_BUS_PREFIX)], NULL, 10);
+    chip->bus = &emu_buses[index];
+    chip->mux = (address >= EMU_MUX_FIRST && address <= EMU_MUX_LAST);
+    emu_config(chip, atomic_fetch_add(&emu_chips, 1U), (uint8_t)index, address);
+
+    dev->emu = chip;
+    dev->address = address;
+    dev->xfer = ATECC_XFER_EMU;
+    snprintf(dev->bus, sizeof(dev->bus), "%s", bus);
+    return true;
+}
+
+/**
+ * @brief Release the emulated chip behind a handle
+ */
+void atecc_emu_detach(atecc_dev_t *dev) {
+    if (dev) {
+        free(dev->emu);
+        dev->emu = NULL;
+    }
+}
+
+/**
+ * @brief Make an emulated chip stop answering after a number of further commands
+ *
+ * From then on every transfer NACKs, exactly as a chip that dropped off
+ * the bus would, so the caller's polling, health tracking and failover run
+ * their normal paths. Real adapters have no such hook, keeping it out of
+ * the transfer path.
+ *
+ * @param dev Handle of an emulated chip
+ * @param commands Commands the chip still executes, counting from now
+ * @return true on success, false with errno set to EOPNOTSUPP for real devices
+ */
+bool atecc_emu_fail_after(atecc_dev_t *dev, unsigned long commands) {
+    if (!dev || !dev->emu || commands == 0) {
+        errno = dev && !dev->emu ? EOPNOTSUPP : EINVAL;
+        return false;
+    }
+    struct atecc_emu_chip *chip = dev->emu;
+    pthread_mutex_lock(&chip->bus->lock);
+    chip->fail_at = chip->commands + commands;
+    pthread_mutex_unlock(&chip->bus->lock);
+    return true;
+}
+
+/**
+ * @brief Book a transfer on the wire, after whatever is already booked
+ *
+ * Called with the bus lock held. Wire time is the bytes at nine clocks
+ * each plus START and STOP at the emulated bus clock.
+ *
+ * @return When the transfer ends
+ */
+static uint64_t emu_book(emu_bus_t *bus, uint64_t start, size_t bytes) {
+    uint64_t wire_us = ((uint64_t)bytes * EMU_BITS_PER_BYTE + EMU_FRAME_BITS) * 1000000U / emu_hz;
+    bus->free_at_us = start + wire_us;
+    bus->busy_us += wire_us;
+    bus->transfers++;
+    return bus->free_at_us;
+}
+
+/**
+ * @brief Hold the caller until its transfer has left the wire
+ */
+static void emu_wait(uint64_t end_us) {
+    struct timespec until = { .tv_sec = (time_t)(end_us / 1000000U), .tv_nsec = (long)(end_us % 1000000U) * 1000L };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+    }
+}
+
+/**
+ * @brief Whether the chip is awake at now, letting its watchdog put it to sleep
+ */
+static bool emu_awake(struct atecc_emu_chip *chip, uint64_t now) {
+    if (chip->wake_at_us != 0 && now >= chip->wake_at_us + EMU_WATCHDOG_US) {
+        chip->wake_at_us = 0;
+    }
+    return chip->wake_at_us != 0 && now >= chip->wake_at_us;
+}
+
+/**
+ * @brief Whether an injected fault has taken the chip off the bus (see atecc_emu_fail_after())
+ */
+static bool emu_failed(const struct atecc_emu_chip *chip) {
+    return chip->fail_at != 0 && chip->commands >= chip->fail_at;
+}
+
+/**
+ * @brief Whether the handle's mux channel is enabled, or the device is directly attached
+ */
+static bool emu_selected(const atecc_dev_t *dev) {
+    if (!dev->mux) {
+        return true;
+    }
+    const struct atecc_emu_chip *mux = dev->mux->port.emu;
+    return mux && (mux->control & (1U << dev->mux_channel)) != 0;
+}
+
+/**
+ * @brief Queue a response packet: count, data, CRC
+ */
+static void emu_respond(struct atecc_emu_chip *chip, const uint8_t *data, size_t length) {
+    chip->response[0] = (uint8_t)(length + 3U);
+    memcpy(&chip->response[1], data, length);
+    uint16_t crc = atecc_crc16(chip->response, length + 1U);
+    chip->response[length + 1U] = (uint8_t)crc;
+    chip->response[length + 2U] = (uint8_t)(crc >> 8);
+    chip->response_length = length + 3U;
+}
+
+static void emu_status(struct atecc_emu_chip *chip, uint8_t status) {
+    emu_respond(chip, &status, 1U);
+}
+
+/**
+ * @brief Key material of a slot, the same on every emulated chip
+ */
+static void emu_derive(const char *label, uint8_t slot, const uint8_t *extra, size_t extra_length, uint8_t *out) {
+    sha256_ctx_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, (const uint8_t *)label, strlen(label));
+    sha256_update(&ctx, &slot, 1U);
+    if (extra_length > 0) {
+        sha256_update(&ctx, extra, extra_length);
+    }
+    sha256_final(&ctx, out);
+}
+
+static uint32_t emu_exec_us(uint8_t opcode, uint8_t mode) {
+    if (opcode == ATECC_CMD_SELFTEST) {
+        uint32_t exec_us = 0;
+        for (size_t i = 0; i < sizeof(emu_selftest_exec) / sizeof(emu_selftest_exec[0]); i++) {
+            if (mode & emu_selftest_exec[i].test) {
+                exec_us += emu_selftest_exec[i].exec_us;
+            }
+        }
+        return exec_us ? exec_us : EMU_DEFAULT_EXEC_US;
+    }
+    for (size_t i = 0; i < sizeof(emu_exec) / sizeof(emu_exec[0]); i++) {
+        if (emu_exec[i].opcode == opcode) {
+            return emu_exec[i].exec_us;
+        }
+    }
+    return EMU_DEFAULT_EXEC_US;
+}
+
+/**
+ * @brief Locate a data zone word or block from a Read/Write param2
+ *
+ * @param param2 Block in bits 8-11, slot in bits 3-6, word in bits 0-2
+ * @param size 4 or 32
+ * @param slot Receives the slot
+ * @param offset Receives the offset into the chip's data array
+ * @return true if the address lies inside the slot, false otherwise
+ */
+static bool emu_data_address(uint16_t param2, size_t size, uint8_t *slot, size_t *offset) {
+    *slot = (uint8_t)((param2 >> 3) & 0x0FU);
+    size_t within = (size_t)(param2 >> 8) * 32U + (size_t)(param2 & 0x07U) * 4U;
+    if (within % size != 0U || within + size > atecc_slot_size(*slot)) {
+        return false;
+    }
+    *offset = within;
+    for (uint8_t s = 0; s < *slot; s++) {
+        *offset += atecc_slot_size(s);
+    }
+    return true;
+}
+
+/**
+ * @brief SlotConfig of a slot, little-endian in the config zone
+ */
+static uint16_t emu_slot_config(const struct atecc_emu_chip *chip, uint8_t slot) {
+    return (uint16_t)(chip->config[20U + 2U * slot] | (chip->config[21U + 2U * slot] << 8));
+}
+
+static bool emu_config_locked(const struct atecc_emu_chip *chip) {
+    return chip->config[ATECC_CONFIG_LOCK_CONFIG] == 0x00;
+}
+
+static bool emu_data_locked(const struct atecc_emu_chip *chip) {
+    return chip->config[ATECC_CONFIG_LOCK_VALUE] == 0x00;
+}
+
+/**
+ * @brief Read: config words or blocks, data slots the chip lets out, zeros for OTP
+ */
+static void emu_read(struct atecc_emu_chip *chip, uint8_t mode, uint16_t param2) {
+    size_t size = (mode & ATECC_ZONE_READ_32) ? 32U : 4U;
+    uint8_t zone = mode & 0x03U;
+    if (zone == EMU_ZONE_CONFIG) {
+        size_t offset = (size_t)(param2 & 0x1FU) * 4U;
+        if (offset % size != 0U || offset + size > ATECC_CONFIG_SIZE) {
+            emu_status(chip, EMU_STATUS_PARSE);
+        } else {
+            emu_respond(chip, &chip->config[offset], size);
+        }
+    } else if (zone == EMU_ZONE_DATA) {
+        uint8_t slot = 0;
+        size_t offset = 0;
+        if (!emu_data_address(param2, size, &slot, &offset)) {
+            emu_status(chip, EMU_STATUS_PARSE);
+        } else if (!emu_data_locked(chip) || (emu_slot_config(chip, slot) & 0x0080U) != 0U) {
+            // Data slots are readable once the data zone is locked, and secret ones never
+            emu_status(chip, EMU_STATUS_EXEC);
+        } else {
+            emu_respond(chip, &chip->data[offset], size);
+        }
+    } else {
+        uint8_t zeros[32] = {0};
+        emu_respond(chip, zeros, size);
+    }
+}
+
+/**
+ * @brief Write: config words and blocks until the config zone locks, then data slots
+ *
+ * As on the chip, config writes leave the read-only head and bytes 84-87
+ * as they are, data writes need a locked config zone, and once the data
+ * zone is locked only slots whose WriteConfig is Always take clear writes.
+ * Encrypted writes and the OTP zone are not emulated.
+ */
+static void emu_write(struct atecc_emu_chip *chip, uint8_t mode, uint16_t param2, const uint8_t *data,
+                      size_t data_length) {
+    size_t size = (mode & 0x80U) ? 32U : 4U;
+    uint8_t zone = mode & 0x03U;
+    if (data_length != size || (mode & 0x40U) != 0U || zone == EMU_ZONE_OTP || zone > EMU_ZONE_DATA) {
+        emu_status(chip, EMU_STATUS_PARSE);
+        return;
+    }
+
+    if (zone == EMU_ZONE_CONFIG) {
+        size_t offset = (size_t)(param2 & 0x1FU) * 4U;
+        if (offset % size != 0U || offset + size > ATECC_CONFIG_SIZE) {
+            emu_status(chip, EMU_STATUS_PARSE);
+            return;
+        }
+        if (emu_config_locked(chip)) {
+            emu_status(chip, EMU_STATUS_EXEC);
+            return;
+        }
+        for (size_t i = 0; i < size; i++) {
+            size_t at = offset + i;
+            if (at >= EMU_CONFIG_HEAD && (at < EMU_CONFIG_EXTRA || at >= EMU_CONFIG_EXTRA + 4U)) {
+                chip->config[at] = data[i];
+            }
+        }
+        emu_status(chip, ATECC_STATUS_SUCCESS);
+        return;
+    }
+
+    uint8_t slot = 0;
+    size_t offset = 0;
+    if (!emu_data_address(param2, size, &slot, &offset)) {
+        emu_status(chip, EMU_STATUS_PARSE);
+        return;
+    }
+    if (!emu_config_locked(chip) || (emu_data_locked(chip) && (emu_slot_config(chip, slot) >> 12) != 0U)) {
+        emu_status(chip, EMU_STATUS_EXEC);
+        return;
+    }
+    memcpy(&chip->data[offset], data, size);
+    emu_status(chip, ATECC_STATUS_SUCCESS);
+}
+
+/**
+ * @brief Lock the config zone, or the data and OTP zones, if the summary CRC matches
+ *
+ * The CRC runs over the zone's current contents, so a Lock after a write
+ * the host did not expect fails. Locking single slots is not emulated.
+ */
+static void emu_lock(struct atecc_emu_chip *chip, uint8_t mode, uint16_t summary) {
+    uint8_t zone = mode & 0x03U;
+    uint16_t crc = 0;
+    if (zone == EMU_ZONE_CONFIG) {
+        if (emu_config_locked(chip)) {
+            emu_status(chip, EMU_STATUS_EXEC);
+            return;
+        }
+        crc = atecc_crc16(chip->config, ATECC_CONFIG_SIZE);
+    } else if (zone == EMU_ZONE_OTP) {
+        if (!emu_config_locked(chip) || emu_data_locked(chip)) {
+            emu_status(chip, EMU_STATUS_EXEC);
+            return;
+        }
+        // The OTP zone is not emulated and reads as zeros
+        uint8_t zones[EMU_DATA_SIZE + EMU_OTP_SIZE] = {0};
+        memcpy(zones, chip->data, EMU_DATA_SIZE);
+        crc = atecc_crc16(zones, sizeof(zones));
+    } else {
+        emu_status(chip, EMU_STATUS_PARSE);
+        return;
+    }
+
+    if ((mode & EMU_LOCK_NO_CRC) == 0U && crc != summary) {
+        emu_status(chip, EMU_STATUS_EXEC);
+        return;
+    }
+    chip->config[zone == EMU_ZONE_CONFIG ? ATECC_CONFIG_LOCK_CONFIG : ATECC_CONFIG_LOCK_VALUE] = 0x00;
+    emu_status(chip, ATECC_STATUS_SUCCESS);
+}
+
+/**
+ * @brief Public key of a slot, as GenKey returns it
+ */
+static void emu_public_key(uint8_t slot, uint8_t *out) {
+    emu_derive("public-x", slot, NULL, 0, out);
+    emu_derive("public-y", slot, NULL, 0, &out[EMU_KEY_SIZE]);
+}
+
+/**
+ * @brief Verify: accept exactly the signature Sign returns for the key's slot and TempKey
+ *
+ * Emulated signatures are derived rather than computed with ECDSA, so a
+ * supplied public key is matched against the keys GenKey returns to find
+ * the slot whose Sign would have produced the signature.
+ */
+static void emu_verify(struct atecc_emu_chip *chip, uint8_t mode, uint16_t param2, const uint8_t *data,
+                       size_t data_length) {
+    uint8_t key[2U * EMU_KEY_SIZE];
+    uint8_t expected[2U * EMU_KEY_SIZE];
+    size_t slot = ATECC_SLOT_COUNT;
+
+    if (mode == EMU_VERIFY_STORED && data_length == sizeof(expected) && param2 < ATECC_SLOT_COUNT) {
+        slot = param2;
+    } else if (mode == EMU_VERIFY_EXTERNAL && data_length == 2U * sizeof(expected)) {
+        for (size_t candidate = 0; candidate < ATECC_SLOT_COUNT && slot == ATECC_SLOT_COUNT; candidate++) {
+            emu_public_key((uint8_t)candidate, key);
+            if (memcmp(key, &data[sizeof(expected)], sizeof(key)) == 0) {
+                slot = candidate;
+            }
+        }
+        if (slot == ATECC_SLOT_COUNT) {
+            emu_status(chip, EMU_STATUS_VERIFY);
+            return;
+        }
+    } else {
+        emu_status(chip, EMU_STATUS_PARSE);
+        return;
+    }
+
+    emu_derive("sign-r", (uint8_t)slot, chip->temp_key, EMU_KEY_SIZE, expected);
+    emu_derive("sign-s", (uint8_t)slot, chip->temp_key, EMU_KEY_SIZE, &expected[EMU_KEY_SIZE]);
+    emu_status(chip, memcmp(expected, data, sizeof(expected)) == 0 ? ATECC_STATUS_SUCCESS : EMU_STATUS_VERIFY);
+}
+
+/**
+ * @brief Run a command packet and queue its response for when execution ends
+ *
+ * Random, SHA, Read, Write, Lock and Info behave like the chip. Key
+ * operations return deterministic stand-ins derived from the slot with
+ * SHA-256, and AES is a keyed XOR that is its own inverse: the results are
+ * consistent across chips, so pooled output can still be compared, but
+ * they are not cryptographically what a real chip returns. Verify accepts
+ * exactly the stand-in signatures of Sign.
+ */
+static void emu_execute(struct atecc_emu_chip *chip, const uint8_t *buf, size_t len, uint64_t now) {
+    chip->commands++;
+    chip->ready_us = now;
+    if (len < 8U || buf[1] != len - 1U) {
+        emu_status(chip, EMU_STATUS_CRC);
+        return;
+    }
+    uint16_t crc = atecc_crc16(&buf[1], len - 3U);
+    if (buf[len - 2U] != (uint8_t)crc || buf[len - 1U] != (uint8_t)(crc >> 8)) {
+        emu_status(chip, EMU_STATUS_CRC);
+        return;
+    }
+
+    uint8_t opcode = buf[2];
+    uint8_t mode = buf[3];
+    uint16_t param2 = (uint16_t)(buf[4] | (buf[5] << 8));
+    const uint8_t *data = &buf[6];
+    size_t data_length = len - 8U;
+    uint8_t out[2U * EMU_KEY_SIZE];
+    uint8_t slot = (uint8_t)(param2 & 0x0FU);
+    chip->ready_us = now + emu_exec_us(opcode, mode);
+
+    switch (opcode) {
+    case ATECC_CMD_READ:
+        emu_read(chip, mode, param2);
+        break;
+    case ATECC_CMD_RANDOM:
+        for (size_t i = 0; i < EMU_KEY_SIZE; i++) {
+            uint64_t x = chip->random_state;
+            x ^= x >> 12;
+            x ^= x << 25;
+            x ^= x >> 27;
+            chip->random_state = x;
+            out[i] = (uint8_t)((x * 0x2545F4914F6CDD1DULL) >> 56);
+        }
+        emu_respond(chip, out, EMU_KEY_SIZE);
+        break;
+    case ATECC_CMD_SHA:
+        if ((mode & 0x07U) == 0x00U) {
+            sha256_init(&chip->sha);
+            emu_status(chip, ATECC_STATUS_SUCCESS);
+        } else if ((mode & 0x07U) == 0x01U && data_length == 64U) {
+            sha256_update(&chip->sha, data, data_length);
+            emu_status(chip, ATECC_STATUS_SUCCESS);
+        } else if ((mode & 0x07U) == 0x02U && data_length == param2 && data_length < 64U) {
+            sha256_update(&chip->sha, data, data_length);
+            sha256_final(&chip->sha, out);
+            emu_respond(chip, out, EMU_KEY_SIZE);
+        } else {
+            emu_status(chip, EMU_STATUS_PARSE);
+        }
+        break;
+    case EMU_CMD_AES:
+        if (data_length != EMU_BLOCK_SIZE || (mode & 0x03U) > 1U) {
+            emu_status(chip, EMU_STATUS_PARSE);
+            break;
+        }
+        emu_derive("aes", slot, NULL, 0, out);
+        for (size_t i = 0; i < EMU_BLOCK_SIZE; i++) {
+            out[i] ^= data[i];
+        }
+        emu_respond(chip, out, EMU_BLOCK_SIZE);
+        break;
+    case ATECC_CMD_NONCE:
+        if (mode == EMU_NONCE_PASSTHRU && data_length == EMU_KEY_SIZE) {
+            memcpy(chip->temp_key, data, EMU_KEY_SIZE);
+            emu_status(chip, ATECC_STATUS_SUCCESS);
+        } else {
+            emu_status(chip, EMU_STATUS_PARSE);
+        }
+        break;
+    case ATECC_CMD_GENKEY:
+        emu_public_key(slot, out);
+        emu_respond(chip, out, sizeof(out));
+        break;
+    case ATECC_CMD_SIGN:
+        emu_derive("sign-r", slot, chip->temp_key, EMU_KEY_SIZE, out);
+        emu_derive("sign-s", slot, chip->temp_key, EMU_KEY_SIZE, &out[EMU_KEY_SIZE]);
+        emu_respond(chip, out, sizeof(out));
+        break;
+    case ATECC_CMD_ECDH:
+        emu_derive("ecdh", slot, data, data_length, out);
+        emu_respond(chip, out, EMU_KEY_SIZE);
+        break;
+    case EMU_CMD_INFO:
+        emu_respond(chip, &chip->config[4], 4U);
+        break;
+    case ATECC_CMD_LOCK:
+        emu_lock(chip, mode, param2);
+        break;
+    case ATECC_CMD_WRITE:
+        emu_write(chip, mode, param2, data, data_length);
+        break;
+    case ATECC_CMD_VERIFY:
+        emu_verify(chip, mode, param2, data, data_length);
+        break;
+    case ATECC_CMD_SELFTEST:
+        emu_status(chip, ATECC_STATUS_SUCCESS);
+        break;
+    default:
+        emu_status(chip, EMU_STATUS_PARSE);
+        break;
+    }
+}
+
+/**
+ * @brief Write to an emulated chip or mux
+ *
+ * The wake token wakes a sleeping chip after ATECC_WAKE_DELAY_US without
+ * being acknowledged. On an awake chip it is taken as a fresh wake, which
+ * restarts the watchdog. A chip that is asleep, still waking or executing
+ * a command NACKs, exactly as on a real bus, and a chip behind a mux
+ * channel that is not enabled does not answer at all. The caller is held
+ * until the transfer has left the wire, including time spent waiting for
+ * transfers of other devices on the same bus.
+ *
+ * @return true on success, false with errno set otherwise
+ */
+bool atecc_emu_write(atecc_dev_t *dev, const uint8_t *buf, size_t len) {
+    struct atecc_emu_chip *chip = dev->emu;
+    emu_bus_t *bus = chip->bus;
+    int error = 0;
+
+    pthread_mutex_lock(&bus->lock);
+    uint64_t now = atecc_now_us();
+    uint64_t start = (bus->free_at_us > now) ? bus->free_at_us : now;
+    bool token = (len == 1U && buf[0] == ATECC_WAKE_TOKEN);
+    if (!emu_selected(dev)) {
+        error = ENXIO;
+    } else if (emu_failed(chip)) {
+        error = EREMOTEIO;
+    } else if (!chip->mux && token) {
+        bool awake = emu_awake(chip, start);
+        chip->wake_at_us = awake ? start : start + ATECC_WAKE_DELAY_US;
+        chip->ready_us = 0;
+        emu_status(chip, ATECC_STATUS_WAKE);
+        error = awake ? 0 : EREMOTEIO;
+    } else if (!chip->mux && (!emu_awake(chip, start) || start < chip->ready_us)) {
+        error = EREMOTEIO;
+    }
+
+    uint64_t end = emu_book(bus, start, error ? 1U : len + 1U);
+    if (!error && chip->mux) {
+        chip->control = buf[0];
+    } else if (!error && (buf[0] == ATECC_WORDADDR_SLEEP || buf[0] == EMU_WORDADDR_IDLE)) {
+        chip->wake_at_us = 0;
+    } else if (!error && buf[0] == ATECC_WORDADDR_CMD) {
+        emu_execute(chip, buf, len, end);
+    }
+    pthread_mutex_unlock(&bus->lock);
+
+    emu_wait(end);
+    errno = error;
+    return error == 0;
+}
+
+/**
+ * @brief Read from an emulated chip or mux: the queued response, padded with 0xFF
+ *
+ * @return true on success, false with errno set otherwise
+ */
+bool atecc_emu_read(atecc_dev_t *dev, uint8_t *buf, size_t len) {
+    struct atecc_emu_chip *chip = dev->emu;
+    emu_bus_t *bus = chip->bus;
+    int error = 0;
+
+    pthread_mutex_lock(&bus->lock);
+    uint64_t now = atecc_now_us();
+    uint64_t start = (bus->free_at_us > now) ? bus->free_at_us : now;
+    if (!emu_selected(dev)) {
+        error = ENXIO;
+    } else if (emu_failed(chip) || (!chip->mux && (!emu_awake(chip, start) || start < chip->ready_us))) {
+        error = EREMOTEIO;
+    }
+
+    uint64_t end = emu_book(bus, start, error ? 1U : len + 1U);
+    if (!error && chip->mux) {
+        memset(buf, chip->control, len);
+    } else if (!error) {
+        size_t copied = (len < chip->response_length) ? len : chip->response_length;
+        memcpy(buf, chip->response, copied);
+        memset(&buf[copied], 0xFF, len - copied);
+    }
+    pthread_mutex_unlock(&bus->lock);
+
+    emu_wait(end);
+    errno = error;
+    return error == 0;
+}
+
+/**
+ * @brief One measured rig size
+ */
+typedef struct {
+    size_t devices;
+    double rate;            // Bytes per second
+    double wire_pct;        // Busiest bus, percent of the run
+    double mux_per_block;   // Mux control writes per AES block
+    bool ok;
+} rig_result_t;
+
+/**
+ * @brief Wire time used so far on each bus
+ */
+static void rig_wire(uint64_t *busy_us) {
+    for (size_t i = 0; i < ATECC_EMU_BUSES; i++) {
+        pthread_mutex_lock(&emu_buses[i].lock);
+        busy_us[i] = emu_buses[i].busy_us;
+        pthread_mutex_unlock(&emu_buses[i].lock);
+    }
+}
+
+/**
+ * @brief Build a rig of the given size and time AES-CTR over it
+ *
+ * Device i sits on bus i % buses. Directly attached devices count up from
+ * address 0x20; with muxes, eight devices at 0x60 share each TCA9548A,
+ * counting up from 0x70. A short run first wakes every chip, so the
+ * measurement starts from awake devices with their identity read.
+ */
+static bool rig_run(size_t devices, size_t buses, bool muxed, const uint8_t *input, uint8_t *output, size_t bytes,
+                    rig_result_t *result) {
+    char names[ATECC_POOL_MAX][48];
+    const char *specs[ATECC_POOL_MAX];
+    for (size_t i = 0; i < devices; i++) {
+        size_t position = i / buses;
+        if (muxed) {
+            snprintf(names[i], sizeof(names[i]), "%s%zu:0x%02zX.%zu:0x%02X", ATECC_EMU_BUS_PREFIX, i % buses,
+                     EMU_MUX_FIRST + position / TCA9548A_CHANNELS, position % TCA9548A_CHANNELS, RIG_MUXED_ADDRESS);
+        } else {
+            snprintf(names[i], sizeof(names[i]), "%s%zu:0x%02zX", ATECC_EMU_BUS_PREFIX, i % buses,
+                     RIG_DIRECT_FIRST + position);
+        }
+        specs[i] = names[i];
+    }
+
+    atecc_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool || !atecc_pool_open(pool, specs, devices)) {
+        free(pool);
+        return false;
+    }
+
+    uint8_t counter[EMU_BLOCK_SIZE] = {0};
+    uint8_t warm[ATECC_POOL_MAX * EMU_BLOCK_SIZE] = {0};
+    bool ok = atecc_aes_ctr(pool->members, pool->count, RIG_KEY_SLOT, counter, warm, warm,
+                            pool->count * EMU_BLOCK_SIZE);
+    uint64_t wire_before[ATECC_EMU_BUSES];
+    uint64_t wire_after[ATECC_EMU_BUSES];
+    unsigned long switches_before = 0;
+    unsigned long switches_after = 0;
+    for (size_t i = 0; i < pool->mux_count; i++) {
+        switches_before += pool->muxes[i].switches;
+    }
+    rig_wire(wire_before);
+
+    uint64_t start = atecc_now_us();
+    ok = ok && atecc_aes_ctr(pool->members, pool->count, RIG_KEY_SLOT, counter, input, output, bytes);
+    uint64_t elapsed_us = atecc_now_us() - start;
+
+    rig_wire(wire_after);
+    uint64_t busiest = 0;
+    for (size_t i = 0; i < buses; i++) {
+        if (wire_after[i] - wire_before[i] > busiest) {
+            busiest = wire_after[i] - wire_before[i];
+        }
+    }
+    for (size_t i = 0; i < pool->mux_count; i++) {
+        switches_after += pool->muxes[i].switches;
+    }
+
+    result->devices = pool->count;
+    result->rate = elapsed_us ? (double)bytes * 1e6 / (double)elapsed_us : 0.0;
+    result->wire_pct = elapsed_us ? 100.0 * (double)busiest / (double)elapsed_us : 0.0;
+    result->mux_per_block = (double)(switches_after - switches_before) /
+                            (double)((bytes + EMU_BLOCK_SIZE - 1U) / EMU_BLOCK_SIZE);
+    result->ok = ok;
+    atecc_pool_close(pool);
+    free(pool);
+    return ok;
+}
+
+/**
+ * @brief Chart pool scaling against device count on emulated rigs
+ *
+ * Usage: rig-bench [--buses B] [--mux] [--max N] [--hz HZ] [--bytes N]
+ *
+ * Runs AES-CTR over the pool scheduler (atecc_aes_ctr()) on rigs of 1, 2,
+ * 4, ... N emulated devices spread over B buses (see rig_run()), and
+ * reports throughput, speedup over one device, scaling efficiency, the
+ * busiest wire's utilization and, with --mux, mux control writes per
+ * block. Every rig's output is checked against the single-device run.
+ * --hz sets the emulated bus clock (default 400 kHz or $ATECC_EMU_HZ).
+ *
+ * @return Process exit status
+ */
+int atecc_rig_bench_main(int argc, char **argv) {
+    size_t buses = 1;
+    size_t max_devices = RIG_DEFAULT_MAX;
+    size_t bytes = RIG_DEFAULT_BYTES;
+    bool muxed = false;
+    unsigned long hz = 0;
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--buses") == 0 && has_value) {
+            buses = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max") == 0 && has_value) {
+            max_devices = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--hz") == 0 && has_value) {
+            hz = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--bytes") == 0 && has_value) {
+            bytes = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--mux") == 0) {
+            muxed = true;
+        } else {
+            fprintf(stderr, "usage: pi_atecc rig-bench [--buses B] [--mux] [--max N] [--hz HZ] [--bytes N]\n");
+            return 2;
+        }
+    }
+    if (buses == 0 || buses > ATECC_EMU_BUSES || max_devices == 0 || max_devices > ATECC_POOL_MAX || bytes == 0) {
+        fprintf(stderr, "rig-bench: --buses must be 1-%d, --max 1-%d and --bytes positive\n", ATECC_EMU_BUSES,
+                ATECC_POOL_MAX);
+        return 2;
+    }
+    pthread_once(&emu_once, emu_init);
+    if (hz > 0) {
+        emu_hz = (uint32_t)hz;
+    }
+
+    uint8_t *input = calloc(bytes, 1);
+    uint8_t *reference = malloc(bytes);
+    uint8_t *output = malloc(bytes);
+    if (!input || !reference || !output) {
+        perror("rig-bench");
+        free(input);
+        free(reference);
+        free(output);
+        return 1;
+    }
+
+    // Powers of two, then the maximum itself
+    size_t counts[RIG_MAX_ROWS];
+    size_t rows = 0;
+    for (size_t devices = 1; devices < max_devices; devices *= 2U) {
+        counts[rows++] = devices;
+    }
+    counts[rows++] = max_devices;
+
+    rig_result_t results[RIG_MAX_ROWS] = {0};
+    bool ok = true;
+    for (size_t r = 0; r < rows && ok; r++) {
+        ok = rig_run(counts[r], buses, muxed, input, r == 0 ? reference : output, bytes, &results[r]);
+        if (ok && r > 0 && memcmp(reference, output, bytes) != 0) {
+            fprintf(stderr, "rig-bench: %zu devices produced different output\n", counts[r]);
+            ok = false;
+        }
+    }
+
+    printf("devices  buses        B/s  speedup  efficiency  wire busy  mux/block  efficiency\n");
+    for (size_t r = 0; r < rows && results[r].ok; r++) {
+        const rig_result_t *result = &results[r];
+        double speedup = results[0].rate > 0.0 ? result->rate / results[0].rate : 0.0;
+        double efficiency = 100.0 * speedup / (double)result->devices;
+        char bar[RIG_BAR + 1];
+        size_t bar_len = (size_t)(efficiency * RIG_BAR / 100.0);
+        bar_len = bar_len > RIG_BAR ? RIG_BAR : bar_len;
+        memset(bar, '#', bar_len);
+        bar[bar_len] = '\0';
+        printf("%7zu  %5zu  %9.1f  %6.2fx  %9.1f%%  %8.1f%%  %9.2f  %s\n", result->devices,
+               result->devices < buses ? result->devices : buses, result->rate, speedup, efficiency,
+               result->wire_pct, result->mux_per_block, bar);
+    }
+    printf("📊 %s at %u Hz; efficiency bar: one '#' per %.1f %%\n", muxed ? "behind TCA9548A muxes" : "directly attached",
+           emu_hz, 100.0 / RIG_BAR);
+
+    free(input);
+    free(reference);
+    free(output);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,539 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "pi_atecc.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FMT_SIMD_NAME "NEON"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FMT_SIMD_NAME "SSE2"
+#else
+#define FMT_SIMD_NAME "scalar"
+#endif
+
+enum {
+    FMT_OUT_DEFAULT_CAPACITY = 1U << 20,
+    FMT_BASE64_CHUNK         = 48U,        // Input bytes per base64 vector step
+    FMT_BENCH_DEFAULT_MIB    = 16U,
+    FMT_BENCH_PRINTF_MIB     = 1U          // printf is too slow for the full size
+};
+
+static const char base64_alphabet[64] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * @brief Scalar hex digits, each byte followed by a space when spaced
+ *
+ * Writes 2 or 3 characters per byte without a terminator; the vector paths
+ * fall back to this for their tails.
+ */
+static void hex_scalar(const uint8_t *data, size_t length, char *out, unsigned int flags) {
+    const char *digits = (flags & ATECC_HEX_LOWER) ? "0123456789abcdef" : "0123456789ABCDEF";
+    bool spaced = (flags & ATECC_HEX_SPACED) != 0U;
+
+    for (size_t i = 0; i < length; i++) {
+        *out++ = digits[data[i] >> 4];
+        *out++ = digits[data[i] & 0x0FU];
+        if (spaced) {
+            *out++ = ' ';
+        }
+    }
+}
+
+#if defined(__ARM_NEON)
+
+static uint8x16_t nibble_to_ascii(uint8x16_t nibble, uint8x16_t letter_adjust) {
+    uint8x16_t is_letter = vcgtq_u8(nibble, vdupq_n_u8(9));
+    return vaddq_u8(vaddq_u8(nibble, vdupq_n_u8('0')), vandq_u8(is_letter, letter_adjust));
+}
+
+/**
+ * @brief 16 bytes per step; the interleaving stores place the digit pairs
+ * (and separators) without any shuffling
+ */
+static void hex_raw(const uint8_t *data, size_t length, char *out, unsigned int flags) {
+    uint8x16_t letter_adjust = vdupq_n_u8((flags & ATECC_HEX_LOWER) ? 'a' - '0' - 10 : 'A' - '0' - 10);
+    bool spaced = (flags & ATECC_HEX_SPACED) != 0U;
+    size_t stride = spaced ? 48U : 32U;
+    size_t i = 0;
+
+    for (; i + 16U <= length; i += 16U, out += stride) {
+        uint8x16_t bytes = vld1q_u8(&data[i]);
+        uint8x16_t high = nibble_to_ascii(vshrq_n_u8(bytes, 4), letter_adjust);
+        uint8x16_t low = nibble_to_ascii(vandq_u8(bytes, vdupq_n_u8(0x0F)), letter_adjust);
+        if (spaced) {
+            uint8x16x3_t triples = { { high, low, vdupq_n_u8(' ') } };
+            vst3q_u8((uint8_t *)out, triples);
+        } else {
+            uint8x16x2_t pairs = { { high, low } };
+            vst2q_u8((uint8_t *)out, pairs);
+        }
+    }
+    hex_scalar(&data[i], length - i, out, flags);
+}
+
+#elif defined(__SSE2__)
+
+static __m128i nibble_to_ascii(__m128i nibble, __m128i letter_adjust) {
+    __m128i is_letter = _mm_cmpgt_epi8(nibble, _mm_set1_epi8(9));
+    return _mm_add_epi8(_mm_add_epi8(nibble, _mm_set1_epi8('0')), _mm_and_si128(is_letter, letter_adjust));
+}
+
+/**
+ * @brief 16 bytes per step; SSE2 has no byte shuffle for the 3-character
+ * spaced layout, so spaced output is expanded from the packed digit pairs
+ */
+static void hex_raw(const uint8_t *data, size_t length, char *out, unsigned int flags) {
+    __m128i letter_adjust = _mm_set1_epi8((flags & ATECC_HEX_LOWER) ? 'a' - '0' - 10 : 'A' - '0' - 10);
+    __m128i mask = _mm_set1_epi8(0x0F);
+    bool spaced = (flags & ATECC_HEX_SPACED) != 0U;
+    size_t i = 0;
+
+    for (; i + 16U <= length; i += 16U) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)&data[i]);
+        __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+        __m128i low = _mm_and_si128(bytes, mask);
+        __m128i first = nibble_to_ascii(_mm_unpacklo_epi8(high, low), letter_adjust);
+        __m128i second = nibble_to_ascii(_mm_unpackhi_epi8(high, low), letter_adjust);
+
+        if (!spaced) {
+            _mm_storeu_si128((__m128i *)out, first);
+            _mm_storeu_si128((__m128i *)(out + 16), second);
+            out += 32;
+            continue;
+        }
+
+        char pairs[32];
+        _mm_storeu_si128((__m128i *)pairs, first);
+        _mm_storeu_si128((__m128i *)(pairs + 16), second);
+        // 4-byte stores overlapping the next pair; the last pair is stored exactly
+        for (unsigned int j = 0; j < 15U; j++, out += 3) {
+            char triple[4] = { pairs[2U * j], pairs[2U * j + 1U], ' ', ' ' };
+            memcpy(out, triple, sizeof(triple));
+        }
+        out[0] = pairs[30];
+        out[1] = pairs[31];
+        out[2] = ' ';
+        out += 3;
+    }
+    hex_scalar(&data[i], length - i, out, flags);
+}
+
+#else
+
+static void hex_raw(const uint8_t *data, size_t length, char *out, unsigned int flags) {
+    hex_scalar(data, length, out, flags);
+}
+
+#endif
+
+/**
+ * @brief Characters hex_raw() writes for length bytes
+ */
+static size_t hex_raw_size(size_t length, unsigned int flags) {
+    return length * ((flags & ATECC_HEX_SPACED) ? 3U : 2U);
+}
+
+/**
+ * @brief Hex-encode bytes into a NUL-terminated string
+ *
+ * The buffer must hold 2 * length + 1 bytes, or 3 * length bytes (at least 1)
+ * with ATECC_HEX_SPACED.
+ *
+ * @param data Bytes to encode
+ * @param length Number of bytes
+ * @param out Output buffer
+ * @param flags ATECC_HEX_LOWER and/or ATECC_HEX_SPACED
+ * @return Number of characters written, excluding the terminator
+ */
+size_t atecc_hex(const uint8_t *data, size_t length, char *out, unsigned int flags) {
+    hex_raw(data, length, out, flags);
+    size_t written = hex_raw_size(length, flags);
+    if ((flags & ATECC_HEX_SPACED) && written > 0U) {
+        written--;  // Drop the trailing separator
+    }
+    out[written] = '\0';
+    return written;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Decode exactly 2 * length hex digits (either case)
+ *
+ * @param text Hex digits
+ * @param length Number of bytes to produce
+ * @param out Output buffer of length bytes
+ * @return true on success, false if a character is not a hex digit
+ */
+bool atecc_hex_decode(const char *text, size_t length, uint8_t *out) {
+    for (size_t i = 0; i < length; i++) {
+        int high = hex_value(text[2U * i]);
+        int low = (high < 0) ? -1 : hex_value(text[2U * i + 1U]);
+        if (low < 0) {
+            return false;
+        }
+        out[i] = (uint8_t)((high << 4) | low);
+    }
+    return true;
+}
+
+/**
+ * @brief Scalar base64 of whole 3-byte groups
+ */
+static void base64_groups_scalar(const uint8_t *data, size_t groups, char *out) {
+    for (size_t i = 0; i < groups; i++, data += 3, out += 4) {
+        uint32_t value = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+        out[0] = base64_alphabet[(value >> 18) & 0x3FU];
+        out[1] = base64_alphabet[(value >> 12) & 0x3FU];
+        out[2] = base64_alphabet[(value >> 6) & 0x3FU];
+        out[3] = base64_alphabet[value & 0x3FU];
+    }
+}
+
+/**
+ * @brief Base64 of whole 3-byte groups, 48 bytes per step where a table lookup instruction exists
+ */
+static void base64_groups(const uint8_t *data, size_t groups, char *out) {
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16x4_t table = { { vld1q_u8((const uint8_t *)&base64_alphabet[0]),
+                             vld1q_u8((const uint8_t *)&base64_alphabet[16]),
+                             vld1q_u8((const uint8_t *)&base64_alphabet[32]),
+                             vld1q_u8((const uint8_t *)&base64_alphabet[48]) } };
+    uint8x16_t six_bits = vdupq_n_u8(0x3F);
+
+    for (; groups >= FMT_BASE64_CHUNK / 3U; groups -= FMT_BASE64_CHUNK / 3U) {
+        uint8x16x3_t in = vld3q_u8(data);
+        uint8x16_t a = in.val[0], b = in.val[1], c = in.val[2];
+        uint8x16x4_t chars = { {
+            vqtbl4q_u8(table, vshrq_n_u8(a, 2)),
+            vqtbl4q_u8(table, vandq_u8(vorrq_u8(vshlq_n_u8(a, 4), vshrq_n_u8(b, 4)), six_bits)),
+            vqtbl4q_u8(table, vandq_u8(vorrq_u8(vshlq_n_u8(b, 2), vshrq_n_u8(c, 6)), six_bits)),
+            vqtbl4q_u8(table, vandq_u8(c, six_bits))
+        } };
+        vst4q_u8((uint8_t *)out, chars);
+        data += FMT_BASE64_CHUNK;
+        out += FMT_BASE64_CHUNK / 3U * 4U;
+    }
+#endif
+    base64_groups_scalar(data, groups, out);
+}
+
+/**
+ * @brief Base64-encode (RFC 4648, padded) into a NUL-terminated string
+ *
+ * The buffer must hold 4 * ((length + 2) / 3) + 1 bytes.
+ *
+ * @param data Bytes to encode
+ * @param length Number of bytes
+ * @param out Output buffer
+ * @return Number of characters written, excluding the terminator
+ */
+size_t atecc_base64(const uint8_t *data, size_t length, char *out) {
+    size_t groups = length / 3U;
+    base64_groups(data, groups, out);
+
+    char *tail = &out[groups * 4U];
+    size_t remaining = length - groups * 3U;
+    if (remaining > 0U) {
+        const uint8_t *rest = &data[groups * 3U];
+        uint32_t value = ((uint32_t)rest[0] << 16) | ((remaining > 1U) ? (uint32_t)rest[1] << 8 : 0U);
+        tail[0] = base64_alphabet[(value >> 18) & 0x3FU];
+        tail[1] = base64_alphabet[(value >> 12) & 0x3FU];
+        tail[2] = (remaining > 1U) ? base64_alphabet[(value >> 6) & 0x3FU] : '=';
+        tail[3] = '=';
+        tail += 4;
+    }
+    *tail = '\0';
+    return (size_t)(tail - out);
+}
+
+/**
+ * @brief Set up a buffered sink on a descriptor
+ *
+ * @param out Sink to initialize
+ * @param fd Destination descriptor
+ * @param capacity Buffer size, 0 for the 1 MiB default
+ * @return true on success, false otherwise
+ */
+bool atecc_out_init(atecc_out_t *out, int fd, size_t capacity) {
+    if (!out) {
+        errno = EINVAL;
+        return false;
+    }
+
+    out->fd = fd;
+    out->used = 0;
+    out->capacity = (capacity < 64U) ? FMT_OUT_DEFAULT_CAPACITY : capacity;
+    out->buf = malloc(out->capacity);
+    return out->buf != NULL;
+}
+
+/**
+ * @brief Write all pending output with as few write() calls as the kernel allows
+ *
+ * @param out Sink
+ * @return true on success, false otherwise
+ */
+bool atecc_out_flush(atecc_out_t *out) {
+    size_t done = 0;
+    while (done < out->used) {
+        ssize_t written = write(out->fd, &out->buf[done], out->used - done);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("atecc_out_flush: write failed");
+            out->used = 0;
+            return false;
+        }
+        done += (size_t)written;
+    }
+    out->used = 0;
+    return true;
+}
+
+/**
+ * @brief Make room for at least need bytes, flushing if necessary
+ */
+static bool out_reserve(atecc_out_t *out, size_t need) {
+    if (out->capacity - out->used >= need) {
+        return true;
+    }
+    return atecc_out_flush(out) && out->capacity >= need;
+}
+
+/**
+ * @brief Append raw text
+ *
+ * @param out Sink
+ * @param text Text to append
+ * @param length Number of bytes
+ * @return true on success, false otherwise
+ */
+bool atecc_out_write(atecc_out_t *out, const char *text, size_t length) {
+    while (length > 0U) {
+        if (out->used == out->capacity && !atecc_out_flush(out)) {
+            return false;
+        }
+        size_t take = out->capacity - out->used;
+        if (take > length) {
+            take = length;
+        }
+        memcpy(&out->buf[out->used], text, take);
+        out->used += take;
+        text += take;
+        length -= take;
+    }
+    return true;
+}
+
+/**
+ * @brief Append a NUL-terminated string
+ */
+bool atecc_out_str(atecc_out_t *out, const char *text) {
+    return atecc_out_write(out, text, strlen(text));
+}
+
+/**
+ * @brief Append hex digits, formatted straight into the sink buffer
+ *
+ * @param out Sink
+ * @param data Bytes to encode
+ * @param length Number of bytes
+ * @param flags ATECC_HEX_LOWER and/or ATECC_HEX_SPACED
+ * @return true on success, false otherwise
+ */
+bool atecc_out_hex(atecc_out_t *out, const uint8_t *data, size_t length, unsigned int flags) {
+    size_t per_byte = hex_raw_size(1U, flags);
+
+    while (length > 0U) {
+        if (!out_reserve(out, per_byte * 16U)) {
+            return false;
+        }
+        size_t take = (out->capacity - out->used) / per_byte;
+        if (take > length) {
+            take = length;
+        }
+        hex_raw(data, take, &out->buf[out->used], flags);
+        out->used += take * per_byte;
+        data += take;
+        length -= take;
+    }
+    if ((flags & ATECC_HEX_SPACED) && out->used > 0U && out->buf[out->used - 1U] == ' ') {
+        out->used--;  // Separators go between bytes only
+    }
+    return true;
+}
+
+/**
+ * @brief Append padded base64, formatted straight into the sink buffer
+ *
+ * @param out Sink
+ * @param data Bytes to encode
+ * @param length Number of bytes
+ * @return true on success, false otherwise
+ */
+bool atecc_out_base64(atecc_out_t *out, const uint8_t *data, size_t length) {
+    // Whole groups only, so padding can appear only at the very end
+    while (length >= 3U) {
+        if (!out_reserve(out, FMT_BASE64_CHUNK / 3U * 4U)) {
+            return false;
+        }
+        size_t groups = (out->capacity - out->used) / 4U;
+        if (groups > length / 3U) {
+            groups = length / 3U;
+        }
+        base64_groups(data, groups, &out->buf[out->used]);
+        out->used += groups * 4U;
+        data += groups * 3U;
+        length -= groups * 3U;
+    }
+
+    char tail[8];
+    size_t written = atecc_base64(data, length, tail);
+    return atecc_out_write(out, tail, written);
+}
+
+/**
+ * @brief Release the sink buffer (pending output is discarded; flush first)
+ */
+void atecc_out_free(atecc_out_t *out) {
+    free(out->buf);
+    out->buf = NULL;
+    out->used = 0;
+    out->capacity = 0;
+}
+
+/**
+ * @brief Hand a formatted buffer to the kernel, as the CLI output paths do
+ */
+static void fmt_bench_write(int fd, const char *text, size_t length) {
+    if (write(fd, text, length) < 0) {
+        perror("fmt-bench: write failed");
+    }
+}
+
+/**
+ * @brief Report throughput of one formatter pass in GB/s of input
+ */
+static void fmt_bench_report(const char *label, size_t bytes, uint64_t start_us) {
+    double elapsed_s = (double)(atecc_now_us() - start_us) / 1e6;
+    printf("📊 %-22s %8.3f GB/s\n", label, (double)bytes / elapsed_s / 1e9);
+}
+
+/**
+ * @brief Compare the formatters against the per-byte printf path
+ *
+ * Usage: fmt-bench [MiB]
+ *
+ * Every formatter writes to /dev/null so the kernel cost is the same
+ * single write() per buffer; vector output is checked against the scalar
+ * reference before timing.
+ *
+ * @return Process exit status
+ */
+int atecc_fmt_bench_main(int argc, char **argv) {
+    size_t mib = (argc > 0) ? strtoul(argv[0], NULL, 10) : FMT_BENCH_DEFAULT_MIB;
+    if (mib == 0) {
+        mib = FMT_BENCH_DEFAULT_MIB;
+    }
+    size_t bytes = mib << 20;
+    size_t printf_bytes = (size_t)FMT_BENCH_PRINTF_MIB << 20;
+    if (printf_bytes > bytes) {
+        printf_bytes = bytes;
+    }
+
+    uint8_t *data = malloc(bytes);
+    char *text = malloc(3U * bytes + 1U);
+    char *reference = malloc(3U * bytes + 1U);
+    int null_fd = open("/dev/null", O_WRONLY);
+    FILE *null_file = (null_fd >= 0) ? fdopen(dup(null_fd), "w") : NULL;
+    if (!data || !text || !reference || !null_file) {
+        perror("fmt-bench");
+        free(data);
+        free(text);
+        free(reference);
+        if (null_fd >= 0) {
+            close(null_fd);
+        }
+        return 1;
+    }
+
+    uint32_t seed = 0x2545F491U;
+    for (size_t i = 0; i < bytes; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        data[i] = (uint8_t)seed;
+    }
+
+    static const unsigned int hex_flags[] = {
+        ATECC_HEX_UPPER, ATECC_HEX_LOWER, ATECC_HEX_SPACED, ATECC_HEX_LOWER | ATECC_HEX_SPACED
+    };
+    bool identical = true;
+    for (size_t f = 0; f < sizeof(hex_flags) / sizeof(hex_flags[0]); f++) {
+        hex_scalar(data, bytes, reference, hex_flags[f]);
+        hex_raw(data, bytes, text, hex_flags[f]);
+        identical = identical && memcmp(text, reference, hex_raw_size(bytes, hex_flags[f])) == 0;
+    }
+    atecc_base64(data, bytes, text);
+    base64_groups_scalar(data, bytes / 3U, reference);
+    identical = identical && memcmp(text, reference, (bytes / 3U) * 4U) == 0;
+    printf("🧪 %s formatter output %s scalar reference over %zu MiB\n", FMT_SIMD_NAME,
+           identical ? "matches" : "❌ DIFFERS from", mib);
+
+    uint64_t start = atecc_now_us();
+    for (size_t i = 0; i < printf_bytes; i++) {
+        fprintf(null_file, "%02X ", data[i]);
+    }
+    fflush(null_file);
+    fmt_bench_report("printf(\"%02X \")", printf_bytes, start);
+
+    start = atecc_now_us();
+    hex_scalar(data, bytes, text, ATECC_HEX_SPACED);
+    fmt_bench_write(null_fd, text, hex_raw_size(bytes, ATECC_HEX_SPACED));
+    fmt_bench_report("hex spaced (scalar)", bytes, start);
+
+    static const struct {
+        const char *label;
+        unsigned int flags;
+    } passes[] = {
+        { "hex spaced", ATECC_HEX_SPACED },
+        { "hex", ATECC_HEX_UPPER },
+        { "hex lower", ATECC_HEX_LOWER }
+    };
+    for (size_t p = 0; p < sizeof(passes) / sizeof(passes[0]); p++) {
+        char label[32];
+        snprintf(label, sizeof(label), "%s (%s)", passes[p].label, FMT_SIMD_NAME);
+        start = atecc_now_us();
+        size_t length = atecc_hex(data, bytes, text, passes[p].flags);
+        fmt_bench_write(null_fd, text, length);
+        fmt_bench_report(label, bytes, start);
+    }
+
+    start = atecc_now_us();
+    size_t base64_length = atecc_base64(data, bytes, text);
+    fmt_bench_write(null_fd, text, base64_length);
+    fmt_bench_report("base64", bytes, start);
+
+    fclose(null_file);
+    close(null_fd);
+    free(data);
+    free(text);
+    free(reference);
+    return identical ? 0 : 1;
+}
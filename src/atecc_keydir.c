@@ -0,0 +1,562 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "pi_atecc.h"
+
+enum {
+    CONFIG_SLOT_CONFIG  = 20U,      // SlotConfig[16], 2 bytes each
+    CONFIG_AES_ENABLE   = 13U,      // Bit 0: AES command enabled
+    CONFIG_KEY_CONFIG   = 96U,      // KeyConfig[16], 2 bytes each
+    KEY_TYPE_P256       = 4U,
+    KEY_TYPE_AES        = 6U,
+    READKEY_EXT_SIGN    = 0x1U,     // SlotConfig.ReadKey bit 0 (private keys): sign external messages
+    READKEY_ECDH        = 0x4U,     // SlotConfig.ReadKey bit 2 (private keys): ECDH permitted
+    TABLE_MIN_BUCKETS   = 16U,
+    KEYS_LINE_MAX       = 256U,
+    KEYS_BENCH_LOOKUPS  = 1000000U,
+    KEYS_DEFAULT_COUNT  = 16U
+};
+
+/**
+ * @brief FNV-1a hash of a key id
+ */
+static uint32_t hash_id(const char *id) {
+    uint32_t hash = 2166136261U;
+    for (; *id; id++) {
+        hash = (hash ^ (uint8_t)*id) * 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * @brief Growable list of entries collected while scanning the pool
+ */
+typedef struct {
+    atecc_key_entry_t *entries;
+    size_t count;
+    size_t capacity;
+} key_list_t;
+
+static atecc_key_entry_t *list_find(key_list_t *list, const char *id) {
+    for (size_t i = 0; i < list->count; i++) {
+        if (strcmp(list->entries[i].id, id) == 0) {
+            return &list->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static atecc_key_entry_t *list_add(key_list_t *list, const char *id) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2U : 32U;
+        atecc_key_entry_t *entries = realloc(list->entries, capacity * sizeof(*entries));
+        if (!entries) {
+            return NULL;
+        }
+        list->entries = entries;
+        list->capacity = capacity;
+    }
+    atecc_key_entry_t *entry = &list->entries[list->count++];
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->id, sizeof(entry->id), "%s", id);
+    entry->hash = hash_id(entry->id);
+    return entry;
+}
+
+/**
+ * @brief Record that a device slot holds the key named id
+ *
+ * Capabilities are intersected so that every replica can serve every
+ * operation the entry advertises.
+ */
+static bool list_add_replica(key_list_t *list, const char *id, unsigned int caps, const uint8_t *public_key,
+                             size_t device, uint8_t slot) {
+    atecc_key_entry_t *entry = list_find(list, id);
+    if (!entry) {
+        entry = list_add(list, id);
+        if (!entry) {
+            return false;
+        }
+        entry->caps = caps;
+        if (public_key) {
+            memcpy(entry->public_key, public_key, sizeof(entry->public_key));
+        }
+    } else {
+        entry->caps &= caps;
+    }
+    if (entry->replica_count < ATECC_POOL_MAX) {
+        entry->replicas[entry->replica_count].device = (uint16_t)device;
+        entry->replicas[entry->replica_count].slot = slot;
+        entry->replica_count++;
+    }
+    return true;
+}
+
+/**
+ * @brief Add every usable key on one device, decoded from its config zone
+ *
+ * P-256 private keys are identified by their public key (computed with
+ * GenKey), so the same key provisioned on several chips becomes one entry.
+ * AES keys cannot be read back and are identified by their key check value
+ * (atecc_aes_kcv()), so only chips holding the same key become replicas.
+ */
+static bool scan_device(key_list_t *list, atecc_dev_t *dev, size_t device) {
+    if (!dev->config_valid) {
+        atecc_cache_load(dev);
+    }
+    if (!atecc_read_config(dev)) {
+        fprintf(stderr, "atecc_keydir: no config zone for %s:0x%02X\n", dev->bus, dev->address);
+        return false;
+    }
+
+    bool aes_enabled = (dev->config[CONFIG_AES_ENABLE] & 0x01U) != 0;
+    for (uint8_t slot = 0; slot < ATECC_SLOT_COUNT; slot++) {
+        unsigned int slot_config = dev->config[CONFIG_SLOT_CONFIG + 2U * slot] |
+                                   (dev->config[CONFIG_SLOT_CONFIG + 2U * slot + 1U] << 8);
+        unsigned int key_config = dev->config[CONFIG_KEY_CONFIG + 2U * slot] |
+                                  (dev->config[CONFIG_KEY_CONFIG + 2U * slot + 1U] << 8);
+        unsigned int key_type = (key_config >> 2) & 0x07U;
+        bool private_key = (key_config & 0x01U) != 0;
+        char id[ATECC_KEY_ID_MAX];
+
+        if (key_type == KEY_TYPE_P256 && private_key) {
+            unsigned int read_key = slot_config & 0x0FU;
+            unsigned int caps = ((read_key & READKEY_EXT_SIGN) ? ATECC_KEY_SIGN : 0U) |
+                                ((read_key & READKEY_ECDH) ? ATECC_KEY_ECDH : 0U);
+            uint8_t public_key[64];
+            if (caps == 0 || !atecc_get_pubkey(dev, slot, public_key)) {
+                continue;
+            }
+            uint8_t digest[32];
+            sha256(public_key, sizeof(public_key), digest);
+            char digest_hex[17];
+            atecc_hex(digest, 8U, digest_hex, ATECC_HEX_LOWER);
+            snprintf(id, sizeof(id), "p256-%s", digest_hex);
+            if (!list_add_replica(list, id, caps, public_key, device, slot)) {
+                return false;
+            }
+        } else if (key_type == KEY_TYPE_AES && aes_enabled) {
+            uint8_t kcv[ATECC_KCV_SIZE];
+            if (!atecc_aes_kcv(dev, slot, kcv)) {
+                continue;
+            }
+            char kcv_hex[2U * ATECC_KCV_SIZE + 1U];
+            atecc_hex(kcv, sizeof(kcv), kcv_hex, ATECC_HEX_LOWER);
+            snprintf(id, sizeof(id), "aes-%s", kcv_hex);
+            if (!list_add_replica(list, id, ATECC_KEY_AES, NULL, device, slot)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Add "name key-id" aliases from a file ('#' starts a comment)
+ */
+static bool load_names(key_list_t *list, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror("atecc_keydir: cannot open names file");
+        return false;
+    }
+
+    char line[KEYS_LINE_MAX];
+    size_t original = list->count;
+    while (fgets(line, sizeof(line), file)) {
+        char *hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        char name[ATECC_KEY_ID_MAX];
+        char target[ATECC_KEY_ID_MAX];
+        if (sscanf(line, "%31s %31s", name, target) != 2) {
+            continue;
+        }
+        atecc_key_entry_t *entry = NULL;
+        for (size_t i = 0; i < original && !entry; i++) {
+            if (strcmp(list->entries[i].id, target) == 0) {
+                entry = &list->entries[i];
+            }
+        }
+        if (!entry) {
+            fprintf(stderr, "atecc_keydir: alias %s: no key %s in the pool\n", name, target);
+            continue;
+        }
+        atecc_key_entry_t copy = *entry;
+        atecc_key_entry_t *alias = list_find(list, name) ? NULL : list_add(list, name);
+        if (alias) {
+            memcpy(copy.id, alias->id, sizeof(copy.id));
+            copy.hash = alias->hash;
+            *alias = copy;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Prepare an empty directory over an opened pool
+ *
+ * @param dir Directory to initialize
+ * @param pool Opened pool; must outlive the directory
+ * @return true on success, false otherwise
+ */
+bool atecc_keydir_init(atecc_keydir_t *dir, atecc_pool_t *pool) {
+    if (!dir || !pool) {
+        errno = EINVAL;
+        return false;
+    }
+    memset(dir, 0, sizeof(*dir));
+    dir->pool = pool;
+    atomic_init(&dir->table, NULL);
+    for (size_t i = 0; i < ATECC_POOL_MAX; i++) {
+        atomic_init(&dir->inflight[i], 0U);
+        atomic_init(&dir->routed[i], 0UL);
+        pthread_mutex_init(&dir->locks[i], NULL);
+    }
+    return true;
+}
+
+/**
+ * @brief Scan the pool and publish a new lookup table
+ *
+ * Safe to call while other threads look keys up: they keep using the
+ * previous table until the new one is published.
+ *
+ * @param dir Directory
+ * @param names_path Optional "name key-id" alias file, NULL for none
+ * @return true if a table was published, false otherwise
+ */
+bool atecc_keydir_build(atecc_keydir_t *dir, const char *names_path) {
+    if (!dir || !dir->pool) {
+        errno = EINVAL;
+        return false;
+    }
+
+    key_list_t list = {0};
+    for (size_t i = 0; i < dir->pool->count; i++) {
+        atecc_dev_t *dev = dir->pool->members[i];
+        pthread_mutex_lock(&dir->locks[i]);
+        bool ok = scan_device(&list, dev, i);
+        pthread_mutex_unlock(&dir->locks[i]);
+        if (!ok && errno == ENOMEM) {
+            free(list.entries);
+            return false;
+        }
+    }
+    if (names_path && !load_names(&list, names_path)) {
+        free(list.entries);
+        return false;
+    }
+
+    size_t buckets = TABLE_MIN_BUCKETS;
+    while (buckets < 2U * list.count) {
+        buckets *= 2U;
+    }
+    atecc_keydir_table_t *table = calloc(1, sizeof(*table) + buckets * sizeof(table->entries[0]));
+    if (!table) {
+        free(list.entries);
+        return false;
+    }
+    table->mask = buckets - 1U;
+    table->count = list.count;
+    for (size_t i = 0; i < list.count; i++) {
+        size_t bucket = list.entries[i].hash & table->mask;
+        while (table->entries[bucket].id[0] != '\0') {
+            bucket = (bucket + 1U) & table->mask;
+        }
+        table->entries[bucket] = list.entries[i];
+    }
+    free(list.entries);
+
+    table->retired = atomic_load_explicit(&dir->table, memory_order_relaxed);
+    atomic_store_explicit(&dir->table, table, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Find a key by logical id without taking locks
+ *
+ * @param dir Directory
+ * @param id Key id or alias
+ * @return Entry, or NULL if the id is unknown
+ */
+const atecc_key_entry_t *atecc_keydir_lookup(const atecc_keydir_t *dir, const char *id) {
+    const atecc_keydir_table_t *table = atomic_load_explicit(&dir->table, memory_order_acquire);
+    if (!table || !id) {
+        return NULL;
+    }
+    uint32_t hash = hash_id(id);
+    for (size_t bucket = hash & table->mask;; bucket = (bucket + 1U) & table->mask) {
+        const atecc_key_entry_t *entry = &table->entries[bucket];
+        if (entry->id[0] == '\0') {
+            return NULL;
+        }
+        if (entry->hash == hash && strcmp(entry->id, id) == 0) {
+            return entry;
+        }
+    }
+}
+
+/**
+ * @brief Pick the least-loaded replica of a key and take its device
+ *
+ * Ties go to the device that has completed the fewest requests.
+ *
+ * @return Chosen replica, or NULL (errno ENOENT for an unknown id, EPERM if
+ *         the key does not allow the operation)
+ */
+static const atecc_key_replica_t *acquire_replica(atecc_keydir_t *dir, const char *id, unsigned int cap) {
+    const atecc_key_entry_t *entry = atecc_keydir_lookup(dir, id);
+    if (!entry || entry->replica_count == 0) {
+        errno = ENOENT;
+        return NULL;
+    }
+    if ((entry->caps & cap) == 0) {
+        errno = EPERM;
+        return NULL;
+    }
+
+    const atecc_key_replica_t *best = &entry->replicas[0];
+    unsigned int best_load = atomic_load_explicit(&dir->inflight[best->device], memory_order_relaxed);
+    unsigned long best_routed = atomic_load_explicit(&dir->routed[best->device], memory_order_relaxed);
+    for (size_t i = 1; i < entry->replica_count; i++) {
+        const atecc_key_replica_t *replica = &entry->replicas[i];
+        unsigned int load = atomic_load_explicit(&dir->inflight[replica->device], memory_order_relaxed);
+        unsigned long routed = atomic_load_explicit(&dir->routed[replica->device], memory_order_relaxed);
+        if (load < best_load || (load == best_load && routed < best_routed)) {
+            best = replica;
+            best_load = load;
+            best_routed = routed;
+        }
+    }
+
+    atomic_fetch_add_explicit(&dir->inflight[best->device], 1U, memory_order_relaxed);
+    pthread_mutex_lock(&dir->locks[best->device]);
+    return best;
+}
+
+static void release_replica(atecc_keydir_t *dir, const atecc_key_replica_t *replica) {
+    pthread_mutex_unlock(&dir->locks[replica->device]);
+    atomic_fetch_add_explicit(&dir->routed[replica->device], 1UL, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&dir->inflight[replica->device], 1U, memory_order_relaxed);
+}
+
+/**
+ * @brief Sign a digest with any device holding the key
+ *
+ * @param dir Directory
+ * @param id Key id or alias
+ * @param digest 32-byte digest
+ * @param signature Receives the 64-byte signature
+ * @return true if successful, false otherwise
+ */
+bool atecc_keydir_sign(atecc_keydir_t *dir, const char *id, const uint8_t *digest, uint8_t *signature) {
+    const atecc_key_replica_t *replica = acquire_replica(dir, id, ATECC_KEY_SIGN);
+    if (!replica) {
+        return false;
+    }
+    bool ok = atecc_sign_digest(dir->pool->members[replica->device], replica->slot, digest, signature);
+    release_replica(dir, replica);
+    return ok;
+}
+
+/**
+ * @brief ECDH with any device holding the key
+ *
+ * @param dir Directory
+ * @param id Key id or alias
+ * @param peer_key 64-byte peer public key
+ * @param secret Receives the 32-byte shared secret
+ * @return true if successful, false otherwise
+ */
+bool atecc_keydir_ecdh(atecc_keydir_t *dir, const char *id, const uint8_t *peer_key, uint8_t *secret) {
+    const atecc_key_replica_t *replica = acquire_replica(dir, id, ATECC_KEY_ECDH);
+    if (!replica) {
+        return false;
+    }
+    bool ok = atecc_ecdh(dir->pool->members[replica->device], replica->slot, peer_key, secret);
+    release_replica(dir, replica);
+    return ok;
+}
+
+/**
+ * @brief AES-128 block operation with any device holding the key
+ *
+ * @param dir Directory
+ * @param id Key id or alias
+ * @param decrypt Decrypt instead of encrypt
+ * @param input 16-byte input block
+ * @param output Receives the 16-byte result
+ * @return true if successful, false otherwise
+ */
+bool atecc_keydir_aes(atecc_keydir_t *dir, const char *id, bool decrypt, const uint8_t *input, uint8_t *output) {
+    const atecc_key_replica_t *replica = acquire_replica(dir, id, ATECC_KEY_AES);
+    if (!replica) {
+        return false;
+    }
+    atecc_dev_t *dev = dir->pool->members[replica->device];
+    bool ok = decrypt ? aes_decrypt(dev, input, output, replica->slot) : aes_encrypt(dev, input, output, replica->slot);
+    release_replica(dir, replica);
+    return ok;
+}
+
+/**
+ * @brief Free every table the directory has published
+ *
+ * No lookups may be running.
+ */
+void atecc_keydir_free(atecc_keydir_t *dir) {
+    if (!dir) {
+        return;
+    }
+    atecc_keydir_table_t *table = atomic_exchange_explicit(&dir->table, NULL, memory_order_acquire);
+    while (table) {
+        atecc_keydir_table_t *retired = table->retired;
+        free(table);
+        table = retired;
+    }
+    for (size_t i = 0; i < ATECC_POOL_MAX; i++) {
+        pthread_mutex_destroy(&dir->locks[i]);
+    }
+}
+
+static void format_caps(unsigned int caps, char *out, size_t size) {
+    snprintf(out, size, "%s%s%s", (caps & ATECC_KEY_SIGN) ? "sign " : "", (caps & ATECC_KEY_ECDH) ? "ecdh " : "",
+             (caps & ATECC_KEY_AES) ? "aes " : "");
+}
+
+/**
+ * @brief Worker issuing Sign requests through the directory
+ */
+typedef struct {
+    atecc_keydir_t *dir;
+    const char *id;
+    size_t count;
+    bool ok;
+} sign_worker_t;
+
+static void *sign_worker(void *arg) {
+    sign_worker_t *worker = arg;
+    uint8_t digest[32] = {0};
+    uint8_t signature[64];
+    worker->ok = true;
+    for (size_t i = 0; worker->ok && i < worker->count; i++) {
+        digest[0] = (uint8_t)i;
+        worker->ok = atecc_keydir_sign(worker->dir, worker->id, digest, signature);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Build and print the key directory, time lookups and optionally route signatures
+ *
+ * Usage: keys [--names FILE] [--sign ID] [--count N] [device...]
+ *
+ * @return Process exit status
+ */
+int atecc_keys_main(int argc, char **argv) {
+    const char *names_path = NULL;
+    const char *sign_id = NULL;
+    size_t count = KEYS_DEFAULT_COUNT;
+    const char *specs[ATECC_POOL_MAX];
+    size_t spec_count = 0;
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--names") == 0 && has_value) {
+            names_path = argv[++i];
+        } else if (strcmp(argv[i], "--sign") == 0 && has_value) {
+            sign_id = argv[++i];
+        } else if (strcmp(argv[i], "--count") == 0 && has_value) {
+            count = strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && spec_count < ATECC_POOL_MAX) {
+            specs[spec_count++] = argv[i];
+        } else {
+            fprintf(stderr, "usage: pi_atecc keys [--names FILE] [--sign ID] [--count N] [device...]\n");
+            return 2;
+        }
+    }
+
+    atecc_pool_t *pool = calloc(1, sizeof(*pool));
+    atecc_keydir_t *dir = calloc(1, sizeof(*dir));
+    if (!pool || !dir || !atecc_pool_open(pool, specs, spec_count)) {
+        fprintf(stderr, "keys: no devices available\n");
+        free(pool);
+        free(dir);
+        return 1;
+    }
+    atecc_keydir_init(dir, pool);
+
+    bool ok = atecc_keydir_build(dir, names_path);
+    const atecc_keydir_table_t *table = atomic_load(&dir->table);
+    const char *sample = NULL;
+    for (size_t b = 0; ok && b <= table->mask; b++) {
+        const atecc_key_entry_t *entry = &table->entries[b];
+        if (entry->id[0] == '\0') {
+            continue;
+        }
+        sample = sample ? sample : entry->id;
+        char caps[32];
+        format_caps(entry->caps, caps, sizeof(caps));
+        printf("🔑 %-24s %-14s %zu replica(s):", entry->id, caps, entry->replica_count);
+        for (size_t r = 0; r < entry->replica_count; r++) {
+            const atecc_dev_t *dev = pool->members[entry->replicas[r].device];
+            printf(" %s:0x%02X/%u", dev->bus, dev->address, entry->replicas[r].slot);
+        }
+        printf("\n");
+    }
+
+    if (ok && sample) {
+        uint64_t start = atecc_now_us();
+        size_t found = 0;
+        for (size_t i = 0; i < KEYS_BENCH_LOOKUPS; i++) {
+            found += atecc_keydir_lookup(dir, sample) != NULL;
+        }
+        double elapsed_ns = (double)(atecc_now_us() - start) * 1000.0;
+        printf("📊 %zu keys, %.1f ns per lookup (%zu/%u found)\n", table->count,
+               elapsed_ns / KEYS_BENCH_LOOKUPS, found, KEYS_BENCH_LOOKUPS);
+    }
+
+    if (ok && sign_id) {
+        const atecc_key_entry_t *entry = atecc_keydir_lookup(dir, sign_id);
+        size_t threads = entry ? 2U * entry->replica_count : 1U;
+        pthread_t ids[2U * ATECC_POOL_MAX];
+        sign_worker_t workers[2U * ATECC_POOL_MAX];
+        size_t per_thread = (count + threads - 1U) / threads;
+        uint64_t start = atecc_now_us();
+        for (size_t t = 0; t < threads; t++) {
+            workers[t] = (sign_worker_t){ .dir = dir, .id = sign_id, .count = per_thread };
+            if (pthread_create(&ids[t], NULL, sign_worker, &workers[t]) != 0) {
+                workers[t].ok = false;
+                threads = t;
+                ok = false;
+                break;
+            }
+        }
+        for (size_t t = 0; t < threads; t++) {
+            pthread_join(ids[t], NULL);
+            ok = ok && workers[t].ok;
+        }
+        double elapsed_s = (double)(atecc_now_us() - start) / 1e6;
+        printf("%s %s: %.2f signatures/s across replicas:", ok ? "✍️" : "❌", sign_id,
+               elapsed_s > 0.0 ? (double)(per_thread * threads) / elapsed_s : 0.0);
+        for (size_t i = 0; i < pool->count; i++) {
+            printf(" %s:0x%02X=%lu", pool->members[i]->bus, pool->members[i]->address,
+                   atomic_load(&dir->routed[i]));
+        }
+        printf("\n");
+    }
+
+    atecc_keydir_free(dir);
+    atecc_pool_close(pool);
+    free(dir);
+    free(pool);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,605 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include "pi_atecc.h"
+
+enum {
+    MERKLE_HASH_SIZE       = 32U,
+    MERKLE_MAX_LEVELS      = 64U,
+    MERKLE_LEAF_PREFIX     = 0x00U,    // Domain separation as in RFC 6962
+    MERKLE_NODE_PREFIX     = 0x01U,
+    BATCH_DEFAULT_MAX      = 4096U,
+    BATCH_DEFAULT_WINDOW   = 1000U,    // ms
+    BATCH_LINE_MAX         = 65536U,
+    SIGNATURE_SIZE         = 64U,
+    PUBKEY_SIZE            = 64U
+};
+
+/**
+ * @brief Host-side Merkle tree, all levels stored bottom-up in one array
+ *
+ * An odd node at the end of a level is promoted to the next level unchanged,
+ * so it has no sibling entry in the inclusion proof. This gives the RFC 6962
+ * Merkle Tree Hash for any leaf count: RFC 6962 splits n leaves at the
+ * largest power of two k < n, the first k leaves form a complete subtree
+ * here too, and the nodes over the other n - k leaves are the tree of
+ * D[k:n], its root promoted until it meets that subtree. Roots and proofs
+ * match RFC 6962 (see tests/merkle_root.c).
+ */
+typedef struct {
+    uint8_t (*nodes)[MERKLE_HASH_SIZE];
+    size_t level_offset[MERKLE_MAX_LEVELS];
+    size_t level_size[MERKLE_MAX_LEVELS];
+    size_t levels;
+} merkle_tree_t;
+
+/**
+ * @brief Hash a record into a leaf: SHA-256(0x00 || record)
+ */
+static void merkle_leaf(const uint8_t *data, size_t length, uint8_t *leaf) {
+    uint8_t prefix = MERKLE_LEAF_PREFIX;
+    sha256_ctx_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, &prefix, 1);
+    sha256_update(&ctx, data, length);
+    sha256_final(&ctx, leaf);
+}
+
+/**
+ * @brief Hash two children into a node: SHA-256(0x01 || left || right)
+ */
+static void merkle_node(const uint8_t *left, const uint8_t *right, uint8_t *node) {
+    uint8_t buffer[1U + 2U * MERKLE_HASH_SIZE];
+    buffer[0] = MERKLE_NODE_PREFIX;
+    memcpy(&buffer[1], left, MERKLE_HASH_SIZE);
+    memcpy(&buffer[1U + MERKLE_HASH_SIZE], right, MERKLE_HASH_SIZE);
+    sha256(buffer, sizeof(buffer), node);
+}
+
+/**
+ * @brief Build a tree over the given leaf hashes
+ *
+ * @param tree Tree to build (free with merkle_free())
+ * @param leaves Leaf hashes
+ * @param count Number of leaves (at least 1)
+ * @return true on success, false if out of memory
+ */
+static bool merkle_build(merkle_tree_t *tree, uint8_t (*leaves)[MERKLE_HASH_SIZE], size_t count) {
+    memset(tree, 0, sizeof(*tree));
+
+    size_t total = 0;
+    for (size_t size = count; ; size = (size + 1U) / 2U) {
+        tree->level_offset[tree->levels] = total;
+        tree->level_size[tree->levels] = size;
+        tree->levels++;
+        total += size;
+        if (size == 1U) {
+            break;
+        }
+    }
+
+    tree->nodes = malloc(total * MERKLE_HASH_SIZE);
+    if (!tree->nodes) {
+        return false;
+    }
+    memcpy(tree->nodes, leaves, count * MERKLE_HASH_SIZE);
+
+    for (size_t level = 1; level < tree->levels; level++) {
+        uint8_t (*below)[MERKLE_HASH_SIZE] = &tree->nodes[tree->level_offset[level - 1U]];
+        uint8_t (*here)[MERKLE_HASH_SIZE] = &tree->nodes[tree->level_offset[level]];
+        size_t below_size = tree->level_size[level - 1U];
+
+        for (size_t i = 0; i < tree->level_size[level]; i++) {
+            if (2U * i + 1U < below_size) {
+                merkle_node(below[2U * i], below[2U * i + 1U], here[i]);
+            } else {
+                memcpy(here[i], below[2U * i], MERKLE_HASH_SIZE);
+            }
+        }
+    }
+    return true;
+}
+
+static void merkle_free(merkle_tree_t *tree) {
+    free(tree->nodes);
+    tree->nodes = NULL;
+}
+
+static const uint8_t *merkle_root(const merkle_tree_t *tree) {
+    return tree->nodes[tree->level_offset[tree->levels - 1U]];
+}
+
+/**
+ * @brief Append one signed record as a JSON line to the output sink
+ *
+ * Each line carries the record, its inclusion proof, the batch root and the
+ * root signature, so any record can be verified on its own.
+ */
+static bool emit_record(atecc_out_t *out, size_t batch, size_t index, const merkle_tree_t *tree,
+                        const uint8_t *record, size_t record_length, const char *root_hex,
+                        const char *signature_hex) {
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "{\"batch\":%zu,\"index\":%zu,\"msg\":\"", batch, index);
+    bool ok = atecc_out_str(out, prefix) &&
+              atecc_out_hex(out, record, record_length, ATECC_HEX_LOWER) &&
+              atecc_out_str(out, "\",\"proof\":[");
+
+    size_t position = index;
+    bool first = true;
+    for (size_t level = 0; ok && level + 1U < tree->levels; level++) {
+        size_t sibling = position ^ 1U;
+        if (sibling < tree->level_size[level]) {
+            const char *side = (sibling < position) ? "\"L" : "\"R";
+            ok = (first || atecc_out_str(out, ",")) && atecc_out_str(out, side) &&
+                 atecc_out_hex(out, tree->nodes[tree->level_offset[level] + sibling], MERKLE_HASH_SIZE,
+                               ATECC_HEX_LOWER) &&
+                 atecc_out_str(out, "\"");
+            first = false;
+        }
+        position >>= 1;
+    }
+
+    return ok && atecc_out_str(out, "],\"root\":\"") && atecc_out_str(out, root_hex) &&
+           atecc_out_str(out, "\",\"sig\":\"") && atecc_out_str(out, signature_hex) &&
+           atecc_out_str(out, "\"}\n");
+}
+
+/**
+ * @brief Collected records of the batch being built
+ */
+typedef struct {
+    uint8_t **records;
+    size_t *lengths;
+    size_t count;
+    size_t capacity;
+} batch_t;
+
+/**
+ * @brief Sign one batch: build the tree on the host, sign the root on the device
+ *
+ * The whole batch is formatted into the sink and handed to the kernel in
+ * one write.
+ *
+ * @return true if the batch was signed and emitted, false otherwise
+ */
+static bool flush_batch(atecc_dev_t *dev, uint8_t key_slot, batch_t *batch, size_t batch_number,
+                        atecc_out_t *out) {
+    if (batch->count == 0) {
+        return true;
+    }
+
+    uint8_t (*leaves)[MERKLE_HASH_SIZE] = malloc(batch->count * MERKLE_HASH_SIZE);
+    if (!leaves) {
+        return false;
+    }
+    for (size_t i = 0; i < batch->count; i++) {
+        merkle_leaf(batch->records[i], batch->lengths[i], leaves[i]);
+    }
+
+    merkle_tree_t tree;
+    bool ok = merkle_build(&tree, leaves, batch->count);
+    free(leaves);
+    if (!ok) {
+        return false;
+    }
+
+    uint8_t signature[SIGNATURE_SIZE];
+    if (!atecc_sign_digest(dev, key_slot, merkle_root(&tree), signature)) {
+        fprintf(stderr, "batch-sign: signing batch %zu failed\n", batch_number);
+        merkle_free(&tree);
+        return false;
+    }
+
+    char root_hex[2U * MERKLE_HASH_SIZE + 1U];
+    char signature_hex[2U * SIGNATURE_SIZE + 1U];
+    atecc_hex(merkle_root(&tree), MERKLE_HASH_SIZE, root_hex, ATECC_HEX_LOWER);
+    atecc_hex(signature, SIGNATURE_SIZE, signature_hex, ATECC_HEX_LOWER);
+    for (size_t i = 0; i < batch->count; i++) {
+        ok = ok && emit_record(out, batch_number, i, &tree, batch->records[i], batch->lengths[i],
+                               root_hex, signature_hex);
+        free(batch->records[i]);
+    }
+    ok = ok && atecc_out_flush(out);
+
+    batch->count = 0;
+    merkle_free(&tree);
+    return ok;
+}
+
+/**
+ * @brief Line reader on a raw descriptor, so poll() sees exactly what is unread
+ */
+typedef struct {
+    int fd;
+    char buffer[BATCH_LINE_MAX];
+    size_t length;
+    bool eof;
+} line_reader_t;
+
+/**
+ * @brief Take the next complete line from the reader, if one is buffered
+ *
+ * A trailing line without newline is returned at end of input. Lines that do
+ * not fit the buffer are split.
+ */
+static bool take_line(line_reader_t *reader, char *line, size_t *line_length) {
+    char *newline = memchr(reader->buffer, '\n', reader->length);
+    size_t length;
+    size_t consumed;
+
+    if (newline) {
+        length = (size_t)(newline - reader->buffer);
+        consumed = length + 1U;
+    } else if (reader->length == sizeof(reader->buffer) || (reader->eof && reader->length > 0)) {
+        length = reader->length;
+        consumed = length;
+    } else {
+        return false;
+    }
+
+    memcpy(line, reader->buffer, length);
+    *line_length = length;
+    memmove(reader->buffer, &reader->buffer[consumed], reader->length - consumed);
+    reader->length -= consumed;
+    return true;
+}
+
+/**
+ * @brief Wait up to timeout_ms for more input (-1 waits forever)
+ */
+static void fill_reader(line_reader_t *reader, int timeout_ms) {
+    struct pollfd pfd = { .fd = reader->fd, .events = POLLIN };
+    if (reader->eof || poll(&pfd, 1, timeout_ms) <= 0) {
+        return;
+    }
+
+    ssize_t received = read(reader->fd, &reader->buffer[reader->length], sizeof(reader->buffer) - reader->length);
+    if (received <= 0) {
+        reader->eof = true;
+    } else {
+        reader->length += (size_t)received;
+    }
+}
+
+/**
+ * @brief Open the device named by an optional topology argument
+ *
+ * @param spec Topology address, NULL for the default device
+ * @param mux Receives the mux the device sits behind, if any
+ * @param dev Receives the device handle
+ * @param muxed Set to whether mux was opened and must be closed with the device (see close_cli_device())
+ * @return true on success, false otherwise (nothing left open)
+ */
+static bool open_cli_device(const char *spec, atecc_mux_t *mux, atecc_dev_t *dev, bool *muxed) {
+    atecc_topo_t topo = { .bus = I2C_DEVICE, .address = ATECC_I2C_ADDRESS };
+    *muxed = false;
+    if (spec && !atecc_parse_topo(spec, &topo)) {
+        fprintf(stderr, "❌ ERROR: Invalid device address '%s'\n", spec);
+        return false;
+    }
+    if (topo.mux_address != 0 && !atecc_mux_open(mux, topo.bus, topo.mux_address)) {
+        return false;
+    }
+    if (!atecc_open_topo(dev, &topo, mux)) {
+        if (topo.mux_address != 0) {
+            atecc_mux_close(mux);
+        }
+        return false;
+    }
+    *muxed = topo.mux_address != 0;
+    return true;
+}
+
+/**
+ * @brief Close a device opened with open_cli_device() and the mux in front of it
+ */
+static void close_cli_device(atecc_mux_t *mux, atecc_dev_t *dev, bool muxed) {
+    atecc_close(dev);
+    if (muxed) {
+        atecc_mux_close(mux);
+    }
+}
+
+/**
+ * @brief Sign stdin records in Merkle batches with one device signature per batch
+ *
+ * Usage: batch-sign <slot> [--max N] [--window-ms MS] [device]
+ *
+ * A batch is closed when it holds N records or MS milliseconds after its first
+ * record arrived, whichever comes first, and at end of input.
+ *
+ * @return Process exit status
+ */
+int atecc_batch_sign_main(int argc, char **argv) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: pi_atecc batch-sign <slot> [--max N] [--window-ms MS] [device]\n");
+        return 2;
+    }
+
+    uint8_t key_slot = (uint8_t)strtoul(argv[0], NULL, 0);
+    size_t max_records = BATCH_DEFAULT_MAX;
+    uint64_t window_ms = BATCH_DEFAULT_WINDOW;
+    const char *spec = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            max_records = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--window-ms") == 0 && i + 1 < argc) {
+            window_ms = strtoull(argv[++i], NULL, 10);
+        } else {
+            spec = argv[i];
+        }
+    }
+    if (max_records == 0) {
+        max_records = BATCH_DEFAULT_MAX;
+    }
+
+    atecc_mux_t mux;
+    atecc_dev_t dev;
+    bool muxed = false;
+    if (!open_cli_device(spec, &mux, &dev, &muxed)) {
+        return 1;
+    }
+
+    uint8_t public_key[PUBKEY_SIZE];
+    if (atecc_get_pubkey(&dev, key_slot, public_key)) {
+        char pubkey_hex[2U * PUBKEY_SIZE + 1U];
+        atecc_hex(public_key, PUBKEY_SIZE, pubkey_hex, ATECC_HEX_LOWER);
+        fprintf(stderr, "🔑 Slot %u public key: %s\n", key_slot, pubkey_hex);
+    }
+
+    batch_t batch = {
+        .records = calloc(max_records, sizeof(uint8_t *)),
+        .lengths = calloc(max_records, sizeof(size_t)),
+        .capacity = max_records
+    };
+    line_reader_t *reader = calloc(1, sizeof(*reader));
+    char *line = malloc(BATCH_LINE_MAX);
+    atecc_out_t out;
+    if (!batch.records || !batch.lengths || !reader || !line || !atecc_out_init(&out, STDOUT_FILENO, 0)) {
+        perror("batch-sign");
+        free(batch.records);
+        free(batch.lengths);
+        free(reader);
+        free(line);
+        close_cli_device(&mux, &dev, muxed);
+        return 1;
+    }
+    reader->fd = STDIN_FILENO;
+
+    size_t batches = 0;
+    size_t records = 0;
+    bool ok = true;
+    uint64_t start = atecc_now_us();
+    uint64_t window_end = 0;
+
+    while (ok) {
+        size_t line_length = 0;
+        if (take_line(reader, line, &line_length)) {
+            uint8_t *record = malloc(line_length ? line_length : 1U);
+            if (!record) {
+                ok = false;
+                break;
+            }
+            memcpy(record, line, line_length);
+            if (batch.count == 0) {
+                window_end = atecc_now_us() + window_ms * 1000U;
+            }
+            batch.records[batch.count] = record;
+            batch.lengths[batch.count] = line_length;
+            batch.count++;
+            records++;
+        }
+
+        uint64_t now = atecc_now_us();
+        bool full = batch.count == batch.capacity;
+        bool expired = batch.count > 0 && now >= window_end;
+        bool drained = reader->eof && reader->length == 0;
+        if (full || expired || (drained && batch.count > 0)) {
+            ok = flush_batch(&dev, key_slot, &batch, ++batches, &out);
+            continue;
+        }
+        if (drained) {
+            break;
+        }
+        if (!memchr(reader->buffer, '\n', reader->length)) {
+            int timeout = (batch.count > 0) ? (int)((window_end - now + 999U) / 1000U) : -1;
+            fill_reader(reader, timeout);
+        }
+    }
+
+    double elapsed_s = (double)(atecc_now_us() - start) / 1e6;
+    fprintf(stderr, "📊 %zu records in %zu batch(es), %.3f s, %.1f signed records/s\n",
+            records, batches, elapsed_s, elapsed_s > 0.0 ? (double)records / elapsed_s : 0.0);
+
+    for (size_t i = 0; i < batch.count; i++) {
+        free(batch.records[i]);
+    }
+    free(batch.records);
+    free(batch.lengths);
+    free(reader);
+    free(line);
+    atecc_out_free(&out);
+    close_cli_device(&mux, &dev, muxed);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Locate a string field ("key":"value") in one of our JSON lines
+ *
+ * @return Pointer to the first character of the value, or NULL
+ */
+static const char *json_string_field(const char *line, const char *key, size_t *length) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\":\"", key);
+    const char *value = strstr(line, pattern);
+    if (!value) {
+        return NULL;
+    }
+    value += strlen(pattern);
+    const char *end = strchr(value, '"');
+    if (!end) {
+        return NULL;
+    }
+    *length = (size_t)(end - value);
+    return value;
+}
+
+/**
+ * @brief Check a record's inclusion proof against its batch root
+ */
+static bool verify_inclusion(const char *line, const uint8_t *root) {
+    size_t length = 0;
+    const char *msg_hex = json_string_field(line, "msg", &length);
+    if (!msg_hex || (length % 2U) != 0) {
+        return false;
+    }
+
+    uint8_t *record = malloc(length / 2U + 1U);
+    if (!record) {
+        return false;
+    }
+    bool decoded = atecc_hex_decode(msg_hex, length / 2U, record);
+    uint8_t hash[MERKLE_HASH_SIZE];
+    merkle_leaf(record, length / 2U, hash);
+    free(record);
+    if (!decoded) {
+        return false;
+    }
+
+    const char *proof = strstr(line, "\"proof\":[");
+    if (!proof) {
+        return false;
+    }
+    proof += strlen("\"proof\":[");
+    while (*proof == '"') {
+        char side = proof[1];
+        uint8_t sibling[MERKLE_HASH_SIZE];
+        if ((side != 'L' && side != 'R') || !atecc_hex_decode(&proof[2], MERKLE_HASH_SIZE, sibling) ||
+            proof[2U + 2U * MERKLE_HASH_SIZE] != '"') {
+            return false;
+        }
+        if (side == 'L') {
+            merkle_node(sibling, hash, hash);
+        } else {
+            merkle_node(hash, sibling, hash);
+        }
+        proof += 3U + 2U * MERKLE_HASH_SIZE;
+        if (*proof == ',') {
+            proof++;
+        }
+    }
+
+    return *proof == ']' && memcmp(hash, root, MERKLE_HASH_SIZE) == 0;
+}
+
+/**
+ * @brief Verify batch-sign output: inclusion proofs on the host, root signatures on the device
+ *
+ * Usage: batch-verify (--pubkey HEX | --slot N) [device]
+ *
+ * Each distinct root signature is checked once with the device's Verify
+ * command; every record's inclusion proof is checked on the host. A root
+ * whose check failed on the device is not cached, so the next record under
+ * it tries again.
+ *
+ * @return Process exit status (1 if any record fails)
+ */
+int atecc_batch_verify_main(int argc, char **argv) {
+    uint8_t public_key[PUBKEY_SIZE];
+    bool have_pubkey = false;
+    int key_slot = -1;
+    const char *spec = NULL;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--pubkey") == 0 && i + 1 < argc) {
+            const char *hex = argv[++i];
+            have_pubkey = strlen(hex) == 2U * PUBKEY_SIZE && atecc_hex_decode(hex, PUBKEY_SIZE, public_key);
+            if (!have_pubkey) {
+                fprintf(stderr, "batch-verify: public key must be %u hex digits\n", 2U * PUBKEY_SIZE);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--slot") == 0 && i + 1 < argc) {
+            key_slot = (int)strtol(argv[++i], NULL, 0);
+        } else {
+            spec = argv[i];
+        }
+    }
+    if (!have_pubkey && key_slot < 0) {
+        fprintf(stderr, "usage: pi_atecc batch-verify (--pubkey HEX | --slot N) [device]\n");
+        return 2;
+    }
+
+    atecc_mux_t mux;
+    atecc_dev_t dev;
+    bool muxed = false;
+    if (!open_cli_device(spec, &mux, &dev, &muxed)) {
+        return 1;
+    }
+    if (!have_pubkey && !atecc_get_pubkey(&dev, (uint8_t)key_slot, public_key)) {
+        close_cli_device(&mux, &dev, muxed);
+        return 1;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t line_length;
+    size_t records = 0;
+    size_t failures = 0;
+    size_t errors = 0;
+    uint8_t last_root[MERKLE_HASH_SIZE];
+    uint8_t last_signature[SIGNATURE_SIZE];
+    bool have_last = false;
+    bool last_valid = false;
+
+    while ((line_length = getline(&line, &capacity, stdin)) > 0) {
+        size_t length = 0;
+        uint8_t root[MERKLE_HASH_SIZE];
+        uint8_t signature[SIGNATURE_SIZE];
+        const char *root_hex = json_string_field(line, "root", &length);
+        bool parsed = root_hex && length == 2U * MERKLE_HASH_SIZE && atecc_hex_decode(root_hex, MERKLE_HASH_SIZE, root);
+        const char *signature_hex = json_string_field(line, "sig", &length);
+        parsed = parsed && signature_hex && length == 2U * SIGNATURE_SIZE &&
+                 atecc_hex_decode(signature_hex, SIGNATURE_SIZE, signature);
+
+        records++;
+        if (!parsed) {
+            failures++;
+            fprintf(stderr, "❌ record %zu: malformed line\n", records);
+            continue;
+        }
+
+        if (!have_last || memcmp(root, last_root, sizeof(root)) != 0 ||
+            memcmp(signature, last_signature, sizeof(signature)) != 0) {
+            // Only a definite verdict is cached; a device error is retried on the next record
+            have_last = atecc_verify_digest(&dev, root, signature, public_key, &last_valid);
+            if (!have_last) {
+                failures++;
+                errors++;
+                fprintf(stderr, "❌ record %zu: root signature not checked: %s\n", records, strerror(errno));
+                continue;
+            }
+            memcpy(last_root, root, sizeof(root));
+            memcpy(last_signature, signature, sizeof(signature));
+        }
+
+        if (!last_valid) {
+            failures++;
+            fprintf(stderr, "❌ record %zu: root signature invalid\n", records);
+        } else if (!verify_inclusion(line, root)) {
+            failures++;
+            fprintf(stderr, "❌ record %zu: inclusion proof invalid\n", records);
+        }
+    }
+
+    printf("%s %zu record(s) checked, %zu failed (%zu on device errors)\n", failures == 0 ? "✅" : "❌", records,
+           failures, errors);
+    free(line);
+    close_cli_device(&mux, &dev, muxed);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,463 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "pi_atecc.h"
+
+/**
+ * @brief Parse a bus name: a bare adapter number ("1"), a device path ("/dev/i2c-1") or an emulated bus ("emu0")
+ *
+ * @param text Bus text (not NUL-terminated at len)
+ * @param len Length of the bus text
+ * @param bus Output buffer for the device path
+ * @param bus_size Size of the output buffer
+ * @return true if the bus name is valid, false otherwise
+ */
+static bool parse_bus(const char *text, size_t len, char *bus, size_t bus_size) {
+    if (len == 0 || len >= bus_size) {
+        return false;
+    }
+    if (text[0] == '/' || (len > strlen(ATECC_EMU_BUS_PREFIX) &&
+                           strncmp(text, ATECC_EMU_BUS_PREFIX, strlen(ATECC_EMU_BUS_PREFIX)) == 0)) {
+        memcpy(bus, text, len);
+        bus[len] = '\0';
+        return true;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+    }
+    int written = snprintf(bus, bus_size, "/dev/i2c-%.*s", (int)len, text);
+    return written > 0 && (size_t)written < bus_size;
+}
+
+/**
+ * @brief Parse a 7-bit I2C address in C notation ("0x60", "96")
+ *
+ * @param text Address text
+ * @param end Set to the first character after the address
+ * @param address Parsed address
+ * @return true if the address is a valid 7-bit address, false otherwise
+ */
+static bool parse_address(const char *text, char **end, uint16_t *address) {
+    errno = 0;
+    unsigned long value = strtoul(text, end, 0);
+    if (errno != 0 || *end == text || value > 0x7FU) {
+        return false;
+    }
+    *address = (uint16_t)value;
+    return true;
+}
+
+/**
+ * @brief Parse a topology-aware device address
+ *
+ * Accepted forms are "<bus>:<address>" for directly attached devices and
+ * "<bus>:<mux>.<channel>:<address>" for devices behind a TCA9548A, e.g.
+ * "1:0x60", "/dev/i2c-3:0x35" or "1:0x70.5:0x60".
+ *
+ * @param spec Address specification
+ * @param topo Parsed topology
+ * @return true on success, false with errno set to EINVAL otherwise
+ */
+bool atecc_parse_topo(const char *spec, atecc_topo_t *topo) {
+    if (!spec || !topo) {
+        errno = EINVAL;
+        return false;
+    }
+
+    memset(topo, 0, sizeof(*topo));
+    const char *colon = strchr(spec, ':');
+    if (!colon || !parse_bus(spec, (size_t)(colon - spec), topo->bus, sizeof(topo->bus))) {
+        errno = EINVAL;
+        return false;
+    }
+
+    char *end = NULL;
+    uint16_t first = 0;
+    if (!parse_address(colon + 1, &end, &first)) {
+        errno = EINVAL;
+        return false;
+    }
+
+    if (*end == '\0') {
+        topo->address = first;
+        return true;
+    }
+
+    if (*end != '.') {
+        errno = EINVAL;
+        return false;
+    }
+
+    const char *channel_text = end + 1;
+    errno = 0;
+    unsigned long channel = strtoul(channel_text, &end, 10);
+    if (errno != 0 || end == channel_text || channel >= TCA9548A_CHANNELS || *end != ':') {
+        errno = EINVAL;
+        return false;
+    }
+
+    uint16_t address = 0;
+    if (!parse_address(end + 1, &end, &address) || *end != '\0') {
+        errno = EINVAL;
+        return false;
+    }
+
+    topo->mux_address = first;
+    topo->mux_channel = (uint8_t)channel;
+    topo->address = address;
+    return true;
+}
+
+/**
+ * @brief Open a TCA9548A multiplexer
+ *
+ * The enabled channel is unknown until the first selection, so the first
+ * device transfer always writes the control register.
+ *
+ * @param mux Multiplexer to initialize
+ * @param path I2C device file the mux sits on
+ * @param address Mux address (0x70-0x77)
+ * @return true on success, false otherwise
+ */
+bool atecc_mux_open(atecc_mux_t *mux, const char *path, uint16_t address) {
+    if (!mux) {
+        errno = EINVAL;
+        return false;
+    }
+
+    memset(mux, 0, sizeof(*mux));
+    mux->channel = -1;
+    pthread_mutex_init(&mux->lock, NULL);
+    if (!atecc_open(&mux->port, path, address)) {
+        pthread_mutex_destroy(&mux->lock);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Close a multiplexer opened with atecc_mux_open()
+ *
+ * No device behind it may be in use.
+ *
+ * @param mux Multiplexer
+ */
+void atecc_mux_close(atecc_mux_t *mux) {
+    if (!mux) {
+        return;
+    }
+    atecc_close(&mux->port);
+    pthread_mutex_destroy(&mux->lock);
+}
+
+/**
+ * @brief Enable a single mux channel, skipping the write if it is already enabled
+ *
+ * @param mux Multiplexer
+ * @param channel Channel to enable (0-7)
+ * @return true on success, false otherwise
+ */
+bool atecc_mux_select(atecc_mux_t *mux, uint8_t channel) {
+    if (!mux || channel >= TCA9548A_CHANNELS) {
+        errno = EINVAL;
+        return false;
+    }
+
+    if (mux->channel == (int)channel) {
+        return true;
+    }
+
+    uint8_t control = (uint8_t)(1U << channel);
+    if (!atecc_i2c_write(&mux->port, &control, 1)) {
+        perror("atecc_mux_select: mux control write failed");
+        mux->channel = -1;
+        return false;
+    }
+
+    mux->channel = channel;
+    mux->switches++;
+    return true;
+}
+
+/**
+ * @brief Open a device described by a topology address
+ *
+ * @param dev Handle to initialize
+ * @param topo Device topology
+ * @param mux Opened multiplexer on the same bus (required when topo has a mux hop)
+ * @return true on success, false otherwise
+ */
+bool atecc_open_topo(atecc_dev_t *dev, const atecc_topo_t *topo, atecc_mux_t *mux) {
+    if (!dev || !topo || (topo->mux_address != 0 && (!mux || mux->port.address != topo->mux_address))) {
+        errno = EINVAL;
+        return false;
+    }
+
+    if (!atecc_open(dev, topo->bus, topo->address)) {
+        return false;
+    }
+
+    if (topo->mux_address != 0) {
+        dev->mux = mux;
+        dev->mux_channel = topo->mux_channel;
+    }
+    return true;
+}
+
+/**
+ * @brief Open a pool of devices from topology addresses, or every discovered device
+ *
+ * Devices behind the same mux share one atecc_mux_t, so their channel
+ * selections are serialized by its lock.
+ *
+ * @param pool Pool to initialize
+ * @param specs Topology addresses, see atecc_parse_topo()
+ * @param spec_count Number of addresses, 0 to use atecc_discover()
+ * @return true if at least one device was opened and every address was valid
+ */
+bool atecc_pool_open(atecc_pool_t *pool, const char **specs, size_t spec_count) {
+    if (!pool || (spec_count > 0 && !specs)) {
+        errno = EINVAL;
+        return false;
+    }
+    memset(pool, 0, sizeof(*pool));
+
+    if (spec_count == 0) {
+        atecc_found_t found[ATECC_POOL_MAX];
+        size_t found_count = atecc_discover(NULL, 0, found, ATECC_POOL_MAX);
+        for (size_t i = 0; i < found_count; i++) {
+            if (atecc_open(&pool->devs[pool->count], found[i].bus, found[i].address)) {
+                pool->members[pool->count] = &pool->devs[pool->count];
+                pool->count++;
+            }
+        }
+        return pool->count > 0;
+    }
+
+    for (size_t i = 0; i < spec_count && pool->count < ATECC_POOL_MAX; i++) {
+        atecc_topo_t topo;
+        if (!atecc_parse_topo(specs[i], &topo)) {
+            fprintf(stderr, "atecc_pool_open: invalid device address '%s'\n", specs[i]);
+            atecc_pool_close(pool);
+            return false;
+        }
+
+        atecc_mux_t *mux = NULL;
+        if (topo.mux_address != 0) {
+            for (size_t j = 0; j < pool->mux_count && !mux; j++) {
+                if (pool->muxes[j].port.address == topo.mux_address && strcmp(pool->muxes[j].port.bus, topo.bus) == 0) {
+                    mux = &pool->muxes[j];
+                }
+            }
+            if (!mux) {
+                mux = &pool->muxes[pool->mux_count];
+                if (!atecc_mux_open(mux, topo.bus, topo.mux_address)) {
+                    atecc_pool_close(pool);
+                    return false;
+                }
+                pool->mux_count++;
+            }
+        }
+
+        if (!atecc_open_topo(&pool->devs[pool->count], &topo, mux)) {
+            atecc_pool_close(pool);
+            return false;
+        }
+        pool->members[pool->count] = &pool->devs[pool->count];
+        pool->count++;
+    }
+    return pool->count > 0;
+}
+
+/**
+ * @brief Close every device and mux in a pool
+ *
+ * @param pool Pool opened with atecc_pool_open()
+ */
+void atecc_pool_close(atecc_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+    for (size_t i = 0; i < pool->count; i++) {
+        atecc_close(&pool->devs[i]);
+    }
+    for (size_t i = 0; i < pool->mux_count; i++) {
+        atecc_mux_close(&pool->muxes[i]);
+    }
+    pool->count = 0;
+    pool->mux_count = 0;
+}
+
+/**
+ * @brief Dispatch order entry: sort key plus original queue position
+ */
+typedef struct {
+    uintptr_t mux;
+    uint8_t channel;
+    size_t index;
+} dispatch_slot_t;
+
+static int compare_dispatch_slot(const void *a, const void *b) {
+    const dispatch_slot_t *lhs = a;
+    const dispatch_slot_t *rhs = b;
+
+    if (lhs->mux != rhs->mux) {
+        return (lhs->mux < rhs->mux) ? -1 : 1;
+    }
+    if (lhs->channel != rhs->channel) {
+        return (lhs->channel < rhs->channel) ? -1 : 1;
+    }
+    return (lhs->index < rhs->index) ? -1 : (lhs->index > rhs->index);
+}
+
+/**
+ * @brief Run a queue of device operations
+ *
+ * In grouped mode jobs are reordered by (mux, channel) so every channel is
+ * selected once per batch; jobs for the same device keep their queue order.
+ * Otherwise jobs run exactly as queued.
+ *
+ * @param jobs Queued jobs, each job's ok field receives its result
+ * @param count Number of jobs
+ * @param grouped Whether to group jobs by mux channel
+ * @return Number of jobs that succeeded
+ */
+size_t atecc_dispatch(atecc_job_t *jobs, size_t count, bool grouped) {
+    if (!jobs || count == 0) {
+        return 0;
+    }
+
+    dispatch_slot_t *order = calloc(count, sizeof(*order));
+    if (!order) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        order[i].mux = (uintptr_t)jobs[i].dev->mux;
+        order[i].channel = jobs[i].dev->mux_channel;
+        order[i].index = i;
+    }
+    if (grouped) {
+        qsort(order, count, sizeof(*order), compare_dispatch_slot);
+    }
+
+    size_t succeeded = 0;
+    for (size_t i = 0; i < count; i++) {
+        atecc_job_t *job = &jobs[order[i].index];
+        job->ok = job->fn(job->dev, job->arg);
+        if (job->ok) {
+            succeeded++;
+        }
+    }
+
+    free(order);
+    return succeeded;
+}
+
+enum {
+    MUX_BENCH_DEFAULT_ROUNDS = 8U
+};
+
+static bool mux_bench_random_job(atecc_dev_t *dev, void *arg) {
+    uint8_t random[32];
+    (void)arg;
+
+    return atecc_random(dev, random);
+}
+
+/**
+ * @brief Time one dispatch pass and report throughput and mux writes
+ *
+ * Every chip runs one untimed Random first, so neither pass pays for the
+ * wake, identity read and profile load of a cold handle, and both start
+ * from the same mux channel.
+ */
+static void mux_bench_pass(const char *label, atecc_mux_t *mux, atecc_job_t *jobs, size_t count, bool grouped) {
+    atecc_dispatch(jobs, TCA9548A_CHANNELS, false);
+
+    unsigned long switches_before = mux->switches;
+    uint64_t start = atecc_now_us();
+    size_t succeeded = atecc_dispatch(jobs, count, grouped);
+    double elapsed_s = (double)(atecc_now_us() - start) / 1e6;
+
+    printf("📊 %-12s %zu/%zu ok, %.3f s, %.1f cmd/s, %lu mux writes\n",
+           label, succeeded, count, elapsed_s, (double)count / elapsed_s, mux->switches - switches_before);
+}
+
+/**
+ * @brief Compare round-robin and channel-grouped dispatch across the 8 channels of a mux
+ *
+ * Usage: mux-bench <bus> <mux-address> [rounds] [device-address]
+ *
+ * @return Process exit status
+ */
+int atecc_mux_bench(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: pi_atecc mux-bench <bus> <mux-address> [rounds] [device-address]\n");
+        return 2;
+    }
+
+    char spec[64];
+    snprintf(spec, sizeof(spec), "%s:%s.0:%s", argv[0], argv[1], (argc > 3) ? argv[3] : "0x60");
+    atecc_topo_t topo;
+    if (!atecc_parse_topo(spec, &topo)) {
+        fprintf(stderr, "mux-bench: invalid bus or address\n");
+        return 2;
+    }
+    size_t rounds = (argc > 2) ? strtoul(argv[2], NULL, 10) : MUX_BENCH_DEFAULT_ROUNDS;
+    if (rounds == 0) {
+        rounds = MUX_BENCH_DEFAULT_ROUNDS;
+    }
+
+    atecc_mux_t mux;
+    if (!atecc_mux_open(&mux, topo.bus, topo.mux_address)) {
+        return 1;
+    }
+
+    atecc_dev_t devs[TCA9548A_CHANNELS];
+    for (uint8_t channel = 0; channel < TCA9548A_CHANNELS; channel++) {
+        topo.mux_channel = channel;
+        if (!atecc_open_topo(&devs[channel], &topo, &mux)) {
+            for (uint8_t opened = 0; opened < channel; opened++) {
+                atecc_close(&devs[opened]);
+            }
+            atecc_mux_close(&mux);
+            return 1;
+        }
+    }
+
+    size_t count = rounds * TCA9548A_CHANNELS;
+    atecc_job_t *jobs = calloc(count, sizeof(*jobs));
+    if (!jobs) {
+        perror("mux-bench");
+        for (uint8_t channel = 0; channel < TCA9548A_CHANNELS; channel++) {
+            atecc_close(&devs[channel]);
+        }
+        atecc_mux_close(&mux);
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t channel = i % TCA9548A_CHANNELS;
+        jobs[i].dev = &devs[channel];
+        jobs[i].fn = mux_bench_random_job;
+        jobs[i].arg = NULL;
+    }
+
+    printf("🔀 %zu Random commands over %u chips behind mux 0x%02X on %s\n",
+           count, TCA9548A_CHANNELS, topo.mux_address, topo.bus);
+    mux_bench_pass("round-robin", &mux, jobs, count, false);
+    mux_bench_pass("grouped", &mux, jobs, count, true);
+
+    free(jobs);
+    for (uint8_t channel = 0; channel < TCA9548A_CHANNELS; channel++) {
+        atecc_close(&devs[channel]);
+    }
+    atecc_mux_close(&mux);
+    return 0;
+}
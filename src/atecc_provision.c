@@ -0,0 +1,216 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include "pi_atecc.h"
+
+enum {
+    CONFIG_WORDS          = ATECC_CONFIG_SIZE / 4U,
+    WORDS_PER_BLOCK       = 8U,
+    FIRST_WRITABLE_WORD   = 4U,     // Bytes 0-15 (serial, revision, AES/I2C enable) are read-only
+    LOCK_WORD             = 21U,    // Bytes 84-87: UserExtra, UserExtraAdd, LockValue, LockConfig
+    TEMPLATE_TEXT_MAX     = 4096U
+};
+
+/**
+ * @brief Whether a config word can be written with the Write command before locking
+ */
+static bool word_writable(unsigned int word) {
+    return word >= FIRST_WRITABLE_WORD && word != LOCK_WORD && word < CONFIG_WORDS;
+}
+
+/**
+ * @brief Load a 128-byte config template: raw binary, or hex text as printed by the demo
+ *
+ * @return true if the file held exactly one config zone, false otherwise
+ */
+static bool load_template(const char *path, uint8_t *config) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror("provision: cannot open template");
+        return false;
+    }
+    char text[TEMPLATE_TEXT_MAX];
+    size_t length = fread(text, 1, sizeof(text), file);
+    fclose(file);
+
+    if (length == ATECC_CONFIG_SIZE) {
+        memcpy(config, text, ATECC_CONFIG_SIZE);
+        return true;
+    }
+
+    size_t digits = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (!isspace((unsigned char)text[i])) {
+            text[digits++] = text[i];
+        }
+    }
+    if (digits != 2U * ATECC_CONFIG_SIZE || !atecc_hex_decode(text, ATECC_CONFIG_SIZE, config)) {
+        fprintf(stderr, "provision: template must be %u raw bytes or %u hex digits\n",
+                ATECC_CONFIG_SIZE, 2U * ATECC_CONFIG_SIZE);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Provisioning outcome for one chip
+ */
+typedef struct {
+    size_t block_writes;    // 32-byte writes issued
+    size_t word_writes;     // 4-byte writes issued
+    bool already_locked;    // Config zone was locked before we started
+} provision_result_t;
+
+/**
+ * @brief Write the configurable part of the config zone and lock it against the expected image
+ *
+ * Only the read-only head (block 0, bytes 0-15) and the lock word are read
+ * from the chip. Blocks without read-only or lock bytes go out as single
+ * 32-byte writes, the rest as 4-byte writes. The Lock command then checks
+ * the CRC of the whole image computed on the host, which replaces a
+ * readback of everything that was written; once it succeeds the image
+ * becomes the handle's cached config and is published to its snapshot.
+ *
+ * @param dev Device handle
+ * @param template Desired config zone (bytes 0-15 and 84-87 are taken from the chip)
+ * @param lock Whether to lock the config zone afterwards
+ * @param result Receives write counts
+ * @return true if the chip is provisioned (and locked if requested), false otherwise
+ */
+static bool provision_chip(atecc_dev_t *dev, const uint8_t *template, bool lock, provision_result_t *result) {
+    uint8_t image[ATECC_CONFIG_SIZE];
+    memcpy(image, template, sizeof(image));
+    memset(result, 0, sizeof(*result));
+
+    uint8_t head[32];
+    if (!atecc_read_config_bytes(dev, 0, head, sizeof(head)) ||
+        !atecc_read_config_bytes(dev, LOCK_WORD, &image[LOCK_WORD * 4U], 4U)) {
+        fprintf(stderr, "provision: cannot read config head of %s:0x%02X\n", dev->bus, dev->address);
+        return false;
+    }
+    memcpy(image, head, FIRST_WRITABLE_WORD * 4U);
+    if (image[ATECC_CONFIG_LOCK_CONFIG] == 0x00) {
+        result->already_locked = true;
+        return true;
+    }
+    if ((template[16] >> 1) != dev->address) {
+        printf("⚠️ Template sets I2C address 0x%02X for %s:0x%02X\n", template[16] >> 1, dev->bus, dev->address);
+    }
+
+    unsigned int word = FIRST_WRITABLE_WORD;
+    while (word < CONFIG_WORDS) {
+        bool whole_block = (word % WORDS_PER_BLOCK == 0U);
+        for (unsigned int i = word; whole_block && i < word + WORDS_PER_BLOCK; i++) {
+            whole_block = word_writable(i);
+        }
+
+        if (whole_block) {
+            if (!atecc_write_config(dev, (uint8_t)word, &image[word * 4U], 32U)) {
+                return false;
+            }
+            result->block_writes++;
+            word += WORDS_PER_BLOCK;
+        } else {
+            if (word_writable(word)) {
+                if (!atecc_write_config(dev, (uint8_t)word, &image[word * 4U], 4U)) {
+                    return false;
+                }
+                result->word_writes++;
+            }
+            word++;
+        }
+    }
+
+    if (!lock) {
+        return true;
+    }
+    if (!atecc_lock_config(dev, image)) {
+        return false;
+    }
+
+    // The Lock CRC matched, so the chip now holds the image with its config zone locked
+    memcpy(dev->config, image, ATECC_CONFIG_SIZE);
+    dev->config[ATECC_CONFIG_LOCK_CONFIG] = 0x00;
+    dev->config_valid = true;
+    atecc_snapshot_publish(dev);
+    return true;
+}
+
+/**
+ * @brief Provision and lock the config zone of one or more chips from a template
+ *
+ * Usage: provision <template> [--no-lock] [device...]
+ *
+ * @return Process exit status
+ */
+int atecc_provision_main(int argc, char **argv) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: pi_atecc provision <template> [--no-lock] [device...]\n");
+        return 2;
+    }
+
+    uint8_t template[ATECC_CONFIG_SIZE];
+    if (!load_template(argv[0], template)) {
+        return 2;
+    }
+
+    bool lock = true;
+    const char *specs[ATECC_POOL_MAX];
+    size_t spec_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-lock") == 0) {
+            lock = false;
+        } else if (argv[i][0] != '-' && spec_count < ATECC_POOL_MAX) {
+            specs[spec_count++] = argv[i];
+        } else {
+            // A mistyped --no-lock must not fall through to locking the chip
+            fprintf(stderr, "usage: pi_atecc provision <template> [--no-lock] [device...]\n");
+            return 2;
+        }
+    }
+
+    atecc_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool || !atecc_pool_open(pool, specs, spec_count)) {
+        fprintf(stderr, "provision: no devices available\n");
+        free(pool);
+        return 1;
+    }
+
+    size_t provisioned = 0;
+    size_t failed = 0;
+    uint64_t total_us = 0;
+    for (size_t i = 0; i < pool->count; i++) {
+        atecc_dev_t *dev = pool->members[i];
+        provision_result_t result;
+        uint64_t start = atecc_now_us();
+        bool ok = provision_chip(dev, template, lock, &result);
+        uint64_t elapsed_us = atecc_now_us() - start;
+
+        if (!ok) {
+            printf("❌ %s:0x%02X provisioning failed\n", dev->bus, dev->address);
+            failed++;
+        } else if (result.already_locked) {
+            printf("🔒 %s:0x%02X config zone already locked, skipped\n", dev->bus, dev->address);
+        } else {
+            printf("✅ %s:0x%02X %s in %.2f s (%zu block + %zu word writes)\n", dev->bus, dev->address,
+                   lock ? "provisioned and locked" : "written", (double)elapsed_us / 1e6,
+                   result.block_writes, result.word_writes);
+            provisioned++;
+            total_us += elapsed_us;
+        }
+    }
+
+    if (provisioned > 0) {
+        printf("📊 %zu chip(s) provisioned, %.2f s per chip\n", provisioned,
+               (double)total_us / 1e6 / (double)provisioned);
+    }
+
+    atecc_pool_close(pool);
+    free(pool);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,327 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "pi_atecc.h"
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+#ifndef SCHED_FLAG_RESET_ON_FORK
+#define SCHED_FLAG_RESET_ON_FORK 0x01
+#endif
+
+/**
+ * @brief Kernel sched_attr layout for sched_setattr(2), which glibc does not wrap
+ */
+typedef struct {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+} rt_sched_attr_t;
+
+/**
+ * @brief Apply real-time settings to the calling (I/O) thread
+ *
+ * Each setting is attempted independently. A setting the process is not
+ * privileged for (EPERM, missing RLIMIT_MEMLOCK/RLIMIT_RTPRIO) is reported
+ * and skipped, so the thread keeps running with whatever could be applied.
+ * SCHED_DEADLINE is set with reset-on-fork: the kernel refuses to clone a
+ * deadline thread otherwise, and per-device workers apply their own settings
+ * through atecc_dev_t.rt.
+ *
+ * @param opts Settings to apply
+ * @return true if every requested setting was applied, false if any degraded
+ */
+bool atecc_rt_apply(const atecc_rt_opts_t *opts) {
+    if (!opts) {
+        errno = EINVAL;
+        return false;
+    }
+
+    bool applied = true;
+
+    if (opts->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(opts->cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) {
+            fprintf(stderr, "⚠️ atecc_rt_apply: CPU %d affinity not applied: %s\n", opts->cpu, strerror(rc));
+            applied = false;
+        }
+    }
+
+    if (opts->policy == ATECC_RT_FIFO) {
+        struct sched_param param = { .sched_priority = opts->priority };
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc != 0) {
+            fprintf(stderr, "⚠️ atecc_rt_apply: SCHED_FIFO priority %d not applied: %s\n", opts->priority, strerror(rc));
+            applied = false;
+        }
+    } else if (opts->policy == ATECC_RT_DEADLINE) {
+        rt_sched_attr_t attr = {
+            .size           = sizeof(attr),
+            .sched_policy   = SCHED_DEADLINE,
+            .sched_flags    = SCHED_FLAG_RESET_ON_FORK,
+            .sched_runtime  = opts->runtime_ns,
+            .sched_deadline = opts->deadline_ns,
+            .sched_period   = opts->period_ns
+        };
+        if (syscall(SYS_sched_setattr, 0, &attr, 0U) < 0) {
+            fprintf(stderr, "⚠️ atecc_rt_apply: SCHED_DEADLINE not applied: %s\n", strerror(errno));
+            applied = false;
+        }
+    }
+
+    if (opts->lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+        fprintf(stderr, "⚠️ atecc_rt_apply: mlockall not applied: %s\n", strerror(errno));
+        applied = false;
+    }
+
+    return applied;
+}
+
+/**
+ * @brief Consume one real-time option at argv[*index]
+ *
+ * Recognises --cpu C, --fifo PRIO, --deadline and --mlock, so every command
+ * driving devices takes the same spelling as latency.
+ *
+ * @param argc Argument count
+ * @param argv Arguments
+ * @param index Position of the option, advanced past its value
+ * @param opts Settings updated with the option
+ * @return true if argv[*index] was a real-time option
+ */
+bool atecc_rt_parse_arg(int argc, char **argv, int *index, atecc_rt_opts_t *opts) {
+    int i = *index;
+    bool has_value = (i + 1 < argc);
+    if (strcmp(argv[i], "--cpu") == 0 && has_value) {
+        opts->cpu = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--fifo") == 0 && has_value) {
+        opts->policy = ATECC_RT_FIFO;
+        opts->priority = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--deadline") == 0) {
+        // 1 ms of CPU every 5 ms covers a command round trip with margin
+        opts->policy = ATECC_RT_DEADLINE;
+        opts->runtime_ns = 1000000U;
+        opts->deadline_ns = 5000000U;
+        opts->period_ns = 5000000U;
+    } else if (strcmp(argv[i], "--mlock") == 0) {
+        opts->lock_memory = true;
+    } else {
+        return false;
+    }
+    *index = i;
+    return true;
+}
+
+/**
+ * @brief Whether opts asks for anything beyond the default scheduling
+ */
+bool atecc_rt_requested(const atecc_rt_opts_t *opts) {
+    return opts->cpu >= 0 || opts->policy != ATECC_RT_NONE || opts->lock_memory;
+}
+
+/**
+ * @brief Apply real-time settings to the calling thread and the workers of a pool
+ *
+ * The caller (a command's main loop or the daemon's event loop) takes the
+ * settings directly. Worker threads spawned per device (atecc_aes_ctr())
+ * re-apply them through atecc_dev_t.rt, which is only set when the caller
+ * got every setting: a degraded setup leaves the workers on whatever they
+ * inherit instead of repeating the same warnings on every thread.
+ *
+ * @param opts Settings to apply, must outlive the pool
+ * @param pool Devices whose workers should follow the settings
+ * @return true if every requested setting was applied
+ */
+bool atecc_rt_apply_pool(const atecc_rt_opts_t *opts, atecc_pool_t *pool) {
+    if (!atecc_rt_apply(opts)) {
+        fprintf(stderr, "⚠️ Some real-time settings were not applied (insufficient privileges?)\n");
+        return false;
+    }
+    for (size_t i = 0; i < pool->count; i++) {
+        pool->devs[i].rt = opts;
+    }
+    return true;
+}
+
+enum {
+    LATENCY_DEFAULT_COUNT = 200U,
+    LATENCY_SLEEP_US      = 5000U,    // Wait used by the serial/config reads
+    LATENCY_MAX_STRESS    = 64U
+};
+
+static atomic_bool stress_running;
+
+/**
+ * @brief Busy loop standing in for competing application threads
+ */
+static void *stress_thread(void *arg) {
+    (void)arg;
+    volatile uint64_t spins = 0;
+    while (atomic_load_explicit(&stress_running, memory_order_relaxed)) {
+        spins++;
+    }
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t lhs = *(const uint64_t *)a;
+    uint64_t rhs = *(const uint64_t *)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+/**
+ * @brief Time count operations and print p50/p99/max
+ *
+ * With a device each sample is a 32-byte config read (command, fixed wait,
+ * response); without one it is the overshoot of the fixed wait alone, which
+ * is where scheduler jitter shows up. Failed wakes and reads are counted
+ * apart and kept out of the percentiles.
+ */
+static bool latency_pass(const char *label, atecc_dev_t *dev, size_t count) {
+    uint64_t *samples = calloc(count, sizeof(*samples));
+    if (!samples) {
+        return false;
+    }
+
+    uint8_t serial[ATECC_SERIAL_NUMBER_SIZE];
+    size_t taken = 0;
+    size_t failures = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (dev && !atecc_ensure_awake(dev)) {
+            failures++;
+            continue;
+        }
+        uint64_t start = atecc_now_us();
+        if (dev) {
+            if (!atecc_read_serial(dev, serial)) {
+                failures++;
+                continue;
+            }
+            samples[taken++] = atecc_now_us() - start;
+        } else {
+            usleep(LATENCY_SLEEP_US);
+            samples[taken++] = atecc_now_us() - start - LATENCY_SLEEP_US;
+        }
+    }
+
+    if (taken == 0) {
+        printf("⏱️ %-9s no samples (%zu failed)\n", label, failures);
+    } else {
+        qsort(samples, taken, sizeof(*samples), compare_u64);
+        printf("⏱️ %-9s p50 %6llu us  p99 %6llu us  max %6llu us  (%zu samples, %zu failed)\n", label,
+               (unsigned long long)samples[taken / 2], (unsigned long long)samples[(taken * 99U) / 100U],
+               (unsigned long long)samples[taken - 1], taken, failures);
+    }
+
+    free(samples);
+    return failures == 0;
+}
+
+/**
+ * @brief Measure device I/O latency with and without real-time settings
+ *
+ * Usage: latency [--count N] [--stress N] [--cpu C] [--fifo PRIO | --deadline]
+ *                [--mlock] [device | --no-device]
+ *
+ * @return Process exit status
+ */
+int atecc_latency_main(int argc, char **argv) {
+    atecc_rt_opts_t opts = { .cpu = -1, .policy = ATECC_RT_NONE };
+    size_t count = LATENCY_DEFAULT_COUNT;
+    size_t stress = 0;
+    bool use_device = true;
+    atecc_topo_t topo = { .bus = I2C_DEVICE, .address = ATECC_I2C_ADDRESS };
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--count") == 0 && has_value) {
+            count = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--stress") == 0 && has_value) {
+            stress = strtoul(argv[++i], NULL, 10);
+        } else if (atecc_rt_parse_arg(argc, argv, &i, &opts)) {
+            // --cpu, --fifo, --deadline and --mlock, consumed into opts
+        } else if (strcmp(argv[i], "--no-device") == 0) {
+            use_device = false;
+        } else if (argv[i][0] != '-' && atecc_parse_topo(argv[i], &topo)) {
+            use_device = true;
+        } else {
+            fprintf(stderr, "usage: pi_atecc latency [--count N] [--stress N] [--cpu C] "
+                            "[--fifo PRIO | --deadline] [--mlock] [device | --no-device]\n");
+            return 2;
+        }
+    }
+    if (count == 0) {
+        count = LATENCY_DEFAULT_COUNT;
+    }
+    if (stress > LATENCY_MAX_STRESS) {
+        stress = LATENCY_MAX_STRESS;
+    }
+
+    atecc_mux_t mux;
+    atecc_dev_t dev_handle;
+    atecc_dev_t *dev = NULL;
+    if (use_device) {
+        if (topo.mux_address != 0 && !atecc_mux_open(&mux, topo.bus, topo.mux_address)) {
+            return 1;
+        }
+        if (!atecc_open_topo(&dev_handle, &topo, &mux)) {
+            if (topo.mux_address != 0) {
+                atecc_mux_close(&mux);
+            }
+            return 1;
+        }
+        dev = &dev_handle;
+    }
+
+    pthread_t stress_threads[LATENCY_MAX_STRESS];
+    size_t stress_started = 0;
+    atomic_store(&stress_running, true);
+    for (size_t i = 0; i < stress; i++) {
+        if (pthread_create(&stress_threads[stress_started], NULL, stress_thread, NULL) == 0) {
+            stress_started++;
+        }
+    }
+    if (stress_started > 0) {
+        printf("🔥 %zu CPU stress thread(s) running\n", stress_started);
+    }
+
+    bool ok = latency_pass("default", dev, count);
+    if (atecc_rt_requested(&opts)) {
+        if (!atecc_rt_apply(&opts)) {
+            fprintf(stderr, "⚠️ Some real-time settings were not applied (insufficient privileges?)\n");
+        }
+        ok = latency_pass("realtime", dev, count) && ok;
+    }
+
+    atomic_store(&stress_running, false);
+    for (size_t i = 0; i < stress_started; i++) {
+        pthread_join(stress_threads[i], NULL);
+    }
+
+    if (dev) {
+        atecc_close(dev);
+    }
+    if (use_device && topo.mux_address != 0) {
+        atecc_mux_close(&mux);
+    }
+    return ok ? 0 : 1;
+}
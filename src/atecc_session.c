@@ -0,0 +1,681 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pi_atecc.h"
+
+enum {
+    SESSION_LINE_MAX       = 16384U,    // Longest request line
+    SESSION_ID_MAX         = 64U,       // Longest echoed request id, as written
+    SESSION_DEFAULT_WINDOW = 32U,       // Buffered requests taken into one batch
+    SESSION_RANDOM_MAX     = 4096U,     // Largest random request
+    DIGEST_SIZE            = 32U,
+    SHA_BLOCK_SIZE         = 64U,
+    SHA_COMMAND_US         = 6000U,     // One SHA Start/Update/End command including its delay
+    AES_BLOCK              = 16U,
+    PUBKEY_SIZE            = 64U,
+    SIGNATURE_SIZE         = 64U
+};
+
+/**
+ * @brief Requests a session understands
+ */
+typedef enum {
+    SESSION_RANDOM = 0,
+    SESSION_SHA256,
+    SESSION_AES_ENCRYPT,
+    SESSION_AES_DECRYPT,
+    SESSION_READ_CONFIG,
+    SESSION_SERIAL,
+    SESSION_SIGN,
+    SESSION_PUBKEY,
+    SESSION_ECDH,
+    SESSION_VERIFY,
+    SESSION_OP_COUNT
+} session_op_t;
+
+/**
+ * @brief Request names and where they may run
+ *
+ * Requests that use no key or per-chip state may go to any device in the
+ * pool; the rest default to the first device unless "device" names one.
+ */
+static const struct {
+    const char *name;
+    bool any_device;
+} session_ops[SESSION_OP_COUNT] = {
+    [SESSION_RANDOM]      = { "random", true },
+    [SESSION_SHA256]      = { "sha256", true },
+    [SESSION_AES_ENCRYPT] = { "aes_encrypt", false },
+    [SESSION_AES_DECRYPT] = { "aes_decrypt", false },
+    [SESSION_READ_CONFIG] = { "read_config", false },
+    [SESSION_SERIAL]      = { "serial", false },
+    [SESSION_SIGN]        = { "sign", false },
+    [SESSION_PUBKEY]      = { "pubkey", false },
+    [SESSION_ECDH]        = { "ecdh", false },
+    [SESSION_VERIFY]      = { "verify", true }
+};
+
+/**
+ * @brief One parsed request and, once run, its result
+ */
+typedef struct {
+    char id[SESSION_ID_MAX + 1U];   // "id" value exactly as written, empty if absent
+    session_op_t op;
+    const char *error;              // Set when the request cannot run
+    size_t device;                  // Pool index it runs on
+    uint8_t slot;
+    size_t bytes;                   // Random bytes wanted
+    uint8_t *data;                  // "data" payload (SHA-256 message, AES blocks)
+    size_t data_length;
+    uint8_t digest[DIGEST_SIZE];
+    uint8_t key[PUBKEY_SIZE];       // ECDH peer key or verify public key
+    uint8_t signature[SIGNATURE_SIZE];
+    uint8_t *result;
+    size_t result_length;
+    const char *field;              // Name of the result field
+    bool valid;                     // verify outcome
+    bool ok;
+    int err;                        // errno of a failed request
+} session_req_t;
+
+/**
+ * @brief Line reader on a raw descriptor, so poll() sees exactly what is unread
+ */
+typedef struct {
+    int fd;
+    char buffer[SESSION_LINE_MAX];
+    size_t length;
+    bool eof;
+} line_reader_t;
+
+/**
+ * @brief Take the next complete line from the reader, if one is buffered
+ *
+ * A trailing line without newline is returned at end of input. Lines that do
+ * not fit the buffer are split, and the pieces fail to parse.
+ */
+static bool take_line(line_reader_t *reader, char *line) {
+    char *newline = memchr(reader->buffer, '\n', reader->length);
+    size_t length;
+    size_t consumed;
+
+    if (newline) {
+        length = (size_t)(newline - reader->buffer);
+        consumed = length + 1U;
+    } else if (reader->length == sizeof(reader->buffer) || (reader->eof && reader->length > 0)) {
+        length = reader->length;
+        consumed = length;
+    } else {
+        return false;
+    }
+
+    memcpy(line, reader->buffer, length);
+    line[length] = '\0';
+    memmove(reader->buffer, &reader->buffer[consumed], reader->length - consumed);
+    reader->length -= consumed;
+    return true;
+}
+
+/**
+ * @brief Wait up to timeout_ms for more input (-1 waits forever)
+ */
+static void fill_reader(line_reader_t *reader, int timeout_ms) {
+    struct pollfd pfd = { .fd = reader->fd, .events = POLLIN };
+    if (reader->eof || poll(&pfd, 1, timeout_ms) <= 0) {
+        return;
+    }
+
+    ssize_t received = read(reader->fd, &reader->buffer[reader->length], sizeof(reader->buffer) - reader->length);
+    if (received <= 0) {
+        reader->eof = true;
+    } else {
+        reader->length += (size_t)received;
+    }
+}
+
+/**
+ * @brief Skip a string token, honouring backslash escapes
+ *
+ * @param at Opening quote
+ * @return Character after the closing quote, or NULL if the string is unterminated
+ */
+static const char *json_skip_string(const char *at) {
+    for (at++; *at && *at != '"'; at++) {
+        if (*at == '\\' && at[1]) {
+            at++;
+        }
+    }
+    return *at == '"' ? at + 1 : NULL;
+}
+
+/**
+ * @brief Skip one value: a string, an object or array with everything nested in it, or a scalar
+ *
+ * @return Character after the value, or NULL if it is malformed
+ */
+static const char *json_skip_value(const char *at) {
+    if (*at == '"') {
+        return json_skip_string(at);
+    }
+    if (*at == '{' || *at == '[') {
+        unsigned int depth = 0;
+        while (*at) {
+            if (*at == '"') {
+                at = json_skip_string(at);
+                if (!at) {
+                    return NULL;
+                }
+                continue;
+            }
+            if (*at == '{' || *at == '[') {
+                depth++;
+            } else if ((*at == '}' || *at == ']') && --depth == 0) {
+                return at + 1;
+            }
+            at++;
+        }
+        return NULL;
+    }
+    size_t length = strcspn(at, ",}] \t");
+    return length > 0 ? at + length : NULL;
+}
+
+/**
+ * @brief Locate the value of a top-level "key": in a request line
+ *
+ * Walks the object's key/value pairs in order, skipping nested values
+ * whole, so a key inside a nested object or a string value never matches.
+ *
+ * @return Pointer to the first character of the value, or NULL
+ */
+static const char *json_field(const char *line, const char *key) {
+    const char *at = line + strspn(line, " \t");
+    if (*at != '{') {
+        return NULL;
+    }
+    at++;
+    size_t key_length = strlen(key);
+    for (;;) {
+        at += strspn(at, " \t");
+        if (*at != '"') {
+            return NULL;
+        }
+        const char *name = at + 1;
+        at = json_skip_string(at);
+        if (!at) {
+            return NULL;
+        }
+        size_t name_length = (size_t)(at - name) - 1U;
+        at += strspn(at, " \t");
+        if (*at != ':') {
+            return NULL;
+        }
+        at++;
+        at += strspn(at, " \t");
+        if (name_length == key_length && strncmp(name, key, key_length) == 0) {
+            return at;
+        }
+        at = json_skip_value(at);
+        if (!at) {
+            return NULL;
+        }
+        at += strspn(at, " \t");
+        if (*at != ',') {
+            return NULL;
+        }
+        at++;
+    }
+}
+
+/**
+ * @brief Locate a string field's contents
+ *
+ * Escapes are left as written; none of the fields a request uses needs one
+ * decoded, and hex fields containing one fail to decode.
+ *
+ * @return Pointer to the first character inside the quotes, or NULL
+ */
+static const char *json_string(const char *line, const char *key, size_t *length) {
+    const char *value = json_field(line, key);
+    if (!value || *value != '"') {
+        return NULL;
+    }
+    const char *end = json_skip_string(value);
+    if (!end) {
+        return NULL;
+    }
+    *length = (size_t)(end - value) - 2U;
+    return value + 1;
+}
+
+/**
+ * @brief Decode a hex string field of exactly length bytes
+ */
+static bool json_hex(const char *line, const char *key, uint8_t *out, size_t length) {
+    size_t text_length = 0;
+    const char *text = json_string(line, key, &text_length);
+    return text && text_length == 2U * length && atecc_hex_decode(text, length, out);
+}
+
+/**
+ * @brief Read a non-negative integer field
+ */
+static bool json_uint(const char *line, const char *key, unsigned long *out) {
+    const char *value = json_field(line, key);
+    if (!value || *value < '0' || *value > '9') {
+        return false;
+    }
+    *out = strtoul(value, NULL, 10);
+    return true;
+}
+
+/**
+ * @brief Copy the raw "id" token (a string with its quotes, or a number) to echo back
+ */
+static bool json_id(const char *line, char *id) {
+    const char *value = json_field(line, "id");
+    if (!value) {
+        id[0] = '\0';
+        return true;
+    }
+    size_t length = 0;
+    if (*value == '"') {
+        const char *end = json_skip_string(value);
+        if (!end) {
+            return false;
+        }
+        length = (size_t)(end - value);
+    } else {
+        length = strspn(value, "-+.0123456789eE");
+    }
+    if (length == 0 || length > SESSION_ID_MAX) {
+        return false;
+    }
+    memcpy(id, value, length);
+    id[length] = '\0';
+    return true;
+}
+
+/**
+ * @brief Parse one request line and pick its device
+ *
+ * Errors are recorded in req->error and answered like any other result.
+ */
+static void parse_request(const char *line, session_req_t *req, size_t device_count, size_t *next_device) {
+    memset(req, 0, sizeof(*req));
+    if (!json_id(line, req->id)) {
+        req->id[0] = '\0';
+        req->error = "invalid id";
+        return;
+    }
+
+    size_t name_length = 0;
+    const char *name = json_string(line, "op", &name_length);
+    req->op = SESSION_OP_COUNT;
+    for (unsigned int op = 0; name && op < SESSION_OP_COUNT; op++) {
+        if (strlen(session_ops[op].name) == name_length && strncmp(name, session_ops[op].name, name_length) == 0) {
+            req->op = (session_op_t)op;
+        }
+    }
+    if (req->op == SESSION_OP_COUNT) {
+        req->error = "unknown op";
+        return;
+    }
+
+    unsigned long value = 0;
+    if (json_uint(line, "device", &value)) {
+        if (value >= device_count) {
+            req->error = "no such device";
+            return;
+        }
+        req->device = value;
+    } else if (session_ops[req->op].any_device) {
+        req->device = (*next_device)++ % device_count;
+    }
+    if (json_uint(line, "slot", &value)) {
+        req->slot = (uint8_t)value;
+        if (value > 15U) {
+            req->error = "invalid slot";
+            return;
+        }
+    }
+
+    size_t data_length = 0;
+    const char *data = json_string(line, "data", &data_length);
+    if (data) {
+        req->data_length = data_length / 2U;
+        req->data = malloc(req->data_length ? req->data_length : 1U);
+        if (!req->data || (data_length % 2U) != 0 || !atecc_hex_decode(data, req->data_length, req->data)) {
+            req->error = "invalid data";
+            return;
+        }
+    }
+
+    bool valid = true;
+    switch (req->op) {
+    case SESSION_RANDOM:
+        req->bytes = json_uint(line, "bytes", &value) ? value : 32U;
+        valid = req->bytes > 0 && req->bytes <= SESSION_RANDOM_MAX;
+        break;
+    case SESSION_SHA256:
+        valid = data != NULL && req->data_length <= ATECC_SHA_MAX_LENGTH;
+        break;
+    case SESSION_AES_ENCRYPT:
+    case SESSION_AES_DECRYPT:
+        valid = data != NULL && req->data_length > 0 && (req->data_length % AES_BLOCK) == 0;
+        break;
+    case SESSION_SIGN:
+        valid = json_hex(line, "digest", req->digest, DIGEST_SIZE);
+        break;
+    case SESSION_ECDH:
+        valid = json_hex(line, "key", req->key, PUBKEY_SIZE);
+        break;
+    case SESSION_VERIFY:
+        valid = json_hex(line, "digest", req->digest, DIGEST_SIZE) &&
+                json_hex(line, "signature", req->signature, SIGNATURE_SIZE) &&
+                json_hex(line, "key", req->key, PUBKEY_SIZE);
+        break;
+    default:
+        break;
+    }
+    if (!valid) {
+        req->error = "invalid arguments";
+    }
+}
+
+/**
+ * @brief Allocate a request's result buffer
+ */
+static uint8_t *take_result(session_req_t *req, const char *field, size_t length) {
+    req->field = field;
+    req->result_length = length;
+    req->result = malloc(length);
+    return req->result;
+}
+
+/**
+ * @brief Run one request against its device
+ */
+static bool run_request(atecc_dev_t *dev, session_req_t *req) {
+    uint8_t *out = NULL;
+    bool ok = false;
+
+    switch (req->op) {
+    case SESSION_RANDOM:
+        out = take_result(req, "random", req->bytes);
+        ok = out != NULL;
+        for (size_t done = 0; ok && done < req->bytes; done += 32U) {
+            uint8_t block[32];
+            ok = atecc_random(dev, block);
+            if (!ok) {
+                break;
+            }
+            memcpy(&out[done], block, (req->bytes - done < 32U) ? req->bytes - done : 32U);
+        }
+        break;
+    case SESSION_SHA256:
+        // SHA state lives in the chip, so the whole message must fit one awake period
+        out = take_result(req, "digest", DIGEST_SIZE);
+        ok = out && atecc_keep_awake(dev, (uint64_t)(req->data_length / SHA_BLOCK_SIZE + 2U) * SHA_COMMAND_US) &&
+             atecc_sha256(dev, req->data, req->data_length, out);
+        break;
+    case SESSION_AES_ENCRYPT:
+    case SESSION_AES_DECRYPT:
+        out = take_result(req, "data", req->data_length);
+        ok = out != NULL;
+        for (size_t done = 0; ok && done < req->data_length; done += AES_BLOCK) {
+            ok = (req->op == SESSION_AES_ENCRYPT) ? aes_encrypt(dev, &req->data[done], &out[done], req->slot)
+                                                  : aes_decrypt(dev, &req->data[done], &out[done], req->slot);
+        }
+        break;
+    case SESSION_READ_CONFIG:
+        out = take_result(req, "config", ATECC_CONFIG_SIZE);
+        ok = out && atecc_read_config(dev);
+        if (ok) {
+            memcpy(out, dev->config, ATECC_CONFIG_SIZE);
+        }
+        break;
+    case SESSION_SERIAL:
+        out = take_result(req, "serial", ATECC_SERIAL_NUMBER_SIZE);
+        // Waking verifies identity: a cached serial is only answered once this chip has confirmed it
+        ok = out && (dev->identity_verified || atecc_ensure_awake(dev));
+        if (ok) {
+            memcpy(out, dev->serial, ATECC_SERIAL_NUMBER_SIZE);
+        }
+        break;
+    case SESSION_SIGN:
+        out = take_result(req, "signature", SIGNATURE_SIZE);
+        ok = out && atecc_sign_digest(dev, req->slot, req->digest, out);
+        break;
+    case SESSION_PUBKEY:
+        out = take_result(req, "pubkey", PUBKEY_SIZE);
+        ok = out && atecc_get_pubkey(dev, req->slot, out);
+        break;
+    case SESSION_ECDH:
+        out = take_result(req, "secret", DIGEST_SIZE);
+        ok = out && atecc_ecdh(dev, req->slot, req->key, out);
+        break;
+    case SESSION_VERIFY:
+        ok = atecc_verify_digest(dev, req->digest, req->signature, req->key, &req->valid);
+        break;
+    default:
+        errno = EINVAL;
+        break;
+    }
+    req->err = ok ? 0 : (errno ? errno : EIO);
+    return ok;
+}
+
+/**
+ * @brief Requests of one batch that run on one device, in input order
+ */
+typedef struct {
+    atecc_dev_t *dev;
+    size_t device;
+    session_req_t *reqs;
+    size_t count;
+} session_worker_t;
+
+static void *session_worker(void *arg) {
+    session_worker_t *worker = arg;
+    for (size_t i = 0; i < worker->count; i++) {
+        session_req_t *req = &worker->reqs[i];
+        if (!req->error && req->device == worker->device) {
+            errno = 0;
+            req->ok = run_request(worker->dev, req);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Run a batch of requests, one thread per device it uses
+ *
+ * Every request a session accepts is independent of the others (none
+ * writes to the chip), so requests for different devices run concurrently
+ * and only those for the same device are serialized.
+ */
+static void run_batch(atecc_pool_t *pool, session_req_t *reqs, size_t count) {
+    session_worker_t workers[ATECC_POOL_MAX];
+    pthread_t threads[ATECC_POOL_MAX];
+    bool started[ATECC_POOL_MAX] = {false};
+    bool used[ATECC_POOL_MAX] = {false};
+    size_t used_count = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!reqs[i].error && !used[reqs[i].device]) {
+            used[reqs[i].device] = true;
+            used_count++;
+        }
+    }
+    for (size_t d = 0; d < pool->count; d++) {
+        workers[d] = (session_worker_t){ .dev = pool->members[d], .device = d, .reqs = reqs, .count = count };
+        if (used[d] && used_count > 1U) {
+            started[d] = pthread_create(&threads[d], NULL, session_worker, &workers[d]) == 0;
+        }
+        if (used[d] && !started[d]) {
+            session_worker(&workers[d]);
+        }
+    }
+    for (size_t d = 0; d < pool->count; d++) {
+        if (started[d]) {
+            pthread_join(threads[d], NULL);
+        }
+    }
+}
+
+/**
+ * @brief Write one response line
+ */
+static bool emit_response(atecc_out_t *out, const session_req_t *req) {
+    bool ok = atecc_out_str(out, "{");
+    if (req->id[0]) {
+        ok = ok && atecc_out_str(out, "\"id\":") && atecc_out_str(out, req->id) && atecc_out_str(out, ",");
+    }
+    if (req->error || !req->ok) {
+        return ok && atecc_out_str(out, "\"ok\":false,\"error\":\"") &&
+               atecc_out_str(out, req->error ? req->error : strerror(req->err)) && atecc_out_str(out, "\"}\n");
+    }
+
+    char device[32];
+    snprintf(device, sizeof(device), "\"ok\":true,\"device\":%zu", req->device);
+    ok = ok && atecc_out_str(out, device);
+    if (req->op == SESSION_VERIFY) {
+        ok = ok && atecc_out_str(out, req->valid ? ",\"valid\":true" : ",\"valid\":false");
+    }
+    if (req->field) {
+        ok = ok && atecc_out_str(out, ",\"") && atecc_out_str(out, req->field) && atecc_out_str(out, "\":\"") &&
+             atecc_out_hex(out, req->result, req->result_length, ATECC_HEX_LOWER) && atecc_out_str(out, "\"");
+    }
+    return ok && atecc_out_str(out, "}\n");
+}
+
+/**
+ * @brief Serve JSON-lines requests from stdin on warm device handles
+ *
+ * Usage: session [--window N] [device...]
+ *
+ * Each input line is one request, such as
+ * {"id":1,"op":"sign","slot":0,"digest":"<64 hex>"}, and gets one response
+ * line in the same order: {"id":1,"ok":true,"device":0,"signature":"..."}
+ * or {"id":1,"ok":false,"error":"..."}. Byte strings are hex. Ops:
+ * random [bytes], sha256 data, aes_encrypt / aes_decrypt slot data,
+ * read_config, serial, sign slot digest, pubkey slot, ecdh slot key,
+ * verify digest signature key. "device" picks a pool member; without it
+ * random, sha256 and verify are spread over the pool and the rest use
+ * device 0.
+ *
+ * The pool is opened once, with cached identity, config and tuning
+ * profiles, so a request costs only its commands. Requests already
+ * buffered on stdin (up to N) are taken as one batch and run per device
+ * in parallel.
+ *
+ * @return Process exit status
+ */
+int atecc_session_main(int argc, char **argv) {
+    size_t window = SESSION_DEFAULT_WINDOW;
+    const char *specs[ATECC_POOL_MAX];
+    size_t spec_count = 0;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && spec_count < ATECC_POOL_MAX) {
+            specs[spec_count++] = argv[i];
+        } else {
+            fprintf(stderr, "usage: pi_atecc session [--window N] [device...]\n");
+            return 2;
+        }
+    }
+    if (window == 0) {
+        window = SESSION_DEFAULT_WINDOW;
+    }
+
+    atecc_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool || !atecc_pool_open(pool, specs, spec_count)) {
+        fprintf(stderr, "session: no devices available\n");
+        free(pool);
+        return 1;
+    }
+    for (size_t i = 0; i < pool->count; i++) {
+        atecc_cache_load(pool->members[i]);
+    }
+
+    session_req_t *reqs = calloc(window, sizeof(*reqs));
+    line_reader_t *reader = calloc(1, sizeof(*reader));
+    char *line = malloc(SESSION_LINE_MAX + 1U);
+    atecc_out_t out;
+    if (!reqs || !reader || !line || !atecc_out_init(&out, STDOUT_FILENO, 0)) {
+        perror("session");
+        free(reqs);
+        free(reader);
+        free(line);
+        atecc_pool_close(pool);
+        free(pool);
+        return 1;
+    }
+    reader->fd = STDIN_FILENO;
+
+    size_t next_device = 0;
+    size_t requests = 0;
+    size_t failed = 0;
+    size_t batches = 0;
+    uint64_t busy_us = 0;
+    bool ok = true;
+    while (ok) {
+        // Block for the first request, then take whatever else is already waiting
+        size_t count = 0;
+        while (count < window) {
+            if (take_line(reader, line)) {
+                if (line[strspn(line, " \t\r")] != '\0') {
+                    parse_request(line, &reqs[count++], pool->count, &next_device);
+                }
+                continue;
+            }
+            if (reader->eof) {
+                break;
+            }
+            size_t buffered = reader->length;
+            fill_reader(reader, count > 0 ? 0 : -1);
+            if (count > 0 && reader->length == buffered && !reader->eof) {
+                break;
+            }
+        }
+        if (count == 0) {
+            break;
+        }
+
+        uint64_t start = atecc_now_us();
+        run_batch(pool, reqs, count);
+        busy_us += atecc_now_us() - start;
+        for (size_t i = 0; i < count; i++) {
+            ok = ok && emit_response(&out, &reqs[i]);
+            failed += (reqs[i].error || !reqs[i].ok) ? 1U : 0U;
+            free(reqs[i].data);
+            free(reqs[i].result);
+        }
+        ok = ok && atecc_out_flush(&out);
+        requests += count;
+        batches++;
+    }
+
+    fprintf(stderr, "📊 %zu request(s) in %zu batch(es), %zu failed, %.2f ms device time per request\n", requests,
+            batches, failed, requests ? (double)busy_us / (double)requests / 1000.0 : 0.0);
+    if (!ok) {
+        perror("session: write failed");
+    }
+    atecc_out_free(&out);
+    free(line);
+    free(reader);
+    free(reqs);
+    atecc_pool_close(pool);
+    free(pool);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,485 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "pi_atecc.h"
+
+enum {
+    CONFIG_REVISION     = 4U,       // Config bytes 4-7
+    CONFIG_AES_ENABLE   = 13U,      // AESEnable, bit 0 enables the AES command
+    CONFIG_SLOT_CONFIG  = 20U,      // SlotConfig, two bytes per slot
+    CONFIG_KEY_CONFIG   = 96U,      // KeyConfig, two bytes per slot
+    BENCH_DEFAULT_MS    = 250U,     // Measurement time per row and mode
+    BENCH_DEFAULT_MAX   = 64U,
+    BENCH_THREADS_MAX   = 256U,
+    BENCH_MAX_ROWS      = 10U,      // 1, 2, 4, ... 256 and one odd maximum
+    BENCH_BAR           = 32U       // Width of the speedup bar at its largest value
+};
+
+/**
+ * @brief Build a view of the handle's cached identity, config, tuning profile and health counters
+ */
+static void describe_handle(const atecc_dev_t *dev, atecc_snapshot_t *view) {
+    memset(view, 0, sizeof(*view));
+    view->published_us = atecc_now_us();
+
+    view->identity_valid = dev->identity_valid;
+    memcpy(view->serial, dev->serial, sizeof(view->serial));
+
+    view->config_valid = dev->config_valid;
+    if (dev->config_valid) {
+        memcpy(view->revision, &dev->config[CONFIG_REVISION], sizeof(view->revision));
+        view->config_locked = dev->config[ATECC_CONFIG_LOCK_CONFIG] == 0x00;
+        view->data_locked = dev->config[ATECC_CONFIG_LOCK_VALUE] == 0x00;
+        view->aes_enabled = (dev->config[CONFIG_AES_ENABLE] & 0x01U) != 0U;
+        for (size_t slot = 0; slot < ATECC_SLOT_COUNT; slot++) {
+            const uint8_t *slot_config = &dev->config[CONFIG_SLOT_CONFIG + 2U * slot];
+            const uint8_t *key_config = &dev->config[CONFIG_KEY_CONFIG + 2U * slot];
+            view->slot_config[slot] = (uint16_t)(slot_config[0] | (slot_config[1] << 8));
+            view->key_config[slot] = (uint16_t)(key_config[0] | (key_config[1] << 8));
+        }
+    }
+
+    view->tune = dev->tune;
+
+    view->commands = dev->commands;
+    view->failures = dev->failures;
+    view->consecutive_failures = dev->consecutive_failures;
+    view->last_ok_us = dev->last_ok_us;
+    view->selftest_passed = dev->selftest_passed;
+    view->selftest_failed = dev->selftest_failed;
+    view->selftest_us = dev->selftest_us;
+}
+
+/**
+ * @brief Copy a view into a cell under its seqlock, numbering it one past the view it replaces
+ */
+static void snapshot_store(atecc_snapshot_cell_t *cell, atecc_snapshot_t *view) {
+    unsigned int seq = atomic_load_explicit(&cell->seq, memory_order_relaxed);
+    do {
+        while ((seq & 1U) != 0U) {
+            seq = atomic_load_explicit(&cell->seq, memory_order_relaxed);
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&cell->seq, &seq, seq + 1U, memory_order_acquire,
+                                                    memory_order_relaxed));
+    atomic_thread_fence(memory_order_release);
+
+    view->generation = cell->view.generation + 1U;
+    memcpy(&cell->view, view, sizeof(*view));
+
+    atomic_store_explicit(&cell->seq, seq + 2U, memory_order_release);
+}
+
+/**
+ * @brief Publish the handle's current state to threads reading its snapshot
+ *
+ * Called by the command path after health counters change and by the
+ * writers that refresh identity, config or the tuning profile (first wake,
+ * config reads and writes, provisioning, calibration). The view is built
+ * first and copied in while seq is odd, keeping the window in which
+ * readers retry as short as a memcpy. Concurrent writers take turns on the
+ * compare-and-swap instead of a lock.
+ *
+ * @param dev Device handle
+ */
+void atecc_snapshot_publish(atecc_dev_t *dev) {
+    if (!dev) {
+        return;
+    }
+
+    atecc_snapshot_t view;
+    describe_handle(dev, &view);
+    snapshot_store(&dev->snapshot, &view);
+}
+
+/**
+ * @brief Copy a consistent view out of a cell
+ *
+ * @return Number of copies discarded because a writer was active
+ */
+static unsigned long snapshot_copy(const atecc_snapshot_cell_t *cell, atecc_snapshot_t *snapshot) {
+    unsigned long retries = 0;
+    unsigned int before;
+    unsigned int after;
+
+    for (;;) {
+        before = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        memcpy(snapshot, &cell->view, sizeof(*snapshot));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&cell->seq, memory_order_relaxed);
+        if ((before & 1U) == 0U && before == after) {
+            return retries;
+        }
+        retries++;
+    }
+}
+
+/**
+ * @brief Take a consistent copy of the latest published view of a handle
+ *
+ * Safe from any thread while another thread drives the handle: reads take
+ * no locks and no system calls and retry only while a publish is copying in.
+ *
+ * @param dev Device handle
+ * @param snapshot Receives the view
+ * @return true if a view has been published, false otherwise (errno set)
+ */
+bool atecc_snapshot_read(const atecc_dev_t *dev, atecc_snapshot_t *snapshot) {
+    if (!dev || !snapshot) {
+        errno = EINVAL;
+        return false;
+    }
+    snapshot_copy(&dev->snapshot, snapshot);
+    if (snapshot->generation == 0U) {
+        errno = ENODATA;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Shared state of one snapshot-bench row
+ */
+typedef struct {
+    atecc_dev_t *dev;
+    bool stress;                        // Views are stamped patterns published into synthetic
+    atecc_snapshot_cell_t synthetic;    // Stress writer's cell, leaving the handle's counters untouched
+    const atecc_snapshot_cell_t *cell;  // Cell the readers copy from: the handle's or synthetic
+    bool locked;                        // Readers copy guarded_view under guard instead of the seqlock
+    pthread_mutex_t guard;
+    atecc_snapshot_t guarded_view;      // Copy of the latest view for the mutex baseline
+    atomic_bool stop;
+} bench_shared_t;
+
+/**
+ * @brief Counters of one reader thread, padded to keep them off each other's cache lines
+ */
+typedef struct {
+    bench_shared_t *shared;
+    pthread_t thread;
+    unsigned long reads;
+    unsigned long retries;
+    unsigned long torn;             // Views older than, or inconsistent with, one already seen
+    char pad[64];
+} bench_reader_t;
+
+/**
+ * @brief Result of one snapshot-bench row
+ */
+typedef struct {
+    size_t threads;
+    double seqlock_rate;            // Reads per second through atecc_snapshot_read()
+    double mutex_rate;              // Reads per second through a mutex-guarded copy
+    unsigned long seqlock_reads;
+    unsigned long retries;
+    unsigned long torn;
+    unsigned long publishes;
+} bench_row_t;
+
+/**
+ * @brief Fill every field of a stress view from one stamp
+ *
+ * The stamp equals the generation the view will be published as (the
+ * stress writer is the only writer of its cell), so a view copied half
+ * before and half after a publish no longer agrees with itself.
+ */
+static void stamp_view(atecc_snapshot_t *view, uint64_t stamp) {
+    memset(view, 0, sizeof(*view));
+    view->published_us = stamp;
+    view->identity_valid = true;
+    memset(view->serial, (int)(stamp & 0xFFU), sizeof(view->serial));
+    view->config_valid = true;
+    memset(view->revision, (int)(stamp & 0xFFU), sizeof(view->revision));
+    for (size_t slot = 0; slot < ATECC_SLOT_COUNT; slot++) {
+        view->slot_config[slot] = (uint16_t)stamp;
+        view->key_config[slot] = (uint16_t)~stamp;
+    }
+    view->commands = (unsigned long)stamp;
+    view->last_ok_us = stamp;
+    view->selftest_us = stamp;
+}
+
+/**
+ * @brief Whether a stress view carries one stamp throughout, the one matching its generation
+ */
+static bool stamp_intact(const atecc_snapshot_t *view) {
+    atecc_snapshot_t expected;
+    stamp_view(&expected, view->generation);
+    return memcmp(view->serial, expected.serial, sizeof(expected.serial)) == 0 &&
+           memcmp(view->revision, expected.revision, sizeof(expected.revision)) == 0 &&
+           memcmp(view->slot_config, expected.slot_config, sizeof(expected.slot_config)) == 0 &&
+           memcmp(view->key_config, expected.key_config, sizeof(expected.key_config)) == 0 &&
+           view->published_us == expected.published_us && view->commands == expected.commands &&
+           view->last_ok_us == expected.last_ok_us && view->selftest_us == expected.selftest_us;
+}
+
+/**
+ * @brief Publish the next stamped view into the stress cell
+ */
+static void stamp_publish(atecc_snapshot_cell_t *cell) {
+    atecc_snapshot_t view;
+    stamp_view(&view, cell->view.generation + 1U);
+    snapshot_store(cell, &view);
+}
+
+static void *bench_reader(void *arg) {
+    bench_reader_t *reader = arg;
+    bench_shared_t *shared = reader->shared;
+    atecc_snapshot_t view;
+    uint64_t last_generation = 0;
+    unsigned long last_commands = 0;
+
+    while (!atomic_load_explicit(&shared->stop, memory_order_relaxed)) {
+        if (shared->locked) {
+            pthread_mutex_lock(&shared->guard);
+            view = shared->guarded_view;
+            pthread_mutex_unlock(&shared->guard);
+        } else {
+            reader->retries += snapshot_copy(shared->cell, &view);
+        }
+        if (view.generation < last_generation || view.commands < last_commands ||
+            view.failures > view.commands || (shared->stress && !stamp_intact(&view))) {
+            reader->torn++;
+        }
+        last_generation = view.generation;
+        last_commands = view.commands;
+        reader->reads++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Run readers against the handle for ms milliseconds while this thread writes
+ *
+ * The writer either runs Random commands, which publish through the command
+ * path, or with stress publishes stamped views back to back into a cell of
+ * its own (see stamp_view()). Fills the seqlock or mutex half of row, as
+ * selected by shared->locked.
+ *
+ * @return true on success, false if a thread could not be started or a command failed
+ */
+static bool bench_run(bench_shared_t *shared, bench_reader_t *readers, unsigned long ms, bench_row_t *row) {
+    size_t threads = row->threads;
+    atecc_dev_t *dev = shared->dev;
+    atomic_store(&shared->stop, false);
+    memset(readers, 0, threads * sizeof(readers[0]));
+
+    size_t started = 0;
+    bool ok = true;
+    for (; started < threads; started++) {
+        readers[started].shared = shared;
+        if (pthread_create(&readers[started].thread, NULL, bench_reader, &readers[started]) != 0) {
+            fprintf(stderr, "snapshot-bench: cannot start reader %zu\n", started);
+            ok = false;
+            break;
+        }
+    }
+
+    atecc_snapshot_t view;
+    snapshot_copy(shared->cell, &view);
+    uint64_t first = view.generation;
+    uint64_t start_us = atecc_now_us();
+    uint64_t end_us = start_us + (uint64_t)ms * 1000U;
+    while (ok && atecc_now_us() < end_us) {
+        if (shared->stress) {
+            stamp_publish(&shared->synthetic);
+        } else {
+            uint8_t random[32];
+            ok = atecc_random(dev, random);
+        }
+        if (shared->locked) {
+            snapshot_copy(shared->cell, &view);
+            pthread_mutex_lock(&shared->guard);
+            shared->guarded_view = view;
+            pthread_mutex_unlock(&shared->guard);
+        }
+    }
+    atomic_store(&shared->stop, true);
+    uint64_t elapsed_us = atecc_now_us() - start_us;
+
+    unsigned long reads = 0;
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(readers[i].thread, NULL);
+        reads += readers[i].reads;
+        row->retries += readers[i].retries;
+        row->torn += readers[i].torn;
+    }
+    snapshot_copy(shared->cell, &view);
+    row->publishes += (unsigned long)(view.generation - first);
+    double rate = elapsed_us ? (double)reads * 1e6 / (double)elapsed_us : 0.0;
+    if (shared->locked) {
+        row->mutex_rate = rate;
+    } else {
+        row->seqlock_rate = rate;
+        row->seqlock_reads = reads;
+    }
+    if (!ok && started == threads) {
+        fprintf(stderr, "snapshot-bench: Random failed on %s:0x%02X\n", dev->bus, dev->address);
+    }
+    return ok;
+}
+
+/**
+ * @brief Chart snapshot reader throughput against reader thread count
+ *
+ * Usage: snapshot-bench [--max N] [--ms MS] [--stress] [device]
+ *
+ * For 1, 2, 4, ... N reader threads (default 64), readers copy the
+ * handle's snapshot in a loop while the main thread drives the device with
+ * Random commands, publishing on every response. Each row runs once
+ * through the seqlock (atecc_snapshot_read()) and once through a copy
+ * guarded by a mutex, the lock every reader would otherwise take. --stress
+ * replaces the commands with back-to-back publishes of synthetic views to
+ * show reader retries under the heaviest write load; each one repeats its
+ * generation across serial, config and counters, so a torn copy of any of
+ * them is caught. Every view a reader takes is also checked against the
+ * ones before it; torn views fail the run. An emulated device
+ * (e.g. emu0:0x60) needs no hardware.
+ *
+ * @return Process exit status
+ */
+int atecc_snapshot_bench_main(int argc, char **argv) {
+    size_t max_threads = BENCH_DEFAULT_MAX;
+    unsigned long ms = BENCH_DEFAULT_MS;
+    bool stress = false;
+    const char *spec = NULL;
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--max") == 0 && has_value) {
+            max_threads = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--ms") == 0 && has_value) {
+            ms = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--stress") == 0) {
+            stress = true;
+        } else if (argv[i][0] != '-') {
+            spec = argv[i];
+        } else {
+            fprintf(stderr, "usage: pi_atecc snapshot-bench [--max N] [--ms MS] [--stress] [device]\n");
+            return 2;
+        }
+    }
+    if (max_threads == 0 || max_threads > BENCH_THREADS_MAX || ms == 0) {
+        fprintf(stderr, "snapshot-bench: --max must be 1-%d and --ms positive\n", BENCH_THREADS_MAX);
+        return 2;
+    }
+
+    atecc_topo_t topo = { .bus = I2C_DEVICE, .address = ATECC_I2C_ADDRESS };
+    if (spec && !atecc_parse_topo(spec, &topo)) {
+        fprintf(stderr, "❌ ERROR: Invalid device address '%s'\n", spec);
+        return 2;
+    }
+    atecc_mux_t mux;
+    atecc_dev_t *dev = malloc(sizeof(*dev));
+    bench_shared_t *shared = malloc(sizeof(*shared));
+    bench_reader_t *readers = calloc(max_threads, sizeof(*readers));
+    if (!dev || !shared || !readers) {
+        perror("snapshot-bench");
+        free(dev);
+        free(shared);
+        free(readers);
+        return 1;
+    }
+    bool muxed = topo.mux_address != 0;
+    if (muxed && !atecc_mux_open(&mux, topo.bus, topo.mux_address)) {
+        free(dev);
+        free(shared);
+        free(readers);
+        return 1;
+    }
+    if (!atecc_open_topo(dev, &topo, &mux)) {
+        if (muxed) {
+            atecc_mux_close(&mux);
+        }
+        free(dev);
+        free(shared);
+        free(readers);
+        return 1;
+    }
+
+    atecc_snapshot_t view = {0};
+    bool ok = atecc_read_config(dev) && atecc_snapshot_read(dev, &view);
+    if (ok) {
+        char serial_hex[2U * ATECC_SERIAL_NUMBER_SIZE + 1U];
+        atecc_hex(view.serial, ATECC_SERIAL_NUMBER_SIZE, serial_hex, ATECC_HEX_UPPER);
+        printf("📸 %s on %s:0x%02X: config %s, data %s, %s, snapshot %zu bytes\n", serial_hex, dev->bus,
+               dev->address, view.config_locked ? "locked" : "unlocked", view.data_locked ? "locked" : "unlocked",
+               view.tune.loaded ? "tuned" : "fixed waits", sizeof(view));
+    } else {
+        fprintf(stderr, "snapshot-bench: cannot read the config zone of %s:0x%02X\n", dev->bus, dev->address);
+    }
+
+    memset(shared, 0, sizeof(*shared));
+    shared->dev = dev;
+    shared->stress = stress;
+    atomic_init(&shared->synthetic.seq, 0U);
+    shared->cell = &dev->snapshot;
+    if (stress) {
+        stamp_publish(&shared->synthetic);
+        shared->cell = &shared->synthetic;
+        snapshot_copy(shared->cell, &view);
+    }
+    pthread_mutex_init(&shared->guard, NULL);
+    shared->guarded_view = view;
+    atomic_init(&shared->stop, false);
+
+    // Powers of two, then the maximum itself
+    size_t counts[BENCH_MAX_ROWS];
+    size_t rows = 0;
+    for (size_t threads = 1; threads < max_threads; threads *= 2U) {
+        counts[rows++] = threads;
+    }
+    counts[rows++] = max_threads;
+
+    bench_row_t results[BENCH_MAX_ROWS] = {0};
+    size_t done = 0;
+    for (; ok && done < rows; done++) {
+        bench_row_t *row = &results[done];
+        row->threads = counts[done];
+        shared->locked = false;
+        ok = bench_run(shared, readers, ms, row);
+        shared->locked = true;
+        ok = ok && bench_run(shared, readers, ms, row);
+        if (ok && row->torn > 0) {
+            fprintf(stderr, "snapshot-bench: %lu torn view(s) with %zu readers\n", row->torn, row->threads);
+            ok = false;
+        }
+    }
+
+    double best = 1.0;
+    for (size_t r = 0; r < done; r++) {
+        double speedup = results[r].mutex_rate > 0.0 ? results[r].seqlock_rate / results[r].mutex_rate : 0.0;
+        best = speedup > best ? speedup : best;
+    }
+    printf("readers   seqlock reads/s     mutex reads/s  speedup  retries/Mread  publishes\n");
+    for (size_t r = 0; r < done; r++) {
+        const bench_row_t *row = &results[r];
+        double speedup = row->mutex_rate > 0.0 ? row->seqlock_rate / row->mutex_rate : 0.0;
+        char bar[BENCH_BAR + 1];
+        size_t bar_len = (size_t)(speedup * BENCH_BAR / best);
+        bar_len = bar_len > BENCH_BAR ? BENCH_BAR : bar_len;
+        memset(bar, '#', bar_len);
+        bar[bar_len] = '\0';
+        printf("%7zu  %16.0f  %16.0f  %6.1fx  %13.1f  %9lu  %s\n", row->threads, row->seqlock_rate,
+               row->mutex_rate, speedup,
+               row->seqlock_reads ? (double)row->retries * 1e6 / (double)row->seqlock_reads : 0.0,
+               row->publishes, bar);
+    }
+    printf("📊 %s writer, %lu ms per row and mode; speedup bar: one '#' per %.2fx\n",
+           stress ? "back-to-back publish" : "Random command", ms, best / BENCH_BAR);
+
+    pthread_mutex_destroy(&shared->guard);
+    atecc_close(dev);
+    if (muxed) {
+        atecc_mux_close(&mux);
+    }
+    free(dev);
+    free(shared);
+    free(readers);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,387 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "pi_atecc.h"
+
+enum {
+    STATUS_VERSION      = 3U,
+    STATUS_FAILED_AFTER = 3U,          // Consecutive failures before a device is reported failed
+    STATUS_BENCH_READS  = 1000000U
+};
+
+/**
+ * @brief Create (or replace) the status page and map it for writing
+ *
+ * @param name shm_open() name, NULL for ATECC_STATUS_SHM
+ * @return Mapped page, or NULL on failure
+ */
+atecc_status_page_t *atecc_status_create(const char *name) {
+    name = name ? name : ATECC_STATUS_SHM;
+
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("atecc_status_create: shm_open failed");
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(atecc_status_page_t)) < 0) {
+        perror("atecc_status_create: ftruncate failed");
+        close(fd);
+        return NULL;
+    }
+
+    atecc_status_page_t *page = mmap(NULL, sizeof(*page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        perror("atecc_status_create: mmap failed");
+        return NULL;
+    }
+
+    memset(page, 0, sizeof(*page));
+    atomic_init(&page->seq, 0U);
+    page->version = STATUS_VERSION;
+    atomic_thread_fence(memory_order_release);
+    page->magic = ATECC_STATUS_MAGIC;
+    return page;
+}
+
+static atecc_health_t device_health(const atecc_dev_t *dev) {
+    if (dev->commands == 0 && dev->last_ok_us == 0) {
+        return ATECC_HEALTH_UNKNOWN;
+    }
+    if (dev->consecutive_failures == 0) {
+        return ATECC_HEALTH_OK;
+    }
+    return (dev->consecutive_failures < STATUS_FAILED_AFTER) ? ATECC_HEALTH_DEGRADED : ATECC_HEALTH_FAILED;
+}
+
+/**
+ * @brief Fill a status entry from a device handle's cached identity, config and counters
+ */
+static void describe_device(const atecc_dev_t *dev, atecc_status_dev_t *entry) {
+    memset(entry, 0, sizeof(*entry));
+    memcpy(entry->bus, dev->bus, sizeof(entry->bus));
+    entry->address = dev->address;
+    if (dev->mux) {
+        entry->mux_address = dev->mux->port.address;
+        entry->mux_channel = dev->mux_channel;
+    }
+    entry->health = (uint8_t)device_health(dev);
+
+    entry->identity_valid = dev->identity_valid;
+    memcpy(entry->serial, dev->serial, sizeof(entry->serial));
+    entry->config_valid = dev->config_valid;
+    if (dev->config_valid) {
+        memcpy(entry->revision, &dev->config[4], sizeof(entry->revision));
+        entry->config_locked = dev->config[ATECC_CONFIG_LOCK_CONFIG] == 0x00;
+        entry->data_locked = dev->config[ATECC_CONFIG_LOCK_VALUE] == 0x00;
+    }
+
+    entry->commands = dev->commands;
+    entry->failures = dev->failures;
+    entry->last_ok_us = dev->last_ok_us;
+    entry->selftest_passed = dev->selftest_passed;
+    entry->selftest_failed = dev->selftest_failed;
+    entry->selftest_us = dev->selftest_us;
+}
+
+/**
+ * @brief Publish the current state of every pool device
+ *
+ * Entries are built first and copied in while seq is odd, keeping the
+ * window in which readers retry as short as a memcpy.
+ *
+ * @param page Page from atecc_status_create()
+ * @param pool Devices to describe
+ * @param requests Requests served so far
+ * @param clients Usage entry per connected client
+ * @param client_count Connected clients
+ * @param selftest Idle-time SelfTest counters (may be NULL)
+ */
+void atecc_status_publish(atecc_status_page_t *page, const atecc_pool_t *pool, uint64_t requests,
+                          const atecc_status_client_t *clients, size_t client_count,
+                          const atecc_status_selftest_t *selftest) {
+    if (!page || !pool || client_count > ATECC_STATUS_CLIENT_MAX) {
+        return;
+    }
+
+    static atecc_status_dev_t entries[ATECC_POOL_MAX];
+    for (size_t i = 0; i < pool->count; i++) {
+        describe_device(pool->members[i], &entries[i]);
+    }
+
+    unsigned int seq = atomic_load_explicit(&page->seq, memory_order_relaxed);
+    atomic_store_explicit(&page->seq, seq + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(page->devices, entries, pool->count * sizeof(entries[0]));
+    page->device_count = (uint32_t)pool->count;
+    page->updated_us = atecc_now_us();
+    page->requests = requests;
+    page->clients = (uint32_t)client_count;
+    if (client_count > 0) {
+        memcpy(page->client_usage, clients, client_count * sizeof(clients[0]));
+    }
+    if (selftest) {
+        page->selftest = *selftest;
+    }
+
+    atomic_store_explicit(&page->seq, seq + 2U, memory_order_release);
+}
+
+/**
+ * @brief Unmap and remove the status page
+ */
+void atecc_status_destroy(atecc_status_page_t *page, const char *name) {
+    if (page) {
+        munmap(page, sizeof(*page));
+    }
+    shm_unlink(name ? name : ATECC_STATUS_SHM);
+}
+
+/**
+ * @brief Map the daemon's status page read-only
+ *
+ * @param name shm_open() name, NULL for ATECC_STATUS_SHM
+ * @return Mapped page, or NULL if no daemon has published one
+ */
+const atecc_status_page_t *atecc_status_map(const char *name) {
+    int fd = shm_open(name ? name : ATECC_STATUS_SHM, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    const atecc_status_page_t *page = mmap(NULL, sizeof(*page), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        return NULL;
+    }
+    if (page->magic != ATECC_STATUS_MAGIC || page->version != STATUS_VERSION) {
+        munmap((void *)page, sizeof(*page));
+        errno = EPROTO;
+        return NULL;
+    }
+    return page;
+}
+
+/**
+ * @brief Take a consistent copy of one device entry
+ *
+ * @param page Page from atecc_status_map()
+ * @param index Device index
+ * @param entry Receives the entry
+ * @param device_count Receives the number of devices on the page (may be NULL)
+ * @return true if index named a published device, false otherwise
+ */
+bool atecc_status_read(const atecc_status_page_t *page, size_t index, atecc_status_dev_t *entry,
+                       size_t *device_count) {
+    unsigned int before;
+    unsigned int after;
+    uint32_t count;
+
+    do {
+        before = atomic_load_explicit(&page->seq, memory_order_acquire);
+        count = page->device_count;
+        if (index < count && index < ATECC_POOL_MAX) {
+            memcpy(entry, &page->devices[index], sizeof(*entry));
+        }
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&page->seq, memory_order_relaxed);
+    } while ((before & 1U) != 0U || before != after);
+
+    if (device_count) {
+        *device_count = count;
+    }
+    return index < count && index < ATECC_POOL_MAX;
+}
+
+/**
+ * @brief Take a consistent copy of every client usage entry
+ *
+ * @param page Page from atecc_status_map()
+ * @param entries Receives up to ATECC_STATUS_CLIENT_MAX entries
+ * @param client_count Receives the number of entries copied
+ * @return true on success, false on invalid arguments
+ */
+bool atecc_status_read_clients(const atecc_status_page_t *page, atecc_status_client_t *entries,
+                               size_t *client_count) {
+    if (!page || !entries || !client_count) {
+        errno = EINVAL;
+        return false;
+    }
+
+    unsigned int before;
+    unsigned int after;
+    uint32_t count;
+
+    do {
+        before = atomic_load_explicit(&page->seq, memory_order_acquire);
+        count = page->clients;
+        if (count > ATECC_STATUS_CLIENT_MAX) {
+            count = ATECC_STATUS_CLIENT_MAX;
+        }
+        memcpy(entries, page->client_usage, count * sizeof(entries[0]));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&page->seq, memory_order_relaxed);
+    } while ((before & 1U) != 0U || before != after);
+
+    *client_count = count;
+    return true;
+}
+
+/**
+ * @brief Take a consistent copy of the page-wide counters
+ *
+ * @param page Page from atecc_status_map()
+ * @param requests Receives the number of requests served
+ * @param clients Receives the number of connected clients
+ * @param selftest Receives the idle-time SelfTest counters
+ * @return true on success, false on invalid arguments
+ */
+bool atecc_status_read_totals(const atecc_status_page_t *page, uint64_t *requests, uint32_t *clients,
+                              atecc_status_selftest_t *selftest) {
+    if (!page || !requests || !clients || !selftest) {
+        errno = EINVAL;
+        return false;
+    }
+
+    unsigned int before;
+    unsigned int after;
+
+    do {
+        before = atomic_load_explicit(&page->seq, memory_order_acquire);
+        *requests = page->requests;
+        *clients = page->clients;
+        memcpy(selftest, &page->selftest, sizeof(*selftest));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&page->seq, memory_order_relaxed);
+    } while ((before & 1U) != 0U || before != after);
+
+    return true;
+}
+
+static const char *health_name(uint8_t health) {
+    switch (health) {
+    case ATECC_HEALTH_OK:       return "ok";
+    case ATECC_HEALTH_DEGRADED: return "degraded";
+    case ATECC_HEALTH_FAILED:   return "failed";
+    default:                    return "unknown";
+    }
+}
+
+/**
+ * @brief Comma-separated names of SelfTest bits, "-" for none
+ */
+static const char *selftest_names(uint8_t tests, char *out, size_t size) {
+    static const struct {
+        uint8_t test;
+        const char *name;
+    } names[] = {
+        { ATECC_SELFTEST_RNG, "RNG" }, { ATECC_SELFTEST_SHA, "SHA" }, { ATECC_SELFTEST_AES, "AES" },
+        { ATECC_SELFTEST_ECDH, "ECDH" }, { ATECC_SELFTEST_ECDSA, "ECDSA" }
+    };
+    size_t used = 0;
+    snprintf(out, size, "-");
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if ((tests & names[i].test) && used < size) {
+            used += (size_t)snprintf(&out[used], size - used, "%s%s", used ? "," : "", names[i].name);
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Print the daemon's status page, optionally timing page reads
+ *
+ * Usage: status [--shm NAME] [--bench]
+ *
+ * @return Process exit status
+ */
+int atecc_status_main(int argc, char **argv) {
+    const char *name = NULL;
+    bool bench = false;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            name = argv[++i];
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        } else {
+            fprintf(stderr, "usage: pi_atecc status [--shm NAME] [--bench]\n");
+            return 2;
+        }
+    }
+
+    const atecc_status_page_t *page = atecc_status_map(name);
+    if (!page) {
+        fprintf(stderr, "status: no status page published (is 'pi_atecc serve' running?)\n");
+        return 1;
+    }
+
+    atecc_status_dev_t entry;
+    size_t count = 0;
+    char serial_hex[2U * ATECC_SERIAL_NUMBER_SIZE + 1U];
+    char revision_hex[2U * sizeof(entry.revision) + 1U];
+    for (size_t i = 0; atecc_status_read(page, i, &entry, &count); i++) {
+        atecc_hex(entry.serial, sizeof(entry.serial), serial_hex, ATECC_HEX_UPPER);
+        atecc_hex(entry.revision, sizeof(entry.revision), revision_hex, ATECC_HEX_UPPER);
+        printf("🆔 %s:0x%02X  serial %s  rev %s  config %s  data %s\n", entry.bus, entry.address,
+               entry.identity_valid ? serial_hex : "?", entry.config_valid ? revision_hex : "?",
+               entry.config_valid ? (entry.config_locked ? "locked" : "unlocked") : "?",
+               entry.config_valid ? (entry.data_locked ? "locked" : "unlocked") : "?");
+        printf("   🩺 %s  %llu commands, %llu failed\n", health_name(entry.health),
+               (unsigned long long)entry.commands, (unsigned long long)entry.failures);
+        if (entry.selftest_us != 0) {
+            char passed[32];
+            char failed[32];
+            printf("   🧪 SelfTest %.0f s ago  passed %s  failed %s\n",
+                   (double)(atecc_now_us() - entry.selftest_us) / 1e6,
+                   selftest_names(entry.selftest_passed, passed, sizeof(passed)),
+                   selftest_names(entry.selftest_failed, failed, sizeof(failed)));
+        }
+    }
+    uint64_t requests = 0;
+    uint32_t clients = 0;
+    atecc_status_selftest_t selftest;
+    atecc_status_read_totals(page, &requests, &clients, &selftest);
+    printf("🛰️ %zu device(s), %llu request(s) served, %u client(s)\n", count, (unsigned long long)requests,
+           clients);
+    if (selftest.slices > 0) {
+        printf("   🧪 %llu SelfTest slice(s), %llu failed, %llu deferred, %llu forced; "
+               "%llu met a request, adding at most %.1f ms\n",
+               (unsigned long long)selftest.slices, (unsigned long long)selftest.failures,
+               (unsigned long long)selftest.deferred, (unsigned long long)selftest.forced,
+               (unsigned long long)selftest.delayed, (double)selftest.delay_max_us / 1000.0);
+    }
+
+    static atecc_status_client_t usage[ATECC_STATUS_CLIENT_MAX];
+    size_t usage_count = 0;
+    atecc_status_read_clients(page, usage, &usage_count);
+    for (size_t i = 0; i < usage_count; i++) {
+        printf("   👤 pid %d  %llu request(s)  %.3f s device time  %.3f s tokens  %llu throttled%s\n",
+               (int)usage[i].pid, (unsigned long long)usage[i].requests, (double)usage[i].device_us / 1e6,
+               (double)usage[i].tokens_us / 1e6, (unsigned long long)usage[i].throttled,
+               usage[i].queued ? "  (queued)" : "");
+    }
+
+    if (bench) {
+        uint64_t start = atecc_now_us();
+        uint64_t sum = 0;
+        for (size_t i = 0; i < STATUS_BENCH_READS; i++) {
+            atecc_status_read(page, 0, &entry, NULL);
+            sum += entry.commands;
+        }
+        double elapsed_ns = (double)(atecc_now_us() - start) * 1000.0;
+        printf("📊 %.1f ns per consistent entry read (%u reads, checksum %llu)\n",
+               elapsed_ns / STATUS_BENCH_READS, STATUS_BENCH_READS, (unsigned long long)sum);
+    }
+
+    munmap((void *)page, sizeof(*page));
+    return 0;
+}
@@ -0,0 +1,817 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include "pi_atecc.h"
+
+enum {
+    STREAM_PAGE_SIZE      = 4096U,
+    STREAM_DEFAULT_DEPTH  = 8U,
+    STREAM_WRITE_FLAG     = 0x10000U,   // user_data bit marking write completions
+    HASH_DEFAULT_CHUNK    = 262144U,    // Host hashing keeps up with any disk
+    RANDOM_DEFAULT_CHUNK  = 4096U,      // 128 Random commands per chunk
+    RANDOM_BLOCK_SIZE     = 32U,
+    DIGEST_SIZE           = 32U,
+    SIGNATURE_SIZE        = 64U
+};
+
+/**
+ * @brief io_uring instance with its mapped rings, set up with raw system calls
+ */
+struct atecc_uring {
+    int fd;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned int *sq_tail;
+    unsigned int *sq_array;
+    unsigned int sq_mask;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned int pending;       // Queued SQEs not yet submitted
+    bool fixed;                 // Buffers registered, so READ_FIXED/WRITE_FIXED apply
+    unsigned int reads;         // Reads in flight
+    unsigned int writes;        // Writes in flight
+};
+
+static void uring_close(struct atecc_uring *ring) {
+    if (!ring) {
+        return;
+    }
+    if (ring->sqes && ring->sqes != MAP_FAILED) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring && ring->sq_ring != MAP_FAILED) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    free(ring);
+}
+
+/**
+ * @brief Create a ring and register the stream's buffers with it
+ *
+ * Registration pins the buffers once instead of on every transfer. If it
+ * is refused (RLIMIT_MEMLOCK), the ring still works with plain READ/WRITE.
+ *
+ * @return The ring, or NULL with errno set if io_uring is unavailable
+ */
+static struct atecc_uring *uring_open(unsigned int entries, uint8_t *memory, size_t chunk, size_t depth) {
+    struct atecc_uring *ring = calloc(1, sizeof(*ring));
+    if (!ring) {
+        return NULL;
+    }
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        free(ring);
+        return NULL;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->sq_ring_size = (ring->cq_ring_size > ring->sq_ring_size) ? ring->cq_ring_size : ring->sq_ring_size;
+    }
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                         IORING_OFF_SQ_RING);
+    ring->cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP) ? ring->sq_ring
+                    : mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                           IORING_OFF_CQ_RING);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                      IORING_OFF_SQES);
+    if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        int saved = errno;
+        uring_close(ring);
+        errno = saved;
+        return NULL;
+    }
+
+    uint8_t *sq = ring->sq_ring;
+    uint8_t *cq = ring->cq_ring;
+    ring->sq_tail = (unsigned int *)(sq + params.sq_off.tail);
+    ring->sq_mask = *(unsigned int *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned int *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned int *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned int *)(cq + params.cq_off.tail);
+    ring->cq_mask = *(unsigned int *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    struct iovec iov[ATECC_STREAM_DEPTH_MAX];
+    for (size_t i = 0; i < depth; i++) {
+        iov[i].iov_base = &memory[i * chunk];
+        iov[i].iov_len = chunk;
+    }
+    ring->fixed = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, iov, (unsigned int)depth) == 0;
+    return ring;
+}
+
+/**
+ * @brief Queue one read or write; it goes to the kernel with the next uring_enter()
+ */
+static void uring_queue(struct atecc_uring *ring, bool write, int fd, uint8_t *addr, size_t length,
+                        uint64_t offset, size_t buf_index) {
+    unsigned int tail = *ring->sq_tail;
+    unsigned int index = tail & ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    if (ring->fixed) {
+        sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->buf_index = (uint16_t)buf_index;
+    } else {
+        sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)addr;
+    sqe->len = (uint32_t)length;
+    sqe->off = offset;
+    sqe->user_data = buf_index | (write ? STREAM_WRITE_FLAG : 0U);
+    ring->sq_array[index] = index;
+    atomic_store_explicit((_Atomic unsigned int *)ring->sq_tail, tail + 1U, memory_order_release);
+    ring->pending++;
+    if (write) {
+        ring->writes++;
+    } else {
+        ring->reads++;
+    }
+}
+
+/**
+ * @brief Submit queued requests and optionally wait for one completion
+ */
+static bool uring_enter(struct atecc_uring *ring, bool wait) {
+    while (ring->pending > 0 || wait) {
+        int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, ring->pending, wait ? 1U : 0U,
+                                     wait ? IORING_ENTER_GETEVENTS : 0U, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        ring->pending -= (unsigned int)submitted;
+        wait = false;
+    }
+    return true;
+}
+
+/**
+ * @brief Whether a descriptor takes explicit offsets, so several transfers can be in flight
+ */
+static bool fd_seekable(int fd, uint64_t *offset) {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (fcntl(fd, F_GETFL) & O_APPEND)) {
+        return false;
+    }
+    off_t position = lseek(fd, 0, SEEK_CUR);
+    if (position < 0) {
+        return false;
+    }
+    *offset = (uint64_t)position;
+    return true;
+}
+
+static uint8_t *stream_data(const atecc_stream_t *stream, size_t index) {
+    return &stream->memory[index * stream->chunk];
+}
+
+static void stream_fail(atecc_stream_t *stream, int error) {
+    if (stream->error == 0) {
+        stream->error = error ? error : EIO;
+    }
+}
+
+static void stream_submit_read(atecc_stream_t *stream, size_t index) {
+    atecc_stream_buf_t *buf = &stream->bufs[index];
+    buf->state = ATECC_STREAM_READING;
+    uint64_t offset = stream->in_seekable ? buf->offset + buf->length : (uint64_t)-1;
+    uring_queue(stream->uring, false, stream->in_fd, stream_data(stream, index) + buf->length,
+                stream->chunk - buf->length, offset, index);
+}
+
+static void stream_submit_write(atecc_stream_t *stream, size_t index) {
+    atecc_stream_buf_t *buf = &stream->bufs[index];
+    buf->state = ATECC_STREAM_WRITING;
+    uint64_t offset = stream->out_seekable ? buf->offset + buf->done : (uint64_t)-1;
+    uring_queue(stream->uring, true, stream->out_fd, stream_data(stream, index) + buf->done,
+                buf->length - buf->done, offset, index);
+}
+
+/**
+ * @brief Start every read and write the ring order allows, and submit them
+ *
+ * Reads fill free buffers ahead of the caller; queued buffers are written
+ * in order. Descriptors without offsets (pipes, terminals) keep one
+ * transfer in flight per direction so data stays in order.
+ */
+static bool stream_pump(atecc_stream_t *stream) {
+    struct atecc_uring *ring = stream->uring;
+    while (stream->in_fd >= 0 && !stream->in_eof && stream->error == 0 &&
+           stream->bufs[stream->next_read].state == ATECC_STREAM_FREE && (stream->in_seekable || ring->reads == 0)) {
+        atecc_stream_buf_t *buf = &stream->bufs[stream->next_read];
+        buf->length = 0;
+        buf->done = 0;
+        buf->offset = stream->in_offset;
+        stream->in_offset += stream->chunk;
+        stream_submit_read(stream, stream->next_read);
+        stream->next_read = (stream->next_read + 1U) % stream->depth;
+    }
+    while (stream->bufs[stream->next_write].state == ATECC_STREAM_QUEUED &&
+           (stream->out_seekable || ring->writes == 0)) {
+        atecc_stream_buf_t *buf = &stream->bufs[stream->next_write];
+        if (buf->length == 0 || stream->error != 0) {
+            buf->state = ATECC_STREAM_FREE;
+        } else {
+            buf->offset = stream->out_offset;
+            stream->out_offset += buf->length;
+            stream_submit_write(stream, stream->next_write);
+        }
+        stream->next_write = (stream->next_write + 1U) % stream->depth;
+    }
+    if (!uring_enter(ring, false)) {
+        stream_fail(stream, errno);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Account for one completed transfer, resubmitting the rest of a short one
+ */
+static void stream_complete(atecc_stream_t *stream, uint64_t user_data, int32_t result) {
+    size_t index = (size_t)(user_data & (STREAM_WRITE_FLAG - 1U));
+    atecc_stream_buf_t *buf = &stream->bufs[index];
+    if (user_data & STREAM_WRITE_FLAG) {
+        stream->uring->writes--;
+        if (result < 0) {
+            stream_fail(stream, -result);
+            buf->state = ATECC_STREAM_FREE;
+            return;
+        }
+        buf->done += (size_t)result;
+        stream->bytes_out += (uint64_t)result;
+        if (result > 0 && buf->done < buf->length) {
+            stream_submit_write(stream, index);
+        } else {
+            if (result == 0 && buf->done < buf->length) {
+                stream_fail(stream, EIO);
+            }
+            buf->state = ATECC_STREAM_FREE;
+        }
+        return;
+    }
+
+    stream->uring->reads--;
+    if (result < 0) {
+        stream_fail(stream, -result);
+        stream->in_eof = true;
+        buf->state = ATECC_STREAM_READY;
+        return;
+    }
+    buf->length += (size_t)result;
+    stream->bytes_in += (uint64_t)result;
+    if (result == 0) {
+        stream->in_eof = true;
+    }
+    // Chunks are handed out full, except the last, so block-sized callers never see a split block
+    if (result > 0 && buf->length < stream->chunk) {
+        stream_submit_read(stream, index);
+    } else {
+        buf->state = ATECC_STREAM_READY;
+    }
+}
+
+/**
+ * @brief Block until at least one transfer completes, then reap every completion
+ */
+static bool stream_wait(atecc_stream_t *stream) {
+    struct atecc_uring *ring = stream->uring;
+    uint64_t start = atecc_now_us();
+    bool ok = uring_enter(ring, true);
+    stream->wait_us += atecc_now_us() - start;
+    if (!ok) {
+        stream_fail(stream, errno);
+        return false;
+    }
+
+    unsigned int head = *ring->cq_head;
+    unsigned int tail = atomic_load_explicit((_Atomic unsigned int *)ring->cq_tail, memory_order_acquire);
+    while (head != tail) {
+        const struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+        stream_complete(stream, cqe->user_data, cqe->res);
+        head++;
+    }
+    atomic_store_explicit((_Atomic unsigned int *)ring->cq_head, head, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Whether any buffer still has a transfer in flight or waiting to start
+ */
+static bool stream_busy(const atecc_stream_t *stream) {
+    for (size_t i = 0; i < stream->depth; i++) {
+        atecc_stream_state_t state = stream->bufs[i].state;
+        if (state == ATECC_STREAM_READING || state == ATECC_STREAM_QUEUED || state == ATECC_STREAM_WRITING) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Set up a stream over an input and/or an output descriptor
+ *
+ * The descriptors stay owned by the caller. ATECC_NO_URING=1 in the
+ * environment forces the read()/write() fallback, for comparisons.
+ *
+ * @param stream Stream to initialize
+ * @param in_fd Descriptor to read, -1 for none
+ * @param out_fd Descriptor to write, -1 for none
+ * @param chunk Bytes per buffer, rounded up to a whole page
+ * @param depth Buffers in the ring (2 to ATECC_STREAM_DEPTH_MAX, 0 for the default)
+ * @param use_uring Whether to try io_uring first
+ * @return true on success, false otherwise
+ */
+bool atecc_stream_open(atecc_stream_t *stream, int in_fd, int out_fd, size_t chunk, size_t depth, bool use_uring) {
+    if (!stream || chunk == 0 || depth > ATECC_STREAM_DEPTH_MAX || (in_fd < 0 && out_fd < 0)) {
+        errno = EINVAL;
+        return false;
+    }
+    memset(stream, 0, sizeof(*stream));
+    stream->in_fd = in_fd;
+    stream->out_fd = out_fd;
+    stream->chunk = (chunk + STREAM_PAGE_SIZE - 1U) / STREAM_PAGE_SIZE * STREAM_PAGE_SIZE;
+    stream->depth = (depth == 0) ? STREAM_DEFAULT_DEPTH : (depth < 2U ? 2U : depth);
+    stream->in_seekable = fd_seekable(in_fd, &stream->in_offset);
+    stream->out_seekable = fd_seekable(out_fd, &stream->out_offset);
+
+    stream->memory = mmap(NULL, stream->depth * stream->chunk, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1, 0);
+    if (stream->memory == MAP_FAILED) {
+        stream->memory = NULL;
+        return false;
+    }
+
+    const char *no_uring = getenv("ATECC_NO_URING");
+    if (use_uring && !(no_uring && no_uring[0] == '1')) {
+        stream->uring = uring_open(2U * (unsigned int)stream->depth, stream->memory, stream->chunk, stream->depth);
+    }
+    return true;
+}
+
+/**
+ * @brief Name of the I/O path a stream ended up on
+ */
+const char *atecc_stream_backend(const atecc_stream_t *stream) {
+    if (!stream || !stream->uring) {
+        return "read/write";
+    }
+    return stream->uring->fixed ? "io_uring, fixed buffers" : "io_uring";
+}
+
+/**
+ * @brief Take the next input chunk, in order
+ *
+ * Every chunk is full except the last. The chunk belongs to the caller
+ * until it is passed to atecc_stream_write() or atecc_stream_release().
+ *
+ * @param stream Stream opened with an input
+ * @param length Receives the chunk length
+ * @return The chunk, or NULL at end of input or on error (see stream->error)
+ */
+uint8_t *atecc_stream_read(atecc_stream_t *stream, size_t *length) {
+    if (!stream || !length || stream->in_fd < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    size_t index = stream->next_take;
+    atecc_stream_buf_t *buf = &stream->bufs[index];
+
+    if (stream->uring) {
+        while (stream->error == 0) {
+            if (!stream_pump(stream)) {
+                return NULL;
+            }
+            if (buf->state == ATECC_STREAM_READY || (buf->state == ATECC_STREAM_FREE && stream->in_eof)) {
+                break;
+            }
+            stream_wait(stream);
+        }
+        if (buf->state != ATECC_STREAM_READY || buf->length == 0 || stream->error != 0) {
+            if (buf->state == ATECC_STREAM_READY) {
+                buf->state = ATECC_STREAM_FREE;
+            }
+            return NULL;
+        }
+    } else {
+        uint64_t start = atecc_now_us();
+        buf->length = 0;
+        while (!stream->in_eof && buf->length < stream->chunk) {
+            ssize_t received = read(stream->in_fd, stream_data(stream, index) + buf->length,
+                                    stream->chunk - buf->length);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received < 0) {
+                stream_fail(stream, errno);
+            }
+            if (received <= 0) {
+                stream->in_eof = true;
+            } else {
+                buf->length += (size_t)received;
+                stream->bytes_in += (uint64_t)received;
+            }
+        }
+        stream->wait_us += atecc_now_us() - start;
+        if (buf->length == 0 || stream->error != 0) {
+            return NULL;
+        }
+    }
+
+    buf->state = ATECC_STREAM_HELD;
+    stream->next_take = (index + 1U) % stream->depth;
+    *length = buf->length;
+    return stream_data(stream, index);
+}
+
+/**
+ * @brief Take an empty chunk to fill, for output-only streams
+ *
+ * @return A buffer of stream->chunk bytes, or NULL on error
+ */
+uint8_t *atecc_stream_buffer(atecc_stream_t *stream) {
+    if (!stream || stream->in_fd >= 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    size_t index = stream->next_take;
+    atecc_stream_buf_t *buf = &stream->bufs[index];
+    while (stream->uring && stream->error == 0 && buf->state != ATECC_STREAM_FREE) {
+        if (!stream_pump(stream)) {
+            return NULL;
+        }
+        if (buf->state != ATECC_STREAM_FREE) {
+            stream_wait(stream);
+        }
+    }
+    if (stream->error != 0) {
+        return NULL;
+    }
+    buf->state = ATECC_STREAM_HELD;
+    buf->length = 0;
+    buf->done = 0;
+    stream->next_take = (index + 1U) % stream->depth;
+    return stream_data(stream, index);
+}
+
+/**
+ * @brief Hand a chunk back to be written, behind every chunk handed back before it
+ *
+ * With io_uring the write completes in the background.
+ *
+ * @param stream Stream opened with an output
+ * @param buf Chunk from atecc_stream_read() or atecc_stream_buffer()
+ * @param length Bytes to write from the start of the chunk
+ * @return false if the stream has failed
+ */
+bool atecc_stream_write(atecc_stream_t *stream, uint8_t *buf, size_t length) {
+    if (!stream || !buf || buf < stream->memory || length > stream->chunk) {
+        errno = EINVAL;
+        return false;
+    }
+    size_t index = (size_t)(buf - stream->memory) / stream->chunk;
+    atecc_stream_buf_t *entry = &stream->bufs[index];
+    if (index >= stream->depth || entry->state != ATECC_STREAM_HELD) {
+        errno = EINVAL;
+        return false;
+    }
+    entry->length = (stream->out_fd >= 0) ? length : 0U;
+    entry->done = 0;
+    entry->state = ATECC_STREAM_QUEUED;
+
+    if (stream->uring) {
+        return stream_pump(stream) && stream->error == 0;
+    }
+
+    uint64_t start = atecc_now_us();
+    while (stream->error == 0 && entry->done < entry->length) {
+        ssize_t written = write(stream->out_fd, buf + entry->done, entry->length - entry->done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            stream_fail(stream, errno);
+        } else {
+            entry->done += (size_t)written;
+            stream->bytes_out += (uint64_t)written;
+        }
+    }
+    stream->wait_us += atecc_now_us() - start;
+    stream->next_write = (index + 1U) % stream->depth;
+    entry->state = ATECC_STREAM_FREE;
+    return stream->error == 0;
+}
+
+/**
+ * @brief Hand a chunk back without writing it
+ */
+bool atecc_stream_release(atecc_stream_t *stream, uint8_t *buf) {
+    return atecc_stream_write(stream, buf, 0);
+}
+
+/**
+ * @brief Finish outstanding writes and free the stream
+ *
+ * @return false if any transfer failed (errno holds the first error)
+ */
+bool atecc_stream_close(atecc_stream_t *stream) {
+    if (!stream) {
+        errno = EINVAL;
+        return false;
+    }
+    if (stream->uring) {
+        while (stream_pump(stream) && stream_busy(stream) && stream_wait(stream)) {
+        }
+        uring_close(stream->uring);
+        stream->uring = NULL;
+    }
+    if (stream->memory) {
+        munmap(stream->memory, stream->depth * stream->chunk);
+        stream->memory = NULL;
+    }
+    if (stream->error != 0) {
+        errno = stream->error;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Close a stream and print its throughput and the time spent blocked on I/O
+ *
+ * @return Result of atecc_stream_close()
+ */
+static bool stream_finish(const char *label, atecc_stream_t *stream, uint64_t bytes, uint64_t start_us) {
+    const char *backend = atecc_stream_backend(stream);
+    bool ok = atecc_stream_close(stream);
+    double elapsed_s = (double)(atecc_now_us() - start_us) / 1e6;
+    fprintf(stderr, "📊 %s: %llu bytes in %.3f s, %.2f MB/s via %s, %.1f ms waiting on I/O\n", label,
+            (unsigned long long)bytes, elapsed_s, elapsed_s > 0.0 ? (double)bytes / elapsed_s / 1e6 : 0.0,
+            backend, (double)stream->wait_us / 1000.0);
+    return ok;
+}
+
+/**
+ * @brief Hash a file on the host through the stream pipeline, optionally signing the digest on the device
+ *
+ * Usage: sha256-file [FILE|-] [--sign SLOT] [--chunk KiB] [--depth N] [--no-uring] [device]
+ *
+ * Hashing runs on the host; the device's SHA engine takes 64 bytes per
+ * command and loses its state when the watchdog puts it to sleep, so it
+ * only signs the result.
+ *
+ * @return Process exit status
+ */
+int atecc_sha256_file_main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *spec = NULL;
+    int sign_slot = -1;
+    size_t chunk = HASH_DEFAULT_CHUNK;
+    size_t depth = 0;
+    bool use_uring = true;
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--sign") == 0 && has_value) {
+            sign_slot = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--chunk") == 0 && has_value) {
+            chunk = strtoul(argv[++i], NULL, 10) * 1024U;
+        } else if (strcmp(argv[i], "--depth") == 0 && has_value) {
+            depth = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--no-uring") == 0) {
+            use_uring = false;
+        } else if (!path && (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)) {
+            path = argv[i];
+        } else if (!spec && argv[i][0] != '-') {
+            spec = argv[i];
+        } else {
+            fprintf(stderr, "usage: pi_atecc sha256-file [FILE|-] [--sign SLOT] [--chunk KiB] [--depth N] "
+                            "[--no-uring] [device]\n");
+            return 2;
+        }
+    }
+
+    int fd = (!path || strcmp(path, "-") == 0) ? STDIN_FILENO : open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("sha256-file: open failed");
+        return 1;
+    }
+    atecc_stream_t stream;
+    if (!atecc_stream_open(&stream, fd, -1, chunk, depth, use_uring)) {
+        perror("sha256-file");
+        if (fd != STDIN_FILENO) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    sha256_ctx_t ctx;
+    sha256_init(&ctx);
+    uint64_t start = atecc_now_us();
+    uint64_t total = 0;
+    size_t length = 0;
+    uint8_t *data;
+    while ((data = atecc_stream_read(&stream, &length)) != NULL) {
+        sha256_update(&ctx, data, length);
+        total += length;
+        atecc_stream_release(&stream, data);
+    }
+    uint8_t digest[DIGEST_SIZE];
+    sha256_final(&ctx, digest);
+    bool ok = stream_finish("sha256-file", &stream, total, start);
+    if (!ok) {
+        perror("sha256-file: read failed");
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+
+    char digest_hex[2U * DIGEST_SIZE + 1U];
+    atecc_hex(digest, DIGEST_SIZE, digest_hex, ATECC_HEX_LOWER);
+    if (ok) {
+        printf("🔒 SHA-256: %s  %s\n", digest_hex, path ? path : "-");
+    }
+
+    if (ok && sign_slot >= 0) {
+        atecc_pool_t *pool = calloc(1, sizeof(*pool));
+        const char *specs[1] = { spec };
+        uint8_t signature[SIGNATURE_SIZE];
+        ok = pool && atecc_pool_open(pool, specs, spec ? 1U : 0U) &&
+             atecc_sign_digest(pool->members[0], (uint8_t)sign_slot, digest, signature);
+        if (ok) {
+            char signature_hex[2U * SIGNATURE_SIZE + 1U];
+            atecc_hex(signature, SIGNATURE_SIZE, signature_hex, ATECC_HEX_LOWER);
+            printf("✍️ Signature (slot %d): %s\n", sign_slot, signature_hex);
+        } else {
+            fprintf(stderr, "❌ sha256-file: signing failed\n");
+        }
+        if (pool) {
+            atecc_pool_close(pool);
+        }
+        free(pool);
+    }
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Contiguous share of a chunk filled by one device
+ */
+typedef struct {
+    atecc_dev_t *dev;
+    uint8_t *out;
+    size_t length;
+    bool ok;
+} random_share_t;
+
+static void *random_worker(void *arg) {
+    random_share_t *share = arg;
+    share->ok = true;
+    for (size_t done = 0; share->ok && done < share->length; done += RANDOM_BLOCK_SIZE) {
+        uint8_t block[RANDOM_BLOCK_SIZE];
+        share->ok = atecc_random(share->dev, block);
+        size_t take = (share->length - done < RANDOM_BLOCK_SIZE) ? share->length - done : RANDOM_BLOCK_SIZE;
+        memcpy(&share->out[done], block, take);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Fill a buffer with device Random output, every pool member taking an equal share
+ */
+static bool fill_random(atecc_pool_t *pool, uint8_t *out, size_t length) {
+    random_share_t shares[ATECC_POOL_MAX];
+    pthread_t threads[ATECC_POOL_MAX];
+    bool started[ATECC_POOL_MAX] = {false};
+    size_t blocks = (length + RANDOM_BLOCK_SIZE - 1U) / RANDOM_BLOCK_SIZE;
+    size_t per_device = (blocks + pool->count - 1U) / pool->count * RANDOM_BLOCK_SIZE;
+
+    for (size_t i = 0; i < pool->count; i++) {
+        size_t offset = (i * per_device < length) ? i * per_device : length;
+        size_t share = (length - offset < per_device) ? length - offset : per_device;
+        shares[i] = (random_share_t){ .dev = pool->members[i], .out = &out[offset], .length = share, .ok = true };
+        if (share > 0 && pool->count > 1U) {
+            started[i] = pthread_create(&threads[i], NULL, random_worker, &shares[i]) == 0;
+        }
+        if (share > 0 && !started[i]) {
+            random_worker(&shares[i]);
+        }
+    }
+    bool ok = true;
+    for (size_t i = 0; i < pool->count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        ok = ok && shares[i].ok;
+    }
+    return ok;
+}
+
+/**
+ * @brief Dump device entropy to a file or stdout, writing behind the devices
+ *
+ * Usage: random-dump <bytes> [--out FILE] [--chunk KiB] [--depth N] [--no-uring] [device...]
+ *
+ * @return Process exit status
+ */
+int atecc_random_dump_main(int argc, char **argv) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: pi_atecc random-dump <bytes> [--out FILE] [--chunk KiB] [--depth N] [--no-uring] "
+                        "[device...]\n");
+        return 2;
+    }
+    uint64_t total = strtoull(argv[0], NULL, 10);
+    const char *path = NULL;
+    size_t chunk = RANDOM_DEFAULT_CHUNK;
+    size_t depth = 0;
+    bool use_uring = true;
+    const char *specs[ATECC_POOL_MAX];
+    size_t spec_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--out") == 0 && has_value) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "--chunk") == 0 && has_value) {
+            chunk = strtoul(argv[++i], NULL, 10) * 1024U;
+        } else if (strcmp(argv[i], "--depth") == 0 && has_value) {
+            depth = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--no-uring") == 0) {
+            use_uring = false;
+        } else if (argv[i][0] != '-' && spec_count < ATECC_POOL_MAX) {
+            specs[spec_count++] = argv[i];
+        }
+    }
+
+    int fd = path ? open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600) : STDOUT_FILENO;
+    if (fd < 0) {
+        perror("random-dump: open failed");
+        return 1;
+    }
+    atecc_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool || !atecc_pool_open(pool, specs, spec_count)) {
+        fprintf(stderr, "random-dump: no devices available\n");
+        free(pool);
+        if (fd != STDOUT_FILENO) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    atecc_stream_t stream;
+    bool ok = atecc_stream_open(&stream, -1, fd, chunk, depth, use_uring);
+    if (ok) {
+        uint64_t start = atecc_now_us();
+        uint64_t done = 0;
+        while (ok && done < total) {
+            uint8_t *buf = atecc_stream_buffer(&stream);
+            size_t length = (total - done < stream.chunk) ? (size_t)(total - done) : stream.chunk;
+            ok = buf && fill_random(pool, buf, length) && atecc_stream_write(&stream, buf, length);
+            done += length;
+        }
+        ok = stream_finish("random-dump", &stream, done, start) && ok;
+    }
+    if (!ok) {
+        perror("random-dump: failed");
+    }
+
+    atecc_pool_close(pool);
+    free(pool);
+    if (fd != STDOUT_FILENO) {
+        close(fd);
+    }
+    return ok ? 0 : 1;
+}
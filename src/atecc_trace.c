@@ -0,0 +1,696 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include "pi_atecc.h"
+
+enum {
+    TRACE_WORD_COMMAND  = 0x03U,    // Word address of a command packet
+    TRACE_WAKE_TOKEN    = 0x00U,
+    TRACE_MUX_FIRST     = 0x70U,    // TCA9548A address range; writes there are channel selects
+    TRACE_MUX_LAST      = 0x77U,
+    TRACE_BUS_MAX       = 16U,
+    TRACE_DEVICE_MAX    = 64U,
+    TRACE_NAME_MAX      = 48U,
+    TRACE_LINE_MAX      = 2U * ATECC_TRACE_MAX_BYTES + 256U,
+    TRACE_CLASS_MAX     = 512U,     // Distinct (opcode, mode) pairs reported
+    TRACE_DEFAULT_TOP   = 10U,
+    TRACE_OPCODE_WAKE   = 0x00U     // Pseudo-opcode of a wake sequence
+};
+
+/**
+ * @brief Command names and rough typical execution times at the default clock
+ *
+ * The typical times only stand in for commands the trace has no polled
+ * reads for: a NACKed read shows the device still busy, so polled commands
+ * get their execution time from the trace itself. --exec NAME=MS replaces
+ * an entry.
+ */
+static struct {
+    uint8_t opcode;
+    const char *name;
+    uint32_t typical_us;
+} trace_opcodes[] = {
+    { TRACE_OPCODE_WAKE, "Wake",        ATECC_WAKE_DELAY_US },
+    { 0x08, "MAC",          5000U },
+    { 0x12, "Write",        7000U },
+    { 0x15, "GenDig",       5000U },
+    { 0x16, "Nonce",        100U },
+    { 0x17, "Lock",         8000U },
+    { 0x1B, "Random",       1000U },
+    { 0x1C, "DeriveKey",    2000U },
+    { 0x20, "UpdateExtra",  8000U },
+    { 0x24, "Counter",      5000U },
+    { 0x28, "CheckMac",     5000U },
+    { 0x30, "Info",         100U },
+    { 0x40, "GenKey",       60000U },
+    { 0x41, "Sign",         40000U },
+    { 0x43, "ECDH",         38000U },
+    { 0x45, "Verify",       40000U },
+    { 0x46, "PrivWrite",    40000U },
+    { 0x47, "SHA",          100U },
+    { 0x51, "AES",          1000U },
+    { 0x56, "KDF",          5000U },
+    { 0x77, "SelfTest",     150000U },
+    { 0x02, "Read",         100U }
+};
+
+/**
+ * @brief One recorded transfer or sleep
+ */
+typedef struct {
+    uint64_t start_us;
+    uint64_t end_us;
+    char kind;              // W/R completed, w/r failed, S sleep
+    uint16_t device;        // Index into trace_t.devices
+    uint16_t length;        // Bytes recorded
+    size_t data;            // Offset of the bytes in trace_t.bytes
+    size_t line;            // Source line, keeps sorting stable
+} trace_event_t;
+
+typedef struct {
+    char name[32];          // I2C device file
+    uint64_t busy_us;       // Union of transfer intervals
+} trace_bus_t;
+
+typedef struct {
+    char name[TRACE_NAME_MAX];  // Device as written in the trace
+    uint16_t bus;
+    bool mux;               // A TCA9548A, not an ATECC
+    int open;               // Request in progress, -1 if none
+    uint64_t first_us;      // First and last event, for the active span
+    uint64_t last_us;
+    uint64_t between_us;    // Sleeps outside any request
+} trace_device_t;
+
+/**
+ * @brief One command (or wake sequence) from its write to its response
+ */
+typedef struct {
+    uint16_t device;
+    uint8_t opcode;
+    uint8_t mode;           // Param1
+    uint64_t start_us;      // Start of the command write
+    uint64_t written_us;    // End of the command write
+    uint64_t read_us;       // Start of the response read
+    uint64_t end_us;        // End of the response read
+    uint64_t sleep_us;      // Fixed sleeps while waiting
+    uint64_t exec_us;       // Estimated execution time
+    unsigned int polls;     // NACKed reads while waiting
+    bool complete;
+} trace_request_t;
+
+/**
+ * @brief Aggregate of one (opcode, mode) class
+ */
+typedef struct {
+    uint8_t opcode;
+    uint8_t mode;
+    size_t count;
+    size_t polled;          // Requests with NACKed reads
+    uint64_t polled_wait_us;    // Write end to response read over polled requests
+    uint64_t wall_us;
+    uint64_t bus_us;
+    uint64_t exec_us;
+    uint64_t sleep_slack_us;
+    uint64_t other_us;
+} trace_class_t;
+
+/**
+ * @brief One line of the ranked wall time summary
+ */
+typedef struct {
+    const char *label;
+    uint64_t us;
+} trace_share_t;
+
+typedef struct {
+    trace_event_t *events;
+    size_t event_count;
+    size_t event_capacity;
+    uint8_t *bytes;
+    size_t byte_count;
+    size_t byte_capacity;
+    trace_bus_t buses[TRACE_BUS_MAX];
+    size_t bus_count;
+    trace_device_t devices[TRACE_DEVICE_MAX];
+    size_t device_count;
+    trace_request_t *requests;
+    size_t request_count;
+    size_t request_capacity;
+} trace_t;
+
+static bool grow(void **array, size_t *capacity, size_t needed, size_t element) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    size_t next = *capacity ? *capacity * 2U : 1024U;
+    while (next < needed) {
+        next *= 2U;
+    }
+    void *larger = realloc(*array, next * element);
+    if (!larger) {
+        return false;
+    }
+    *array = larger;
+    *capacity = next;
+    return true;
+}
+
+static const char *opcode_name(uint8_t opcode) {
+    for (size_t i = 0; i < sizeof(trace_opcodes) / sizeof(trace_opcodes[0]); i++) {
+        if (trace_opcodes[i].opcode == opcode) {
+            return trace_opcodes[i].name;
+        }
+    }
+    return "?";
+}
+
+static uint32_t opcode_typical_us(uint8_t opcode) {
+    for (size_t i = 0; i < sizeof(trace_opcodes) / sizeof(trace_opcodes[0]); i++) {
+        if (trace_opcodes[i].opcode == opcode) {
+            return trace_opcodes[i].typical_us;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Find or add a device by bus and name
+ *
+ * @return Device index, -1 when a table is full
+ */
+static int trace_device(trace_t *trace, const char *bus, const char *name) {
+    size_t b = 0;
+    while (b < trace->bus_count && strcmp(trace->buses[b].name, bus) != 0) {
+        b++;
+    }
+    if (b == trace->bus_count) {
+        if (b == TRACE_BUS_MAX) {
+            return -1;
+        }
+        snprintf(trace->buses[b].name, sizeof(trace->buses[b].name), "%s", bus);
+        trace->bus_count++;
+    }
+
+    for (size_t d = 0; d < trace->device_count; d++) {
+        if (trace->devices[d].bus == b && strcmp(trace->devices[d].name, name) == 0) {
+            return (int)d;
+        }
+    }
+    if (trace->device_count == TRACE_DEVICE_MAX) {
+        return -1;
+    }
+    trace_device_t *device = &trace->devices[trace->device_count];
+    memset(device, 0, sizeof(*device));
+    snprintf(device->name, sizeof(device->name), "%s", name);
+    device->bus = (uint16_t)b;
+    device->open = -1;
+    // A bare address in the mux range is a mux control port; devices behind one carry a MUX.CH: prefix
+    unsigned long address = strtoul(name, NULL, 16);
+    device->mux = (strchr(name, ':') == NULL && address >= TRACE_MUX_FIRST && address <= TRACE_MUX_LAST);
+    return (int)trace->device_count++;
+}
+
+/**
+ * @brief Parse a trace written under $ATECC_TRACE
+ */
+static bool trace_load(trace_t *trace, FILE *in) {
+    char line[TRACE_LINE_MAX];
+    size_t line_number = 0;
+    while (fgets(line, sizeof(line), in)) {
+        line_number++;
+        unsigned long long start_us;
+        unsigned long long end_us;
+        char kind;
+        char bus[32];
+        char name[TRACE_NAME_MAX];
+        int consumed = 0;
+        if (sscanf(line, "%llu %llu %c %31s %47s %n", &start_us, &end_us, &kind, bus, name, &consumed) != 5 ||
+            strchr("WRwrS", kind) == NULL) {
+            fprintf(stderr, "trace: line %zu: not a trace record\n", line_number);
+            return false;
+        }
+
+        const char *hex = &line[consumed];
+        size_t hex_length = strcspn(hex, " \r\n");
+        int device = trace_device(trace, bus, name);
+        if (device < 0 || hex_length % 2U != 0U ||
+            !grow((void **)&trace->events, &trace->event_capacity, trace->event_count + 1U, sizeof(trace_event_t)) ||
+            !grow((void **)&trace->bytes, &trace->byte_capacity, trace->byte_count + hex_length / 2U + 1U, 1U)) {
+            fprintf(stderr, "trace: line %zu: cannot record event\n", line_number);
+            return false;
+        }
+        if (!atecc_hex_decode(hex, hex_length / 2U, &trace->bytes[trace->byte_count])) {
+            fprintf(stderr, "trace: line %zu: bad hex payload\n", line_number);
+            return false;
+        }
+
+        trace->events[trace->event_count++] = (trace_event_t){
+            .start_us = start_us,
+            .end_us = end_us,
+            .kind = kind,
+            .device = (uint16_t)device,
+            .length = (uint16_t)(hex_length / 2U),
+            .data = trace->byte_count,
+            .line = line_number
+        };
+        trace->byte_count += hex_length / 2U;
+    }
+    return true;
+}
+
+static int compare_events(const void *a, const void *b) {
+    const trace_event_t *x = a;
+    const trace_event_t *y = b;
+    if (x->start_us != y->start_us) {
+        return (x->start_us > y->start_us) - (x->start_us < y->start_us);
+    }
+    return (x->line > y->line) - (x->line < y->line);
+}
+
+/**
+ * @brief Validate every command and response frame's CRC in one pass
+ */
+static void trace_check_crcs(const trace_t *trace, size_t *frames, size_t *bad, size_t *checked_bytes) {
+    *frames = 0;
+    *bad = 0;
+    *checked_bytes = 0;
+    for (size_t i = 0; i < trace->event_count; i++) {
+        const trace_event_t *event = &trace->events[i];
+        const uint8_t *data = &trace->bytes[event->data];
+        const uint8_t *frame = NULL;
+        size_t length = 0;
+        if (event->kind == 'W' && event->length >= 8U && data[0] == TRACE_WORD_COMMAND &&
+            data[1] == event->length - 1U) {
+            frame = &data[1];
+            length = data[1];
+        } else if (event->kind == 'R' && event->length >= 4U && data[0] >= 4U && data[0] <= event->length &&
+                   !trace->devices[event->device].mux) {
+            frame = data;
+            length = data[0];
+        }
+        if (!frame) {
+            continue;
+        }
+        uint16_t crc = atecc_crc16(frame, length - 2U);
+        (*frames)++;
+        *checked_bytes += length;
+        if (frame[length - 2U] != (uint8_t)crc || frame[length - 1U] != (uint8_t)(crc >> 8)) {
+            (*bad)++;
+        }
+    }
+}
+
+static bool open_request(trace_t *trace, trace_device_t *device, const trace_event_t *event, uint8_t opcode,
+                         uint8_t mode) {
+    if (!grow((void **)&trace->requests, &trace->request_capacity, trace->request_count + 1U,
+              sizeof(trace_request_t))) {
+        return false;
+    }
+    trace->requests[trace->request_count] = (trace_request_t){
+        .device = event->device,
+        .opcode = opcode,
+        .mode = mode,
+        .start_us = event->start_us,
+        .written_us = event->end_us
+    };
+    device->open = (int)trace->request_count++;
+    return true;
+}
+
+/**
+ * @brief Rebuild commands per device from the time-ordered events
+ *
+ * A command write (or a wake token) opens a request on its device; NACKed
+ * reads and sleeps while it is open are its wait; the next completed read
+ * closes it. A new command before any response leaves the old one
+ * incomplete.
+ */
+static bool trace_reconstruct(trace_t *trace) {
+    for (size_t i = 0; i < trace->event_count; i++) {
+        const trace_event_t *event = &trace->events[i];
+        trace_device_t *device = &trace->devices[event->device];
+        const uint8_t *data = &trace->bytes[event->data];
+        if (device->first_us == 0 || event->start_us < device->first_us) {
+            device->first_us = event->start_us;
+        }
+        if (event->end_us > device->last_us) {
+            device->last_us = event->end_us;
+        }
+        if (device->mux) {
+            continue;
+        }
+        trace_request_t *open = (device->open >= 0) ? &trace->requests[device->open] : NULL;
+
+        switch (event->kind) {
+        case 'W':
+        case 'w':
+            if (event->kind == 'W' && event->length >= 8U && data[0] == TRACE_WORD_COMMAND) {
+                if (!open_request(trace, device, event, data[2], data[3])) {
+                    return false;
+                }
+            } else if (event->length == 1U && data[0] == TRACE_WAKE_TOKEN) {
+                // The wake token is usually NACKed, so it counts whether or not the write completed
+                if (!open_request(trace, device, event, TRACE_OPCODE_WAKE, 0)) {
+                    return false;
+                }
+            }
+            break;
+        case 'r':
+            if (open) {
+                open->polls++;
+            }
+            break;
+        case 'R':
+            if (open) {
+                open->read_us = event->start_us;
+                open->end_us = event->end_us;
+                open->complete = true;
+                device->open = -1;
+            }
+            break;
+        case 'S':
+            if (open) {
+                open->sleep_us += event->end_us - event->start_us;
+            } else {
+                device->between_us += event->end_us - event->start_us;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Union of transfer intervals per bus
+ */
+static void trace_bus_busy(trace_t *trace) {
+    for (size_t b = 0; b < trace->bus_count; b++) {
+        uint64_t covered_to = 0;
+        uint64_t busy = 0;
+        for (size_t i = 0; i < trace->event_count; i++) {
+            const trace_event_t *event = &trace->events[i];
+            if (event->kind == 'S' || trace->devices[event->device].bus != b) {
+                continue;
+            }
+            uint64_t from = (event->start_us > covered_to) ? event->start_us : covered_to;
+            if (event->end_us > from) {
+                busy += event->end_us - from;
+                covered_to = event->end_us;
+            }
+        }
+        trace->buses[b].busy_us = busy;
+    }
+}
+
+static trace_class_t *class_for(trace_class_t *classes, size_t *count, uint8_t opcode, uint8_t mode) {
+    for (size_t i = 0; i < *count; i++) {
+        if (classes[i].opcode == opcode && classes[i].mode == mode) {
+            return &classes[i];
+        }
+    }
+    if (*count == TRACE_CLASS_MAX) {
+        return NULL;
+    }
+    classes[*count] = (trace_class_t){ .opcode = opcode, .mode = mode };
+    return &classes[(*count)++];
+}
+
+static int compare_classes(const void *a, const void *b) {
+    const trace_class_t *x = a;
+    const trace_class_t *y = b;
+    return (x->wall_us < y->wall_us) - (x->wall_us > y->wall_us);
+}
+
+static int compare_requests(const void *a, const void *b) {
+    const trace_request_t *x = a;
+    const trace_request_t *y = b;
+    uint64_t wx = x->end_us - x->start_us;
+    uint64_t wy = y->end_us - y->start_us;
+    return (wx < wy) - (wx > wy);
+}
+
+/**
+ * @brief Split a request's wall time along its critical path
+ *
+ * The path is sequential: command write, device execution, idle time
+ * until the host reads, response read. Idle time is charged to fixed
+ * sleeps up to the sleep time spent waiting; the rest is host overhead
+ * (scheduling, poll interval).
+ */
+static void request_path(const trace_request_t *request, uint64_t *bus_us, uint64_t *exec_us,
+                         uint64_t *sleep_slack_us, uint64_t *other_us) {
+    uint64_t wait = request->read_us - request->written_us;
+    uint64_t exec = (request->exec_us < wait) ? request->exec_us : wait;
+    uint64_t idle = wait - exec;
+    *bus_us = (request->written_us - request->start_us) + (request->end_us - request->read_us);
+    *exec_us = exec;
+    *sleep_slack_us = (idle < request->sleep_us) ? idle : request->sleep_us;
+    *other_us = idle - *sleep_slack_us;
+}
+
+static double ms(uint64_t us) {
+    return (double)us / 1000.0;
+}
+
+static bool set_exec_override(const char *spec) {
+    const char *equals = strchr(spec, '=');
+    if (!equals) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(trace_opcodes) / sizeof(trace_opcodes[0]); i++) {
+        if (strlen(trace_opcodes[i].name) == (size_t)(equals - spec) &&
+            strncasecmp(trace_opcodes[i].name, spec, (size_t)(equals - spec)) == 0) {
+            trace_opcodes[i].typical_us = (uint32_t)(atof(equals + 1) * 1000.0);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Print the report: buses, devices, CRCs, time by command class, slowest requests
+ */
+static void trace_report(trace_t *trace, const char *path, size_t top) {
+    uint64_t first = UINT64_MAX;
+    uint64_t last = 0;
+    for (size_t i = 0; i < trace->event_count; i++) {
+        first = (trace->events[i].start_us < first) ? trace->events[i].start_us : first;
+        last = (trace->events[i].end_us > last) ? trace->events[i].end_us : last;
+    }
+    uint64_t span = (last > first) ? last - first : 1U;
+    printf("📼 %s: %zu event(s), %zu device(s) on %zu bus(es), %.3f s\n", path, trace->event_count,
+           trace->device_count, trace->bus_count, (double)span / 1e6);
+
+    size_t frames;
+    size_t bad;
+    size_t checked_bytes;
+    uint64_t crc_start = atecc_now_us();
+    trace_check_crcs(trace, &frames, &bad, &checked_bytes);
+    uint64_t crc_us = atecc_now_us() - crc_start;
+    printf("🔢 CRC: %zu frame(s), %zu bad (%zu bytes in %llu us)\n", frames, bad, checked_bytes,
+           (unsigned long long)crc_us);
+
+    for (size_t b = 0; b < trace->bus_count; b++) {
+        printf("🚌 %s: bus busy %.1f%%\n", trace->buses[b].name, 100.0 * (double)trace->buses[b].busy_us / (double)span);
+    }
+
+    // Execution time per class: measured from polled requests, else the typical table
+    static trace_class_t classes[TRACE_CLASS_MAX];
+    size_t class_count = 0;
+    for (size_t i = 0; i < trace->request_count; i++) {
+        const trace_request_t *request = &trace->requests[i];
+        if (request->complete && request->polls > 0) {
+            trace_class_t *class = class_for(classes, &class_count, request->opcode, request->mode);
+            if (!class) {
+                continue;
+            }
+            class->polled++;
+            class->polled_wait_us += request->read_us - request->written_us;
+        }
+    }
+    uint64_t device_exec[TRACE_DEVICE_MAX] = {0};
+    uint64_t total_bus = 0;
+    uint64_t total_exec = 0;
+    uint64_t total_slack = 0;
+    uint64_t total_other = 0;
+    size_t incomplete = 0;
+    for (size_t i = 0; i < trace->request_count; i++) {
+        trace_request_t *request = &trace->requests[i];
+        if (!request->complete) {
+            incomplete++;
+            continue;
+        }
+        trace_class_t *class = class_for(classes, &class_count, request->opcode, request->mode);
+        if (!class) {
+            continue;
+        }
+        request->exec_us = class->polled ? class->polled_wait_us / class->polled : opcode_typical_us(request->opcode);
+
+        uint64_t bus_us;
+        uint64_t exec_us;
+        uint64_t slack_us;
+        uint64_t other_us;
+        request_path(request, &bus_us, &exec_us, &slack_us, &other_us);
+        class->count++;
+        class->wall_us += request->end_us - request->start_us;
+        class->bus_us += bus_us;
+        class->exec_us += exec_us;
+        class->sleep_slack_us += slack_us;
+        class->other_us += other_us;
+        device_exec[request->device] += exec_us;
+        total_bus += bus_us;
+        total_exec += exec_us;
+        total_slack += slack_us;
+        total_other += other_us;
+    }
+
+    uint64_t total_active = 0;
+    uint64_t total_between = 0;
+    for (size_t d = 0; d < trace->device_count; d++) {
+        const trace_device_t *device = &trace->devices[d];
+        if (device->mux) {
+            continue;
+        }
+        uint64_t active = device->last_us - device->first_us;
+        total_active += active;
+        total_between += device->between_us;
+        printf("📟 %s %s: device busy %.1f%% (estimated)\n", trace->buses[device->bus].name, device->name,
+               active ? 100.0 * (double)device_exec[d] / (double)active : 0.0);
+    }
+    if (incomplete > 0) {
+        printf("⚠️ %zu command(s) without a response\n", incomplete);
+    }
+
+    // Ranked totals over every device's active span
+    uint64_t in_requests = total_bus + total_exec + total_slack + total_other;
+    uint64_t outside = (total_active > in_requests) ? total_active - in_requests : 0;
+    trace_share_t where[] = {
+        { "device execution", total_exec },
+        { "idle after fixed sleeps", total_slack },
+        { "host overhead while waiting", total_other },
+        { "command/response transfers", total_bus },
+        { "between commands", outside }
+    };
+    size_t where_count = sizeof(where) / sizeof(where[0]);
+    for (size_t i = 1; i < where_count; i++) {
+        for (size_t j = i; j > 0 && where[j].us > where[j - 1U].us; j--) {
+            trace_share_t swap = where[j];
+            where[j] = where[j - 1U];
+            where[j - 1U] = swap;
+        }
+    }
+    printf("⏱️ Where device wall time goes (%.1f ms over all devices):\n", ms(total_active));
+    for (size_t i = 0; i < where_count; i++) {
+        printf("   %zu. %-28s %10.1f ms  %5.1f%%\n", i + 1U, where[i].label, ms(where[i].us),
+               total_active ? 100.0 * (double)where[i].us / (double)total_active : 0.0);
+    }
+    printf("💤 fixed sleeps between commands: %.1f ms\n", ms(total_between));
+
+    qsort(classes, class_count, sizeof(classes[0]), compare_classes);
+    printf("📋 By command, ranked by wall time:\n");
+    printf("   %-12s %4s %7s %10s %9s %9s %9s %9s  %s\n", "command", "mode", "count", "wall ms", "bus", "exec",
+           "slack", "other", "exec from");
+    for (size_t i = 0; i < class_count; i++) {
+        const trace_class_t *class = &classes[i];
+        if (class->count == 0) {
+            continue;
+        }
+        printf("   %-12s 0x%02X %7zu %10.1f %9.1f %9.1f %9.1f %9.1f  %s\n", opcode_name(class->opcode), class->mode,
+               class->count, ms(class->wall_us), ms(class->bus_us), ms(class->exec_us), ms(class->sleep_slack_us),
+               ms(class->other_us), class->polled ? "polls" : "typical");
+    }
+
+    qsort(trace->requests, trace->request_count, sizeof(trace->requests[0]), compare_requests);
+    printf("🐢 Slowest commands (critical path):\n");
+    for (size_t i = 0, shown = 0; i < trace->request_count && shown < top; i++) {
+        const trace_request_t *request = &trace->requests[i];
+        if (!request->complete) {
+            continue;
+        }
+        uint64_t bus_us;
+        uint64_t exec_us;
+        uint64_t slack_us;
+        uint64_t other_us;
+        request_path(request, &bus_us, &exec_us, &slack_us, &other_us);
+        const trace_device_t *device = &trace->devices[request->device];
+        printf("   %-10s 0x%02X %s %s +%.3f s: %.1f ms = %.1f bus + %.1f exec + %.1f sleep slack + %.1f other"
+               " (%u poll(s))\n", opcode_name(request->opcode), request->mode, trace->buses[device->bus].name,
+               device->name, (double)(request->start_us - first) / 1e6, ms(request->end_us - request->start_us),
+               ms(bus_us), ms(exec_us), ms(slack_us), ms(other_us), request->polls);
+        shown++;
+    }
+}
+
+/**
+ * @brief Analyze an I2C trace recorded with ATECC_TRACE=FILE
+ *
+ * Usage: trace <file | -> [--top N] [--exec NAME=MS ...]
+ *
+ * Rebuilds commands from the raw frames, checks every CRC, and reports bus
+ * and device utilization, time lost to fixed sleeps, time per command and
+ * the critical path of the slowest commands. A file of "-" reads the trace
+ * from stdin.
+ *
+ * @return Process exit status
+ */
+int atecc_trace_main(int argc, char **argv) {
+    const char *path = NULL;
+    size_t top = TRACE_DEFAULT_TOP;
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--top") == 0 && has_value) {
+            top = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--exec") == 0 && has_value) {
+            if (!set_exec_override(argv[++i])) {
+                fprintf(stderr, "trace: --exec takes NAME=MS with a known command name\n");
+                return 2;
+            }
+        } else if ((argv[i][0] != '-' || strcmp(argv[i], "-") == 0) && !path) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "usage: pi_atecc trace <file | -> [--top N] [--exec NAME=MS ...]\n");
+        return 2;
+    }
+
+    FILE *in = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+    if (!in) {
+        perror("trace: cannot open trace");
+        return 1;
+    }
+    trace_t *trace = calloc(1, sizeof(*trace));
+    bool ok = trace && trace_load(trace, in);
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    if (ok) {
+        qsort(trace->events, trace->event_count, sizeof(trace->events[0]), compare_events);
+        ok = trace_reconstruct(trace);
+    }
+    if (ok) {
+        trace_bus_busy(trace);
+        trace_report(trace, path, top);
+    }
+
+    if (trace) {
+        free(trace->events);
+        free(trace->bytes);
+        free(trace->requests);
+        free(trace);
+    }
+    return ok ? 0 : 1;
+}
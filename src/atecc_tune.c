@@ -0,0 +1,567 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "pi_atecc.h"
+
+enum {
+    CALIBRATE_DEFAULT_RUNS = 32U,
+    CALIBRATE_MAX_RUNS     = 1000U,
+    CALIBRATE_WAKE_MAX_US  = 10000U,    // The library's fixed wake wait
+    CALIBRATE_NONCES       = 3U,        // Nonce samples per run: plain, before Sign, before Verify
+    TUNE_MIN_POLL_US       = 100U,
+    TUNE_ROUND_US          = 10U
+};
+
+/**
+ * @brief Command measured by `pi_atecc calibrate`
+ *
+ * Only commands the library issues and that leave no trace in the device are
+ * measured; Write and Lock keep their fixed waits.
+ */
+typedef enum {
+    CAL_READ_4 = 0,
+    CAL_READ_32,
+    CAL_RANDOM,
+    CAL_NONCE,
+    CAL_SHA_START,
+    CAL_SHA_UPDATE,
+    CAL_SHA_END,
+    CAL_GENKEY,
+    CAL_SIGN,
+    CAL_VERIFY,
+    CAL_AES_ENCRYPT,
+    CAL_AES_DECRYPT,
+    CAL_SELFTEST_RNG,
+    CAL_SELFTEST_SHA,
+    CAL_SELFTEST_AES,
+    CAL_SELFTEST_ECDH,
+    CAL_SELFTEST_ECDSA,
+    CAL_COUNT
+} cal_id_t;
+
+typedef struct {
+    const char *name;
+    uint8_t opcode;
+    uint8_t mode;
+    uint32_t max_ms;            // Fixed wait the library uses for the command
+} cal_cmd_t;
+
+static const cal_cmd_t cal_cmds[CAL_COUNT] = {
+    [CAL_READ_4]      = { "Read 4",      ATECC_CMD_READ,   0x00, 5 },
+    [CAL_READ_32]     = { "Read 32",     ATECC_CMD_READ,   ATECC_ZONE_READ_32, 5 },
+    [CAL_RANDOM]      = { "Random",      ATECC_CMD_RANDOM, 0x00, 50 },
+    [CAL_NONCE]       = { "Nonce",       ATECC_CMD_NONCE,  0x03, 7 },
+    [CAL_SHA_START]   = { "SHA start",   ATECC_CMD_SHA,    0x00, 5 },
+    [CAL_SHA_UPDATE]  = { "SHA update",  ATECC_CMD_SHA,    0x01, 5 },
+    [CAL_SHA_END]     = { "SHA end",     ATECC_CMD_SHA,    0x02, 5 },
+    [CAL_GENKEY]      = { "GenKey",      ATECC_CMD_GENKEY, 0x00, 115 },
+    [CAL_SIGN]        = { "Sign",        ATECC_CMD_SIGN,   0x80, 115 },
+    [CAL_VERIFY]      = { "Verify",      ATECC_CMD_VERIFY, 0x02, 105 },
+    [CAL_AES_ENCRYPT] = { "AES encrypt", 0x51,             0x00, 5 },
+    [CAL_AES_DECRYPT] = { "AES decrypt", 0x51,             0x01, 5 },
+    [CAL_SELFTEST_RNG]   = { "Test RNG",   ATECC_CMD_SELFTEST, ATECC_SELFTEST_RNG, 20 },
+    [CAL_SELFTEST_SHA]   = { "Test SHA",   ATECC_CMD_SELFTEST, ATECC_SELFTEST_SHA, 10 },
+    [CAL_SELFTEST_AES]   = { "Test AES",   ATECC_CMD_SELFTEST, ATECC_SELFTEST_AES, 10 },
+    [CAL_SELFTEST_ECDH]  = { "Test ECDH",  ATECC_CMD_SELFTEST, ATECC_SELFTEST_ECDH, 80 },
+    [CAL_SELFTEST_ECDSA] = { "Test ECDSA", ATECC_CMD_SELFTEST, ATECC_SELFTEST_ECDSA, 200 }
+};
+
+/**
+ * @brief Completion times collected for one command
+ */
+typedef struct {
+    uint32_t *samples;
+    size_t count;
+    unsigned long errors;       // No response, bad CRC or an error status
+    uint64_t polls;             // NACKed reads
+    uint64_t poll_us;           // Time spent in them
+    uint32_t read_us_min;       // Fastest successful read
+    size_t read_len;            // Length of that read
+} cal_stats_t;
+
+typedef struct {
+    atecc_dev_t *dev;
+    cal_stats_t stats[CAL_COUNT];
+    int key_slot;               // ECC key slot for GenKey/Sign/Verify, -1 to skip
+    int aes_slot;               // AES key slot, -1 to skip
+    bool selftest;              // Time each SelfTest algorithm, for the daemon's idle-time slices
+} cal_state_t;
+
+/**
+ * @brief Configured clock of the adapter behind an I2C device file
+ *
+ * Read from the adapter's device tree node, which is where Linux takes it
+ * from; adapters without one (USB bridges, ACPI) report 0.
+ *
+ * @param bus I2C device file, e.g. "/dev/i2c-1"
+ * @return Clock in Hz, 0 if unknown
+ */
+uint32_t atecc_bus_hz(const char *bus) {
+    static const char *const formats[] = {
+        "/sys/class/i2c-adapter/%s/of_node/clock-frequency",
+        "/sys/class/i2c-dev/%s/device/of_node/clock-frequency"
+    };
+    const char *name = strrchr(bus, '/');
+    name = name ? name + 1 : bus;
+
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        char path[256];
+        snprintf(path, sizeof(path), formats[i], name);
+        FILE *file = fopen(path, "rb");
+        if (!file) {
+            continue;
+        }
+        uint8_t cell[4];
+        size_t length = fread(cell, 1, sizeof(cell), file);
+        fclose(file);
+        if (length == sizeof(cell)) {
+            return ((uint32_t)cell[0] << 24) | ((uint32_t)cell[1] << 16) | ((uint32_t)cell[2] << 8) | cell[3];
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Calibrated ready time of a command
+ *
+ * @param tune Tuning profile
+ * @param opcode Command opcode
+ * @param mode Command param1
+ * @return Ready time in microseconds, 0 when the command is not calibrated
+ */
+uint32_t atecc_tune_ready_us(const atecc_tune_t *tune, uint8_t opcode, uint8_t mode) {
+    if (!tune->loaded) {
+        return 0;
+    }
+    for (size_t i = 0; i < tune->op_count; i++) {
+        if (tune->ops[i].opcode == opcode && tune->ops[i].mode == mode) {
+            return tune->ops[i].ready_us;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Profile path for a serial number: "tune-<SERIAL>.txt" in atecc_cache_dir()
+ */
+static bool tune_path(const uint8_t *serial, char *path, size_t size) {
+    char dir[256];
+    if (!atecc_cache_dir(dir, sizeof(dir))) {
+        return false;
+    }
+    char serial_hex[2U * ATECC_SERIAL_NUMBER_SIZE + 1U];
+    atecc_hex(serial, ATECC_SERIAL_NUMBER_SIZE, serial_hex, ATECC_HEX_UPPER);
+    int written = snprintf(path, size, "%s/tune-%s.txt", dir, serial_hex);
+    return written > 0 && (size_t)written < size;
+}
+
+/**
+ * @brief Load the tuning profile written by `pi_atecc calibrate` for the device's serial number
+ *
+ * Called once the serial number has been read from the device. A profile
+ * measured at a different adapter clock is ignored, since NACK and transfer
+ * times scale with it. Set ATECC_NO_TUNE to keep the fixed waits.
+ *
+ * @param dev Device handle with a verified identity
+ * @return true if a profile was loaded, false otherwise
+ */
+bool atecc_tune_load(atecc_dev_t *dev) {
+    char path[512];
+    memset(&dev->tune, 0, sizeof(dev->tune));
+    if (!dev->identity_valid || getenv("ATECC_NO_TUNE") || !tune_path(dev->serial, path, sizeof(path))) {
+        return false;
+    }
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    atecc_tune_t tune = {0};
+    char line[128];
+    char serial_hex[2U * ATECC_SERIAL_NUMBER_SIZE + 1U];
+    bool serial_ok = false;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        char text[32];
+        unsigned int opcode;
+        unsigned int mode;
+        unsigned int value;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (sscanf(line, "serial %31s", text) == 1) {
+            atecc_hex(dev->serial, ATECC_SERIAL_NUMBER_SIZE, serial_hex, ATECC_HEX_UPPER);
+            serial_ok = strcmp(text, serial_hex) == 0;
+        } else if (sscanf(line, "poll_us %u", &value) == 1) {
+            tune.poll_us = value;
+        } else if (sscanf(line, "wake_us %u", &value) == 1) {
+            tune.wake_us = value;
+        } else if (sscanf(line, "bus_hz %u", &value) == 1) {
+            tune.bus_hz = value;
+        } else if (sscanf(line, "op %x %x %u", &opcode, &mode, &value) == 3 && opcode <= 0xFFU && mode <= 0xFFU &&
+                   tune.op_count < ATECC_TUNE_OPS_MAX) {
+            tune.ops[tune.op_count++] = (atecc_tune_op_t){ (uint8_t)opcode, (uint8_t)mode, value };
+        } else {
+            ok = false;
+        }
+    }
+    fclose(file);
+
+    if (!ok || !serial_ok || tune.poll_us == 0U) {
+        fprintf(stderr, "atecc_tune_load: ignoring malformed profile %s\n", path);
+        return false;
+    }
+    uint32_t bus_hz = atecc_bus_hz(dev->bus);
+    if (tune.bus_hz != 0U && bus_hz != 0U && tune.bus_hz != bus_hz) {
+        fprintf(stderr, "atecc_tune_load: profile measured at %u Hz, bus runs at %u Hz; rerun calibrate\n",
+                tune.bus_hz, bus_hz);
+        return false;
+    }
+
+    tune.loaded = true;
+    dev->tune = tune;
+    return true;
+}
+
+/**
+ * @brief Write a tuning profile for the device's serial number
+ *
+ * @param dev Device handle with a known identity
+ * @param tune Profile to write
+ * @return true if the profile was written, false otherwise
+ */
+bool atecc_tune_save(const atecc_dev_t *dev, const atecc_tune_t *tune) {
+    char path[512];
+    char tmp_path[520];
+    if (!dev->identity_valid || !tune_path(dev->serial, path, sizeof(path))) {
+        errno = EINVAL;
+        return false;
+    }
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *file = fopen(tmp_path, "w");
+    if (!file) {
+        return false;
+    }
+    char serial_hex[2U * ATECC_SERIAL_NUMBER_SIZE + 1U];
+    atecc_hex(dev->serial, ATECC_SERIAL_NUMBER_SIZE, serial_hex, ATECC_HEX_UPPER);
+    fprintf(file, "# pi_atecc tuning profile, written by `pi_atecc calibrate`\n");
+    fprintf(file, "serial %s\n", serial_hex);
+    fprintf(file, "bus_hz %u\n", tune->bus_hz);
+    fprintf(file, "poll_us %u\n", tune->poll_us);
+    fprintf(file, "wake_us %u\n", tune->wake_us);
+    for (size_t i = 0; i < tune->op_count; i++) {
+        fprintf(file, "op %02X %02X %u\n", tune->ops[i].opcode, tune->ops[i].mode, tune->ops[i].ready_us);
+    }
+
+    bool ok = !ferror(file);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmp_path, path) < 0) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Run one command under atecc_time_command() and record its completion time
+ *
+ * @return true if the command returned a response with success status
+ */
+static bool cal_run(cal_state_t *state, cal_id_t id, uint16_t param2, const uint8_t *data, uint8_t data_len,
+                    uint8_t *response, size_t response_len) {
+    const cal_cmd_t *cmd = &cal_cmds[id];
+    cal_stats_t *stats = &state->stats[id];
+    atecc_cmd_timing_t timing;
+
+    if (!atecc_time_command(state->dev, cmd->opcode, cmd->mode, param2, data, data_len, response, response_len,
+                            cmd->max_ms * 1000U, &timing) || timing.status != ATECC_STATUS_SUCCESS) {
+        stats->errors++;
+        return false;
+    }
+
+    stats->samples[stats->count++] = timing.ready_us;
+    stats->polls += timing.polls;
+    stats->poll_us += timing.poll_us;
+    if (stats->read_us_min == 0U || timing.read_us < stats->read_us_min) {
+        stats->read_us_min = timing.read_us;
+        stats->read_len = response_len;
+    }
+    return true;
+}
+
+/**
+ * @brief One calibration run: every measured command once, in dependency order
+ *
+ * Sequences that keep state in the device (SHA, Nonce before Sign or Verify)
+ * are kept inside one watchdog window with atecc_keep_awake().
+ */
+static void cal_pass(cal_state_t *state) {
+    uint8_t response[ATECC_RESPONSE_SIZE];
+    uint8_t digest[32];
+    uint8_t block[64];
+    uint8_t key_data[128];      // Signature followed by the public key, as Verify takes them
+
+    cal_run(state, CAL_READ_4, 0x0000, NULL, 0, response, 7);
+    cal_run(state, CAL_READ_32, 0x0000, NULL, 0, response, 35);
+    if (cal_run(state, CAL_RANDOM, 0x0000, NULL, 0, response, 35)) {
+        memcpy(digest, &response[1], sizeof(digest));
+    } else {
+        memset(digest, 0xA5, sizeof(digest));
+    }
+    cal_run(state, CAL_NONCE, 0x0000, digest, sizeof(digest), response, 4);
+
+    memset(block, 0x5A, sizeof(block));
+    atecc_keep_awake(state->dev, 50000U);
+    if (cal_run(state, CAL_SHA_START, 0x0000, NULL, 0, response, 4) &&
+        cal_run(state, CAL_SHA_UPDATE, 0x0000, block, sizeof(block), response, 4)) {
+        cal_run(state, CAL_SHA_END, 0x0000, NULL, 0, response, 35);
+    }
+
+    if (state->key_slot >= 0) {
+        uint16_t slot = (uint16_t)state->key_slot;
+        if (cal_run(state, CAL_GENKEY, slot, NULL, 0, response, 67)) {
+            memcpy(&key_data[64], &response[1], 64);
+            atecc_keep_awake(state->dev, 250000U);
+            if (cal_run(state, CAL_NONCE, 0x0000, digest, sizeof(digest), response, 4) &&
+                cal_run(state, CAL_SIGN, slot, NULL, 0, response, 67)) {
+                memcpy(key_data, &response[1], 64);
+                atecc_keep_awake(state->dev, 250000U);
+                if (cal_run(state, CAL_NONCE, 0x0000, digest, sizeof(digest), response, 4)) {
+                    cal_run(state, CAL_VERIFY, 0x0004, key_data, sizeof(key_data), response, 4);
+                }
+            }
+        }
+    }
+
+    if (state->aes_slot >= 0) {
+        uint16_t slot = (uint16_t)state->aes_slot;
+        uint8_t input[16];
+        memcpy(input, digest, sizeof(input));
+        if (cal_run(state, CAL_AES_ENCRYPT, slot, input, sizeof(input), response, 19)) {
+            memcpy(input, &response[1], sizeof(input));
+            cal_run(state, CAL_AES_DECRYPT, slot, input, sizeof(input), response, 19);
+        }
+    }
+
+    if (state->selftest) {
+        for (cal_id_t id = CAL_SELFTEST_RNG; id <= CAL_SELFTEST_ECDSA; id++) {
+            atecc_keep_awake(state->dev, cal_cmds[id].max_ms * 1000U);
+            cal_run(state, id, 0x0000, NULL, 0, response, 4);
+        }
+    }
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t round_up_us(uint32_t us) {
+    return (us + TUNE_ROUND_US - 1U) / TUNE_ROUND_US * TUNE_ROUND_US;
+}
+
+/**
+ * @brief Run the calibration passes on an awake device and report and save the profile
+ *
+ * @param state Calibration state with sample buffers for runs passes
+ * @param runs Number of passes
+ * @param save Write the profile with atecc_tune_save()
+ * @param wake_samples Buffer for runs wake times
+ * @return Process exit status
+ */
+static int calibrate(cal_state_t *state, size_t runs, bool save, uint32_t *wake_samples) {
+    atecc_dev_t *dev = state->dev;
+    if (!atecc_ensure_awake(dev)) {
+        fprintf(stderr, "calibrate: device not answering\n");
+        return 1;
+    }
+    memset(&dev->tune, 0, sizeof(dev->tune));
+
+    char serial_hex[2U * ATECC_SERIAL_NUMBER_SIZE + 1U];
+    atecc_hex(dev->serial, ATECC_SERIAL_NUMBER_SIZE, serial_hex, ATECC_HEX_UPPER);
+    printf("🔧 Calibrating %s on %s, %zu runs\n", serial_hex, dev->bus, runs);
+
+    size_t wakes = 0;
+    for (size_t i = 0; i < runs; i++) {
+        if (atecc_time_wake(dev, CALIBRATE_WAKE_MAX_US, &wake_samples[wakes])) {
+            wakes++;
+        }
+    }
+    for (size_t i = 0; i < runs; i++) {
+        cal_pass(state);
+    }
+
+    atecc_tune_t tune = { .bus_hz = atecc_bus_hz(dev->bus) };
+    uint64_t polls = 0;
+    uint64_t poll_us = 0;
+    unsigned long errors = 0;
+    uint32_t read_us_min = 0;
+    size_t read_len = 0;
+
+    printf("%-12s %6s %8s %8s %8s %9s\n", "command", "runs", "min_us", "p50_us", "max_us", "fixed_us");
+    for (size_t i = 0; i < CAL_COUNT; i++) {
+        cal_stats_t *stats = &state->stats[i];
+        polls += stats->polls;
+        poll_us += stats->poll_us;
+        errors += stats->errors;
+        if (stats->read_len > read_len || (stats->read_len == read_len && stats->read_us_min < read_us_min)) {
+            read_us_min = stats->read_us_min;
+            read_len = stats->read_len;
+        }
+        if (stats->count == 0) {
+            if (stats->errors > 0) {
+                printf("⚠️ %s: no successful run (%lu errors), keeping the fixed wait\n", cal_cmds[i].name,
+                       stats->errors);
+            }
+            continue;
+        }
+
+        qsort(stats->samples, stats->count, sizeof(uint32_t), compare_u32);
+        uint32_t ready_us = round_up_us(stats->samples[stats->count - 1U]);
+        printf("%-12s %6zu %8u %8u %8u %9u%s\n", cal_cmds[i].name, stats->count, stats->samples[0],
+               stats->samples[stats->count / 2U], stats->samples[stats->count - 1U], cal_cmds[i].max_ms * 1000U,
+               stats->errors ? "  ⚠️ errors" : "");
+        if (ready_us < cal_cmds[i].max_ms * 1000U) {
+            tune.ops[tune.op_count++] = (atecc_tune_op_t){ cal_cmds[i].opcode, cal_cmds[i].mode, ready_us };
+        }
+    }
+
+    if (wakes > 0) {
+        qsort(wake_samples, wakes, sizeof(uint32_t), compare_u32);
+        tune.wake_us = round_up_us(wake_samples[wakes - 1U]);
+        printf("⏰ Wake to ready: min %u, p50 %u, max %u us (fixed %u)\n", wake_samples[0], wake_samples[wakes / 2U],
+               wake_samples[wakes - 1U], CALIBRATE_WAKE_MAX_US);
+    } else {
+        printf("⚠️ No timed wake succeeded, keeping the fixed wake wait\n");
+    }
+
+    uint32_t nack_us = polls ? (uint32_t)(poll_us / polls) : 0U;
+    tune.poll_us = 2U * nack_us;
+    if (tune.poll_us < TUNE_MIN_POLL_US) {
+        tune.poll_us = TUNE_MIN_POLL_US;
+    }
+    printf("🔁 NACK poll: %u us each over %llu polls, backoff %u us\n", nack_us, (unsigned long long)polls,
+           tune.poll_us);
+
+    if (read_us_min > 0U) {
+        // One address byte plus the payload, nine clocks per byte including ACK
+        uint64_t effective_hz = (uint64_t)(read_len + 1U) * 9U * 1000000U / read_us_min;
+        printf("🚌 Bus: %zu-byte read in %u us, ~%llu Hz effective\n", read_len, read_us_min,
+               (unsigned long long)effective_hz);
+    }
+    if (tune.bus_hz) {
+        printf("   Adapter clock %u Hz; the ATECC608 takes up to 1000000 Hz. Raise it in the device tree\n"
+               "   (e.g. dtparam=i2c_arm_baudrate=...) and calibrate again to test a faster bus.\n", tune.bus_hz);
+    } else {
+        printf("   Adapter clock unknown (no device tree clock-frequency)\n");
+    }
+    if (errors > 0) {
+        printf("⚠️ %lu command(s) failed at this bus clock; lower it before relying on the profile\n", errors);
+    } else {
+        printf("✅ No transfer or CRC errors at this bus clock\n");
+    }
+
+    tune.loaded = true;
+    if (save) {
+        if (!atecc_tune_save(dev, &tune)) {
+            perror("calibrate: writing profile failed");
+            return 1;
+        }
+        dev->tune = tune;
+        atecc_snapshot_publish(dev);
+        printf("💾 Profile with %zu command(s) saved for %s\n", tune.op_count, serial_hex);
+    }
+    return errors > 0 ? 1 : 0;
+}
+
+/**
+ * @brief Measure command completion, NACK-poll and wake times and write a tuning profile
+ *
+ * Each command's profile entry is the longest completion time seen over all
+ * runs, so the first poll normally finds the response ready; slower outliers
+ * are caught by polling every poll_us up to the fixed worst case. The backoff
+ * is twice the cost of one NACKed poll, so polling holds the bus at most a
+ * third of the time. The adapter clock cannot be changed from userspace; it
+ * is recorded so a profile is dropped when the clock changes.
+ *
+ * Usage: calibrate [--runs N] [--key-slot S] [--aes-slot S] [--selftest] [--no-save] [device]
+ *
+ * @return Process exit status
+ */
+int atecc_calibrate_main(int argc, char **argv) {
+    size_t runs = CALIBRATE_DEFAULT_RUNS;
+    bool save = true;
+    cal_state_t state = { .key_slot = -1, .aes_slot = -1 };
+    atecc_topo_t topo = { .bus = I2C_DEVICE, .address = ATECC_I2C_ADDRESS };
+
+    for (int i = 0; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--runs") == 0 && has_value) {
+            runs = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--key-slot") == 0 && has_value) {
+            state.key_slot = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--aes-slot") == 0 && has_value) {
+            state.aes_slot = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--selftest") == 0) {
+            state.selftest = true;
+        } else if (strcmp(argv[i], "--no-save") == 0) {
+            save = false;
+        } else if (argv[i][0] != '-' && atecc_parse_topo(argv[i], &topo)) {
+            continue;
+        } else {
+            fprintf(stderr, "usage: pi_atecc calibrate [--runs N] [--key-slot S] [--aes-slot S] [--selftest] "
+                            "[--no-save] [device]\n");
+            return 2;
+        }
+    }
+    if (runs == 0 || runs > CALIBRATE_MAX_RUNS || state.key_slot >= ATECC_SLOT_COUNT ||
+        state.aes_slot >= ATECC_SLOT_COUNT) {
+        fprintf(stderr, "calibrate: --runs must be 1-%u and slots 0-%u\n", CALIBRATE_MAX_RUNS,
+                ATECC_SLOT_COUNT - 1);
+        return 2;
+    }
+
+    atecc_mux_t mux;
+    atecc_dev_t dev;
+    bool muxed = topo.mux_address != 0;
+    if (muxed && !atecc_mux_open(&mux, topo.bus, topo.mux_address)) {
+        return 1;
+    }
+    if (!atecc_open_topo(&dev, &topo, &mux)) {
+        if (muxed) {
+            atecc_mux_close(&mux);
+        }
+        return 1;
+    }
+    state.dev = &dev;
+
+    int status = 1;
+    uint32_t *wake_samples = calloc(runs, sizeof(uint32_t));
+    bool allocated = wake_samples != NULL;
+    for (size_t i = 0; i < CAL_COUNT; i++) {
+        state.stats[i].samples = calloc(runs * CALIBRATE_NONCES, sizeof(uint32_t));
+        allocated = allocated && state.stats[i].samples;
+    }
+    if (!allocated) {
+        perror("calibrate: calloc");
+    } else {
+        status = calibrate(&state, runs, save, wake_samples);
+    }
+
+    for (size_t i = 0; i < CAL_COUNT; i++) {
+        free(state.stats[i].samples);
+    }
+    free(wake_samples);
+    atecc_close(&dev);
+    if (muxed) {
+        atecc_mux_close(&mux);
+    }
+    return status;
+}
@@ -0,0 +1,367 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "pi_atecc.h"
+
+enum {
+    WB_HEADER_SIZE      = 8U,       // Magic (2), CRC16 (2), sequence (4, little-endian)
+    WB_CRC_OFFSET       = 2U,
+    WB_SEQ_OFFSET       = 4U,
+    BENCH_UPDATES       = 200U,
+    BENCH_PERIOD_MS     = 5U,
+    BENCH_INTERVAL_MS   = 1000U,
+    BENCH_STATE_SIZE    = 16U
+};
+
+static const uint8_t wb_magic[2] = { 'W', 'B' };
+
+static uint32_t load_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void store_le32(uint8_t *p, uint32_t value) {
+    for (unsigned int i = 0; i < 4U; i++) {
+        p[i] = (uint8_t)(value >> (8U * i));
+    }
+}
+
+/**
+ * @brief CRC16 over a copy with its CRC field taken as zero
+ */
+static uint16_t copy_crc(const uint8_t *copy, size_t size) {
+    uint8_t scratch[ATECC_WB_COPY_MAX];
+    memcpy(scratch, copy, size);
+    scratch[WB_CRC_OFFSET] = 0;
+    scratch[WB_CRC_OFFSET + 1U] = 0;
+    return atecc_crc16(scratch, size);
+}
+
+/**
+ * @brief Whether a copy read from the slot carries a complete, committed state
+ */
+static bool copy_valid(const uint8_t *copy, size_t size) {
+    uint16_t crc = (uint16_t)(copy[WB_CRC_OFFSET] | (copy[WB_CRC_OFFSET + 1U] << 8));
+    return memcmp(copy, wb_magic, sizeof(wb_magic)) == 0 && copy_crc(copy, size) == crc;
+}
+
+/**
+ * @brief Write the current image to the older copy, header block last
+ *
+ * Blocks that already hold the right bytes are skipped. The header block
+ * changes on every commit (new sequence and CRC) and goes out last, so until
+ * it lands the copy fails its CRC check and the other copy stays current.
+ *
+ * @param wb Write-back buffer
+ * @return true if the copy was committed, false otherwise
+ */
+static bool wb_commit(atecc_wb_t *wb) {
+    uint64_t start = atecc_now_us();
+    unsigned int target = wb->active ^ 1U;
+    size_t size = wb->copy_blocks * ATECC_SLOT_BLOCK_SIZE;
+    uint32_t sequence = wb->sequence + 1U;
+
+    memcpy(wb->image, wb_magic, sizeof(wb_magic));
+    store_le32(&wb->image[WB_SEQ_OFFSET], sequence);
+    uint16_t crc = copy_crc(wb->image, size);
+    wb->image[WB_CRC_OFFSET] = (uint8_t)(crc & 0xFFU);
+    wb->image[WB_CRC_OFFSET + 1U] = (uint8_t)(crc >> 8);
+
+    bool ok = true;
+    for (size_t i = 1; ok && i <= wb->copy_blocks; i++) {
+        size_t block = i % wb->copy_blocks;
+        size_t at = block * ATECC_SLOT_BLOCK_SIZE;
+        if (memcmp(&wb->image[at], &wb->copies[target][at], ATECC_SLOT_BLOCK_SIZE) == 0) {
+            continue;
+        }
+        ok = atecc_write_slot_block(wb->dev, wb->slot, (uint8_t)(target * wb->copy_blocks + block),
+                                    &wb->image[at]);
+        if (ok) {
+            memcpy(&wb->copies[target][at], &wb->image[at], ATECC_SLOT_BLOCK_SIZE);
+            wb->stats.block_writes++;
+        }
+    }
+
+    wb->stats.flush_us_total += atecc_now_us() - start;
+    if (!ok) {
+        fprintf(stderr, "atecc_wb: commit of slot %u copy %u failed, keeping sequence %u\n",
+                wb->slot, target, wb->sequence);
+        return false;
+    }
+    wb->active = target;
+    wb->sequence = sequence;
+    wb->pending = 0;
+    wb->stats.flushes++;
+    return true;
+}
+
+/**
+ * @brief Open a write-back buffer over a data slot and recover its newest copy
+ *
+ * Both copies are read once; the valid one with the higher sequence becomes
+ * the current state. If neither is valid the payload starts zeroed.
+ *
+ * @param wb Buffer to initialize
+ * @param dev Device holding the slot
+ * @param slot Data slot with at least two full blocks (8-15)
+ * @param interval_ms Flush this long after the first pending update, 0 to disable
+ * @param max_pending Flush once this many bytes are pending, 0 to disable
+ * @return true if the slot was read, false otherwise
+ */
+bool atecc_wb_open(atecc_wb_t *wb, atecc_dev_t *dev, uint8_t slot, uint64_t interval_ms, size_t max_pending) {
+    if (!wb || !dev) {
+        errno = EINVAL;
+        return false;
+    }
+    memset(wb, 0, sizeof(*wb));
+    wb->copy_blocks = atecc_slot_size(slot) / ATECC_SLOT_BLOCK_SIZE / 2U;
+    if (wb->copy_blocks == 0) {
+        fprintf(stderr, "atecc_wb_open: slot %u is too small for two copies\n", slot);
+        errno = EINVAL;
+        return false;
+    }
+    wb->dev = dev;
+    wb->slot = slot;
+    wb->capacity = wb->copy_blocks * ATECC_SLOT_BLOCK_SIZE - WB_HEADER_SIZE;
+    wb->interval_us = interval_ms * 1000U;
+    wb->max_pending = max_pending;
+
+    size_t size = wb->copy_blocks * ATECC_SLOT_BLOCK_SIZE;
+    for (unsigned int copy = 0; copy < 2U; copy++) {
+        for (size_t block = 0; block < wb->copy_blocks; block++) {
+            if (!atecc_read_slot_block(dev, slot, (uint8_t)(copy * wb->copy_blocks + block),
+                                       &wb->copies[copy][block * ATECC_SLOT_BLOCK_SIZE])) {
+                fprintf(stderr, "atecc_wb_open: cannot read slot %u\n", slot);
+                return false;
+            }
+        }
+    }
+
+    bool valid[2] = { copy_valid(wb->copies[0], size), copy_valid(wb->copies[1], size) };
+    uint32_t sequences[2] = { load_le32(&wb->copies[0][WB_SEQ_OFFSET]), load_le32(&wb->copies[1][WB_SEQ_OFFSET]) };
+    if (valid[0] || valid[1]) {
+        unsigned int newest = (valid[0] && valid[1]) ? ((int32_t)(sequences[1] - sequences[0]) > 0) : valid[1];
+        wb->active = newest;
+        wb->sequence = sequences[newest];
+        wb->recovered = true;
+        memcpy(wb->image, wb->copies[newest], size);
+    } else {
+        wb->active = 1U;    // First commit goes to copy 0
+    }
+    return true;
+}
+
+/**
+ * @brief Read from the buffered payload (never touches the device)
+ *
+ * @return true if the range is inside the payload, false otherwise
+ */
+bool atecc_wb_read(const atecc_wb_t *wb, size_t offset, uint8_t *data, size_t length) {
+    if (!wb || !data || offset > wb->capacity || length > wb->capacity - offset) {
+        errno = EINVAL;
+        return false;
+    }
+    memcpy(data, &wb->image[WB_HEADER_SIZE + offset], length);
+    return true;
+}
+
+/**
+ * @brief Update part of the payload, flushing if the size or interval threshold is reached
+ *
+ * @param wb Write-back buffer
+ * @param offset Payload offset
+ * @param data New bytes
+ * @param length Number of bytes
+ * @return true if the update was buffered (and any triggered flush succeeded), false otherwise
+ */
+bool atecc_wb_write(atecc_wb_t *wb, size_t offset, const uint8_t *data, size_t length) {
+    if (!wb || !data || offset > wb->capacity || length > wb->capacity - offset) {
+        errno = EINVAL;
+        return false;
+    }
+    uint64_t start = atecc_now_us();
+
+    wb->stats.updates++;
+    if (length > 0) {
+        wb->stats.through_writes += (offset + length - 1U) / ATECC_SLOT_BLOCK_SIZE - offset / ATECC_SLOT_BLOCK_SIZE + 1U;
+    }
+    uint8_t *target = &wb->image[WB_HEADER_SIZE + offset];
+    if (length > 0 && memcmp(target, data, length) != 0) {
+        memcpy(target, data, length);
+        if (wb->pending == 0) {
+            wb->pending_since_us = start;
+        }
+        wb->pending += length;
+    }
+
+    bool ok = true;
+    if (wb->max_pending > 0 && wb->pending >= wb->max_pending) {
+        ok = wb_commit(wb);
+    } else {
+        ok = atecc_wb_poll(wb);
+    }
+
+    uint64_t elapsed_us = atecc_now_us() - start;
+    wb->stats.update_us_total += elapsed_us;
+    if (elapsed_us > wb->stats.update_us_max) {
+        wb->stats.update_us_max = elapsed_us;
+    }
+    return ok;
+}
+
+/**
+ * @brief Flush if pending updates are older than the configured interval
+ *
+ * Call this periodically when updates stop arriving.
+ *
+ * @return true unless a flush was due and failed
+ */
+bool atecc_wb_poll(atecc_wb_t *wb) {
+    if (!wb || wb->pending == 0 || wb->interval_us == 0 ||
+        atecc_now_us() - wb->pending_since_us < wb->interval_us) {
+        return true;
+    }
+    return wb_commit(wb);
+}
+
+/**
+ * @brief Commit all pending updates now
+ *
+ * @return true if nothing was pending or the commit succeeded, false otherwise
+ */
+bool atecc_wb_sync(atecc_wb_t *wb) {
+    if (!wb) {
+        errno = EINVAL;
+        return false;
+    }
+    return wb->pending == 0 || wb_commit(wb);
+}
+
+/**
+ * @brief Exercise the write-back layer with a counter and rolling-state workload
+ *
+ * Usage: wb-bench <slot> [--updates N] [--period-ms MS] [--interval-ms MS] [--max-pending BYTES] [device]
+ *
+ * Each update increments a 4-byte counter at offset 0; every fourth update
+ * also rewrites a 16-byte rolling state after it.
+ *
+ * @return Process exit status
+ */
+int atecc_wb_bench_main(int argc, char **argv) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: pi_atecc wb-bench <slot> [--updates N] [--period-ms MS] [--interval-ms MS] "
+                        "[--max-pending BYTES] [device]\n");
+        return 2;
+    }
+
+    uint8_t slot = (uint8_t)strtoul(argv[0], NULL, 0);
+    size_t updates = BENCH_UPDATES;
+    unsigned long period_ms = BENCH_PERIOD_MS;
+    uint64_t interval_ms = BENCH_INTERVAL_MS;
+    size_t max_pending = 0;
+    const char *spec = NULL;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--updates") == 0 && has_value) {
+            updates = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--period-ms") == 0 && has_value) {
+            period_ms = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--interval-ms") == 0 && has_value) {
+            interval_ms = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-pending") == 0 && has_value) {
+            max_pending = strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && !spec) {
+            spec = argv[i];
+        } else {
+            fprintf(stderr, "usage: pi_atecc wb-bench <slot> [--updates N] [--period-ms MS] [--interval-ms MS] "
+                            "[--max-pending BYTES] [device]\n");
+            return 2;
+        }
+    }
+
+    atecc_topo_t topo = { .bus = I2C_DEVICE, .address = ATECC_I2C_ADDRESS };
+    if (spec && !atecc_parse_topo(spec, &topo)) {
+        fprintf(stderr, "❌ ERROR: Invalid device address '%s'\n", spec);
+        return 2;
+    }
+    atecc_mux_t mux;
+    atecc_dev_t dev;
+    bool muxed = (topo.mux_address != 0);
+    if (muxed && !atecc_mux_open(&mux, topo.bus, topo.mux_address)) {
+        return 1;
+    }
+    if (!atecc_open_topo(&dev, &topo, &mux)) {
+        if (muxed) {
+            atecc_mux_close(&mux);
+        }
+        return 1;
+    }
+
+    uint8_t counter_bytes[4];
+    atecc_wb_t *wb = malloc(sizeof(*wb));
+    bool opened = wb && atecc_wb_open(wb, &dev, slot, interval_ms, max_pending);
+    if (opened && wb->capacity < sizeof(counter_bytes)) {
+        fprintf(stderr, "wb-bench: slot %u has no room for the %zu-byte counter\n", slot, sizeof(counter_bytes));
+        opened = false;
+    }
+    if (!opened) {
+        free(wb);
+        atecc_close(&dev);
+        if (muxed) {
+            atecc_mux_close(&mux);
+        }
+        return 1;
+    }
+
+    atecc_wb_read(wb, 0, counter_bytes, sizeof(counter_bytes));
+    uint32_t counter = load_le32(counter_bytes);
+    if (wb->recovered) {
+        printf("📂 Slot %u: copy %u, sequence %u, counter %u (%zu payload bytes)\n", slot, wb->active,
+               wb->sequence, counter, wb->capacity);
+    } else {
+        printf("📂 Slot %u: no valid copy, starting empty (%zu payload bytes)\n", slot, wb->capacity);
+    }
+
+    uint8_t state[BENCH_STATE_SIZE] = {0};
+    size_t state_size = wb->capacity - sizeof(counter_bytes);
+    if (state_size > sizeof(state)) {
+        state_size = sizeof(state);
+    }
+    bool ok = true;
+    for (size_t i = 0; ok && i < updates; i++) {
+        store_le32(counter_bytes, ++counter);
+        ok = atecc_wb_write(wb, 0, counter_bytes, sizeof(counter_bytes));
+        if (ok && i % 4U == 3U) {
+            for (size_t k = 0; k < sizeof(state); k++) {
+                state[k] = (uint8_t)(counter * 31U + k);
+            }
+            ok = atecc_wb_write(wb, 4, state, state_size);
+        }
+        if (period_ms > 0) {
+            usleep((useconds_t)(period_ms * 1000U));
+        }
+        ok = ok && atecc_wb_poll(wb);
+    }
+    ok = ok && atecc_wb_sync(wb);
+
+    const atecc_wb_stats_t *stats = &wb->stats;
+    long avoided = (long)stats->through_writes - (long)stats->block_writes;
+    printf("📊 %lu updates: %lu block writes in %lu flushes (write-through: %lu, avoided: %ld)\n",
+           stats->updates, stats->block_writes, stats->flushes, stats->through_writes, avoided);
+    printf("⏱️ Caller latency: mean %.1f us, max %llu us; commit mean %.1f ms\n",
+           stats->updates ? (double)stats->update_us_total / (double)stats->updates : 0.0,
+           (unsigned long long)stats->update_us_max,
+           stats->flushes ? (double)stats->flush_us_total / 1000.0 / (double)stats->flushes : 0.0);
+    printf("%s Slot %u at sequence %u, counter %u\n", ok ? "✅" : "❌", slot, wb->sequence, counter);
+
+    free(wb);
+    atecc_close(&dev);
+    if (muxed) {
+        atecc_mux_close(&mux);
+    }
+    return ok ? 0 : 1;
+}
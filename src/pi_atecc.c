@@ -1,11 +1,13 @@
 #define _DEFAULT_SOURCE
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <time.h>
 #include <sys/ioctl.h>
 #include <linux/i2c-dev.h>
 #include <linux/i2c.h>
@@ -65,6 +67,43 @@ static bool validate_crc(uint8_t *response, size_t length) {
     return (computed_crc[0] == response[length - 2] && computed_crc[1] == response[length - 1]);
 }
 
+static uint16_t crc16_table[256];      // Register update for one byte fed MSB first
+static uint8_t crc16_reflect[256];      // Bit-reversed byte values
+static pthread_once_t crc16_once = PTHREAD_ONCE_INIT;
+
+static void crc16_init(void) {
+    for (unsigned int i = 0; i < 256U; i++) {
+        uint16_t crc = (uint16_t)(i << 8);
+        uint8_t reflected = 0;
+        for (unsigned int bit = 0; bit < 8U; bit++) {
+            crc = (uint16_t)((crc & 0x8000U) ? (uint16_t)(crc << 1) ^ 0x8005U : (uint16_t)(crc << 1));
+            reflected |= (uint8_t)(((i >> bit) & 1U) << (7U - bit));
+        }
+        crc16_table[i] = crc;
+        crc16_reflect[i] = reflected;
+    }
+}
+
+/**
+ * @brief CRC16 of a host buffer, as the device computes it
+ *
+ * Table-driven equivalent of calc_crc16_ccitt() for bulk use: the device
+ * feeds each byte LSB first into an MSB-first register, which is the usual
+ * byte-wise update on the bit-reversed byte.
+ *
+ * @param data Bytes to checksum
+ * @param length Number of bytes
+ * @return CRC value (little-endian byte order on the wire)
+ */
+uint16_t atecc_crc16(const uint8_t *data, size_t length) {
+    pthread_once(&crc16_once, crc16_init);
+    uint16_t crc = 0;
+    for (size_t i = 0; i < length; i++) {
+        crc = (uint16_t)((crc << 8) ^ crc16_table[(crc >> 8) ^ crc16_reflect[data[i]]]);
+    }
+    return crc;
+}
+
 /**
  * @brief Debug function to print expected and computed CRC values
  * 
@@ -86,22 +125,547 @@ static void debug_crc_mismatch(uint8_t *data, size_t length, uint8_t *expected_c
     }
 }
 
+static FILE *trace_file;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static _Thread_local const atecc_dev_t *trace_last_dev;    // Device of this thread's last transfer
+
+static void trace_open(void) {
+    const char *path = getenv("ATECC_TRACE");
+    if (!path || path[0] == '\0') {
+        return;
+    }
+    trace_file = fopen(path, "ae");
+    if (!trace_file) {
+        perror("atecc_trace: cannot open $ATECC_TRACE");
+        return;
+    }
+    setvbuf(trace_file, NULL, _IOLBF, 0);
+}
+
+/**
+ * @brief Transfer trace sink, opened from $ATECC_TRACE on first use
+ *
+ * @return Open trace file, or NULL when tracing is off
+ */
+static FILE *trace_sink(void) {
+    pthread_once(&trace_once, trace_open);
+    return trace_file;
+}
+
+/**
+ * @brief Append one trace line: start and end time, kind, bus, device, bytes
+ *
+ * Kinds are W/R for completed writes/reads, w/r for failed ones (a failed
+ * read records no bytes) and S for a fixed sleep, attributed to the calling
+ * thread's last device. Devices behind a mux are written as MUX.CHANNEL:ADDRESS,
+ * the form atecc_parse_topo() takes. See atecc_trace.c for the analyzer.
+ */
+static void trace_event(FILE *trace, const atecc_dev_t *dev, char kind, uint64_t start_us, const uint8_t *buf,
+                        size_t len) {
+    uint64_t end_us = atecc_now_us();
+    char hex[2U * ATECC_TRACE_MAX_BYTES + 1U];
+    len = (len > ATECC_TRACE_MAX_BYTES) ? ATECC_TRACE_MAX_BYTES : len;
+    atecc_hex(buf, buf ? len : 0, hex, ATECC_HEX_LOWER);
+
+    flockfile(trace);
+    fprintf(trace, "%llu %llu %c %s ", (unsigned long long)start_us, (unsigned long long)end_us, kind, dev->bus);
+    if (dev->mux) {
+        fprintf(trace, "0x%02X.%u:", dev->mux->port.address, dev->mux_channel);
+    }
+    fprintf(trace, "0x%02X %s\n", dev->address, hex);
+    funlockfile(trace);
+    if (kind != 'S') {
+        trace_last_dev = dev;
+    }
+}
+
+/**
+ * @brief Sleep for specified microseconds
+ *
+ * @param microseconds Number of microseconds to sleep
+ */
+static void sleep_us(uint64_t microseconds) {
+    FILE *trace = trace_sink();
+    uint64_t start_us = trace ? atecc_now_us() : 0;
+    usleep((useconds_t)microseconds);
+    if (trace && trace_last_dev) {
+        trace_event(trace, trace_last_dev, 'S', start_us, NULL, 0);
+    }
+}
+
 /**
  * @brief Sleep for specified milliseconds
  * 
  * @param milliseconds Number of milliseconds to sleep
  */
 static void sleep_ms(unsigned int milliseconds) {
-    usleep(milliseconds * 1000U);
+    sleep_us((uint64_t)milliseconds * 1000U);
+}
+
+/**
+ * @brief Monotonic timestamp in microseconds, for timing and benchmarks
+ */
+uint64_t atecc_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U;
+}
+
+/**
+ * @brief Issue a raw SMBus transaction through the i2c-dev I2C_SMBUS ioctl
+ *
+ * @param fd I2C file descriptor (already bound with I2C_SLAVE)
+ * @param read_write I2C_SMBUS_READ or I2C_SMBUS_WRITE
+ * @param command SMBus command byte (the ATECC word address)
+ * @param size SMBus transaction type (I2C_SMBUS_BYTE, I2C_SMBUS_I2C_BLOCK_DATA, ...)
+ * @param data Transaction payload
+ * @return 0 on success, -1 with errno set on failure
+ */
+static int smbus_access(int fd, uint8_t read_write, uint8_t command, uint32_t size, union i2c_smbus_data *data) {
+    struct i2c_smbus_ioctl_data args = {
+        .read_write = read_write,
+        .command    = command,
+        .size       = size,
+        .data       = data
+    };
+    return ioctl(fd, I2C_SMBUS, &args);
+}
+
+/**
+ * @brief Whether an I2C_RDWR failure means the adapter rejects the ioctl itself
+ *
+ * Some USB-I2C bridges advertise I2C_FUNC_I2C but refuse I2C_RDWR; those still
+ * service plain read()/write(), so the transfer is retried with them instead
+ * of failing. The handle keeps I2C_RDWR, so one spurious EINVAL does not
+ * downgrade every later transfer.
+ */
+static bool rdwr_unsupported(int err) {
+    return err == EOPNOTSUPP || err == ENOTTY || err == EINVAL;
+}
+
+/**
+ * @brief Name of a transfer primitive, for diagnostics
+ */
+const char *atecc_xfer_name(atecc_xfer_t xfer) {
+    switch (xfer) {
+    case ATECC_XFER_RDWR:  return "I2C_RDWR";
+    case ATECC_XFER_RAW:   return "read/write";
+    case ATECC_XFER_SMBUS: return "SMBus I2C block";
+    case ATECC_XFER_EMU:   return "emulated";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Open an I2C adapter and negotiate the transfer primitive for an ATECC device
+ *
+ * Queries I2C_FUNCS once and selects I2C_RDWR for full I2C adapters, or SMBus
+ * I2C block transfers for SMBus-only controllers. Adapters that do not implement
+ * I2C_FUNCS are assumed to be plain I2C. Opening generates no bus traffic; the
+ * device is woken by the first command (see atecc_ensure_awake()). Bus names
+ * starting with ATECC_EMU_BUS_PREFIX open an emulated chip instead.
+ *
+ * @param dev Handle to initialize
+ * @param path I2C device file (e.g. "/dev/i2c-1")
+ * @param address 7-bit device address
+ * @return true on success, false otherwise
+ */
+bool atecc_open(atecc_dev_t *dev, const char *path, uint16_t address) {
+    if (!dev || !path) {
+        errno = EINVAL;
+        return false;
+    }
+
+    memset(dev, 0, sizeof(*dev));
+    atomic_init(&dev->snapshot.seq, 0U);
+    if (atecc_emu_bus(path)) {
+        return atecc_emu_attach(dev, path, address);
+    }
+    dev->fd = open(path, O_RDWR);
+    if (dev->fd < 0) {
+        perror("atecc_open: open i2c");
+        return false;
+    }
+
+    if (ioctl(dev->fd, I2C_SLAVE, address) < 0) {
+        perror("atecc_open: I2C_SLAVE");
+        atecc_close(dev);
+        return false;
+    }
+
+    unsigned long funcs = 0;
+    if (ioctl(dev->fd, I2C_FUNCS, &funcs) < 0) {
+        funcs = I2C_FUNC_I2C;
+    }
+
+    dev->address = address;
+    dev->funcs = funcs;
+    snprintf(dev->bus, sizeof(dev->bus), "%s", path);
+
+    if (funcs & I2C_FUNC_I2C) {
+        dev->xfer = ATECC_XFER_RDWR;
+    } else if ((funcs & I2C_FUNC_SMBUS_I2C_BLOCK) == I2C_FUNC_SMBUS_I2C_BLOCK) {
+        dev->xfer = ATECC_XFER_SMBUS;
+    } else {
+        fprintf(stderr, "atecc_open: adapter supports neither I2C nor SMBus I2C block transfers (funcs 0x%08lX)\n",
+                funcs);
+        atecc_close(dev);
+        errno = EOPNOTSUPP;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Close a device handle
+ *
+ * @param dev Handle to close
+ */
+void atecc_close(atecc_dev_t *dev) {
+    if (dev && dev->emu) {
+        atecc_emu_detach(dev);
+    }
+    if (dev && dev->fd >= 0) {
+        close(dev->fd);
+        dev->fd = -1;
+    }
+}
+
+/**
+ * @brief Pick the primitive for one transfer from the adapter's I2C_FUNCS bitmap
+ *
+ * Plain I2C adapters use I2C_RDWR for every transfer. SMBus-only
+ * controllers use SMBus send byte for single-byte writes, I2C block writes
+ * for frames of up to 32 bytes after the word address, and I2C block reads
+ * continued with SMBus receive byte for longer responses. Frames that none
+ * of the adapter's primitives can carry are refused.
+ *
+ * @param dev Device handle
+ * @param len Transfer length, including the word address for writes
+ * @param write Whether the transfer is a write
+ * @param xfer Receives the primitive
+ * @return true if a primitive carries the transfer, false with errno set to EMSGSIZE otherwise
+ */
+static bool transfer_primitive(const atecc_dev_t *dev, size_t len, bool write, atecc_xfer_t *xfer) {
+    if (dev->xfer != ATECC_XFER_SMBUS) {
+        *xfer = dev->xfer;
+        return true;
+    }
+    *xfer = ATECC_XFER_SMBUS;
+    if (write ? (len - 1U <= ATECC_SMBUS_BLOCK_MAX)
+              : (len <= ATECC_SMBUS_BLOCK_MAX || (dev->funcs & I2C_FUNC_SMBUS_READ_BYTE))) {
+        return true;
+    }
+    errno = EMSGSIZE;
+    return false;
+}
+
+/**
+ * @brief Write bytes to the device with the primitive picked for the transfer
+ *
+ * The first byte is the ATECC word address. SMBus adapters carry it as the
+ * command byte of an I2C block write (single-byte writes use SMBus send byte).
+ *
+ * @param dev Device handle
+ * @param buf Bytes to write, starting with the word address
+ * @param len Number of bytes
+ * @return true on success, false with errno set otherwise
+ */
+static bool i2c_write_bus(atecc_dev_t *dev, uint8_t *buf, size_t len) {
+    atecc_xfer_t xfer;
+    if (!transfer_primitive(dev, len, true, &xfer)) {
+        return false;
+    }
+    if (xfer == ATECC_XFER_EMU) {
+        return atecc_emu_write(dev, buf, len);
+    }
+    if (xfer == ATECC_XFER_RDWR) {
+        struct i2c_rdwr_ioctl_data write_data = {0};
+        struct i2c_msg write_msg = {
+            .addr  = dev->address,
+            .flags = 0,
+            .len   = (uint16_t)len,
+            .buf   = buf
+        };
+        write_data.msgs  = &write_msg;
+        write_data.nmsgs = 1;
+        if (ioctl(dev->fd, I2C_RDWR, &write_data) >= 0) {
+            return true;
+        }
+        if (!rdwr_unsupported(errno)) {
+            return false;
+        }
+        xfer = ATECC_XFER_RAW;
+    }
+
+    if (xfer == ATECC_XFER_RAW) {
+        ssize_t written = write(dev->fd, buf, len);
+        if (written < 0) {
+            return false;
+        }
+        if ((size_t)written != len) {
+            errno = EIO;
+            return false;
+        }
+        return true;
+    }
+
+    union i2c_smbus_data data;
+    if (len == 1U && (dev->funcs & I2C_FUNC_SMBUS_WRITE_BYTE)) {
+        return smbus_access(dev->fd, I2C_SMBUS_WRITE, buf[0], I2C_SMBUS_BYTE, NULL) >= 0;
+    }
+    data.block[0] = (uint8_t)(len - 1U);
+    memcpy(&data.block[1], &buf[1], len - 1U);
+    return smbus_access(dev->fd, I2C_SMBUS_WRITE, buf[0], I2C_SMBUS_I2C_BLOCK_DATA, &data) >= 0;
+}
+
+/**
+ * @brief Read bytes from the device with the primitive picked for the transfer
+ *
+ * SMBus adapters read the first 32 bytes with an I2C block read whose command
+ * byte is the reset word address (rewinding the I/O buffer), and fetch any
+ * remainder with SMBus receive byte, which continues from the address counter.
+ *
+ * @param dev Device handle
+ * @param buf Buffer for the received bytes
+ * @param len Number of bytes to read
+ * @return true on success, false with errno set otherwise
+ */
+static bool i2c_read_bus(atecc_dev_t *dev, uint8_t *buf, size_t len) {
+    atecc_xfer_t xfer;
+    if (!transfer_primitive(dev, len, false, &xfer)) {
+        return false;
+    }
+    if (xfer == ATECC_XFER_EMU) {
+        return atecc_emu_read(dev, buf, len);
+    }
+    if (xfer == ATECC_XFER_RDWR) {
+        struct i2c_rdwr_ioctl_data read_data = {0};
+        struct i2c_msg read_msg = {
+            .addr  = dev->address,
+            .flags = I2C_M_RD,
+            .len   = (uint16_t)len,
+            .buf   = buf
+        };
+        read_data.msgs  = &read_msg;
+        read_data.nmsgs = 1;
+        if (ioctl(dev->fd, I2C_RDWR, &read_data) >= 0) {
+            return true;
+        }
+        if (!rdwr_unsupported(errno)) {
+            return false;
+        }
+        xfer = ATECC_XFER_RAW;
+    }
+
+    if (xfer == ATECC_XFER_RAW) {
+        ssize_t received = read(dev->fd, buf, len);
+        if (received < 0) {
+            return false;
+        }
+        if ((size_t)received != len) {
+            errno = EIO;
+            return false;
+        }
+        return true;
+    }
+
+    union i2c_smbus_data data;
+    size_t chunk = (len > ATECC_SMBUS_BLOCK_MAX) ? ATECC_SMBUS_BLOCK_MAX : len;
+    data.block[0] = (uint8_t)chunk;
+    if (smbus_access(dev->fd, I2C_SMBUS_READ, ATECC_WORDADDR_STATUS, I2C_SMBUS_I2C_BLOCK_DATA, &data) < 0) {
+        return false;
+    }
+    memcpy(buf, &data.block[1], chunk);
+
+    for (size_t i = chunk; i < len; i++) {
+        if (smbus_access(dev->fd, I2C_SMBUS_READ, 0, I2C_SMBUS_BYTE, &data) < 0) {
+            return false;
+        }
+        buf[i] = data.byte;
+    }
+    return true;
+}
+
+/**
+ * @brief i2c_write_bus(), recorded to the trace when tracing is on
+ */
+static bool i2c_write_direct(atecc_dev_t *dev, uint8_t *buf, size_t len) {
+    FILE *trace = trace_sink();
+    if (!trace) {
+        return i2c_write_bus(dev, buf, len);
+    }
+    uint64_t start_us = atecc_now_us();
+    bool ok = i2c_write_bus(dev, buf, len);
+    int saved_errno = errno;
+    trace_event(trace, dev, ok ? 'W' : 'w', start_us, buf, len);
+    errno = saved_errno;
+    return ok;
+}
+
+/**
+ * @brief i2c_read_bus(), recorded to the trace when tracing is on
+ */
+static bool i2c_read_direct(atecc_dev_t *dev, uint8_t *buf, size_t len) {
+    FILE *trace = trace_sink();
+    if (!trace) {
+        return i2c_read_bus(dev, buf, len);
+    }
+    uint64_t start_us = atecc_now_us();
+    bool ok = i2c_read_bus(dev, buf, len);
+    int saved_errno = errno;
+    trace_event(trace, dev, ok ? 'R' : 'r', start_us, ok ? buf : NULL, len);
+    errno = saved_errno;
+    return ok;
+}
+
+/**
+ * @brief Whether a transfer error is the device NACKing its address
+ *
+ * Adapters report an unanswered address as EREMOTEIO, ENXIO or EIO; SMBus
+ * emulation on some adapters times out instead.
+ */
+static bool is_nack(int error) {
+    return error == EIO || error == EREMOTEIO || error == ENXIO || error == ETIMEDOUT;
+}
+
+/**
+ * @brief Whether a failed transfer should be retried under a tuning profile
+ *
+ * The device NACKs its address while it executes a command. After a
+ * calibrated command_wait() the transfer is retried every poll_us until the
+ * command's fixed worst-case time has passed.
+ *
+ * @param dev Device handle
+ * @return true after backing off, false to report the failure
+ */
+static bool poll_again(atecc_dev_t *dev) {
+    int saved_errno = errno;
+    if (dev->poll_deadline_us == 0 || atecc_now_us() >= dev->poll_deadline_us || !is_nack(saved_errno)) {
+        return false;
+    }
+    dev->polls++;
+    sleep_us(dev->tune.poll_us);
+    errno = saved_errno;
+    return true;
+}
+
+/**
+ * @brief Write bytes to the device, selecting its mux channel first
+ *
+ * Devices behind a TCA9548A get their channel selected first; the mux is only
+ * written when the channel differs from the one already enabled. The mux lock
+ * is held across select and transfer so threads driving other channels of the
+ * same mux cannot interleave.
+ *
+ * @param dev Device handle
+ * @param buf Bytes to write, starting with the word address
+ * @param len Number of bytes
+ * @return true on success, false with errno set otherwise
+ */
+static bool i2c_write_selected(atecc_dev_t *dev, uint8_t *buf, size_t len) {
+    if (!dev->mux) {
+        return i2c_write_direct(dev, buf, len);
+    }
+
+    pthread_mutex_lock(&dev->mux->lock);
+    bool ok = atecc_mux_select(dev->mux, dev->mux_channel) && i2c_write_direct(dev, buf, len);
+    int saved_errno = errno;
+    pthread_mutex_unlock(&dev->mux->lock);
+    errno = saved_errno;
+    return ok;
+}
+
+/**
+ * @brief Read bytes from the device, selecting its mux channel first
+ *
+ * @param dev Device handle
+ * @param buf Buffer for the received bytes
+ * @param len Number of bytes to read
+ * @return true on success, false with errno set otherwise
+ */
+static bool i2c_read_selected(atecc_dev_t *dev, uint8_t *buf, size_t len) {
+    if (!dev->mux) {
+        return i2c_read_direct(dev, buf, len);
+    }
+
+    pthread_mutex_lock(&dev->mux->lock);
+    bool ok = atecc_mux_select(dev->mux, dev->mux_channel) && i2c_read_direct(dev, buf, len);
+    int saved_errno = errno;
+    pthread_mutex_unlock(&dev->mux->lock);
+    errno = saved_errno;
+    return ok;
+}
+
+/**
+ * @brief Write bytes to the device, polling while a calibrated command completes
+ *
+ * @param dev Device handle
+ * @param buf Bytes to write, starting with the word address
+ * @param len Number of bytes
+ * @return true on success, false with errno set otherwise
+ */
+bool atecc_i2c_write(atecc_dev_t *dev, uint8_t *buf, size_t len) {
+    if (!dev || !buf || len == 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    bool ok;
+    while (!(ok = i2c_write_selected(dev, buf, len)) && poll_again(dev)) {
+    }
+    dev->poll_deadline_us = 0;
+    return ok;
+}
+
+/**
+ * @brief Read bytes from the device, polling while a calibrated command completes
+ *
+ * @param dev Device handle
+ * @param buf Buffer for the received bytes
+ * @param len Number of bytes to read
+ * @return true on success, false with errno set otherwise
+ */
+bool atecc_i2c_read(atecc_dev_t *dev, uint8_t *buf, size_t len) {
+    if (!dev || !buf || len == 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    bool ok;
+    while (!(ok = i2c_read_selected(dev, buf, len)) && poll_again(dev)) {
+    }
+    dev->poll_deadline_us = 0;
+    return ok;
+}
+
+/**
+ * @brief Record the outcome of a command response in the device's health counters
+ *
+ * @param dev Device handle
+ * @param ok Whether a valid response was received
+ * @return ok, so callers can return through it
+ */
+static bool note_result(atecc_dev_t *dev, bool ok) {
+    if (ok) {
+        dev->consecutive_failures = 0;
+        dev->last_ok_us = atecc_now_us();
+    } else {
+        dev->failures++;
+        dev->consecutive_failures++;
+    }
+    atecc_snapshot_publish(dev);
+    return ok;
 }
 
 /**
  * @brief Sends a command to an ATECC device over the I2C bus.
  *
  * This function constructs the command with the given parameters, calculates the CRC16-CCITT checksum,
- * and sends the full command using the I2C file descriptor.
+ * and sends the full command using the transfer primitive negotiated for the device.
  *
- * @param[in] fd The I2C file descriptor.
+ * @param[in] dev The device handle.
  * @param[in] opcode The command opcode to send to the ATECC device.
  * @param[in] param1 The first parameter for the command.
  * @param[in] param2 The second parameter for the command.
@@ -111,7 +675,7 @@ static void sleep_ms(unsigned int milliseconds) {
  * @param[in] resp_max Response buffer size (unused, kept for API compatibility).
  * @return bool Returns true on success, false on failure.
  */
-static bool send_atecc_cmd(int fd, uint8_t opcode, uint8_t param1, uint16_t param2, const uint8_t *data,
+static bool send_atecc_cmd(atecc_dev_t *dev, uint8_t opcode, uint8_t param1, uint16_t param2, const uint8_t *data,
                     uint8_t data_len, uint8_t *resp, uint16_t resp_max) {
     (void)resp;
     (void)resp_max;
@@ -142,33 +706,59 @@ static bool send_atecc_cmd(int fd, uint8_t opcode, uint8_t param1, uint16_t para
     full_command[0] = ATECC_WORDADDR_CMD;
     memcpy(&full_command[1], command, sizeof(command));
 
-    struct i2c_rdwr_ioctl_data write_data = {0};
-    struct i2c_msg write_msg = {
-        .addr  = ATECC_I2C_ADDRESS,
-        .flags = 0,
-        .len   = (uint16_t)sizeof(full_command),
-        .buf   = full_command
-    };
-    write_data.msgs  = &write_msg;
-    write_data.nmsgs = 1;
-    if (ioctl(fd, I2C_RDWR, &write_data) < 0 && errno != EIO && errno != EREMOTEIO) {
-        perror("send_atecc_cmd: I2C write failed");
+    atecc_xfer_t xfer;
+    if (!transfer_primitive(dev, sizeof(full_command), true, &xfer)) {
+        fprintf(stderr, "send_atecc_cmd: command 0x%02X needs a %zu-byte write, the adapter's SMBus block writes "
+                        "carry at most %d\n", opcode, sizeof(full_command), ATECC_SMBUS_BLOCK_MAX + 1);
         return false;
     }
+    if (!atecc_i2c_write(dev, full_command, sizeof(full_command))) {
+        perror("send_atecc_cmd: I2C write failed");
+        return note_result(dev, false);
+    }
 
+    dev->commands++;
+    dev->last_opcode = opcode;
+    dev->last_mode = param1;
+    dev->sent_us = atecc_now_us();
     return true;
 }
 
+/**
+ * @brief Wait for the command just sent to complete
+ *
+ * Without a tuning entry for the command this is the fixed worst-case sleep.
+ * With one, it sleeps until the calibrated ready time and lets the next
+ * transfer poll until the worst case has passed (see poll_again()).
+ *
+ * @param dev Device handle
+ * @param max_ms Worst-case execution time of the command
+ */
+static void command_wait(atecc_dev_t *dev, unsigned int max_ms) {
+    uint32_t ready_us = atecc_tune_ready_us(&dev->tune, dev->last_opcode, dev->last_mode);
+    if (ready_us == 0U || ready_us >= max_ms * 1000U) {
+        sleep_ms(max_ms);
+        return;
+    }
+
+    uint64_t now_us = atecc_now_us();
+    uint64_t ready_at_us = dev->sent_us + ready_us;
+    if (ready_at_us > now_us) {
+        sleep_us(ready_at_us - now_us);
+    }
+    dev->poll_deadline_us = dev->sent_us + (uint64_t)max_ms * 1000U;
+}
+
 /**
  * @brief Receives a response from an ATECC device over the I2C bus.
  * 
- * @param fd I2C file descriptor
+ * @param dev Device handle
  * @param buffer Buffer to store the received response
  * @param length Expected length of the response data
  * @param full_response Whether to read the full response including CRC
  * @return true if response received successfully, false otherwise
  */
-static bool receive_atecc_response(int fd, uint8_t *buffer, size_t length, bool full_response) {
+static bool read_atecc_response(atecc_dev_t *dev, uint8_t *buffer, size_t length, bool full_response) {
     if (!buffer || length == 0) {
         errno = EINVAL;
         return false;
@@ -182,16 +772,7 @@ static bool receive_atecc_response(int fd, uint8_t *buffer, size_t length, bool
     }
 
     // Read response from I2C bus
-    struct i2c_rdwr_ioctl_data read_data = {0};
-    struct i2c_msg read_msg = {
-        .addr  = ATECC_I2C_ADDRESS,
-        .flags = I2C_M_RD,
-        .len   = (uint16_t)read_length,
-        .buf   = response
-    };
-    read_data.msgs  = &read_msg;
-    read_data.nmsgs = 1;
-    if (ioctl(fd, I2C_RDWR, &read_data) < 0 && errno != EIO && errno != EREMOTEIO) {
+    if (!atecc_i2c_read(dev, response, read_length)) {
         perror("receive_atecc_response: I2C read failed");
         return false;
     }
@@ -222,48 +803,40 @@ static bool receive_atecc_response(int fd, uint8_t *buffer, size_t length, bool
     return true;
 }
 
+static bool receive_atecc_response(atecc_dev_t *dev, uint8_t *buffer, size_t length, bool full_response) {
+    return note_result(dev, read_atecc_response(dev, buffer, length, full_response));
+}
+
 /**
  * @brief Wake the ATECC device from sleep
+ *
+ * Silent on success: commands wake the chip lazily, so anything printed here
+ * would end up inside their stdout output. Failures go to stderr.
  * 
- * @param fd I2C file descriptor
+ * @param dev Device handle
  * @return true if wake successful, false otherwise
  */
-static bool atecc_wake(int fd) {
+bool atecc_wake(atecc_dev_t *dev) {
     uint8_t wake_token[1] = {ATECC_WAKE_TOKEN};
 
-    printf("⏰ Sending wake command...\n");
-
-    struct i2c_rdwr_ioctl_data wake_data = {0};
-    struct i2c_msg wake_msg = {
-        .addr  = ATECC_I2C_ADDRESS,
-        .flags = 0,
-        .len   = 1,
-        .buf   = wake_token
-    };
-    wake_data.msgs  = &wake_msg;
-    wake_data.nmsgs = 1;
-
-    if (ioctl(fd, I2C_RDWR, &wake_data) < 0 && errno != EIO && errno != EREMOTEIO) {
+    // The wake token is clocked at a sleeping chip, which does not ACK it
+    if (!atecc_i2c_write(dev, wake_token, sizeof(wake_token)) && errno != EIO && errno != EREMOTEIO) {
         perror("atecc_wake: I2C write failed");
         return false;
     }
 
-    // Wait for device to wake up
-    sleep_ms(10);
+    // Wait for device to wake up: the fixed 10 ms, or the calibrated time and polling
+    uint64_t token_us = atecc_now_us();
+    if (dev->tune.loaded && dev->tune.wake_us > 0U && dev->tune.wake_us < 10000U) {
+        sleep_us(dev->tune.wake_us);
+        dev->poll_deadline_us = token_us + 10000U;
+    } else {
+        sleep_ms(10);
+    }
 
     // Read wake response
     uint8_t response[4] = {0};
-    struct i2c_rdwr_ioctl_data read_data = {0};
-    struct i2c_msg read_msg = {
-        .addr  = ATECC_I2C_ADDRESS,
-        .flags = I2C_M_RD,
-        .len   = sizeof(response),
-        .buf   = response
-    };
-    read_data.msgs  = &read_msg;
-    read_data.nmsgs = 1;
-
-    if (ioctl(fd, I2C_RDWR, &read_data) < 0) {
+    if (!atecc_i2c_read(dev, response, sizeof(response))) {
         perror("atecc_wake: I2C read failed");
         return false;
     }
@@ -275,12 +848,52 @@ static bool atecc_wake(int fd) {
         return false;
     }
 
-    printf("📬 Wake response: ");
-    for (size_t i = 0; i < sizeof(response); i++) {
-        printf("%02X ", response[i]);
+    return true;
+}
+
+/**
+ * @brief Wake the device on demand and verify its identity once per handle
+ *
+ * Does not wake a device that is inside the watchdog window of its last
+ * wake. Until the serial number has been read back from this device, it is
+ * read on every call; if it differs from a cached identity (e.g. from
+ * atecc_cache_load()), the cached config is dropped. On success
+ * dev->identity_verified is always set.
+ *
+ * @param dev Device handle
+ * @return true if the device is awake, false otherwise
+ */
+bool atecc_ensure_awake(atecc_dev_t *dev) {
+    if (!dev || dev->fd < 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    if (!dev->awake || atecc_now_us() - dev->woke_at_us >= ATECC_AWAKE_WINDOW_US) {
+        dev->awake = false;
+        if (!atecc_wake(dev)) {
+            return note_result(dev, false);
+        }
+        dev->awake = true;
+        dev->woke_at_us = atecc_now_us();
+    }
+
+    if (!dev->identity_verified) {
+        uint8_t serial[ATECC_SERIAL_NUMBER_SIZE] = {0};
+        if (!atecc_read_serial(dev, serial)) {
+            fprintf(stderr, "atecc_ensure_awake: identity verification failed\n");
+            return false;
+        }
+        if (dev->identity_valid && memcmp(serial, dev->serial, sizeof(serial)) != 0) {
+            fprintf(stderr, "atecc_ensure_awake: serial number changed, dropping cached config\n");
+            dev->config_valid = false;
+        }
+        memcpy(dev->serial, serial, sizeof(serial));
+        dev->identity_valid = true;
+        dev->identity_verified = true;
+        atecc_tune_load(dev);
+        atecc_snapshot_publish(dev);
     }
-    printf("\n");
-    printf("✅ ATECC608A is awake!\n");
 
     return true;
 }
@@ -288,22 +901,13 @@ static bool atecc_wake(int fd) {
 /**
  * @brief Put the ATECC device to sleep
  * 
- * @param fd I2C file descriptor
+ * @param dev Device handle
  * @return true if sleep command successful, false otherwise
  */
-static bool atecc_sleep(int fd) {
+static bool atecc_sleep(atecc_dev_t *dev) {
     uint8_t sleep_cmd = ATECC_CMD_SLEEP;
-    struct i2c_rdwr_ioctl_data sleep_data = {0};
-    struct i2c_msg sleep_msg = {
-        .addr  = ATECC_I2C_ADDRESS,
-        .flags = 0,
-        .len   = 1,
-        .buf   = &sleep_cmd
-    };
-    sleep_data.msgs  = &sleep_msg;
-    sleep_data.nmsgs = 1;
-
-    if (ioctl(fd, I2C_RDWR, &sleep_data) < 0) {
+    dev->awake = false;
+    if (!atecc_i2c_write(dev, &sleep_cmd, 1)) {
         perror("atecc_sleep: I2C write failed");
         return false;
     }
@@ -313,54 +917,178 @@ static bool atecc_sleep(int fd) {
 }
 
 /**
- * @brief Read the serial number from the ATECC device
- * 
- * @param fd I2C file descriptor
- * @param serial_number Buffer to store the serial number (must be at least ATECC_SERIAL_NUMBER_SIZE bytes)
- * @return true if successful, false otherwise
+ * @brief Make sure the device stays awake for at least the next needed_us
+ *
+ * When less than needed_us of the watchdog window is left, the device is put
+ * to sleep and woken again, so a sequence that keeps state in the device
+ * (SHA, Nonce + Sign) does not straddle a watchdog expiry.
+ *
+ * @param dev Device handle
+ * @param needed_us Time the next command sequence needs
+ * @return true if the device is awake, false otherwise
  */
-static bool read_atecc_serial_number(int fd, uint8_t *serial_number) {
-    if (!serial_number) {
+bool atecc_keep_awake(atecc_dev_t *dev, uint64_t needed_us) {
+    if (dev && dev->awake && atecc_now_us() - dev->woke_at_us + needed_us > ATECC_AWAKE_WINDOW_US) {
+        atecc_sleep(dev);
+    }
+    return atecc_ensure_awake(dev);
+}
+
+/**
+ * @brief Run one command and time its completion by polling for the response
+ *
+ * The response is read back to back from the end of the command write, so
+ * ready_us is the completion time to within one NACKed read. Used by
+ * `pi_atecc calibrate`; ordinary commands wait through command_wait().
+ *
+ * @param dev Device handle
+ * @param opcode Command opcode
+ * @param mode Command param1
+ * @param param2 Command param2
+ * @param data Command data (may be NULL when data_len is 0)
+ * @param data_len Command data length
+ * @param response Receives the response packet (count, data, CRC)
+ * @param response_len Expected response length including count and CRC
+ * @param max_us Give up when no response arrived after this long
+ * @param timing Receives the measured timing
+ * @return true if a response with a valid CRC arrived, false otherwise
+ */
+bool atecc_time_command(atecc_dev_t *dev, uint8_t opcode, uint8_t mode, uint16_t param2, const uint8_t *data,
+                        uint8_t data_len, uint8_t *response, size_t response_len, uint32_t max_us,
+                        atecc_cmd_timing_t *timing) {
+    if (!response || response_len < 4U || response_len > ATECC_RESPONSE_SIZE || !timing) {
         errno = EINVAL;
         return false;
     }
+    memset(timing, 0, sizeof(*timing));
+
+    if (!atecc_ensure_awake(dev) || !send_atecc_cmd(dev, opcode, mode, param2, data, data_len, NULL, 0)) {
+        return false;
+    }
+
+    uint64_t start_us;
+    uint64_t end_us;
+    for (;;) {
+        start_us = atecc_now_us();
+        bool ok = atecc_i2c_read(dev, response, response_len);
+        end_us = atecc_now_us();
+        if (ok) {
+            break;
+        }
+        if (!is_nack(errno) || end_us - dev->sent_us >= max_us) {
+            return note_result(dev, false);
+        }
+        timing->polls++;
+        timing->poll_us += (uint32_t)(end_us - start_us);
+    }
+    timing->ready_us = (uint32_t)(start_us - dev->sent_us);
+    timing->read_us = (uint32_t)(end_us - start_us);
+
+    uint8_t count = response[0];
+    if (count < 4U || count > response_len || !validate_crc(response, count)) {
+        errno = EIO;
+        return note_result(dev, false);
+    }
+    timing->status = (count == 4U) ? response[1] : ATECC_STATUS_SUCCESS;
+    return note_result(dev, true);
+}
 
-    uint8_t serial[ATECC_SERIAL_NUMBER_SIZE] = {0};
-    uint8_t last_response[4] = {0};
+/**
+ * @brief Put the device to sleep, wake it and time the wake response
+ *
+ * @param dev Device handle
+ * @param max_us Give up when no wake response arrived after this long
+ * @param wake_us Receives the time from wake token to the start of the first successful read
+ * @return true if a valid wake response arrived, false otherwise
+ */
+bool atecc_time_wake(atecc_dev_t *dev, uint32_t max_us, uint32_t *wake_us) {
+    if (!dev || dev->fd < 0 || !wake_us) {
+        errno = EINVAL;
+        return false;
+    }
 
-    if (!send_atecc_cmd(fd, ATECC_CMD_READ, 0x00, 0x0000, NULL, 0, NULL, 0)) {
+    atecc_sleep(dev);
+    uint8_t wake_token[1] = {ATECC_WAKE_TOKEN};
+    if (!atecc_i2c_write(dev, wake_token, sizeof(wake_token)) && errno != EIO && errno != EREMOTEIO) {
+        perror("atecc_time_wake: I2C write failed");
         return false;
     }
-    sleep_ms(5);
-    
-    if (!receive_atecc_response(fd, &serial[0], 4, true)) {
+    uint64_t token_us = atecc_now_us();
+
+    uint8_t response[4] = {0};
+    uint64_t start_us;
+    for (;;) {
+        start_us = atecc_now_us();
+        if (atecc_i2c_read(dev, response, sizeof(response))) {
+            break;
+        }
+        if (!is_nack(errno) || atecc_now_us() - token_us >= max_us) {
+            return false;
+        }
+    }
+
+    if (response[0] != 0x04 || response[1] != ATECC_STATUS_WAKE) {
+        errno = EIO;
         return false;
     }
+    *wake_us = (uint32_t)(start_us - token_us);
+    dev->awake = true;
+    dev->woke_at_us = token_us;
+    return true;
+}
 
-    if (!send_atecc_cmd(fd, ATECC_CMD_READ, 0x00, 0x0002, NULL, 0, NULL, 0)) {
+/**
+ * @brief Read the serial number with a single 32-byte config zone read, without printing
+ *
+ * SN[0:3] live at config bytes 0-3 and SN[4:8] at bytes 8-12, so one block
+ * read replaces three word reads.
+ *
+ * @param dev Device handle
+ * @param serial Buffer of at least ATECC_SERIAL_NUMBER_SIZE bytes
+ * @return true if successful, false otherwise
+ */
+bool atecc_read_serial(atecc_dev_t *dev, uint8_t *serial) {
+    if (!serial) {
+        errno = EINVAL;
         return false;
     }
-    sleep_ms(5);
 
-    if (!receive_atecc_response(fd, &serial[4], 4, true)) {
+    uint8_t block[32] = {0};
+    if (!send_atecc_cmd(dev, ATECC_CMD_READ, ATECC_ZONE_READ_32, 0x0000, NULL, 0, NULL, 0)) {
         return false;
     }
+    command_wait(dev, 5);
 
-    if (!send_atecc_cmd(fd, ATECC_CMD_READ, 0x00, 0x0003, NULL, 0, NULL, 0)) {
+    if (!receive_atecc_response(dev, block, sizeof(block), true)) {
         return false;
     }
-    sleep_ms(5);
 
-    if (!receive_atecc_response(fd, last_response, 4, true)) {
+    memcpy(&serial[0], &block[0], 4);
+    memcpy(&serial[4], &block[8], 5);
+    return true;
+}
+
+/**
+ * @brief Read the serial number from the ATECC device
+ * 
+ * @param dev Device handle
+ * @param serial_number Buffer to store the serial number (must be at least ATECC_SERIAL_NUMBER_SIZE bytes)
+ * @return true if successful, false otherwise
+ */
+static bool read_atecc_serial_number(atecc_dev_t *dev, uint8_t *serial_number) {
+    if (!serial_number) {
+        errno = EINVAL;
         return false;
     }
 
-    serial[8] = last_response[0];
-    printf("🆔 Serial Number: ");
-    for (int i = 0; i < (int)sizeof(serial); i++) {
-        printf("%02X", serial[i]);
+    // Waking verifies identity, which leaves the serial number cached in the handle
+    if (!atecc_ensure_awake(dev)) {
+        return false;
     }
-    printf("\n");
+
+    char serial_hex[2U * ATECC_SERIAL_NUMBER_SIZE + 1U];
+    atecc_hex(dev->serial, ATECC_SERIAL_NUMBER_SIZE, serial_hex, ATECC_HEX_UPPER);
+    printf("🆔 Serial Number: %s\n", serial_hex);
 
     return true;
 }
@@ -390,14 +1118,17 @@ static uint64_t map_random_to_range(uint8_t *random_bytes, uint64_t min, uint64_
  * @param min The minimum value (inclusive)
  * @param max The maximum value (exclusive)
  */
-static bool genrate_random_number_in_range(int fd,uint64_t min, uint64_t max) {
+static bool genrate_random_number_in_range(atecc_dev_t *dev, uint64_t min, uint64_t max) {
     uint8_t resp[32] = {0};
-    if (!send_atecc_cmd(fd, ATECC_CMD_RANDOM, 0x00, 0x0000, NULL, 0, NULL, 0)) {
+    if (!atecc_ensure_awake(dev)) {
         return false;
     }
-    sleep_ms(50);
+    if (!send_atecc_cmd(dev, ATECC_CMD_RANDOM, 0x00, 0x0000, NULL, 0, NULL, 0)) {
+        return false;
+    }
+    command_wait(dev, 50);
 
-    if (!receive_atecc_response(fd, resp, sizeof(resp), true)) {
+    if (!receive_atecc_response(dev, resp, sizeof(resp), true)) {
         printf("Failed to receive random number\n");
         return false;
     }
@@ -409,111 +1140,167 @@ static bool genrate_random_number_in_range(int fd,uint64_t min, uint64_t max) {
     return true;
 }
 
+/**
+ * @brief Fetch 32 random bytes from the device without printing them
+ *
+ * @param dev Device handle
+ * @param out Buffer of at least 32 bytes
+ * @return true if successful, false otherwise
+ */
+bool atecc_random(atecc_dev_t *dev, uint8_t *out) {
+    if (!out) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+    if (!send_atecc_cmd(dev, ATECC_CMD_RANDOM, 0x00, 0x0000, NULL, 0, NULL, 0)) {
+        return false;
+    }
+    command_wait(dev, 50);
+
+    return receive_atecc_response(dev, out, 32, true);
+}
+
 /**
  * @brief Generate a random value of specified length
  * 
- * @param fd I2C file descriptor
+ * @param dev Device handle
  * @param length Length of random value to generate (max 31)
  * @return true if successful, false otherwise
  */
-static bool generate_random_value(int fd, uint8_t length) {
+static bool generate_random_value(atecc_dev_t *dev, uint8_t length) {
     uint8_t resp[32] = {0};
     if (length > sizeof(resp) - 1) {
         errno = EINVAL;
         return false;
     }
-    if (!send_atecc_cmd(fd, ATECC_CMD_RANDOM, 0x00, 0x0000, NULL, 0, NULL, 0)) {
+    if (!atecc_ensure_awake(dev)) {
         return false;
     }
-    sleep_ms(50);
-
-    if (!receive_atecc_response(fd, resp, length, true)) {
+    if (!send_atecc_cmd(dev, ATECC_CMD_RANDOM, 0x00, 0x0000, NULL, 0, NULL, 0)) {
         return false;
     }
+    command_wait(dev, 50);
 
-    printf("🎰 Random Value: ");
-    for (uint8_t i = 0; i < length; i++) {
-        printf("%02X ", resp[i]);
+    if (!receive_atecc_response(dev, resp, length, true)) {
+        return false;
     }
-    printf("\n");
+
+    char random_hex[3U * UINT8_MAX];
+    atecc_hex(resp, length, random_hex, ATECC_HEX_SPACED);
+    printf("🎰 Random Value: %s\n", random_hex);
 
     return true;
 }
 
 /**
- * @brief Computes the SHA-256 hash of the given data using the ATECC device.
- * @param fd I2C file descriptor
- * @param data Pointer to the data to hash
+ * @brief Compute SHA-256 on the device (Start, 64-byte Updates, End)
+ *
+ * The device keeps the hash state between commands, so the whole sequence
+ * must run inside one awake period; see atecc_keep_awake().
+ *
+ * @param dev Device handle
+ * @param data Data to hash
+ * @param data_len Number of bytes
+ * @param output Receives the 32-byte digest
+ * @return true if successful, false otherwise
  */
-static bool compute_sha256(int fd, const uint8_t *data, size_t data_len, uint8_t *output) {
+bool atecc_sha256(atecc_dev_t *dev, const uint8_t *data, size_t data_len, uint8_t *output) {
     if (!output || (!data && data_len != 0U)) {
         errno = EINVAL;
         return false;
     }
 
-    if (!send_atecc_cmd(fd, ATECC_CMD_SHA, 0x00, 0x0000, NULL, 0, NULL, 0)) {
-        fprintf(stderr, "compute_sha256: SHA start command failed\n");
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+
+    if (!send_atecc_cmd(dev, ATECC_CMD_SHA, 0x00, 0x0000, NULL, 0, NULL, 0)) {
+        fprintf(stderr, "atecc_sha256: SHA start command failed\n");
         return false;
     }
-    sleep_ms(5);
+    command_wait(dev, 5);
 
     size_t offset = 0U;
     while ((data_len - offset) >= 64U) {
-        if (!send_atecc_cmd(fd, ATECC_CMD_SHA, 0x01, 0x0000, &data[offset], (uint8_t)64, NULL, 0)) {
-            fprintf(stderr, "compute_sha256: SHA update failed at offset %zu\n", offset);
+        if (!send_atecc_cmd(dev, ATECC_CMD_SHA, 0x01, 0x0000, &data[offset], (uint8_t)64, NULL, 0)) {
+            fprintf(stderr, "atecc_sha256: SHA update failed at offset %zu\n", offset);
             return false;
         }
         offset += 64U;
-        sleep_ms(5);
+        command_wait(dev, 5);
     }
 
     uint8_t remaining = (uint8_t)(data_len - offset);
     const uint8_t *final_block = (remaining > 0U) ? &data[offset] : NULL;
-    if (!send_atecc_cmd(fd, ATECC_CMD_SHA, 0x02, (uint16_t)remaining, final_block, remaining, NULL, 0)) {
-        fprintf(stderr, "compute_sha256: SHA end command failed\n");
+    if (!send_atecc_cmd(dev, ATECC_CMD_SHA, 0x02, (uint16_t)remaining, final_block, remaining, NULL, 0)) {
+        fprintf(stderr, "atecc_sha256: SHA end command failed\n");
         return false;
     }
-    sleep_ms(5);
+    command_wait(dev, 5);
 
     uint8_t response[35] = {0};
-    struct i2c_rdwr_ioctl_data read_data = {0};
-    struct i2c_msg read_msg = {
-        .addr  = ATECC_I2C_ADDRESS,
-        .flags = I2C_M_RD,
-        .len   = (uint16_t)sizeof(response),
-        .buf   = response
-    };
-    read_data.msgs = &read_msg;
-    read_data.nmsgs = 1;
-    if (ioctl(fd, I2C_RDWR, &read_data) < 0) {
-        perror("compute_sha256: I2C read failed");
+    if (!atecc_i2c_read(dev, response, sizeof(response))) {
+        perror("atecc_sha256: I2C read failed");
         return false;
     }
 
     uint8_t count = response[0];
     if (count != 0x23U || count > sizeof(response) || count < 3U) {
         errno = EIO;
-        fprintf(stderr, "compute_sha256: invalid response count 0x%02X\n", count);
+        fprintf(stderr, "atecc_sha256: invalid response count 0x%02X\n", count);
         return false;
     }
 
     if (!validate_crc(response, (size_t)count)) {
-        fprintf(stderr, "compute_sha256: CRC validation failed\n");
+        fprintf(stderr, "atecc_sha256: CRC validation failed\n");
         debug_crc_mismatch(response, (size_t)count, &response[count - 2]);
         return false;
     }
 
     memcpy(output, &response[1], 32);
+    return true;
+}
 
-    printf("🔒 SHA-256: ");
-    for (size_t i = 0; i < 32; i++) {
-        printf("%02X", output[i]);
+/**
+ * @brief Computes the SHA-256 hash of the given data using the ATECC device and prints it.
+ * @param dev Device handle
+ * @param data Pointer to the data to hash
+ */
+static bool compute_sha256(atecc_dev_t *dev, const uint8_t *data, size_t data_len, uint8_t *output) {
+    if (!atecc_sha256(dev, data, data_len, output)) {
+        return false;
     }
-    printf("\n");
+
+    char digest_hex[2U * 32U + 1U];
+    atecc_hex(output, 32, digest_hex, ATECC_HEX_UPPER);
+    printf("🔒 SHA-256: %s\n", digest_hex);
 
     return true;
 }
 
+/**
+ * @brief Whether dev->config can be used instead of reading the config zone
+ *
+ * A config loaded by atecc_cache_load() belongs to whichever chip last sat
+ * at this address, so it is only used once atecc_ensure_awake() has read
+ * the serial number back from this chip (which drops it on a mismatch).
+ *
+ * @param dev Device handle
+ * @return true if dev->config holds this chip's config zone
+ */
+static bool cached_config_usable(atecc_dev_t *dev) {
+    if (!dev->config_valid) {
+        return false;
+    }
+    if (!dev->identity_verified && !atecc_ensure_awake(dev)) {
+        return false;
+    }
+    return dev->config_valid;
+}
+
 /**
  * @brief Reads the configuration of a specific slot from the ATECC608A device over I2C bus.
  *
@@ -523,28 +1310,32 @@ static bool compute_sha256(int fd, const uint8_t *data, size_t data_len, uint8_t
  * @param slot The slot number for which to read the configuration.
  * @return true if the slot configuration is successfully read, false otherwise.
  */
-bool read_slot_config(int fd, uint8_t slot) {
+bool read_slot_config(atecc_dev_t *dev, uint8_t slot) {
     uint8_t raw[7] = {0};
 
     printf("🔎 Checking Slot %d Configuration...\n", slot);
 
-    if (!send_atecc_cmd(fd, ATECC_CMD_READ, 0x00, slot, NULL, 0, NULL, 0)) {
-        perror("read_slot_config: I2C write failed");
+    if (cached_config_usable(dev) && slot < ATECC_CONFIG_SIZE / 4U) {
+        // Rebuild the frame the device would return from the cached config
+        raw[0] = 0x07;
+        memcpy(&raw[1], &dev->config[slot * 4U], 4);
+        compute_crc(5, raw, &raw[5]);
+        printf("🔎 Slot %d Config Data: %02X %02X %02X %02X\n",
+               slot, raw[0], raw[1], raw[2], raw[3]);
+        return true;
+    }
+
+    if (!atecc_ensure_awake(dev)) {
         return false;
     }
-    sleep_ms(20);
 
-    struct i2c_rdwr_ioctl_data read_data = {0};
-    struct i2c_msg read_msg = {
-        .addr  = ATECC_I2C_ADDRESS,
-        .flags = I2C_M_RD,
-        .len   = (uint16_t)sizeof(raw),
-        .buf   = raw
-    };
-    read_data.msgs  = &read_msg;
-    read_data.nmsgs = 1;
+    if (!send_atecc_cmd(dev, ATECC_CMD_READ, 0x00, slot, NULL, 0, NULL, 0)) {
+        perror("read_slot_config: I2C write failed");
+        return false;
+    }
+    command_wait(dev, 20);
 
-    if (ioctl(fd, I2C_RDWR, &read_data) < 0 && errno != EIO && errno != EREMOTEIO) {
+    if (!atecc_i2c_read(dev, raw, sizeof(raw))) {
         perror("read_slot_config: I2C read failed");
         return false;
     }
@@ -568,28 +1359,45 @@ bool read_slot_config(int fd, uint8_t slot) {
 }
 
 /**
- * @brief Reads the configuration data of all slots from the ATECC608A device over I2C bus.
+ * @brief Print the config zone as rows of 16 hex bytes
+ */
+static void print_config_rows(const uint8_t *config_data) {
+    char row_hex[3U * 16U];
+    for (size_t row = 0; row < ATECC_CONFIG_SIZE; row += 16U) {
+        atecc_hex(&config_data[row], 16, row_hex, ATECC_HEX_SPACED);
+        printf("%s\n", row_hex);
+    }
+}
+
+/**
+ * @brief Read the config zone into the handle's cache without printing
  *
- * This function reads the configuration data of all slots from the ATECC608A device by sending read commands
- * and receiving responses. It then prints the configuration data in hexadecimal format.
+ * A config zone already cached in the handle is kept as is. A freshly read
+ * zone is also written to the on-disk cache once it is locked.
  *
- * @return true if the configuration data is successfully read, false otherwise.
+ * @param dev Device handle
+ * @return true if dev->config holds the config zone, false otherwise
  */
-bool read_config_zone(int fd) {
-    enum { CONFIG_SIZE = 128U, BYTES_PER_BLOCK = 4U, BLOCK_COUNT = CONFIG_SIZE / BYTES_PER_BLOCK };
-    uint8_t config_data[CONFIG_SIZE] = {0};
+bool atecc_read_config(atecc_dev_t *dev) {
+    enum { BYTES_PER_BLOCK = 4U, BLOCK_COUNT = ATECC_CONFIG_SIZE / BYTES_PER_BLOCK };
+    uint8_t config_data[ATECC_CONFIG_SIZE] = {0};
 
-    printf("🔎 Reading Configuration Data...\n");
+    if (cached_config_usable(dev)) {
+        return true;
+    }
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
 
     for (uint8_t block = 0; block < BLOCK_COUNT; ++block) {
-        if (!send_atecc_cmd(fd, ATECC_CMD_READ, 0x00, block, NULL, 0, NULL, 0)) {
+        if (!send_atecc_cmd(dev, ATECC_CMD_READ, 0x00, block, NULL, 0, NULL, 0)) {
             fprintf(stderr, "❌ ERROR: Failed to send read command for block %u\n", block);
             return false;
         }
-        sleep_ms(20);
+        command_wait(dev, 20);
 
         uint8_t block_data[BYTES_PER_BLOCK] = {0};
-        if (!receive_atecc_response(fd, block_data, BYTES_PER_BLOCK, true)) {
+        if (!receive_atecc_response(dev, block_data, BYTES_PER_BLOCK, true)) {
             fprintf(stderr, "❌ ERROR: Failed to read configuration for block %u\n", block);
             return false;
         }
@@ -597,78 +1405,42 @@ bool read_config_zone(int fd) {
         memcpy(&config_data[block * BYTES_PER_BLOCK], block_data, BYTES_PER_BLOCK);
     }
 
-    for (size_t i = 0; i < CONFIG_SIZE; ++i) {
-        printf("%02X%s", config_data[i], ((i + 1U) % 16U == 0U) ? "\n" : " ");
-    }
-
+    memcpy(dev->config, config_data, ATECC_CONFIG_SIZE);
+    dev->config_valid = true;
+    atecc_cache_store(dev);
+    atecc_snapshot_publish(dev);
     return true;
 }
 
 /**
- * @brief Checks the lock status of the ATECC608A device.
+ * @brief Reads the configuration data of all slots from the ATECC608A device over I2C bus.
  *
- * This function checks the lock status of the ATECC608A device by sending read commands
- * and receiving responses. It then prints the lock status of the device.
+ * This function reads the configuration data of all slots from the ATECC608A device by sending read commands
+ * and receiving responses. It then prints the configuration data in hexadecimal format. A config zone already
+ * cached in the handle is printed without touching the bus.
  *
- * @return true if the lock status is successfully checked, false otherwise.
+ * @return true if the configuration data is successfully read, false otherwise.
  */
-bool check_lock_status(int fd) {
-    uint8_t raw[7] = {0};
-    uint8_t lock_bytes[4] = {0};
-    uint8_t expected_address = 0x15;  // Correct address for lock bytes
-    
-    // 🔹 Send read command for lock status at word address 0x15
-    printf("🔍 Checking ATECC608A Lock Status...\n");
-    if (!send_atecc_cmd(fd, ATECC_CMD_READ, 0x00, expected_address, NULL, 0, NULL, 0)) {
-        printf("❌ ERROR: Failed to send lock status read command!\n");
-        return false;
-    }
-
-    sleep_ms(23);
-
-    struct i2c_rdwr_ioctl_data read_data = {0};
-    struct i2c_msg read_msg = {
-        .addr  = ATECC_I2C_ADDRESS,
-        .flags = I2C_M_RD,
-        .len   = (uint16_t)sizeof(raw),
-        .buf   = raw
-    };
-    read_data.msgs = &read_msg;
-    read_data.nmsgs = 1;
+bool read_config_zone(atecc_dev_t *dev) {
+    printf("🔎 Reading Configuration Data...\n");
 
-    if (ioctl(fd, I2C_RDWR, &read_data) < 0 && errno != EIO && errno != EREMOTEIO) {
-        printf("❌ ERROR: Failed to read lock status response!\n");
+    if (!atecc_read_config(dev)) {
         return false;
-}
-
-uint8_t count = raw[0];
-if (count > sizeof(raw) || count < 4U) {
-    printf("❌ ERROR: Invalid lock status response length!\n");
-    return false;
-}
-
-if (!validate_crc(raw, count)) {
-    printf("❌ ERROR: Lock status CRC validation failed!\n");
-    debug_crc_mismatch(raw, count, &raw[count - 2]);
-    return false;
-}
-
-size_t data_len = (size_t)(count - 3U);
-if (data_len < sizeof(lock_bytes)) {
-    printf("❌ ERROR: Lock status payload too short!\n");
-    return false;
-}
-
-memcpy(lock_bytes, &raw[1], sizeof(lock_bytes));
+    }
 
-printf("🔐 Raw Lock Status Response: ");
-for (size_t i = 0; i < count; ++i) {
-    printf("%02X ", raw[i]);
+    print_config_rows(dev->config);
+    return true;
 }
-printf("\n");
 
-uint8_t lock_config = lock_bytes[0];  // Byte 0x15 (Config Lock)
-uint8_t lock_value = lock_bytes[1];   // Byte 0x16 (Data Lock)
+/**
+ * @brief Print and classify the lock bytes read from word address 0x15
+ *
+ * @param lock_bytes The 4 bytes at word address 0x15
+ * @return true if the lock state is recognized, false otherwise
+ */
+static bool report_lock_status(const uint8_t *lock_bytes) {
+    uint8_t lock_config = lock_bytes[0];  // Byte 0x15 (Config Lock)
+    uint8_t lock_value = lock_bytes[1];   // Byte 0x16 (Data Lock)
 
     printf("🔒 Config Lock Status: %02X\n", lock_config);
     printf("🔒 Data Lock Status: %02X\n", lock_value);
@@ -692,19 +1464,84 @@ uint8_t lock_value = lock_bytes[1];   // Byte 0x16 (Data Lock)
     }
 }
 
+/**
+ * @brief Checks the lock status of the ATECC608A device.
+ *
+ * This function checks the lock status of the ATECC608A device by sending read commands
+ * and receiving responses. It then prints the lock status of the device.
+ *
+ * @return true if the lock status is successfully checked, false otherwise.
+ */
+bool check_lock_status(atecc_dev_t *dev) {
+    uint8_t raw[7] = {0};
+    uint8_t lock_bytes[4] = {0};
+    uint8_t expected_address = 0x15;  // Correct address for lock bytes
+    
+    // 🔹 Send read command for lock status at word address 0x15
+    printf("🔍 Checking ATECC608A Lock Status...\n");
+    if (cached_config_usable(dev)) {
+        memcpy(lock_bytes, &dev->config[expected_address * 4U], sizeof(lock_bytes));
+        printf("🔐 Lock Status (cached config): %02X %02X %02X %02X\n",
+               lock_bytes[0], lock_bytes[1], lock_bytes[2], lock_bytes[3]);
+        return report_lock_status(lock_bytes);
+    }
+
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+    if (!send_atecc_cmd(dev, ATECC_CMD_READ, 0x00, expected_address, NULL, 0, NULL, 0)) {
+        printf("❌ ERROR: Failed to send lock status read command!\n");
+        return false;
+    }
+
+    command_wait(dev, 23);
+
+    if (!atecc_i2c_read(dev, raw, sizeof(raw))) {
+        perror("check_lock_status: I2C read failed");
+        printf("❌ ERROR: Failed to read lock status response!\n");
+        return false;
+    }
+
+    uint8_t count = raw[0];
+    if (count > sizeof(raw) || count < 4U) {
+        printf("❌ ERROR: Invalid lock status response length!\n");
+        return false;
+    }
+
+    if (!validate_crc(raw, count)) {
+        printf("❌ ERROR: Lock status CRC validation failed!\n");
+        debug_crc_mismatch(raw, count, &raw[count - 2]);
+        return false;
+    }
+
+    size_t data_len = (size_t)(count - 3U);
+    if (data_len < sizeof(lock_bytes)) {
+        printf("❌ ERROR: Lock status payload too short!\n");
+        return false;
+    }
+
+    memcpy(lock_bytes, &raw[1], sizeof(lock_bytes));
+
+    char raw_hex[3U * sizeof(raw)];
+    atecc_hex(raw, count, raw_hex, ATECC_HEX_SPACED);
+    printf("🔐 Raw Lock Status Response: %s\n", raw_hex);
+
+    return report_lock_status(lock_bytes);
+}
+
 enum {
     AES_BLOCK_SIZE       = 16U,
     AES_RESPONSE_SIZE    = 1U + AES_BLOCK_SIZE + 2U,
     AES_PROCESS_DELAY_MS = 5U
 };
 
-bool send_aes_command(int fd, uint8_t mode, uint8_t key_slot, const uint8_t *input_data) {
-    if (fd < 0 || !input_data) {
+bool send_aes_command(atecc_dev_t *dev, uint8_t mode, uint8_t key_slot, const uint8_t *input_data) {
+    if (!dev || dev->fd < 0 || !input_data) {
         errno = EINVAL;
         return false;
     }
 
-    if (!send_atecc_cmd(fd, 0x51U, mode, (uint16_t)(key_slot & 0xFFU), input_data, AES_BLOCK_SIZE, NULL, 0)) {
+    if (!send_atecc_cmd(dev, 0x51U, mode, (uint16_t)(key_slot & 0xFFU), input_data, AES_BLOCK_SIZE, NULL, 0)) {
         fprintf(stderr, "send_aes_command: failed to send AES command\n");
         return false;
     }
@@ -712,24 +1549,9 @@ bool send_aes_command(int fd, uint8_t mode, uint8_t key_slot, const uint8_t *inp
     return true;
 }
 
-bool receive_aes_response(int fd, uint8_t *output_data) {
-    if (fd < 0 || !output_data) {
-        errno = EINVAL;
-        return false;
-    }
-
+static bool read_aes_response(atecc_dev_t *dev, uint8_t *output_data) {
     uint8_t response[AES_RESPONSE_SIZE] = {0};
-    struct i2c_rdwr_ioctl_data read_data = {0};
-    struct i2c_msg read_msg = {
-        .addr  = ATECC_I2C_ADDRESS,
-        .flags = I2C_M_RD,
-        .len   = (uint16_t)sizeof(response),
-        .buf   = response
-    };
-    read_data.msgs  = &read_msg;
-    read_data.nmsgs = 1;
-
-    if (ioctl(fd, I2C_RDWR, &read_data) < 0 && errno != EIO && errno != EREMOTEIO) {
+    if (!atecc_i2c_read(dev, response, sizeof(response))) {
         perror("receive_aes_response: I2C read failed");
         return false;
     }
@@ -770,20 +1592,33 @@ bool receive_aes_response(int fd, uint8_t *output_data) {
     return true;
 }
 
-bool aes_encrypt(int fd, const uint8_t *plaintext, uint8_t *ciphertext, uint8_t key_slot) {
-    if (fd < 0 || !plaintext || !ciphertext) {
+bool receive_aes_response(atecc_dev_t *dev, uint8_t *output_data) {
+    if (!dev || dev->fd < 0 || !output_data) {
+        errno = EINVAL;
+        return false;
+    }
+
+    return note_result(dev, read_aes_response(dev, output_data));
+}
+
+bool aes_encrypt(atecc_dev_t *dev, const uint8_t *plaintext, uint8_t *ciphertext, uint8_t key_slot) {
+    if (!dev || dev->fd < 0 || !plaintext || !ciphertext) {
         errno = EINVAL;
         return false;
     }
 
-    if (!send_aes_command(fd, 0x00U, key_slot, plaintext)) {
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+
+    if (!send_aes_command(dev, 0x00U, key_slot, plaintext)) {
         fprintf(stderr, "aes_encrypt: AES encrypt command failed\n");
         return false;
     }
 
-    sleep_ms(AES_PROCESS_DELAY_MS);
+    command_wait(dev, AES_PROCESS_DELAY_MS);
 
-    if (!receive_aes_response(fd, ciphertext)) {
+    if (!receive_aes_response(dev, ciphertext)) {
         fprintf(stderr, "aes_encrypt: AES encrypt response failed\n");
         return false;
     }
@@ -791,20 +1626,24 @@ bool aes_encrypt(int fd, const uint8_t *plaintext, uint8_t *ciphertext, uint8_t
     return true;
 }
 
-bool aes_decrypt(int fd, const uint8_t *ciphertext, uint8_t *plaintext, uint8_t key_slot) {
-    if (fd < 0 || !ciphertext || !plaintext) {
+bool aes_decrypt(atecc_dev_t *dev, const uint8_t *ciphertext, uint8_t *plaintext, uint8_t key_slot) {
+    if (!dev || dev->fd < 0 || !ciphertext || !plaintext) {
         errno = EINVAL;
         return false;
     }
 
-    if (!send_aes_command(fd, 0x01U, key_slot, ciphertext)) {
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+
+    if (!send_aes_command(dev, 0x01U, key_slot, ciphertext)) {
         fprintf(stderr, "aes_decrypt: AES decrypt command failed\n");
         return false;
     }
 
-    sleep_ms(AES_PROCESS_DELAY_MS);
+    command_wait(dev, AES_PROCESS_DELAY_MS);
 
-    if (!receive_aes_response(fd, plaintext)) {
+    if (!receive_aes_response(dev, plaintext)) {
         fprintf(stderr, "aes_decrypt: AES decrypt response failed\n");
         return false;
     }
@@ -813,67 +1652,783 @@ bool aes_decrypt(int fd, const uint8_t *ciphertext, uint8_t *plaintext, uint8_t
 }
 
 /**
- * @brief Main function for testing ATECC608A communication
- * 
- * @return int Exit status
+ * @brief Key check value of the AES key in a slot
+ *
+ * The first ATECC_KCV_SIZE bytes of the SHA-256 of an all-zero block
+ * encrypted under the key. Chips holding the same key give the same value,
+ * so replicas can be matched without the key leaving the chip.
+ *
+ * @param dev Device handle
+ * @param key_slot AES key slot
+ * @param kcv Receives ATECC_KCV_SIZE bytes
+ * @return true on success, false otherwise
  */
-int main(void) {
-    int fd = open(I2C_DEVICE, O_RDWR);
-    if (fd < 0) { perror("open i2c"); return 1; }
-
-    // Set slave (we'll switch as needed inside helper calls)
-    if (ioctl(fd, I2C_SLAVE, ATECC_I2C_ADDRESS) < 0) {
-        perror("I2C_SLAVE");
-        close(fd);
-        return 1;
-    }
-
-    printf("Waking ATECC608A...\n");
-    if (!atecc_wake(fd)) {
-        close(fd);
-        return 1;
-    }
-    
-    uint8_t serial_number[ATECC_SERIAL_NUMBER_SIZE] = {0};
-    if (!read_atecc_serial_number(fd, serial_number)) {
-        fprintf(stderr, "❌ ERROR: Failed to read serial number\n");
-        close(fd);
-        return 1;
+bool atecc_aes_kcv(atecc_dev_t *dev, uint8_t key_slot, uint8_t *kcv) {
+    uint8_t zero[AES_BLOCK_SIZE] = {0};
+    uint8_t check[AES_BLOCK_SIZE];
+    uint8_t digest[32];
+    if (!kcv) {
+        errno = EINVAL;
+        return false;
     }
-    
-    if (!genrate_random_number_in_range(fd, 0, 10000000)) {
-        fprintf(stderr, "❌ ERROR: Failed to generate random number in range\n");
-        close(fd);
-        return 1;
+    if (!aes_encrypt(dev, zero, check, key_slot)) {
+        return false;
     }
+    sha256(check, sizeof(check), digest);
+    memcpy(kcv, digest, ATECC_KCV_SIZE);
+    return true;
+}
 
-    if (!generate_random_value(fd, 16)) {
-        fprintf(stderr, "❌ ERROR: Failed to generate random value\n");
-        close(fd);
-        return 1;
-    }
+enum {
+    ECC_DIGEST_SIZE      = 32U,
+    ECC_SIGNATURE_SIZE   = 64U,
+    ECC_PUBKEY_SIZE      = 64U,
+    NONCE_MODE_PASSTHRU  = 0x03U,   // Load the 32-byte input into TempKey unchanged
+    SIGN_MODE_EXTERNAL   = 0x80U,   // Sign the digest in TempKey
+    GENKEY_MODE_PUBLIC   = 0x00U,   // Compute the public key of a stored private key
+    VERIFY_MODE_EXTERNAL = 0x02U,   // Verify against a public key supplied in the command
+    VERIFY_KEY_P256      = 0x0004U,
+    ECDH_MODE_CLEAR      = 0x0CU,   // Private key from a slot, shared secret returned in the clear
+    ECDH_SECRET_SIZE     = 32U,
+    NONCE_DELAY_MS       = 7U,
+    SIGN_DELAY_MS        = 115U,
+    GENKEY_DELAY_MS      = 115U,
+    VERIFY_DELAY_MS      = 105U,
+    ECDH_DELAY_MS        = 58U
+};
 
-    uint8_t sha_output[32] = {0};
-    //const char *data_to_hash = "Hello, ATECC608A!";
-    if (!compute_sha256(fd, (const uint8_t *)serial_number, strlen((const char *)serial_number), sha_output)) {
+/**
+ * @brief Read a 4-byte status-only response (count, status, CRC)
+ *
+ * @param dev Device handle
+ * @param status Receives the device status byte
+ * @return true if a valid status packet was read, false otherwise
+ */
+static bool receive_atecc_status(atecc_dev_t *dev, uint8_t *status) {
+    uint8_t response[4] = {0};
+    if (!atecc_i2c_read(dev, response, sizeof(response))) {
+        perror("receive_atecc_status: I2C read failed");
+        return note_result(dev, false);
+    }
+    if (response[0] != sizeof(response) || !validate_crc(response, sizeof(response))) {
+        errno = EIO;
+        fprintf(stderr, "receive_atecc_status: invalid status packet\n");
+        return note_result(dev, false);
+    }
+    *status = response[1];
+    return note_result(dev, true);
+}
+
+/**
+ * @brief Load a 32-byte digest into TempKey with a pass-through Nonce
+ *
+ * @param dev Device handle
+ * @param digest 32-byte digest
+ * @return true if successful, false otherwise
+ */
+static bool load_tempkey_digest(atecc_dev_t *dev, const uint8_t *digest) {
+    if (!send_atecc_cmd(dev, ATECC_CMD_NONCE, NONCE_MODE_PASSTHRU, 0x0000, digest, ECC_DIGEST_SIZE, NULL, 0)) {
+        return false;
+    }
+    command_wait(dev, NONCE_DELAY_MS);
+
+    uint8_t status = ATECC_STATUS_ERROR;
+    if (!receive_atecc_status(dev, &status) || status != ATECC_STATUS_SUCCESS) {
+        fprintf(stderr, "load_tempkey_digest: Nonce failed (status 0x%02X)\n", status);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Sign an externally computed SHA-256 digest with the private key in a slot
+ *
+ * @param dev Device handle
+ * @param key_slot Slot holding the ECC P-256 private key
+ * @param digest 32-byte message digest
+ * @param signature Receives the 64-byte signature (R || S)
+ * @return true if successful, false otherwise
+ */
+bool atecc_sign_digest(atecc_dev_t *dev, uint8_t key_slot, const uint8_t *digest, uint8_t *signature) {
+    if (!digest || !signature) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev) || !load_tempkey_digest(dev, digest)) {
+        return false;
+    }
+
+    if (!send_atecc_cmd(dev, ATECC_CMD_SIGN, SIGN_MODE_EXTERNAL, key_slot, NULL, 0, NULL, 0)) {
+        fprintf(stderr, "atecc_sign_digest: Sign command failed\n");
+        return false;
+    }
+    command_wait(dev, SIGN_DELAY_MS);
+
+    if (!receive_atecc_response(dev, signature, ECC_SIGNATURE_SIZE, true)) {
+        fprintf(stderr, "atecc_sign_digest: Sign response failed\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Compute the public key for the private key held in a slot
+ *
+ * @param dev Device handle
+ * @param key_slot Slot holding the ECC P-256 private key
+ * @param public_key Receives the 64-byte public key (X || Y)
+ * @return true if successful, false otherwise
+ */
+bool atecc_get_pubkey(atecc_dev_t *dev, uint8_t key_slot, uint8_t *public_key) {
+    if (!public_key) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+
+    if (!send_atecc_cmd(dev, ATECC_CMD_GENKEY, GENKEY_MODE_PUBLIC, key_slot, NULL, 0, NULL, 0)) {
+        fprintf(stderr, "atecc_get_pubkey: GenKey command failed\n");
+        return false;
+    }
+    command_wait(dev, GENKEY_DELAY_MS);
+
+    if (!receive_atecc_response(dev, public_key, ECC_PUBKEY_SIZE, true)) {
+        fprintf(stderr, "atecc_get_pubkey: GenKey response failed\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief ECDH between the private key in a slot and a peer public key
+ *
+ * @param dev Device handle
+ * @param key_slot Slot holding the ECC P-256 private key (ECDH enabled in its SlotConfig)
+ * @param peer_key 64-byte peer public key (X || Y)
+ * @param secret Receives the 32-byte shared secret (X coordinate)
+ * @return true if successful, false otherwise
+ */
+bool atecc_ecdh(atecc_dev_t *dev, uint8_t key_slot, const uint8_t *peer_key, uint8_t *secret) {
+    if (!peer_key || !secret) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+
+    if (!send_atecc_cmd(dev, ATECC_CMD_ECDH, ECDH_MODE_CLEAR, key_slot, peer_key, ECC_PUBKEY_SIZE, NULL, 0)) {
+        fprintf(stderr, "atecc_ecdh: ECDH command failed\n");
+        return false;
+    }
+    command_wait(dev, ECDH_DELAY_MS);
+
+    if (!receive_atecc_response(dev, secret, ECDH_SECRET_SIZE, true)) {
+        fprintf(stderr, "atecc_ecdh: ECDH response failed\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Verify a P-256 signature over a digest against a supplied public key
+ *
+ * @param dev Device handle
+ * @param digest 32-byte message digest
+ * @param signature 64-byte signature (R || S)
+ * @param public_key 64-byte public key (X || Y)
+ * @param valid Set to whether the signature verified
+ * @return true if the device completed the check, false on communication or device errors
+ */
+bool atecc_verify_digest(atecc_dev_t *dev, const uint8_t *digest, const uint8_t *signature,
+                         const uint8_t *public_key, bool *valid) {
+    if (!digest || !signature || !public_key || !valid) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev) || !load_tempkey_digest(dev, digest)) {
+        return false;
+    }
+
+    uint8_t data[ECC_SIGNATURE_SIZE + ECC_PUBKEY_SIZE];
+    memcpy(data, signature, ECC_SIGNATURE_SIZE);
+    memcpy(&data[ECC_SIGNATURE_SIZE], public_key, ECC_PUBKEY_SIZE);
+    if (!send_atecc_cmd(dev, ATECC_CMD_VERIFY, VERIFY_MODE_EXTERNAL, VERIFY_KEY_P256, data, sizeof(data), NULL, 0)) {
+        fprintf(stderr, "atecc_verify_digest: Verify command failed\n");
+        return false;
+    }
+    command_wait(dev, VERIFY_DELAY_MS);
+
+    uint8_t status = ATECC_STATUS_ERROR;
+    if (!receive_atecc_status(dev, &status)) {
+        return false;
+    }
+    // Only a match or a miscompare is a verdict on the signature
+    if (status != ATECC_STATUS_SUCCESS && status != ATECC_STATUS_MISCOMPARE) {
+        fprintf(stderr, "atecc_verify_digest: device status 0x%02X\n", status);
+        errno = EIO;
+        return false;
+    }
+    *valid = (status == ATECC_STATUS_SUCCESS);
+    return true;
+}
+
+/**
+ * @brief Worst-case SelfTest time per algorithm, in milliseconds
+ *
+ * The datasheet only gives the time of the full SelfTest; the split follows
+ * the execution times of the commands each test exercises.
+ */
+static const struct {
+    uint8_t test;
+    unsigned int delay_ms;
+} selftest_delays[] = {
+    { ATECC_SELFTEST_RNG,   20U },
+    { ATECC_SELFTEST_ECDSA, 200U },
+    { ATECC_SELFTEST_ECDH,  80U },
+    { ATECC_SELFTEST_AES,   10U },
+    { ATECC_SELFTEST_SHA,   10U }
+};
+
+static unsigned int selftest_delay_ms(uint8_t tests) {
+    unsigned int delay_ms = 0;
+    for (size_t i = 0; i < sizeof(selftest_delays) / sizeof(selftest_delays[0]); i++) {
+        if (tests & selftest_delays[i].test) {
+            delay_ms += selftest_delays[i].delay_ms;
+        }
+    }
+    return delay_ms;
+}
+
+/**
+ * @brief Expected duration of a SelfTest, from the tuning profile when it has the mode
+ *
+ * @param dev Device handle
+ * @param tests ATECC_SELFTEST_* bits
+ * @return Microseconds the device is busy
+ */
+uint32_t atecc_selftest_us(const atecc_dev_t *dev, uint8_t tests) {
+    uint32_t ready_us = atecc_tune_ready_us(&dev->tune, ATECC_CMD_SELFTEST, tests);
+    return ready_us ? ready_us : selftest_delay_ms(tests) * 1000U;
+}
+
+/**
+ * @brief Run SelfTest for the given algorithms and record the result in the health state
+ *
+ * A failed test leaves the device refusing the commands that use the
+ * algorithm until a later SelfTest of it passes.
+ *
+ * @param dev Device handle
+ * @param tests ATECC_SELFTEST_* bits
+ * @param failed Receives the bits of the tests that failed, 0 when all passed
+ * @return true if the device answered, false otherwise
+ */
+bool atecc_selftest(atecc_dev_t *dev, uint8_t tests, uint8_t *failed) {
+    unsigned int delay_ms = selftest_delay_ms(tests);
+    if (!failed || delay_ms == 0) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_keep_awake(dev, (uint64_t)delay_ms * 1000U)) {
+        return false;
+    }
+    if (!send_atecc_cmd(dev, ATECC_CMD_SELFTEST, tests, 0x0000, NULL, 0, NULL, 0)) {
+        fprintf(stderr, "atecc_selftest: SelfTest command failed\n");
+        return false;
+    }
+    command_wait(dev, delay_ms);
+
+    uint8_t result = ATECC_STATUS_ERROR;
+    if (!receive_atecc_status(dev, &result)) {
+        return false;
+    }
+    *failed = result & tests;
+    dev->selftest_failed = (uint8_t)((dev->selftest_failed & ~tests) | *failed);
+    dev->selftest_passed = (uint8_t)((dev->selftest_passed & ~tests) | (tests & ~*failed));
+    dev->selftest_us = atecc_now_us();
+    atecc_snapshot_publish(dev);
+    return true;
+}
+
+enum {
+    CONFIG_WORD_SIZE     = 4U,
+    CONFIG_BLOCK_SIZE    = 32U,
+    WRITE_MODE_32        = 0x80U,   // Write param1 flag: 32-byte block (zone bits 0 = config)
+    LOCK_MODE_CONFIG_CRC = 0x00U,   // Lock the config zone only if its CRC matches param2
+    ZONE_DATA            = 0x02U,   // Read/Write param1 zone bits: data zone
+    READ_DELAY_MS        = 5U,
+    WRITE_DELAY_MS       = 45U,
+    LOCK_DELAY_MS        = 32U
+};
+
+/**
+ * @brief Read a 4-byte word or a 32-byte block of the config zone
+ *
+ * @param dev Device handle
+ * @param word Config word index (0-31); block reads must start on a multiple of 8
+ * @param data Output buffer
+ * @param length 4 or 32
+ * @return true if successful, false otherwise
+ */
+bool atecc_read_config_bytes(atecc_dev_t *dev, uint8_t word, uint8_t *data, size_t length) {
+    bool block = (length == CONFIG_BLOCK_SIZE);
+    if (!data || (!block && length != CONFIG_WORD_SIZE) || word >= ATECC_CONFIG_SIZE / CONFIG_WORD_SIZE ||
+        (block && word % 8U != 0U)) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+
+    if (!send_atecc_cmd(dev, ATECC_CMD_READ, block ? ATECC_ZONE_READ_32 : 0x00, word, NULL, 0, NULL, 0)) {
+        return false;
+    }
+    command_wait(dev, READ_DELAY_MS);
+    return receive_atecc_response(dev, data, length, true);
+}
+
+/**
+ * @brief Drop every cached copy of the config zone after it has been changed
+ */
+static void invalidate_config(atecc_dev_t *dev) {
+    dev->config_valid = false;
+    atecc_cache_invalidate(dev);
+    atecc_snapshot_publish(dev);
+}
+
+/**
+ * @brief Write a 4-byte word or a 32-byte block of an unlocked config zone
+ *
+ * @param dev Device handle
+ * @param word Config word index (0-31); block writes must start on a multiple of 8
+ * @param data Bytes to write
+ * @param length 4 or 32
+ * @return true if the device accepted the write, false otherwise
+ */
+bool atecc_write_config(atecc_dev_t *dev, uint8_t word, const uint8_t *data, size_t length) {
+    bool block = (length == CONFIG_BLOCK_SIZE);
+    if (!data || (!block && length != CONFIG_WORD_SIZE) || word >= ATECC_CONFIG_SIZE / CONFIG_WORD_SIZE ||
+        (block && word % 8U != 0U)) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+
+    invalidate_config(dev);
+    if (!send_atecc_cmd(dev, ATECC_CMD_WRITE, block ? WRITE_MODE_32 : 0x00, word, data, (uint8_t)length, NULL, 0)) {
+        return false;
+    }
+    command_wait(dev, WRITE_DELAY_MS);
+
+    uint8_t status = 0xFF;
+    if (!receive_atecc_status(dev, &status)) {
+        return false;
+    }
+    if (status != ATECC_STATUS_SUCCESS) {
+        errno = EIO;
+        fprintf(stderr, "atecc_write_config: word %u rejected (status 0x%02X)\n", word, status);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Lock the config zone, letting the device verify its contents
+ *
+ * The CRC of the expected 128-byte image is computed on the host and passed
+ * with the Lock command; the device only locks if its own config zone has
+ * the same CRC, so no readback is needed.
+ *
+ * @param dev Device handle
+ * @param config Expected config zone contents (128 bytes)
+ * @return true if the zone was locked, false otherwise
+ */
+bool atecc_lock_config(atecc_dev_t *dev, const uint8_t *config) {
+    if (!config) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+
+    uint16_t summary = atecc_crc16(config, ATECC_CONFIG_SIZE);
+
+    invalidate_config(dev);
+    if (!send_atecc_cmd(dev, ATECC_CMD_LOCK, LOCK_MODE_CONFIG_CRC, summary, NULL, 0, NULL, 0)) {
+        return false;
+    }
+    command_wait(dev, LOCK_DELAY_MS);
+
+    uint8_t status = 0xFF;
+    if (!receive_atecc_status(dev, &status)) {
+        return false;
+    }
+    if (status != ATECC_STATUS_SUCCESS) {
+        errno = EIO;
+        fprintf(stderr, "atecc_lock_config: Lock rejected (status 0x%02X): config zone does not match "
+                        "the expected image\n", status);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Size of a data zone slot
+ *
+ * @param slot Slot number (0-15)
+ * @return 36 for slots 0-7, 416 for slot 8, 72 for slots 9-15, 0 for invalid slots
+ */
+size_t atecc_slot_size(uint8_t slot) {
+    if (slot < 8U) {
+        return 36U;
+    }
+    if (slot == 8U) {
+        return 416U;
+    }
+    return (slot < 16U) ? 72U : 0U;
+}
+
+/**
+ * @brief Check a data zone word or block address and build the Read/Write param2
+ */
+static bool slot_address(uint8_t slot, size_t offset, size_t length, uint16_t *address) {
+    if ((length != CONFIG_WORD_SIZE && length != CONFIG_BLOCK_SIZE) || offset % length != 0U ||
+        offset + length > atecc_slot_size(slot)) {
+        errno = EINVAL;
+        return false;
+    }
+    size_t block = offset / CONFIG_BLOCK_SIZE;
+    size_t word = (offset % CONFIG_BLOCK_SIZE) / CONFIG_WORD_SIZE;
+    *address = (uint16_t)((block << 8) | ((size_t)slot << 3) | word);
+    return true;
+}
+
+/**
+ * @brief Read one 4-byte word or 32-byte block of a data slot
+ */
+static bool read_slot_unit(atecc_dev_t *dev, uint8_t slot, size_t offset, uint8_t *data, size_t length) {
+    uint16_t address = 0;
+    if (!slot_address(slot, offset, length, &address)) {
+        return false;
+    }
+    uint8_t mode = (length == CONFIG_BLOCK_SIZE) ? (ATECC_ZONE_READ_32 | ZONE_DATA) : ZONE_DATA;
+    if (!send_atecc_cmd(dev, ATECC_CMD_READ, mode, address, NULL, 0, NULL, 0)) {
+        return false;
+    }
+    command_wait(dev, READ_DELAY_MS);
+    return receive_atecc_response(dev, data, length, true);
+}
+
+/**
+ * @brief Write one 4-byte word or 32-byte block of a data slot
+ */
+static bool write_slot_unit(atecc_dev_t *dev, uint8_t slot, size_t offset, const uint8_t *data, size_t length) {
+    uint16_t address = 0;
+    if (!slot_address(slot, offset, length, &address)) {
+        return false;
+    }
+    uint8_t mode = (length == CONFIG_BLOCK_SIZE) ? (WRITE_MODE_32 | ZONE_DATA) : ZONE_DATA;
+    if (!send_atecc_cmd(dev, ATECC_CMD_WRITE, mode, address, data, (uint8_t)length, NULL, 0)) {
+        return false;
+    }
+    command_wait(dev, WRITE_DELAY_MS);
+
+    uint8_t status = 0xFF;
+    if (!receive_atecc_status(dev, &status)) {
+        return false;
+    }
+    if (status != ATECC_STATUS_SUCCESS) {
+        errno = EIO;
+        fprintf(stderr, "write_slot_unit: slot %u offset %zu rejected (status 0x%02X)\n", slot, offset, status);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read one full 32-byte block of a data zone slot in the clear
+ *
+ * @param dev Device handle
+ * @param slot Slot number
+ * @param block Block index inside the slot
+ * @param data Receives 32 bytes
+ * @return true if successful, false otherwise
+ */
+bool atecc_read_slot_block(atecc_dev_t *dev, uint8_t slot, uint8_t block, uint8_t *data) {
+    if (!data) {
+        errno = EINVAL;
+        return false;
+    }
+    return atecc_ensure_awake(dev) && read_slot_unit(dev, slot, (size_t)block * CONFIG_BLOCK_SIZE, data,
+                                                     CONFIG_BLOCK_SIZE);
+}
+
+/**
+ * @brief Write one full 32-byte block of a data zone slot in the clear
+ *
+ * The slot's WriteConfig must allow clear writes once the data zone is locked.
+ *
+ * @param dev Device handle
+ * @param slot Slot number
+ * @param block Block index inside the slot
+ * @param data 32 bytes to write
+ * @return true if the device accepted the write, false otherwise
+ */
+bool atecc_write_slot_block(atecc_dev_t *dev, uint8_t slot, uint8_t block, const uint8_t *data) {
+    if (!data) {
+        errno = EINVAL;
+        return false;
+    }
+    return atecc_ensure_awake(dev) && write_slot_unit(dev, slot, (size_t)block * CONFIG_BLOCK_SIZE, data,
+                                                      CONFIG_BLOCK_SIZE);
+}
+
+/**
+ * @brief Read a range of a data slot in the clear, using block reads where aligned
+ *
+ * @param dev Device handle
+ * @param slot Slot number
+ * @param offset Byte offset in the slot (multiple of 4)
+ * @param data Output buffer
+ * @param length Number of bytes (multiple of 4)
+ * @return true if successful, false otherwise
+ */
+bool atecc_read_slot(atecc_dev_t *dev, uint8_t slot, size_t offset, uint8_t *data, size_t length) {
+    if (!data || offset % CONFIG_WORD_SIZE != 0U || length % CONFIG_WORD_SIZE != 0U) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+    for (size_t done = 0; done < length;) {
+        size_t unit = ((offset + done) % CONFIG_BLOCK_SIZE == 0U && length - done >= CONFIG_BLOCK_SIZE)
+                          ? CONFIG_BLOCK_SIZE : CONFIG_WORD_SIZE;
+        if (!read_slot_unit(dev, slot, offset + done, &data[done], unit)) {
+            return false;
+        }
+        done += unit;
+    }
+    return true;
+}
+
+/**
+ * @brief Write a range of a data slot in the clear, using block writes where aligned
+ *
+ * @param dev Device handle
+ * @param slot Slot number
+ * @param offset Byte offset in the slot (multiple of 4)
+ * @param data Bytes to write
+ * @param length Number of bytes (multiple of 4)
+ * @return true if the device accepted every write, false otherwise
+ */
+bool atecc_write_slot(atecc_dev_t *dev, uint8_t slot, size_t offset, const uint8_t *data, size_t length) {
+    if (!data || offset % CONFIG_WORD_SIZE != 0U || length % CONFIG_WORD_SIZE != 0U) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!atecc_ensure_awake(dev)) {
+        return false;
+    }
+    for (size_t done = 0; done < length;) {
+        size_t unit = ((offset + done) % CONFIG_BLOCK_SIZE == 0U && length - done >= CONFIG_BLOCK_SIZE)
+                          ? CONFIG_BLOCK_SIZE : CONFIG_WORD_SIZE;
+        if (!write_slot_unit(dev, slot, offset + done, &data[done], unit)) {
+            return false;
+        }
+        done += unit;
+    }
+    return true;
+}
+
+/**
+ * @brief Close the demo's device and the TCA9548A mux in front of it, if any
+ */
+static void close_demo_device(atecc_dev_t *dev, atecc_mux_t *mux, bool muxed) {
+    atecc_close(dev);
+    if (muxed) {
+        atecc_mux_close(mux);
+    }
+}
+
+/**
+ * @brief Main function for testing ATECC608A communication
+ *
+ * Usage: pi_atecc [device], where device is a topology address such as
+ * "1:0x60" or "1:0x70.3:0x60" (default: I2C_DEVICE at ATECC_I2C_ADDRESS),
+ * pi_atecc mux-bench <bus> <mux-address> [rounds] [device-address], or
+ * pi_atecc discover [address...], pi_atecc latency [options] [device], or
+ * pi_atecc batch-sign / batch-verify (see atecc_merkle.c), or
+ * pi_atecc aes-ctr <slot> <counter-hex> [--bench BYTES] [--in FILE] [--out FILE] [device...], or
+ * pi_atecc sha256-file [FILE] [--sign SLOT] [device] / random-dump <bytes> [--out FILE] [device...]
+ * (see atecc_stream.c), or
+ * pi_atecc fmt-bench [MiB], or the daemon pair
+ * pi_atecc serve [--socket PATH] [device...] / client-bench [options] / batch-bench [options] /
+ * burst-bench [options] / status, or
+ * pi_atecc provision <template> [--no-lock] [device...], or
+ * pi_atecc wb-bench <slot> [options] [device], or
+ * pi_atecc cert store|fetch <template.der> ... (see atecc_cert.c), or
+ * pi_atecc keys [--names FILE] [--sign ID] [--count N] [device...], or
+ * pi_atecc trace <file> [--top N] [--exec NAME=MS ...] on a trace recorded
+ * with ATECC_TRACE=FILE, or
+ * pi_atecc calibrate [--runs N] [--key-slot S] [--aes-slot S] [--selftest] [--no-save] [device], or
+ * pi_atecc session [--window N] [device...] for JSON-lines requests on stdin (see atecc_session.c), or
+ * pi_atecc rig-bench [--buses B] [--mux] [--max N] [--hz HZ] on emulated devices (see atecc_emu.c), or
+ * pi_atecc snapshot-bench [--max N] [--ms MS] [--stress] [device] (see atecc_snapshot.c).
+ * Device addresses on the buses "emu0".."emu15" open emulated chips for any subcommand.
+ * 
+ * @return int Exit status
+ */
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "mux-bench") == 0) {
+        return atecc_mux_bench(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "discover") == 0) {
+        return atecc_discover_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "latency") == 0) {
+        return atecc_latency_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "batch-sign") == 0) {
+        return atecc_batch_sign_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "batch-verify") == 0) {
+        return atecc_batch_verify_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) {
+        return atecc_serve_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "trace") == 0) {
+        return atecc_trace_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "calibrate") == 0) {
+        return atecc_calibrate_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "session") == 0) {
+        return atecc_session_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "rig-bench") == 0) {
+        return atecc_rig_bench_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "snapshot-bench") == 0) {
+        return atecc_snapshot_bench_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "keys") == 0) {
+        return atecc_keys_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "cert") == 0) {
+        return atecc_cert_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "wb-bench") == 0) {
+        return atecc_wb_bench_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "provision") == 0) {
+        return atecc_provision_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "status") == 0) {
+        return atecc_status_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "batch-bench") == 0) {
+        return atecc_batch_bench_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "burst-bench") == 0) {
+        return atecc_burst_bench_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "client-bench") == 0) {
+        return atecc_client_bench_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "fmt-bench") == 0) {
+        return atecc_fmt_bench_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "sha256-file") == 0) {
+        return atecc_sha256_file_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "random-dump") == 0) {
+        return atecc_random_dump_main(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "aes-ctr") == 0) {
+        return atecc_aes_ctr_main(argc - 2, argv + 2);
+    }
+
+    atecc_topo_t topo = { .bus = I2C_DEVICE, .address = ATECC_I2C_ADDRESS };
+    if (argc > 1 && !atecc_parse_topo(argv[1], &topo)) {
+        fprintf(stderr, "❌ ERROR: Invalid device address '%s' (expected bus:addr or bus:mux.channel:addr)\n", argv[1]);
+        return 2;
+    }
+
+    atecc_mux_t mux;
+    bool muxed = topo.mux_address != 0;
+    if (muxed && !atecc_mux_open(&mux, topo.bus, topo.mux_address)) {
+        return 1;
+    }
+
+    atecc_dev_t dev_handle;
+    atecc_dev_t *dev = &dev_handle;
+    if (!atecc_open_topo(dev, &topo, &mux)) {
+        if (muxed) {
+            atecc_mux_close(&mux);
+        }
+        return 1;
+    }
+    printf("🔌 I2C transport: %s (funcs 0x%08lX)\n", atecc_xfer_name(dev->xfer), dev->funcs);
+
+    // Cached identity and config are used until the first command wakes the chip
+    atecc_cache_load(dev);
+
+    printf("⏰ Sending wake command...\n");
+    if (!atecc_ensure_awake(dev)) {
+        fprintf(stderr, "❌ ERROR: Failed to wake ATECC608A\n");
+        close_demo_device(dev, &mux, muxed);
+        return 1;
+    }
+    printf("✅ ATECC608A is awake!\n");
+
+    uint8_t serial_number[ATECC_SERIAL_NUMBER_SIZE] = {0};
+    if (!read_atecc_serial_number(dev, serial_number)) {
+        fprintf(stderr, "❌ ERROR: Failed to read serial number\n");
+        close_demo_device(dev, &mux, muxed);
+        return 1;
+    }
+    
+    if (!genrate_random_number_in_range(dev, 0, 10000000)) {
+        fprintf(stderr, "❌ ERROR: Failed to generate random number in range\n");
+        close_demo_device(dev, &mux, muxed);
+        return 1;
+    }
+
+    if (!generate_random_value(dev, 16)) {
+        fprintf(stderr, "❌ ERROR: Failed to generate random value\n");
+        close_demo_device(dev, &mux, muxed);
+        return 1;
+    }
+
+    uint8_t sha_output[32] = {0};
+    //const char *data_to_hash = "Hello, ATECC608A!";
+    if (!compute_sha256(dev, (const uint8_t *)serial_number, strlen((const char *)serial_number), sha_output)) {
         fprintf(stderr, "❌ ERROR: Failed to compute SHA-256 hash\n");
-        close(fd);
+        close_demo_device(dev, &mux, muxed);
         return 1;
     }
 
-    if (!read_slot_config(fd, 3)) {
+    if (!read_slot_config(dev, 3)) {
         fprintf(stderr, "❌ ERROR: Failed to read slot configuration\n");
     }
 
-    if (!read_config_zone(fd)) {
+    if (!read_config_zone(dev)) {
         fprintf(stderr, "❌ ERROR: Failed to read configuration zone\n");
-        close(fd);
+        close_demo_device(dev, &mux, muxed);
         return 1;
     }
 
-    if (!check_lock_status(fd)) {
+    if (!check_lock_status(dev)) {
         fprintf(stderr, "❌ ERROR: Failed to check lock status\n");
-        close(fd);
+        close_demo_device(dev, &mux, muxed);
         return 1;
     }
 
@@ -883,31 +2438,23 @@ int main(void) {
     uint8_t key_slot = 0x03;
 
     printf("🔐 Performing AES 128-bit Encryption/Decryption using Slot %d...\n", key_slot);
-    printf("🔹 Plaintext: ");
-    for (int i = 0; i < 16; i++) {
-        printf("%02X ", plaintext[i]);
-    }
-    printf("\n");
+    char block_hex[3U * 16U];
+    atecc_hex(plaintext, 16, block_hex, ATECC_HEX_SPACED);
+    printf("🔹 Plaintext: %s\n", block_hex);
 
-    if (aes_encrypt(fd, plaintext, ciphertext, key_slot)) {
-        printf("🔹 Ciphertext: ");
-        for (int i = 0; i < 16; i++) {
-            printf("%02X ", ciphertext[i]);
-        }
-        printf("\n");
+    if (aes_encrypt(dev, plaintext, ciphertext, key_slot)) {
+        atecc_hex(ciphertext, 16, block_hex, ATECC_HEX_SPACED);
+        printf("🔹 Ciphertext: %s\n", block_hex);
     } else {
         printf("❌ AES 128-bit encryption failed!\n");
         printf("❓ Is the slot configured for AES?\n");
-        close(fd);
+        close_demo_device(dev, &mux, muxed);
         return 1;
     }
 
-    if (aes_decrypt(fd, ciphertext, decrypted_text, key_slot)) {
-        printf("🔹 Decrypted: ");
-        for (int i = 0; i < 16; i++) {
-            printf("%02X ", decrypted_text[i]);
-        }
-        printf("\n");
+    if (aes_decrypt(dev, ciphertext, decrypted_text, key_slot)) {
+        atecc_hex(decrypted_text, 16, block_hex, ATECC_HEX_SPACED);
+        printf("🔹 Decrypted: %s\n", block_hex);
 
         if (memcmp(plaintext, decrypted_text, 16) == 0) {
             printf("✅ AES Decryption Successful! Plaintext Matches!\n");
@@ -916,17 +2463,17 @@ int main(void) {
         }
     } else {
         printf("❌ AES Decryption Failed!\n");
-        close(fd);
+        close_demo_device(dev, &mux, muxed);
         return 1;
     }
 
     printf("🌙 Putting ATECC608A to sleep...\n");
-    if (!atecc_sleep(fd)) {
+    if (!atecc_sleep(dev)) {
         fprintf(stderr, "⚠️ Failed to issue sleep command\n");
     }
 
     printf("🎉 ATECC608A Test Complete!\n");
-    close(fd);
+    close_demo_device(dev, &mux, muxed);
 
     return 0;
 }
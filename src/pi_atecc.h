@@ -5,10 +5,12 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #define I2C_DEVICE "/dev/i2c-1"         // I2C device file
 #define ATECC_I2C_ADDRESS 0x60          // Default I2C address for ATECC608A
-#define ATECC_CMD_SIZE 128              // Maximum command size
+#define ATECC_CMD_SIZE 151              // Maximum command size (Verify with external key)
 #define ATECC_RESPONSE_SIZE 128         // Maximum response size
 #define ATECC_WAKE_DELAY_US 1500        // Delay after wake command
 #define ATECC_SLEEP_DELAY_US 500        // Delay after sleep command
@@ -17,10 +19,11 @@
 #define ATECC_CMD_WAKE 0x00             // Wake command
 #define ATECC_CMD_SLEEP 0x01            // Sleep command
 #define ATECC_CMD_READ 0x02             // Read command
-#define ATECC_CMD_WRITE 0x03            // Write command
+#define ATECC_CMD_WRITE 0x12            // Write command
 #define ATECC_CMD_RANDOM 0x1B           // Random number command
 #define ATECC_CMD_SHA 0x47              // SHA command
 #define ATECC_STATUS_SUCCESS 0x00       // Success status
+#define ATECC_STATUS_MISCOMPARE 0x01    // CheckMac or Verify did not match
 #define ATECC_STATUS_WAKE 0x11          // Wake token status
 #define ATECC_STATUS_ERROR 0xFF         // Generic error status
 #define ATECC_SERIAL_NUMBER_SIZE 9      // 9 bytes serial number size
@@ -30,5 +33,825 @@
 #define ATECC_WORDADDR_SLEEP 0x01       // Sleep word address
 #define ATECC_CMD_AES_ENCRYPT 0xAE      // AES Encrypt command
 #define ATECC_CMD_AES_DECRYPT 0xAF      // AES Decrypt command
+#define ATECC_CMD_NONCE 0x16            // Nonce command
+#define ATECC_CMD_GENKEY 0x40           // GenKey command
+#define ATECC_CMD_SIGN 0x41             // Sign command
+#define ATECC_CMD_VERIFY 0x45           // Verify command
+#define ATECC_CMD_LOCK 0x17             // Lock command
+#define ATECC_CMD_ECDH 0x43             // ECDH command
+#define ATECC_CMD_SELFTEST 0x77         // SelfTest command
+#define ATECC_SELFTEST_RNG 0x01         // SelfTest mode bit: DRBG random number generator
+#define ATECC_SELFTEST_ECDSA 0x02       // SelfTest mode bit: ECDSA sign and verify
+#define ATECC_SELFTEST_ECDH 0x08        // SelfTest mode bit: ECDH
+#define ATECC_SELFTEST_AES 0x10         // SelfTest mode bit: AES
+#define ATECC_SELFTEST_SHA 0x20         // SelfTest mode bit: SHA-256
+#define ATECC_SMBUS_BLOCK_MAX 32        // Largest payload of an SMBus I2C block transfer
+#define TCA9548A_CHANNELS 8             // Downstream channels on a TCA9548A mux
+#define ATECC_ZONE_READ_32 0x80         // Read param1 flag: 32-byte block read (config zone)
+#define ATECC_DISCOVER_MAX 64           // Maximum devices reported by atecc_discover()
+#define ATECC_POOL_MAX ATECC_DISCOVER_MAX   // Maximum devices in an atecc_pool_t
+#define ATECC_CONFIG_SIZE 128           // Config zone size in bytes
+#define ATECC_CONFIG_LOCK_VALUE 86      // Config byte: data/OTP zone lock (0x00 = locked)
+#define ATECC_CONFIG_LOCK_CONFIG 87     // Config byte: config zone lock (0x00 = locked)
+#define ATECC_AWAKE_WINDOW_US 1000000   // Re-wake after this long, inside the 1.3 s watchdog
+#define ATECC_KCV_SIZE 8                // Bytes of an AES key check value (atecc_aes_kcv())
+#define ATECC_SHA_MAX_LENGTH 10240U     // Longest message the device SHA engine hashes inside one awake window
+#define ATECC_RING_SIZE (4U << 20)      // Per-client shared result ring of the serve daemon
+#define ATECC_DAEMON_MAGIC 0x41544344U  // "ATCD", first word of the daemon hello
+#define ATECC_STATUS_SHM "/pi_atecc-status"   // Default name of the daemon's status page
+#define ATECC_STATUS_MAGIC 0x41545350U  // "ATSP", first word of the status page
+#define ATECC_TRACE_MAX_BYTES 256       // Longest transfer recorded in full by $ATECC_TRACE
+#define ATECC_STATUS_CLIENT_MAX 32       // Client entries on the status page (the daemon's client limit)
+#define ATECC_HEX_UPPER 0x00            // atecc_hex() flag: uppercase digits (default)
+#define ATECC_HEX_LOWER 0x01            // atecc_hex() flag: lowercase digits
+#define ATECC_HEX_SPACED 0x02           // atecc_hex() flag: one space between bytes
+#define ATECC_SLOT_BLOCK_SIZE 32        // Data zone block, the unit of a 32-byte Read/Write
+#define ATECC_WB_COPY_MAX 192           // Largest write-back copy: half of slot 8's 13 blocks
+#define ATECC_CERT_COMPRESSED_SIZE 72   // Compressed certificate: signature, dates, ids
+#define ATECC_CERT_MAX 1024             // Largest DER certificate handled on the host
+#define ATECC_CERT_CACHE_MAX 16         // Rebuilt certificates kept per atecc_cert_cache_t
+#define ATECC_SLOT_COUNT 16             // Data zone slots
+#define ATECC_KEY_ID_MAX 32             // Longest logical key id, including the terminator
+#define ATECC_TUNE_OPS_MAX 32           // Calibrated (opcode, mode) entries in a tuning profile
+#define ATECC_STREAM_DEPTH_MAX 32       // Buffers cycling through an atecc_stream_t
+#define ATECC_EMU_BUS_PREFIX "emu"      // Bus names "emu0".."emu15" are emulated (see atecc_emu.c)
+#define ATECC_EMU_BUSES 16              // Emulated buses
+
+/**
+ * @brief Transfer primitive negotiated for a device from the adapter's I2C_FUNCS bitmap
+ *
+ * Each transfer still picks its own primitive: I2C_RDWR falls back to
+ * read()/write() for a transfer the adapter refuses, and SMBus adapters
+ * switch between send byte, block and receive byte transfers by length.
+ */
+typedef enum {
+    ATECC_XFER_RDWR = 0,    // I2C_RDWR ioctl with i2c_msg arrays (plain I2C adapters)
+    ATECC_XFER_RAW,         // read()/write() on the I2C_SLAVE-bound descriptor
+    ATECC_XFER_SMBUS,       // SMBus I2C block transfers, payloads up to 32 bytes
+    ATECC_XFER_EMU          // Emulated chip on a virtual bus, no hardware involved
+} atecc_xfer_t;
+
+struct atecc_mux;
+struct atecc_emu_chip;
+
+/**
+ * @brief Calibrated completion time of one command (opcode and mode byte)
+ */
+typedef struct {
+    uint8_t opcode;         // Command opcode
+    uint8_t mode;           // Param1 of the command
+    uint32_t ready_us;      // Longest completion time seen by `pi_atecc calibrate`
+} atecc_tune_op_t;
+
+/**
+ * @brief Per-serial tuning profile written by `pi_atecc calibrate`
+ *
+ * Commands without an entry keep the fixed worst-case wait. A calibrated
+ * command waits its ready_us and then polls the NACKing device every poll_us
+ * until the response arrives or the fixed worst case has passed.
+ */
+typedef struct {
+    bool loaded;                                // Profile loaded for this device
+    uint32_t poll_us;                           // Backoff between NACKed polls
+    uint32_t wake_us;                           // Wake token to wake response
+    uint32_t bus_hz;                            // Adapter clock the profile was measured at, 0 if unknown
+    size_t op_count;                            // Valid entries in ops
+    atecc_tune_op_t ops[ATECC_TUNE_OPS_MAX];    // Calibrated commands
+} atecc_tune_t;
+
+/**
+ * @brief Response timing of one command, measured by atecc_time_command()
+ */
+typedef struct {
+    uint32_t ready_us;      // Command write to the start of the first successful read
+    uint32_t polls;         // NACKed reads before it
+    uint32_t poll_us;       // Time spent in NACKed reads
+    uint32_t read_us;       // Duration of the successful read
+    uint8_t status;         // Status byte of a 4-byte response, otherwise 0
+} atecc_cmd_timing_t;
+
+/**
+ * @brief Immutable view of a device handle for threads that do not drive it
+ *
+ * Built from the handle's cached identity, decoded config, tuning profile
+ * and health counters each time one of them changes (see
+ * atecc_snapshot_publish()), and read with atecc_snapshot_read().
+ */
+typedef struct {
+    uint64_t generation;                        // Publishes so far, 0 until the first
+    uint64_t published_us;                      // CLOCK_MONOTONIC time of the publish
+
+    // Identity
+    bool identity_valid;                        // serial holds a known serial number
+    uint8_t serial[ATECC_SERIAL_NUMBER_SIZE];   // Serial number
+
+    // Decoded config zone, valid when config_valid
+    bool config_valid;                          // Fields below were decoded from a config zone read
+    uint8_t revision[4];                        // Config bytes 4-7
+    bool config_locked;                         // Config zone locked
+    bool data_locked;                           // Data and OTP zones locked
+    bool aes_enabled;                           // AES command enabled (AESEnable bit 0)
+    uint16_t slot_config[ATECC_SLOT_COUNT];     // SlotConfig per slot
+    uint16_t key_config[ATECC_SLOT_COUNT];      // KeyConfig per slot
+
+    // Learned timings
+    atecc_tune_t tune;                          // Tuning profile in use, tune.loaded false when none
+
+    // Health
+    unsigned long commands;                     // Commands sent
+    unsigned long failures;                     // Commands without a valid response
+    unsigned int consecutive_failures;          // Failures since the last valid response
+    uint64_t last_ok_us;                        // Time of the last valid response
+    uint8_t selftest_passed;                    // SelfTest bits that passed on their last run
+    uint8_t selftest_failed;                    // SelfTest bits that failed on their last run
+    uint64_t selftest_us;                       // Time of the last SelfTest
+} atecc_snapshot_t;
+
+/**
+ * @brief Seqlock around the latest atecc_snapshot_t of a handle
+ *
+ * A writer moves seq to an odd value with a compare-and-swap, copies the
+ * view in and releases it with the next even value; readers retry until
+ * they see the same even seq before and after copying, so they never block
+ * the command path or each other.
+ */
+typedef struct {
+    atomic_uint seq;                            // Seqlock sequence, odd while a writer copies in
+    atecc_snapshot_t view;                      // Latest published view
+} atecc_snapshot_cell_t;
+
+/**
+ * @brief Scheduling policy requested for the device I/O thread
+ */
+typedef enum {
+    ATECC_RT_NONE = 0,      // Leave the thread on its current policy
+    ATECC_RT_FIFO,          // SCHED_FIFO at priority
+    ATECC_RT_DEADLINE       // SCHED_DEADLINE with runtime/deadline/period
+} atecc_rt_policy_t;
+
+/**
+ * @brief Real-time settings for the thread that polls the device
+ */
+typedef struct {
+    int cpu;                    // CPU to pin to, -1 to keep the current affinity
+    atecc_rt_policy_t policy;   // Scheduling policy
+    int priority;               // SCHED_FIFO priority (1-99)
+    uint64_t runtime_ns;        // SCHED_DEADLINE runtime budget
+    uint64_t deadline_ns;       // SCHED_DEADLINE relative deadline
+    uint64_t period_ns;         // SCHED_DEADLINE period
+    bool lock_memory;           // mlockall(MCL_CURRENT | MCL_FUTURE)
+} atecc_rt_opts_t;
+
+/**
+ * @brief Open handle to an ATECC device on a Linux I2C adapter
+ */
+typedef struct {
+    int fd;                 // I2C adapter file descriptor
+    uint16_t address;       // 7-bit device address
+    unsigned long funcs;    // I2C_FUNCS bitmap reported by the adapter
+    atecc_xfer_t xfer;      // Primitive negotiated at open, see transfer_primitive() in pi_atecc.c
+    struct atecc_mux *mux;  // Upstream TCA9548A, NULL when directly attached
+    uint8_t mux_channel;    // Mux channel (0-7) the device sits behind
+    char bus[32];           // I2C device file, used to key the on-disk cache
+    struct atecc_emu_chip *emu;     // Emulated chip behind this handle, NULL on real adapters
+    const atecc_rt_opts_t *rt;      // Applied by worker threads spawned for this handle, NULL for none
+
+    // Lazy session state: nothing below touches the bus until the first command
+    bool awake;                                 // Woken and inside the watchdog window
+    uint64_t woke_at_us;                        // Time of the last wake
+    bool identity_valid;                        // serial holds a known serial number
+    bool identity_verified;                     // serial was read from this device since open
+    uint8_t serial[ATECC_SERIAL_NUMBER_SIZE];   // Cached serial number
+    bool config_valid;                          // config holds the device's config zone
+    uint8_t config[ATECC_CONFIG_SIZE];          // Cached config zone
+
+    // Health counters, updated by the command path
+    unsigned long commands;                     // Commands sent
+    unsigned long failures;                     // Commands without a valid response
+    unsigned int consecutive_failures;          // Failures since the last valid response
+    uint64_t last_ok_us;                        // Time of the last valid response
+    unsigned long polls;                        // NACKed polls under a tuning profile
+    uint8_t selftest_passed;                    // SelfTest bits that passed on their last run
+    uint8_t selftest_failed;                    // SelfTest bits that failed on their last run
+    uint64_t selftest_us;                       // Time of the last SelfTest
+
+    // Response timing: fixed waits, or the calibrated profile (atecc_tune_load())
+    atecc_tune_t tune;
+    uint8_t last_opcode;                        // Opcode of the last command sent
+    uint8_t last_mode;                          // Param1 of the last command sent
+    uint64_t sent_us;                           // End of the last command write
+    uint64_t poll_deadline_us;                  // Retry NACKed transfers until then, 0 when not polling
+
+    // Published for threads sharing the handle (atecc_snapshot_read())
+    atecc_snapshot_cell_t snapshot;
+} atecc_dev_t;
+
+/**
+ * @brief TCA9548A I2C multiplexer shared by the devices behind it
+ */
+typedef struct atecc_mux {
+    atecc_dev_t port;       // Handle bound to the multiplexer's own address
+    int channel;            // Channel currently enabled, -1 when unknown
+    unsigned long switches; // Control register writes issued
+    pthread_mutex_t lock;   // Serializes channel select + transfer across threads
+} atecc_mux_t;
+
+/**
+ * @brief Topology-aware device address: bus, optional mux hop, device address
+ */
+typedef struct {
+    char bus[32];           // I2C device file
+    uint16_t mux_address;   // TCA9548A address, 0 when directly attached
+    uint8_t mux_channel;    // Mux channel (0-7)
+    uint16_t address;       // 7-bit device address
+} atecc_topo_t;
+
+/**
+ * @brief Device found by atecc_discover()
+ */
+typedef struct {
+    char bus[32];                               // I2C device file
+    uint16_t address;                           // 7-bit device address
+    atecc_xfer_t xfer;                          // Negotiated transfer primitive
+    uint8_t serial[ATECC_SERIAL_NUMBER_SIZE];   // Device serial number
+} atecc_found_t;
+
+/**
+ * @brief Set of opened devices, possibly spread over several buses and muxes
+ */
+typedef struct {
+    atecc_mux_t muxes[ATECC_POOL_MAX];          // Muxes the devices sit behind
+    size_t mux_count;                           // Opened muxes
+    atecc_dev_t devs[ATECC_POOL_MAX];           // Device handles
+    atecc_dev_t *members[ATECC_POOL_MAX];       // Handle pointers, as taken by atecc_aes_ctr()
+    size_t count;                               // Opened devices
+} atecc_pool_t;
+
+/**
+ * @brief Queued device operation for atecc_dispatch()
+ */
+typedef bool (*atecc_job_fn)(atecc_dev_t *dev, void *arg);
+
+typedef struct {
+    atecc_dev_t *dev;       // Target device
+    atecc_job_fn fn;        // Operation to run against the device
+    void *arg;              // Operation argument
+    bool ok;                // Result, filled in by atecc_dispatch()
+} atecc_job_t;
+
+/**
+ * @brief Host-side SHA-256 context
+ */
+typedef struct {
+    uint32_t state[8];      // Chaining value
+    uint64_t length;        // Total bytes absorbed
+    uint8_t buffer[64];     // Partial block
+    size_t buffered;        // Bytes in buffer
+} sha256_ctx_t;
+
+/**
+ * @brief Operations served by the daemon (atecc_serve_main)
+ */
+typedef enum {
+    ATECC_OP_RANDOM = 1,        // Random bytes written into the client ring
+    ATECC_OP_RANDOM_INLINE,     // Random bytes sent back through the socket
+    ATECC_OP_AES_CTR,           // AES-CTR in place over a region of the client ring
+    ATECC_OP_SHA256,            // Device SHA-256 of a ring region, digest written at its start
+    ATECC_OP_SET_BATCH          // Set the caller's batching: key_slot = atecc_batch_mode_t, length = max delay (us)
+} atecc_op_t;
+
+/**
+ * @brief How the daemon holds requests back to batch them
+ */
+typedef enum {
+    ATECC_BATCH_OFF = 0,        // Dispatch every request as soon as it arrives
+    ATECC_BATCH_FIXED,          // Always wait the maximum delay after the first queued request
+    ATECC_BATCH_ADAPTIVE        // Wait in proportion to device utilization, up to the maximum delay
+} atecc_batch_mode_t;
+
+/**
+ * @brief Daemon greeting, sent with the client's ring memfd attached
+ */
+typedef struct {
+    uint32_t magic;         // ATECC_DAEMON_MAGIC
+    uint32_t version;       // Protocol version
+    uint64_t ring_size;     // Size of the attached ring
+} atecc_hello_t;
+
+/**
+ * @brief Request on the daemon control socket
+ *
+ * Results are placed at [offset, offset + length) of the client ring; for
+ * AES-CTR that region holds the input and is transformed in place.
+ */
+typedef struct {
+    uint32_t op;            // atecc_op_t
+    uint32_t id;            // Echoed in the reply
+    uint64_t offset;        // Ring offset of the result
+    uint64_t length;        // Bytes requested
+    uint8_t counter[16];    // AES-CTR initial counter block
+    uint8_t key_slot;       // AES-CTR key slot
+    uint8_t reserved[7];
+} atecc_request_t;
+
+/**
+ * @brief Reply on the daemon control socket
+ *
+ * For ATECC_OP_RANDOM_INLINE the reply is followed by length payload bytes.
+ */
+typedef struct {
+    uint32_t id;            // Request id
+    int32_t status;         // 0 on success, otherwise an errno value
+    uint64_t offset;        // Ring offset of the result
+    uint64_t length;        // Result length
+} atecc_reply_t;
+
+/**
+ * @brief Connection to the daemon with its shared result ring mapped
+ */
+typedef struct {
+    int fd;                 // Control socket
+    uint8_t *ring;          // Shared ring mapping
+    size_t ring_size;       // Ring size
+    size_t ring_next;       // Next free ring offset
+    uint32_t next_id;       // Next request id
+} atecc_client_t;
+
+/**
+ * @brief Device health as published on the status page
+ */
+typedef enum {
+    ATECC_HEALTH_UNKNOWN = 0,   // No command answered yet
+    ATECC_HEALTH_OK,            // Last command answered
+    ATECC_HEALTH_DEGRADED,      // Recent commands failed
+    ATECC_HEALTH_FAILED         // Not answering
+} atecc_health_t;
+
+/**
+ * @brief Per-device entry of the status page
+ */
+typedef struct {
+    char bus[32];                               // I2C device file
+    uint16_t address;                           // 7-bit device address
+    uint16_t mux_address;                       // TCA9548A address, 0 when directly attached
+    uint8_t mux_channel;                        // Mux channel
+    uint8_t health;                             // atecc_health_t
+    bool identity_valid;                        // serial is known
+    bool config_valid;                          // revision and lock fields are known
+    uint8_t serial[ATECC_SERIAL_NUMBER_SIZE];   // Serial number
+    uint8_t revision[4];                        // Config bytes 4-7 (RevNum)
+    bool config_locked;                         // LockConfig == 0x00
+    bool data_locked;                           // LockValue == 0x00
+    uint64_t commands;                          // Commands sent
+    uint64_t failures;                          // Commands without a valid response
+    uint64_t last_ok_us;                        // CLOCK_MONOTONIC time of the last valid response
+    uint8_t selftest_passed;                    // SelfTest bits that passed on their last run
+    uint8_t selftest_failed;                    // SelfTest bits that failed on their last run
+    uint64_t selftest_us;                       // CLOCK_MONOTONIC time of the last SelfTest, 0 if none
+} atecc_status_dev_t;
+
+/**
+ * @brief Per-client usage entry of the status page
+ *
+ * Device time is charged from the daemon's per-operation execution model,
+ * not measured, so it is comparable across clients and devices.
+ */
+typedef struct {
+    int32_t pid;                                // Client process (SO_PEERCRED)
+    uint32_t queued;                            // Has a request in the daemon's queue
+    uint64_t requests;                          // Requests completed
+    uint64_t device_us;                         // Device time charged
+    int64_t tokens_us;                          // Token bucket level (negative while in debt)
+    uint64_t throttled;                         // Rounds sat out for lack of tokens
+} atecc_status_client_t;
+
+/**
+ * @brief Idle-time SelfTest counters of the daemon
+ *
+ * A slice is one SelfTest algorithm on one device. A request that arrives
+ * while a slice runs waits for it, so delay_max_us bounds the delay SelfTest
+ * added to any request; it stays 0 while no request has met a slice.
+ */
+typedef struct {
+    uint64_t slices;            // Slices run
+    uint64_t failures;          // Slices that reported a failed test
+    uint64_t deferred;          // Planned slices put off because requests arrived first
+    uint64_t forced;            // Slices run without a predicted gap because the test was overdue
+    uint64_t delayed;           // Slices during which requests arrived
+    uint64_t delay_max_us;      // Longest of those slices
+} atecc_status_selftest_t;
+
+/**
+ * @brief Read-only identity and health page published by the daemon
+ *
+ * The daemon is the only writer and brackets every update with seq (odd
+ * while writing); readers retry until they see the same even seq before
+ * and after copying, so reads take no locks and no system calls.
+ */
+typedef struct {
+    uint32_t magic;                             // ATECC_STATUS_MAGIC
+    uint32_t version;                           // Layout version
+    atomic_uint seq;                            // Seqlock sequence
+    uint32_t device_count;                      // Valid entries in devices
+    uint64_t updated_us;                        // CLOCK_MONOTONIC time of the last update
+    uint64_t requests;                          // Requests served by the daemon
+    uint32_t clients;                           // Connected clients
+    uint32_t reserved;
+    atecc_status_dev_t devices[ATECC_POOL_MAX]; // One entry per pool device
+    atecc_status_client_t client_usage[ATECC_STATUS_CLIENT_MAX];   // One entry per connected client
+    atecc_status_selftest_t selftest;           // Idle-time SelfTest counters
+} atecc_status_page_t;
+
+/**
+ * @brief Counters kept by the write-back layer (atecc_wb_t)
+ */
+typedef struct {
+    unsigned long updates;          // atecc_wb_write() calls
+    unsigned long flushes;          // Copies committed to the device
+    unsigned long block_writes;     // 32-byte device writes issued
+    unsigned long through_writes;   // Block writes a write-through layer would have issued
+    uint64_t update_us_total;       // Time callers spent in atecc_wb_write()
+    uint64_t update_us_max;         // Slowest atecc_wb_write()
+    uint64_t flush_us_total;        // Time spent committing copies
+} atecc_wb_stats_t;
+
+/**
+ * @brief Write-back buffer for a frequently updated data slot
+ *
+ * The slot holds two copies, each a header (sequence, CRC) followed by the
+ * payload. Updates land in host memory and are committed to the older copy
+ * header block last, so a torn flush leaves the newer copy intact.
+ */
+typedef struct {
+    atecc_dev_t *dev;                           // Device holding the slot
+    uint8_t slot;                               // Data slot (8-15)
+    size_t copy_blocks;                         // Blocks per copy
+    size_t capacity;                            // Payload bytes per copy
+    uint64_t interval_us;                       // Flush this long after the first pending update, 0 = off
+    size_t max_pending;                         // Flush once this many bytes are pending, 0 = off
+    uint32_t sequence;                          // Sequence of the newest committed copy
+    unsigned int active;                        // Copy (0 or 1) holding the newest committed state
+    bool recovered;                             // A valid copy was found when opening
+    uint8_t image[ATECC_WB_COPY_MAX];           // Header + current payload, including pending updates
+    uint8_t copies[2][ATECC_WB_COPY_MAX];       // What each on-chip copy is known to hold
+    size_t pending;                             // Bytes updated since the last flush
+    uint64_t pending_since_us;                  // Time of the first pending update
+    atecc_wb_stats_t stats;                     // Counters
+} atecc_wb_t;
+
+/**
+ * @brief Offsets of the device-specific fields in a DER certificate
+ *
+ * Offsets point at element contents. Every certificate built from one
+ * template has the same layout, only the contents of these fields differ.
+ */
+typedef struct {
+    size_t tbs_offset;          // tbsCertificate element (header included)
+    size_t tbs_length;
+    size_t serial_offset;       // Serial number INTEGER contents
+    size_t serial_length;
+    size_t issue_offset;        // notBefore time contents
+    size_t issue_length;        // 13 (UTCTime) or 15 (GeneralizedTime)
+    size_t expire_offset;       // notAfter time contents
+    size_t expire_length;
+    size_t pubkey_offset;       // X || Y after the 0x04 point prefix
+    size_t ski_offset;          // subjectKeyIdentifier (SHA-1 of the key) contents, 0 if absent
+    size_t sig_alg_offset;      // signatureAlgorithm element (header included)
+    size_t sig_alg_length;
+    size_t sig_offset;          // signatureValue BIT STRING contents after the unused-bits byte
+    size_t sig_length;
+} atecc_cert_layout_t;
+
+/**
+ * @brief Host-held certificate template for compressed certificates
+ */
+typedef struct {
+    uint8_t der[ATECC_CERT_MAX];    // Template certificate
+    size_t length;                  // Template length
+    atecc_cert_layout_t layout;     // Field offsets in der
+    uint8_t template_id;            // Template id stored in compressed certificates (0-15)
+    uint8_t chain_id;               // Chain id stored in compressed certificates (0-15)
+    uint8_t sn_source;              // ATECC_CERT_SN_* serial number source
+    uint8_t digest[32];             // SHA-256 of der, naming the template in certificate caches
+} atecc_cert_def_t;
+
+/**
+ * @brief Serial number sources of a compressed certificate
+ */
+enum {
+    ATECC_CERT_SN_STORED = 0x0,     // Serial number as in the template
+    ATECC_CERT_SN_DEVICE = 0xA      // The chip's 9-byte serial number
+};
+
+/**
+ * @brief Rebuilt certificate held in memory
+ */
+typedef struct {
+    uint8_t serial[ATECC_SERIAL_NUMBER_SIZE];   // Device the certificate belongs to
+    uint8_t template_digest[32];                // atecc_cert_def_t.digest of the template it was rebuilt from
+    uint8_t cert_slot;                          // Slot holding the compressed certificate
+    uint8_t key_slot;                           // Slot whose public key it carries
+    size_t length;                              // DER length, 0 for an empty entry
+    uint8_t der[ATECC_CERT_MAX];                // Rebuilt certificate
+} atecc_cert_entry_t;
+
+/**
+ * @brief Cache of rebuilt certificates, keyed by serial, template and slots
+ */
+typedef struct {
+    atecc_cert_entry_t entries[ATECC_CERT_CACHE_MAX];
+    size_t next;                // Entry replaced on the next miss when full
+    unsigned long hits;         // Lookups served without device traffic
+    unsigned long misses;       // Lookups that read and rebuilt a certificate
+} atecc_cert_cache_t;
+
+/**
+ * @brief Operations a key directory entry can be used for
+ */
+enum {
+    ATECC_KEY_SIGN = 0x01,          // Sign of external digests
+    ATECC_KEY_ECDH = 0x02,          // ECDH with the shared secret returned
+    ATECC_KEY_AES  = 0x04           // AES block encrypt/decrypt
+};
+
+/**
+ * @brief One copy of a key: a slot on a pool device
+ */
+typedef struct {
+    uint16_t device;                // Index into the pool's members
+    uint8_t slot;                   // Slot holding the key
+} atecc_key_replica_t;
+
+/**
+ * @brief Logical key and every device slot holding an equivalent key
+ */
+typedef struct {
+    char id[ATECC_KEY_ID_MAX];                  // Logical key id, empty for a free bucket
+    uint32_t hash;                              // Hash of id
+    unsigned int caps;                          // ATECC_KEY_* operations allowed on every replica
+    uint8_t public_key[64];                     // P-256 public key, zero for AES keys
+    size_t replica_count;
+    atecc_key_replica_t replicas[ATECC_POOL_MAX];
+} atecc_key_entry_t;
+
+/**
+ * @brief Immutable open-addressing table published by atecc_keydir_build()
+ */
+typedef struct atecc_keydir_table {
+    size_t mask;                                // Bucket count - 1 (power of two)
+    size_t count;                               // Used buckets
+    struct atecc_keydir_table *retired;         // Previously published table, freed with the directory
+    atecc_key_entry_t entries[];
+} atecc_keydir_table_t;
+
+/**
+ * @brief Key directory over a device pool
+ *
+ * Lookups read the published table without locks; a rebuild publishes a
+ * new table and keeps the old one alive until atecc_keydir_free().
+ * Operations go to the replica with the fewest requests in flight.
+ */
+typedef struct {
+    atecc_pool_t *pool;                                 // Devices the replicas point into
+    _Atomic(atecc_keydir_table_t *) table;              // Published table
+    atomic_uint inflight[ATECC_POOL_MAX];               // Requests queued or running per device
+    atomic_ulong routed[ATECC_POOL_MAX];                // Requests completed per device
+    pthread_mutex_t locks[ATECC_POOL_MAX];              // Serializes command sequences per device
+} atecc_keydir_t;
+
+/**
+ * @brief Buffered output sink flushed with write(2)
+ */
+typedef struct {
+    int fd;                 // Destination descriptor
+    char *buf;              // Pending output
+    size_t used;            // Bytes pending
+    size_t capacity;        // Buffer size
+} atecc_out_t;
+
+/**
+ * @brief State of one atecc_stream_t buffer
+ */
+typedef enum {
+    ATECC_STREAM_FREE = 0,  // Available for a read or for the caller to fill
+    ATECC_STREAM_READING,   // Read in flight
+    ATECC_STREAM_READY,     // Read complete, waiting for the caller
+    ATECC_STREAM_HELD,      // Handed to the caller
+    ATECC_STREAM_QUEUED,    // Waiting for its turn to be written
+    ATECC_STREAM_WRITING    // Write in flight
+} atecc_stream_state_t;
+
+typedef struct {
+    atecc_stream_state_t state;
+    size_t length;          // Bytes read so far, or bytes to write
+    size_t done;            // Bytes written so far
+    uint64_t offset;        // File offset of the first byte, for seekable descriptors
+} atecc_stream_buf_t;
+
+struct atecc_uring;
+
+/**
+ * @brief Chunked file pipeline that keeps reads ahead of and writes behind the device
+ *
+ * Buffers cycle in a ring: reads fill them in order ahead of the caller,
+ * the caller transforms a chunk in place, and its write completes in the
+ * background while later chunks are processed. io_uring with registered
+ * buffers is used when the kernel allows it, plain read()/write() otherwise.
+ */
+typedef struct {
+    int in_fd;                  // Input descriptor, -1 for output-only streams
+    int out_fd;                 // Output descriptor, -1 for input-only streams
+    size_t chunk;               // Bytes per buffer
+    size_t depth;               // Buffers in the ring
+    uint8_t *memory;            // depth * chunk bytes, page aligned
+    atecc_stream_buf_t bufs[ATECC_STREAM_DEPTH_MAX];
+    size_t next_read;           // Next buffer to start reading into
+    size_t next_take;           // Next buffer handed to the caller
+    size_t next_write;          // Next queued buffer to start writing
+    bool in_seekable;           // Reads may go out at explicit offsets, several at once
+    bool out_seekable;          // Likewise for writes
+    uint64_t in_offset;         // Offset of the next read
+    uint64_t out_offset;        // Offset of the next write
+    bool in_eof;                // A read returned 0
+    int error;                  // First errno, 0 if none
+    struct atecc_uring *uring;  // NULL when falling back to read()/write()
+    uint64_t bytes_in;          // Counters for reports
+    uint64_t bytes_out;
+    uint64_t wait_us;           // Time callers spent blocked on I/O
+} atecc_stream_t;
+
+bool atecc_open(atecc_dev_t *dev, const char *path, uint16_t address);
+void atecc_close(atecc_dev_t *dev);
+const char *atecc_xfer_name(atecc_xfer_t xfer);
+bool atecc_i2c_write(atecc_dev_t *dev, uint8_t *buf, size_t len);
+bool atecc_i2c_read(atecc_dev_t *dev, uint8_t *buf, size_t len);
+bool atecc_wake(atecc_dev_t *dev);
+bool atecc_ensure_awake(atecc_dev_t *dev);
+bool atecc_keep_awake(atecc_dev_t *dev, uint64_t needed_us);
+bool atecc_random(atecc_dev_t *dev, uint8_t *out);
+bool atecc_sha256(atecc_dev_t *dev, const uint8_t *data, size_t data_len, uint8_t *output);
+bool atecc_read_serial(atecc_dev_t *dev, uint8_t *serial);
+bool atecc_read_config(atecc_dev_t *dev);
+bool atecc_read_config_bytes(atecc_dev_t *dev, uint8_t word, uint8_t *data, size_t length);
+bool atecc_write_config(atecc_dev_t *dev, uint8_t word, const uint8_t *data, size_t length);
+bool atecc_lock_config(atecc_dev_t *dev, const uint8_t *config);
+size_t atecc_slot_size(uint8_t slot);
+bool atecc_read_slot_block(atecc_dev_t *dev, uint8_t slot, uint8_t block, uint8_t *data);
+bool atecc_write_slot_block(atecc_dev_t *dev, uint8_t slot, uint8_t block, const uint8_t *data);
+bool atecc_read_slot(atecc_dev_t *dev, uint8_t slot, size_t offset, uint8_t *data, size_t length);
+bool atecc_write_slot(atecc_dev_t *dev, uint8_t slot, size_t offset, const uint8_t *data, size_t length);
+uint16_t atecc_crc16(const uint8_t *data, size_t length);
+bool aes_encrypt(atecc_dev_t *dev, const uint8_t *plaintext, uint8_t *ciphertext, uint8_t key_slot);
+bool aes_decrypt(atecc_dev_t *dev, const uint8_t *ciphertext, uint8_t *plaintext, uint8_t key_slot);
+bool atecc_aes_kcv(atecc_dev_t *dev, uint8_t key_slot, uint8_t *kcv);
+bool atecc_sign_digest(atecc_dev_t *dev, uint8_t key_slot, const uint8_t *digest, uint8_t *signature);
+bool atecc_get_pubkey(atecc_dev_t *dev, uint8_t key_slot, uint8_t *public_key);
+bool atecc_ecdh(atecc_dev_t *dev, uint8_t key_slot, const uint8_t *peer_key, uint8_t *secret);
+bool atecc_verify_digest(atecc_dev_t *dev, const uint8_t *digest, const uint8_t *signature,
+                         const uint8_t *public_key, bool *valid);
+uint32_t atecc_selftest_us(const atecc_dev_t *dev, uint8_t tests);
+bool atecc_selftest(atecc_dev_t *dev, uint8_t tests, uint8_t *failed);
+uint64_t atecc_now_us(void);
+bool atecc_time_command(atecc_dev_t *dev, uint8_t opcode, uint8_t mode, uint16_t param2, const uint8_t *data,
+                        uint8_t data_len, uint8_t *response, size_t response_len, uint32_t max_us,
+                        atecc_cmd_timing_t *timing);
+bool atecc_time_wake(atecc_dev_t *dev, uint32_t max_us, uint32_t *wake_us);
+
+bool atecc_parse_topo(const char *spec, atecc_topo_t *topo);
+bool atecc_mux_open(atecc_mux_t *mux, const char *path, uint16_t address);
+void atecc_mux_close(atecc_mux_t *mux);
+bool atecc_mux_select(atecc_mux_t *mux, uint8_t channel);
+bool atecc_open_topo(atecc_dev_t *dev, const atecc_topo_t *topo, atecc_mux_t *mux);
+bool atecc_pool_open(atecc_pool_t *pool, const char **specs, size_t spec_count);
+void atecc_pool_close(atecc_pool_t *pool);
+size_t atecc_dispatch(atecc_job_t *jobs, size_t count, bool grouped);
+int atecc_mux_bench(int argc, char **argv);
+
+bool atecc_emu_bus(const char *bus);
+bool atecc_emu_attach(atecc_dev_t *dev, const char *bus, uint16_t address);
+void atecc_emu_detach(atecc_dev_t *dev);
+bool atecc_emu_write(atecc_dev_t *dev, const uint8_t *buf, size_t len);
+bool atecc_emu_read(atecc_dev_t *dev, uint8_t *buf, size_t len);
+bool atecc_emu_fail_after(atecc_dev_t *dev, unsigned long commands);
+int atecc_rig_bench_main(int argc, char **argv);
+void atecc_snapshot_publish(atecc_dev_t *dev);
+bool atecc_snapshot_read(const atecc_dev_t *dev, atecc_snapshot_t *snapshot);
+int atecc_snapshot_bench_main(int argc, char **argv);
+
+bool atecc_cache_load(atecc_dev_t *dev);
+bool atecc_cache_store(const atecc_dev_t *dev);
+void atecc_cache_invalidate(const atecc_dev_t *dev);
+bool atecc_cache_dir(char *dir, size_t size);
+
+uint32_t atecc_bus_hz(const char *bus);
+uint32_t atecc_tune_ready_us(const atecc_tune_t *tune, uint8_t opcode, uint8_t mode);
+bool atecc_tune_load(atecc_dev_t *dev);
+bool atecc_tune_save(const atecc_dev_t *dev, const atecc_tune_t *tune);
+int atecc_calibrate_main(int argc, char **argv);
+
+int atecc_session_main(int argc, char **argv);
+
+void sha256_init(sha256_ctx_t *ctx);
+void sha256_update(sha256_ctx_t *ctx, const uint8_t *data, size_t length);
+void sha256_final(sha256_ctx_t *ctx, uint8_t *digest);
+void sha256(const uint8_t *data, size_t length, uint8_t *digest);
+void sha1(const uint8_t *data, size_t length, uint8_t *digest);
+
+size_t atecc_hex(const uint8_t *data, size_t length, char *out, unsigned int flags);
+bool atecc_hex_decode(const char *text, size_t length, uint8_t *out);
+size_t atecc_base64(const uint8_t *data, size_t length, char *out);
+bool atecc_out_init(atecc_out_t *out, int fd, size_t capacity);
+bool atecc_out_write(atecc_out_t *out, const char *text, size_t length);
+bool atecc_out_str(atecc_out_t *out, const char *text);
+bool atecc_out_hex(atecc_out_t *out, const uint8_t *data, size_t length, unsigned int flags);
+bool atecc_out_base64(atecc_out_t *out, const uint8_t *data, size_t length);
+bool atecc_out_flush(atecc_out_t *out);
+void atecc_out_free(atecc_out_t *out);
+int atecc_fmt_bench_main(int argc, char **argv);
+
+bool atecc_stream_open(atecc_stream_t *stream, int in_fd, int out_fd, size_t chunk, size_t depth, bool use_uring);
+uint8_t *atecc_stream_read(atecc_stream_t *stream, size_t *length);
+uint8_t *atecc_stream_buffer(atecc_stream_t *stream);
+bool atecc_stream_write(atecc_stream_t *stream, uint8_t *buf, size_t length);
+bool atecc_stream_release(atecc_stream_t *stream, uint8_t *buf);
+bool atecc_stream_close(atecc_stream_t *stream);
+const char *atecc_stream_backend(const atecc_stream_t *stream);
+int atecc_sha256_file_main(int argc, char **argv);
+int atecc_random_dump_main(int argc, char **argv);
+
+int atecc_provision_main(int argc, char **argv);
+
+bool atecc_wb_open(atecc_wb_t *wb, atecc_dev_t *dev, uint8_t slot, uint64_t interval_ms, size_t max_pending);
+bool atecc_wb_read(const atecc_wb_t *wb, size_t offset, uint8_t *data, size_t length);
+bool atecc_wb_write(atecc_wb_t *wb, size_t offset, const uint8_t *data, size_t length);
+bool atecc_wb_poll(atecc_wb_t *wb);
+bool atecc_wb_sync(atecc_wb_t *wb);
+int atecc_wb_bench_main(int argc, char **argv);
+
+bool atecc_cert_parse(const uint8_t *der, size_t length, atecc_cert_layout_t *layout);
+bool atecc_cert_def_load(atecc_cert_def_t *def, const char *path);
+bool atecc_cert_compress(const atecc_cert_def_t *def, const uint8_t *der, size_t length, uint8_t *compressed);
+bool atecc_cert_rebuild(const atecc_cert_def_t *def, const uint8_t *compressed, const uint8_t *serial,
+                        const uint8_t *public_key, uint8_t *der, size_t *length);
+bool atecc_cert_get(atecc_cert_cache_t *cache, atecc_dev_t *dev, const atecc_cert_def_t *def, uint8_t cert_slot,
+                    uint8_t key_slot, const uint8_t **der, size_t *length);
+int atecc_cert_main(int argc, char **argv);
+
+bool atecc_keydir_init(atecc_keydir_t *dir, atecc_pool_t *pool);
+bool atecc_keydir_build(atecc_keydir_t *dir, const char *names_path);
+const atecc_key_entry_t *atecc_keydir_lookup(const atecc_keydir_t *dir, const char *id);
+bool atecc_keydir_sign(atecc_keydir_t *dir, const char *id, const uint8_t *digest, uint8_t *signature);
+bool atecc_keydir_ecdh(atecc_keydir_t *dir, const char *id, const uint8_t *peer_key, uint8_t *secret);
+bool atecc_keydir_aes(atecc_keydir_t *dir, const char *id, bool decrypt, const uint8_t *input, uint8_t *output);
+void atecc_keydir_free(atecc_keydir_t *dir);
+int atecc_keys_main(int argc, char **argv);
+
+const char *atecc_socket_path(void);
+bool atecc_read_full(int fd, void *buf, size_t len);
+bool atecc_write_full(int fd, const void *buf, size_t len);
+int atecc_serve_main(int argc, char **argv);
+atecc_status_page_t *atecc_status_create(const char *name);
+void atecc_status_publish(atecc_status_page_t *page, const atecc_pool_t *pool, uint64_t requests,
+                          const atecc_status_client_t *clients, size_t client_count,
+                          const atecc_status_selftest_t *selftest);
+void atecc_status_destroy(atecc_status_page_t *page, const char *name);
+const atecc_status_page_t *atecc_status_map(const char *name);
+bool atecc_status_read(const atecc_status_page_t *page, size_t index, atecc_status_dev_t *entry,
+                       size_t *device_count);
+bool atecc_status_read_clients(const atecc_status_page_t *page, atecc_status_client_t *entries,
+                               size_t *client_count);
+bool atecc_status_read_totals(const atecc_status_page_t *page, uint64_t *requests, uint32_t *clients,
+                              atecc_status_selftest_t *selftest);
+int atecc_status_main(int argc, char **argv);
+bool atecc_client_open(atecc_client_t *client, const char *path);
+void atecc_client_close(atecc_client_t *client);
+uint8_t *atecc_client_reserve(atecc_client_t *client, size_t length);
+bool atecc_client_random(atecc_client_t *client, size_t length, uint8_t **data);
+bool atecc_client_random_copy(atecc_client_t *client, uint8_t *buf, size_t length);
+bool atecc_client_aes_ctr(atecc_client_t *client, uint8_t key_slot, const uint8_t *counter, uint8_t *data,
+                          size_t length);
+bool atecc_client_sha256(atecc_client_t *client, uint8_t *data, size_t length, uint8_t *digest);
+bool atecc_client_set_batch(atecc_client_t *client, atecc_batch_mode_t mode, uint64_t max_delay_us);
+int atecc_client_bench_main(int argc, char **argv);
+int atecc_batch_bench_main(int argc, char **argv);
+int atecc_burst_bench_main(int argc, char **argv);
+int atecc_trace_main(int argc, char **argv);
+
+void atecc_ctr_add(uint8_t *counter, uint64_t blocks);
+bool atecc_aes_ctr(atecc_dev_t **devs, size_t dev_count, uint8_t key_slot, const uint8_t *counter,
+                   const uint8_t *input, uint8_t *output, size_t length);
+int atecc_aes_ctr_main(int argc, char **argv);
+
+int atecc_batch_sign_main(int argc, char **argv);
+int atecc_batch_verify_main(int argc, char **argv);
+
+bool atecc_rt_apply(const atecc_rt_opts_t *opts);
+bool atecc_rt_parse_arg(int argc, char **argv, int *index, atecc_rt_opts_t *opts);
+bool atecc_rt_requested(const atecc_rt_opts_t *opts);
+bool atecc_rt_apply_pool(const atecc_rt_opts_t *opts, atecc_pool_t *pool);
+int atecc_latency_main(int argc, char **argv);
+
+size_t atecc_discover(const uint16_t *addresses, size_t address_count, atecc_found_t *found, size_t max_found);
+int atecc_discover_main(int argc, char **argv);
 
 #endif // PI_ATECC_H
\ No newline at end of file
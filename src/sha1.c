@@ -0,0 +1,80 @@
+#include <stdint.h>
+#include <string.h>
+#include "pi_atecc.h"
+
+static uint32_t rotl32(uint32_t value, unsigned int bits) {
+    return (value << bits) | (value >> (32U - bits));
+}
+
+/**
+ * @brief Compress one 64-byte block into the hash state (FIPS 180-4, section 6.1.2)
+ */
+static void sha1_block(uint32_t *state, const uint8_t *block) {
+    uint32_t w[80];
+    for (unsigned int i = 0; i < 16U; i++) {
+        w[i] = ((uint32_t)block[i * 4U] << 24) | ((uint32_t)block[i * 4U + 1U] << 16) |
+               ((uint32_t)block[i * 4U + 2U] << 8) | (uint32_t)block[i * 4U + 3U];
+    }
+    for (unsigned int i = 16U; i < 80U; i++) {
+        w[i] = rotl32(w[i - 3U] ^ w[i - 8U] ^ w[i - 14U] ^ w[i - 16U], 1);
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (unsigned int i = 0; i < 80U; i++) {
+        uint32_t f;
+        uint32_t k;
+        if (i < 20U) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        } else if (i < 40U) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60U) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        uint32_t t = rotl32(a, 5) + f + e + k + w[i];
+        e = d; d = c; c = rotl32(b, 30); b = a; a = t;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+}
+
+/**
+ * @brief One-shot host-side SHA-1, used for X.509 key identifiers
+ *
+ * @param data Data to hash
+ * @param length Number of bytes
+ * @param digest Receives the 20-byte digest
+ */
+void sha1(const uint8_t *data, size_t length, uint8_t *digest) {
+    uint32_t state[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+    size_t done = 0;
+    for (; length - done >= 64U; done += 64U) {
+        sha1_block(state, &data[done]);
+    }
+
+    uint8_t tail[128] = {0};
+    size_t rest = length - done;
+    memcpy(tail, &data[done], rest);
+    tail[rest] = 0x80;
+    size_t tail_length = (rest < 56U) ? 64U : 128U;
+    uint64_t bits = (uint64_t)length * 8U;
+    for (unsigned int i = 0; i < 8U; i++) {
+        tail[tail_length - 1U - i] = (uint8_t)(bits >> (8U * i));
+    }
+    for (size_t at = 0; at < tail_length; at += 64U) {
+        sha1_block(state, &tail[at]);
+    }
+
+    for (unsigned int i = 0; i < 5U; i++) {
+        digest[i * 4U] = (uint8_t)(state[i] >> 24);
+        digest[i * 4U + 1U] = (uint8_t)(state[i] >> 16);
+        digest[i * 4U + 2U] = (uint8_t)(state[i] >> 8);
+        digest[i * 4U + 3U] = (uint8_t)state[i];
+    }
+}
@@ -0,0 +1,147 @@
+#include <stdint.h>
+#include <string.h>
+#include "pi_atecc.h"
+
+/**
+ * @brief SHA-256 round constants (FIPS 180-4, section 4.2.2)
+ */
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t rotr32(uint32_t value, unsigned int bits) {
+    return (value >> bits) | (value << (32U - bits));
+}
+
+/**
+ * @brief Compress one 64-byte block into the hash state
+ */
+static void sha256_block(sha256_ctx_t *ctx, const uint8_t *block) {
+    uint32_t w[64];
+    for (unsigned int i = 0; i < 16U; i++) {
+        w[i] = ((uint32_t)block[i * 4U] << 24) | ((uint32_t)block[i * 4U + 1U] << 16) |
+               ((uint32_t)block[i * 4U + 2U] << 8) | (uint32_t)block[i * 4U + 3U];
+    }
+    for (unsigned int i = 16U; i < 64U; i++) {
+        uint32_t s0 = rotr32(w[i - 15U], 7) ^ rotr32(w[i - 15U], 18) ^ (w[i - 15U] >> 3);
+        uint32_t s1 = rotr32(w[i - 2U], 17) ^ rotr32(w[i - 2U], 19) ^ (w[i - 2U] >> 10);
+        w[i] = w[i - 16U] + s0 + w[i - 7U] + s1;
+    }
+
+    uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+    uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+
+    for (unsigned int i = 0; i < 64U; i++) {
+        uint32_t s1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+        uint32_t s0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + maj;
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d;
+    ctx->state[4] += e; ctx->state[5] += f; ctx->state[6] += g; ctx->state[7] += h;
+}
+
+/**
+ * @brief Start a host-side SHA-256 computation
+ *
+ * @param ctx Hash context
+ */
+void sha256_init(sha256_ctx_t *ctx) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(ctx->state, initial, sizeof(initial));
+    ctx->length = 0;
+    ctx->buffered = 0;
+}
+
+/**
+ * @brief Absorb data into a host-side SHA-256 computation
+ *
+ * @param ctx Hash context
+ * @param data Data to hash
+ * @param length Number of bytes
+ */
+void sha256_update(sha256_ctx_t *ctx, const uint8_t *data, size_t length) {
+    ctx->length += length;
+
+    if (ctx->buffered > 0U) {
+        size_t take = 64U - ctx->buffered;
+        if (take > length) {
+            take = length;
+        }
+        memcpy(&ctx->buffer[ctx->buffered], data, take);
+        ctx->buffered += take;
+        data += take;
+        length -= take;
+        if (ctx->buffered < 64U) {
+            return;
+        }
+        sha256_block(ctx, ctx->buffer);
+        ctx->buffered = 0;
+    }
+
+    while (length >= 64U) {
+        sha256_block(ctx, data);
+        data += 64;
+        length -= 64U;
+    }
+
+    memcpy(ctx->buffer, data, length);
+    ctx->buffered = length;
+}
+
+/**
+ * @brief Finish a host-side SHA-256 computation
+ *
+ * @param ctx Hash context
+ * @param digest Output buffer of 32 bytes
+ */
+void sha256_final(sha256_ctx_t *ctx, uint8_t *digest) {
+    uint64_t bit_length = ctx->length * 8U;
+
+    ctx->buffer[ctx->buffered++] = 0x80;
+    if (ctx->buffered > 56U) {
+        memset(&ctx->buffer[ctx->buffered], 0, 64U - ctx->buffered);
+        sha256_block(ctx, ctx->buffer);
+        ctx->buffered = 0;
+    }
+    memset(&ctx->buffer[ctx->buffered], 0, 56U - ctx->buffered);
+    for (unsigned int i = 0; i < 8U; i++) {
+        ctx->buffer[56U + i] = (uint8_t)(bit_length >> (56U - i * 8U));
+    }
+    sha256_block(ctx, ctx->buffer);
+
+    for (unsigned int i = 0; i < 8U; i++) {
+        digest[i * 4U] = (uint8_t)(ctx->state[i] >> 24);
+        digest[i * 4U + 1U] = (uint8_t)(ctx->state[i] >> 16);
+        digest[i * 4U + 2U] = (uint8_t)(ctx->state[i] >> 8);
+        digest[i * 4U + 3U] = (uint8_t)ctx->state[i];
+    }
+}
+
+/**
+ * @brief One-shot host-side SHA-256
+ *
+ * @param data Data to hash
+ * @param length Number of bytes
+ * @param digest Output buffer of 32 bytes
+ */
+void sha256(const uint8_t *data, size_t length, uint8_t *digest) {
+    sha256_ctx_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, length);
+    sha256_final(&ctx, digest);
+}
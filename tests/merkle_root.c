@@ -0,0 +1,104 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    LINE_MAX_BYTES = 65536,
+    ROOT_HEX       = 64
+};
+
+/**
+ * @brief RFC 6962 Merkle Tree Hashes of the records "record-0" .. "record-<n-1>"
+ *
+ * Computed independently with the recursive definition of RFC 6962 section
+ * 2.1, splitting at the largest power of two below n.
+ */
+static const struct {
+    unsigned int leaves;
+    const char *root;
+} cases[] = {
+    { 1U,  "45c7bdcd45db42b418f7c42663fbeb464c9f0a88980cbc31fdddd29d24f724ee" },
+    { 2U,  "d075b56a4adef62530a52839802802da518a21b5d0bf35eb05fea2b295a855fa" },
+    { 3U,  "d6a93c4b91bf4b5be4fae77b5be1439df69e7c7c38007eb704c299cd0e1057b1" },
+    { 5U,  "be86a57ed4ff3ab4bdeac05994ad169ef3a431e8991ed51f7c143b4d9f2f478e" },
+    { 6U,  "167ab22f16e64441b876c6d674bb36782d78178a5b5f44fb937110b8908fd996" },
+    { 7U,  "ac49bffc2e4b5dc0e6a0fc76b80860d2c23955b84d453db541134372e2c5a91f" },
+    { 11U, "2c4e61ec91447cb9366f22814a367cf09592a224593de9e514feee25d2324564" }
+};
+
+/**
+ * @brief Sign one batch on an emulated device and check its root and proofs
+ *
+ * @param pi_atecc Path to pi_atecc
+ * @param leaves Records in the batch
+ * @param root Expected root, lowercase hex
+ * @return true if every record carries the expected root and batch-verify accepts them
+ */
+static bool check_batch(const char *pi_atecc, unsigned int leaves, const char *root) {
+    char records[64];
+    snprintf(records, sizeof(records), "seq 0 %u | sed 's/^/record-/'", leaves - 1U);
+
+    char command[1024];
+    snprintf(command, sizeof(command), "%s | '%s' batch-sign 0 emu0:0x60 2>/dev/null", records, pi_atecc);
+    FILE *signer = popen(command, "r");
+    if (!signer) {
+        perror("merkle_root: popen failed");
+        return false;
+    }
+
+    char *line = malloc(LINE_MAX_BYTES);
+    unsigned int lines = 0;
+    bool ok = line != NULL;
+    while (ok && fgets(line, LINE_MAX_BYTES, signer)) {
+        lines++;
+        const char *value = strstr(line, "\"root\":\"");
+        if (!value || strncmp(value + strlen("\"root\":\""), root, ROOT_HEX) != 0) {
+            fprintf(stderr, "❌ %u leaves: record %u has the wrong root: %s", leaves, lines, line);
+            ok = false;
+        }
+    }
+    free(line);
+    int status = pclose(signer);
+    if (ok && (status != 0 || lines != leaves)) {
+        fprintf(stderr, "❌ %u leaves: batch-sign failed or gave %u record(s)\n", leaves, lines);
+        ok = false;
+    }
+    if (!ok) {
+        return false;
+    }
+
+    snprintf(command, sizeof(command),
+             "%s | '%s' batch-sign 0 emu0:0x60 2>/dev/null | '%s' batch-verify --slot 0 emu0:0x60 >/dev/null 2>&1",
+             records, pi_atecc, pi_atecc);
+    if (system(command) != 0) {
+        fprintf(stderr, "❌ %u leaves: batch-verify rejected the inclusion proofs\n", leaves);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Check batch-sign roots against RFC 6962 for even and odd leaf counts
+ *
+ * Usage: merkle_root <path to pi_atecc>
+ *
+ * @return 0 when every root matches and every proof verifies, 1 otherwise
+ */
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: merkle_root <pi_atecc>\n");
+        return 2;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        ok = check_batch(argv[1], cases[i].leaves, cases[i].root) && ok;
+    }
+    if (ok) {
+        printf("✅ %zu batch roots match RFC 6962\n", sizeof(cases) / sizeof(cases[0]));
+    }
+    return ok ? 0 : 1;
+}
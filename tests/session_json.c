@@ -0,0 +1,265 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/**
+ * @brief Requests covering every session op, plus lines that must fail
+ *
+ * Every line gets exactly one response line on stdout.
+ */
+static const char *const requests[] = {
+    "{\"id\":1,\"op\":\"random\",\"bytes\":16}",
+    "{\"id\":2,\"op\":\"sha256\",\"data\":\"616263\"}",
+    "{\"id\":3,\"op\":\"aes_encrypt\",\"slot\":3,\"data\":\"00112233445566778899aabbccddeeff\"}",
+    "{\"id\":4,\"op\":\"aes_decrypt\",\"slot\":3,\"data\":\"00112233445566778899aabbccddeeff\"}",
+    "{\"id\":5,\"op\":\"read_config\"}",
+    "{\"id\":6,\"op\":\"serial\"}",
+    "{\"id\":7,\"op\":\"sign\",\"slot\":0,\"digest\":"
+    "\"0000000000000000000000000000000000000000000000000000000000000000\"}",
+    "{\"id\":8,\"op\":\"pubkey\",\"slot\":0}",
+    "{\"id\":9,\"op\":\"ecdh\",\"slot\":0,\"key\":\"00000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000000000000000000000\"}",
+    "{\"id\":10,\"op\":\"verify\",\"digest\":\"00\",\"signature\":\"00\",\"key\":\"00\"}",
+    "{\"id\":\"a\\\"b\",\"op\":\"nope\"}",
+    "not json at all"
+};
+
+enum {
+    LINE_MAX_BYTES = 65536
+};
+
+static bool json_value(const char **p);
+
+/**
+ * @brief Skip JSON whitespace
+ */
+static void json_ws(const char **p) {
+    while (**p == ' ' || **p == '\t' || **p == '\r' || **p == '\n') {
+        (*p)++;
+    }
+}
+
+/**
+ * @brief Match a string, escapes included
+ */
+static bool json_string(const char **p) {
+    if (**p != '"') {
+        return false;
+    }
+    for ((*p)++; **p != '"'; (*p)++) {
+        unsigned char c = (unsigned char)**p;
+        if (c < 0x20U) {
+            return false;
+        }
+        if (c != '\\') {
+            continue;
+        }
+        (*p)++;
+        if (**p == 'u') {
+            for (int i = 0; i < 4; i++) {
+                (*p)++;
+                if (!isxdigit((unsigned char)**p)) {
+                    return false;
+                }
+            }
+        } else if (!strchr("\"\\/bfnrt", **p) || **p == '\0') {
+            return false;
+        }
+    }
+    (*p)++;
+    return true;
+}
+
+/**
+ * @brief Match a number
+ */
+static bool json_number(const char **p) {
+    const char *start = *p;
+    if (**p == '-') {
+        (*p)++;
+    }
+    if (**p == '0') {
+        (*p)++;
+    } else if (isdigit((unsigned char)**p)) {
+        while (isdigit((unsigned char)**p)) {
+            (*p)++;
+        }
+    } else {
+        return false;
+    }
+    if (**p == '.') {
+        (*p)++;
+        if (!isdigit((unsigned char)**p)) {
+            return false;
+        }
+        while (isdigit((unsigned char)**p)) {
+            (*p)++;
+        }
+    }
+    if (**p == 'e' || **p == 'E') {
+        (*p)++;
+        if (**p == '+' || **p == '-') {
+            (*p)++;
+        }
+        if (!isdigit((unsigned char)**p)) {
+            return false;
+        }
+        while (isdigit((unsigned char)**p)) {
+            (*p)++;
+        }
+    }
+    return *p > start;
+}
+
+/**
+ * @brief Match an object or array body after its opening bracket
+ */
+static bool json_members(const char **p, char close, bool keyed) {
+    json_ws(p);
+    if (**p == close) {
+        (*p)++;
+        return true;
+    }
+    for (;;) {
+        json_ws(p);
+        if (keyed) {
+            if (!json_string(p)) {
+                return false;
+            }
+            json_ws(p);
+            if (**p != ':') {
+                return false;
+            }
+            (*p)++;
+        }
+        if (!json_value(p)) {
+            return false;
+        }
+        json_ws(p);
+        if (**p == close) {
+            (*p)++;
+            return true;
+        }
+        if (**p != ',') {
+            return false;
+        }
+        (*p)++;
+    }
+}
+
+/**
+ * @brief Match a literal such as true
+ */
+static bool json_literal(const char **p, const char *literal) {
+    size_t length = strlen(literal);
+    if (strncmp(*p, literal, length) != 0) {
+        return false;
+    }
+    *p += length;
+    return true;
+}
+
+/**
+ * @brief Match any JSON value
+ */
+static bool json_value(const char **p) {
+    json_ws(p);
+    switch (**p) {
+    case '{':
+        (*p)++;
+        return json_members(p, '}', true);
+    case '[':
+        (*p)++;
+        return json_members(p, ']', false);
+    case '"':
+        return json_string(p);
+    case 't':
+        return json_literal(p, "true");
+    case 'f':
+        return json_literal(p, "false");
+    case 'n':
+        return json_literal(p, "null");
+    default:
+        return json_number(p);
+    }
+}
+
+/**
+ * @brief Whether a line is exactly one JSON object
+ */
+static bool json_line(const char *line) {
+    const char *p = line;
+    json_ws(&p);
+    if (*p != '{' || !json_value(&p)) {
+        return false;
+    }
+    json_ws(&p);
+    return *p == '\0';
+}
+
+/**
+ * @brief Run a session on an emulated device and check every stdout line is JSON
+ *
+ * Usage: session_json <path to pi_atecc>
+ *
+ * @return 0 when every request got one JSON response line, 1 otherwise
+ */
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: session_json <pi_atecc>\n");
+        return 2;
+    }
+
+    size_t count = sizeof(requests) / sizeof(requests[0]);
+    char *input = NULL;
+    size_t input_length = 0;
+    FILE *script = open_memstream(&input, &input_length);
+    if (!script) {
+        perror("session_json");
+        return 1;
+    }
+    fprintf(script, "printf '%%s\\n'");
+    for (size_t i = 0; i < count; i++) {
+        fprintf(script, " '%s'", requests[i]);
+    }
+    fprintf(script, " | '%s' session emu0:0x60 2>/dev/null", argv[1]);
+    fclose(script);
+
+    FILE *session = popen(input, "r");
+    free(input);
+    if (!session) {
+        perror("session_json: popen failed");
+        return 1;
+    }
+
+    char *line = malloc(LINE_MAX_BYTES);
+    size_t lines = 0;
+    bool ok = line != NULL;
+    while (ok && fgets(line, LINE_MAX_BYTES, session)) {
+        line[strcspn(line, "\n")] = '\0';
+        lines++;
+        if (!json_line(line)) {
+            fprintf(stderr, "❌ Line %zu is not JSON: %s\n", lines, line);
+            ok = false;
+        }
+    }
+    free(line);
+    int status = pclose(session);
+
+    if (ok && lines != count) {
+        fprintf(stderr, "❌ %zu response line(s) for %zu request(s)\n", lines, count);
+        ok = false;
+    }
+    if (ok && status == -1) {
+        perror("session_json: pclose failed");
+        ok = false;
+    }
+    if (ok) {
+        printf("✅ %zu JSON response line(s)\n", lines);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    RANDOM_BYTES = 4096,
+    CTR_BYTES    = 1000     // Not a whole number of blocks, so the tail is covered too
+};
+
+/**
+ * @brief Run a shell pipeline and collect what it writes to stdout
+ *
+ * @param command Pipeline, stderr of each stage should go to /dev/null
+ * @param buffer Receives the first size bytes of output
+ * @param size Buffer size
+ * @param length Receives the total number of bytes written, which may exceed size
+ * @return true if the pipeline ran and exited with status 0
+ */
+static bool run(const char *command, unsigned char *buffer, size_t size, size_t *length) {
+    FILE *pipe = popen(command, "r");
+    if (!pipe) {
+        perror("stream_output: popen failed");
+        return false;
+    }
+    *length = 0;
+    unsigned char scratch[512];
+    size_t got;
+    do {
+        unsigned char *into = (*length < size) ? buffer + *length : scratch;
+        size_t room = (*length < size) ? size - *length : sizeof(scratch);
+        got = fread(into, 1, room, pipe);
+        *length += got;
+    } while (got > 0);
+    int status = pclose(pipe);
+    if (status != 0) {
+        fprintf(stderr, "❌ '%s' exited with status %d\n", command, status);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Check that random-dump and aes-ctr write nothing but data to stdout
+ *
+ * Usage: stream_output <path to pi_atecc>
+ *
+ * random-dump must write exactly the requested bytes, and aes-ctr run twice
+ * with the same counter must give back its input byte for byte.
+ *
+ * @return 0 when both streams hold only data, 1 otherwise
+ */
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: stream_output <pi_atecc>\n");
+        return 2;
+    }
+
+    static unsigned char output[RANDOM_BYTES];
+    char command[1024];
+    size_t length = 0;
+    bool ok = true;
+
+    snprintf(command, sizeof(command), "'%s' random-dump %d emu0:0x60 2>/dev/null", argv[1], RANDOM_BYTES);
+    if (!run(command, output, RANDOM_BYTES, &length) || length != RANDOM_BYTES) {
+        fprintf(stderr, "❌ random-dump wrote %zu bytes for %d\n", length, RANDOM_BYTES);
+        ok = false;
+    }
+
+    static const char counter[] = "000102030405060708090a0b0c0d0e0f";
+    snprintf(command, sizeof(command),
+             "head -c %d /dev/zero | '%s' aes-ctr 3 %s emu0:0x60 2>/dev/null | '%s' aes-ctr 3 %s emu0:0x60 2>/dev/null",
+             CTR_BYTES, argv[1], counter, argv[1], counter);
+    if (!run(command, output, CTR_BYTES, &length) || length != CTR_BYTES) {
+        fprintf(stderr, "❌ aes-ctr round trip gave %zu bytes for %d\n", length, CTR_BYTES);
+        ok = false;
+    } else {
+        for (size_t i = 0; i < CTR_BYTES; i++) {
+            if (output[i] != 0U) {
+                fprintf(stderr, "❌ aes-ctr round trip differs at byte %zu\n", i);
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    if (ok) {
+        printf("✅ random-dump and aes-ctr wrote only data\n");
+    }
+    return ok ? 0 : 1;
+}